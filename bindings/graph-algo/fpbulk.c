@@ -0,0 +1,501 @@
+/*
+ * fpbulk.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Python 3 bindings that pass whole batches of requests and admitted traffic
+ * between Python and the allocator, as contiguous buffers. Any object with
+ * the buffer protocol works: numpy arrays, array.array, bytearray. Sources,
+ * destinations and demand sizes are uint16, other amounts and times uint32.
+ *
+ * Unlike the SWIG modules, which expose the C structures edge by edge, a call
+ * here crosses into C once per batch:
+ *
+ *   alloc = fpbulk.Allocator(num_nodes)
+ *   alloc.add_backlog(src, dst, amount)
+ *   n = alloc.allocate(sizes, src_out, dst_out, num_batches)
+ *
+ * fills sizes with the number of edges admitted in each timeslot and
+ * src_out/dst_out with the edges, timeslot after timeslot.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "../../src/graph-algo/algo_config.h"
+#include "../../src/graph-algo/fp_ring.h"
+#include "../../src/graph-algo/generate_requests_batch.h"
+#include "../../src/graph-algo/admissible.h"
+#include "../../src/graph-algo/path_selection.h"
+#include "../../src/graph-algo/platform.h"
+
+/* enough bins for every flow to be backlogged, with room to spare */
+#define BULK_BIN_MEMPOOL_SIZE			(2 * MAX_NODES * MAX_NODES / SMALL_BIN_SIZE)
+#define BULK_ADMITTED_MEMPOOL_SIZE		(4 * BATCH_SIZE)
+#define BULK_ADMITTED_OUT_RING_LOG_SIZE	8
+
+typedef struct {
+	PyObject_HEAD
+	struct admissible_state *status;
+	struct fp_ring *q_bin;
+	struct fp_ring *q_head;
+	struct fp_ring *q_admitted_out;
+	struct fp_ring *q_spent;
+	struct fp_mempool *bin_mempool;
+	struct fp_mempool *admitted_traffic_mempool;
+	uint16_t num_nodes;
+	bool oversubscribed;
+	uint16_t inter_rack_capacity;
+	uint16_t out_of_boundary_capacity;
+} AllocatorObject;
+
+/**
+ * Gets a C-contiguous buffer of @itemsize-byte elements from @obj
+ * @return 0 on success, -1 with a Python exception set on failure
+ */
+static int get_buffer(PyObject *obj, Py_buffer *view, Py_ssize_t itemsize,
+		bool writable, const char *name)
+{
+	int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+
+	if (writable)
+		flags |= PyBUF_WRITABLE;
+	if (PyObject_GetBuffer(obj, view, flags) != 0)
+		return -1;
+	if (view->itemsize != itemsize) {
+		PyErr_Format(PyExc_TypeError,
+				"%s must have %zd-byte elements, got %zd", name, itemsize,
+				view->itemsize);
+		PyBuffer_Release(view);
+		return -1;
+	}
+	return 0;
+}
+
+static inline Py_ssize_t n_elems(Py_buffer *view)
+{
+	return view->len / view->itemsize;
+}
+
+static void mempool_destroy(struct fp_mempool *mp)
+{
+	uint32_t i;
+
+	if (mp == NULL)
+		return;
+	/* elements still in use by the allocator are lost with it */
+	for (i = 0; i < mp->cur_elements; i++)
+		free(mp->elements[i]);
+	free(mp->elements);
+	free(mp);
+}
+
+static void Allocator_dealloc(AllocatorObject *self)
+{
+	free(self->status);
+	free(self->q_bin);
+	free(self->q_head);
+	free(self->q_admitted_out);
+	free(self->q_spent);
+	mempool_destroy(self->bin_mempool);
+	mempool_destroy(self->admitted_traffic_mempool);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static int Allocator_init(AllocatorObject *self, PyObject *args,
+		PyObject *kwds)
+{
+	static char *kwlist[] = {"num_nodes", "oversubscribed",
+			"inter_rack_capacity", "out_of_boundary_capacity", NULL};
+	unsigned int num_nodes;
+	int oversubscribed = 0;
+	unsigned int inter_rack_capacity = 0;
+	unsigned int out_of_boundary_capacity = 0;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "I|pII", kwlist, &num_nodes,
+			&oversubscribed, &inter_rack_capacity, &out_of_boundary_capacity))
+		return -1;
+	if (num_nodes < 2 || num_nodes > MAX_NODES) {
+		PyErr_Format(PyExc_ValueError, "num_nodes must be in [2, %d]",
+				MAX_NODES);
+		return -1;
+	}
+	if (self->status != NULL) {
+		PyErr_SetString(PyExc_RuntimeError, "Allocator already initialized");
+		return -1;
+	}
+
+	self->q_bin = fp_ring_create(2 * FP_NODES_SHIFT);
+	self->q_head = fp_ring_create(2 * FP_NODES_SHIFT);
+	self->q_admitted_out = fp_ring_create(BULK_ADMITTED_OUT_RING_LOG_SIZE);
+	self->q_spent = fp_ring_create(2 * FP_NODES_SHIFT);
+	self->bin_mempool = fp_mempool_create(BULK_BIN_MEMPOOL_SIZE,
+			bin_num_bytes(SMALL_BIN_SIZE));
+	self->admitted_traffic_mempool = fp_mempool_create(
+			BULK_ADMITTED_MEMPOOL_SIZE, sizeof(struct admitted_traffic));
+	if (!self->q_bin || !self->q_head || !self->q_admitted_out ||
+			!self->q_spent || !self->bin_mempool ||
+			!self->admitted_traffic_mempool) {
+		PyErr_NoMemory();
+		return -1;
+	}
+
+	self->num_nodes = num_nodes;
+	self->oversubscribed = oversubscribed;
+	self->inter_rack_capacity = inter_rack_capacity;
+	self->out_of_boundary_capacity = out_of_boundary_capacity;
+	self->status = create_admissible_state(oversubscribed, inter_rack_capacity,
+			out_of_boundary_capacity, num_nodes, self->q_head,
+			self->q_admitted_out, self->q_spent, self->bin_mempool,
+			self->admitted_traffic_mempool, &self->q_bin, NULL, NULL);
+	if (self->status == NULL) {
+		PyErr_NoMemory();
+		return -1;
+	}
+	return 0;
+}
+
+static bool check_initialized(AllocatorObject *self)
+{
+	if (self->status == NULL) {
+		PyErr_SetString(PyExc_RuntimeError, "Allocator not initialized");
+		return false;
+	}
+	return true;
+}
+
+PyDoc_STRVAR(add_backlog_doc,
+"add_backlog(src, dst, amount, urgent=False)\n\n"
+"Adds amount[i] timeslots of demand from src[i] to dst[i] for every i.\n"
+"src and dst are uint16 buffers, amount a uint32 buffer of the same length.");
+
+static PyObject *Allocator_add_backlog(AllocatorObject *self, PyObject *args,
+		PyObject *kwds)
+{
+	static char *kwlist[] = {"src", "dst", "amount", "urgent", NULL};
+	PyObject *src_obj, *dst_obj, *amount_obj;
+	Py_buffer src, dst, amount;
+	int urgent = 0;
+	const uint16_t *s, *d;
+	const uint32_t *a;
+	Py_ssize_t i, n;
+
+	if (!check_initialized(self))
+		return NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|p", kwlist, &src_obj,
+			&dst_obj, &amount_obj, &urgent))
+		return NULL;
+	if (get_buffer(src_obj, &src, 2, false, "src") != 0)
+		return NULL;
+	if (get_buffer(dst_obj, &dst, 2, false, "dst") != 0)
+		goto release_src;
+	if (get_buffer(amount_obj, &amount, 4, false, "amount") != 0)
+		goto release_dst;
+
+	n = n_elems(&src);
+	if (n_elems(&dst) != n || n_elems(&amount) != n) {
+		PyErr_SetString(PyExc_ValueError,
+				"src, dst and amount must have the same length");
+		goto release_all;
+	}
+
+	s = src.buf;
+	d = dst.buf;
+	a = amount.buf;
+	for (i = 0; i < n; i++) {
+		if (s[i] >= self->num_nodes || d[i] >= self->num_nodes ||
+				s[i] == d[i]) {
+			PyErr_Format(PyExc_ValueError, "bad request %zd: %u -> %u", i,
+					s[i], d[i]);
+			goto release_all;
+		}
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	for (i = 0; i < n; i++) {
+		if (a[i] == 0)
+			continue;
+		if (urgent)
+			add_urgent_backlog(self->status, s[i], d[i], a[i]);
+		else
+			add_backlog(self->status, s[i], d[i], a[i]);
+	}
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&amount);
+	PyBuffer_Release(&dst);
+	PyBuffer_Release(&src);
+	Py_RETURN_NONE;
+
+release_all:
+	PyBuffer_Release(&amount);
+release_dst:
+	PyBuffer_Release(&dst);
+release_src:
+	PyBuffer_Release(&src);
+	return NULL;
+}
+
+PyDoc_STRVAR(allocate_doc,
+"allocate(sizes, src, dst, num_batches=1, num_racks=0) -> int\n\n"
+"Allocates num_batches batches of BATCH_SIZE timeslots. Writes the number of\n"
+"edges admitted in each timeslot to the uint16 buffer sizes, and the edges,\n"
+"timeslot after timeslot, to the uint16 buffers src and dst. With num_racks,\n"
+"also selects paths, encoded in the top bits of dst as in select_paths().\n"
+"Returns the total number of edges.");
+
+static PyObject *Allocator_allocate(AllocatorObject *self, PyObject *args,
+		PyObject *kwds)
+{
+	static char *kwlist[] = {"sizes", "src", "dst", "num_batches", "num_racks",
+			NULL};
+	PyObject *sizes_obj, *src_obj, *dst_obj;
+	Py_buffer sizes, src, dst;
+	unsigned int num_batches = 1;
+	unsigned int num_racks = 0;
+	Py_ssize_t max_edges;
+	Py_ssize_t n = 0;
+	uint32_t b, i, j;
+	bool overflow = false;
+
+	if (!check_initialized(self))
+		return NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|II", kwlist, &sizes_obj,
+			&src_obj, &dst_obj, &num_batches, &num_racks))
+		return NULL;
+	if (num_racks > MAX_RACKS) {
+		PyErr_Format(PyExc_ValueError, "num_racks must be at most %d",
+				MAX_RACKS);
+		return NULL;
+	}
+	if (get_buffer(sizes_obj, &sizes, 2, true, "sizes") != 0)
+		return NULL;
+	if (get_buffer(src_obj, &src, 2, true, "src") != 0)
+		goto release_sizes;
+	if (get_buffer(dst_obj, &dst, 2, true, "dst") != 0)
+		goto release_src;
+
+	max_edges = n_elems(&src);
+	if (n_elems(&dst) != max_edges) {
+		PyErr_SetString(PyExc_ValueError, "src and dst must have the same length");
+		goto release_all;
+	}
+	if (n_elems(&sizes) < (Py_ssize_t)num_batches * ADMITTED_PER_BATCH) {
+		PyErr_Format(PyExc_ValueError, "sizes must hold %u timeslots",
+				num_batches * ADMITTED_PER_BATCH);
+		goto release_all;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	for (b = 0; b < num_batches; b++) {
+		flush_backlog(self->status);
+		get_admissible_traffic(self->status, 0, 0, 1, 0);
+		handle_spent_demands(self->status);
+
+		for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+			struct admitted_traffic *admitted;
+			uint16_t *sizes_out = sizes.buf;
+			uint16_t *src_out = src.buf;
+			uint16_t *dst_out = dst.buf;
+
+			fp_ring_dequeue(get_q_admitted_out(self->status),
+					(void **)&admitted);
+			if (num_racks > 0)
+				select_paths(admitted, num_racks);
+
+			sizes_out[b * ADMITTED_PER_BATCH + i] = admitted->size;
+			if (n + admitted->size > max_edges) {
+				/* keep allocating, so the allocator stays consistent */
+				overflow = true;
+			} else {
+				for (j = 0; j < admitted->size; j++) {
+					src_out[n + j] = admitted->edges[j].src;
+					dst_out[n + j] = admitted->edges[j].dst;
+				}
+				n += admitted->size;
+			}
+			fp_mempool_put(get_admitted_traffic_mempool(self->status),
+					admitted);
+		}
+	}
+	Py_END_ALLOW_THREADS
+
+	if (overflow) {
+		PyErr_SetString(PyExc_BufferError,
+				"src and dst too short for the admitted edges");
+		goto release_all;
+	}
+
+	PyBuffer_Release(&dst);
+	PyBuffer_Release(&src);
+	PyBuffer_Release(&sizes);
+	return PyLong_FromSsize_t(n);
+
+release_all:
+	PyBuffer_Release(&dst);
+release_src:
+	PyBuffer_Release(&src);
+release_sizes:
+	PyBuffer_Release(&sizes);
+	return NULL;
+}
+
+PyDoc_STRVAR(reset_doc,
+"reset()\n\n"
+"Clears all demands, keeping the allocator's parameters.");
+
+static PyObject *Allocator_reset(AllocatorObject *self, PyObject *unused)
+{
+	if (!check_initialized(self))
+		return NULL;
+	reset_admissible_state(self->status, self->oversubscribed,
+			self->inter_rack_capacity, self->out_of_boundary_capacity,
+			self->num_nodes);
+	Py_RETURN_NONE;
+}
+
+static PyMethodDef Allocator_methods[] = {
+	{"add_backlog", (PyCFunction)Allocator_add_backlog,
+			METH_VARARGS | METH_KEYWORDS, add_backlog_doc},
+	{"allocate", (PyCFunction)Allocator_allocate,
+			METH_VARARGS | METH_KEYWORDS, allocate_doc},
+	{"reset", (PyCFunction)Allocator_reset, METH_NOARGS, reset_doc},
+	{NULL}
+};
+
+static PyTypeObject AllocatorType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "fpbulk.Allocator",
+	.tp_doc = PyDoc_STR("Allocator(num_nodes, oversubscribed=False, "
+			"inter_rack_capacity=0, out_of_boundary_capacity=0)\n\n"
+			"The pipelined timeslot allocator, with bulk input and output."),
+	.tp_basicsize = sizeof(AllocatorObject),
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_new = PyType_GenericNew,
+	.tp_init = (initproc)Allocator_init,
+	.tp_dealloc = (destructor)Allocator_dealloc,
+	.tp_methods = Allocator_methods,
+};
+
+PyDoc_STRVAR(generate_requests_doc,
+"generate_requests(src, dst, backlog, time, num_nodes, duration, fraction,\n"
+"                  mean, seed=1) -> int\n\n"
+"Generates requests with Poisson arrivals and geometric sizes, like\n"
+"generate_requests_poisson(), into the uint16 buffers src, dst and backlog\n"
+"and the uint32 buffer time, until duration or the buffers are full.\n"
+"Returns the number of requests.");
+
+static PyObject *fpbulk_generate_requests(PyObject *module, PyObject *args,
+		PyObject *kwds)
+{
+	static char *kwlist[] = {"src", "dst", "backlog", "time", "num_nodes",
+			"duration", "fraction", "mean", "seed", NULL};
+	PyObject *objs[4];
+	Py_buffer views[4];
+	const Py_ssize_t itemsizes[4] = {2, 2, 2, 4};
+	const char *names[4] = {"src", "dst", "backlog", "time"};
+	unsigned int num_nodes, duration;
+	double fraction, mean;
+	unsigned long long seed = 1;
+	struct batch_request_generator *gen;
+	struct request_batch *batch;
+	Py_ssize_t size, n = 0;
+	uint32_t i;
+	int k, got = 0;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOOOIIdd|K", kwlist,
+			&objs[0], &objs[1], &objs[2], &objs[3], &num_nodes, &duration,
+			&fraction, &mean, &seed))
+		return NULL;
+	if (num_nodes < 2 || num_nodes > MAX_NODES || fraction <= 0 || mean < 1) {
+		PyErr_SetString(PyExc_ValueError, "bad generator parameters");
+		return NULL;
+	}
+
+	for (got = 0; got < 4; got++)
+		if (get_buffer(objs[got], &views[got], itemsizes[got], true,
+				names[got]) != 0)
+			goto release;
+	size = n_elems(&views[0]);
+	for (k = 1; k < 4; k++) {
+		if (n_elems(&views[k]) != size) {
+			PyErr_SetString(PyExc_ValueError,
+					"src, dst, backlog and time must have the same length");
+			goto release;
+		}
+	}
+
+	gen = malloc(sizeof(*gen));
+	batch = malloc(sizeof(*batch));
+	if (gen == NULL || batch == NULL) {
+		free(gen);
+		free(batch);
+		PyErr_NoMemory();
+		goto release;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	batch_gen_init(gen, seed, mean / fraction, 0, num_nodes, mean);
+	while (n < size) {
+		batch_gen_fill(gen, batch, REQ_BATCH_SIZE);
+		for (i = 0; i < batch->n && n < size; i++, n++) {
+			if (batch->time[i] >= duration)
+				goto done;
+			((uint16_t *)views[0].buf)[n] = batch->src[i];
+			((uint16_t *)views[1].buf)[n] = batch->dst[i];
+			((uint16_t *)views[2].buf)[n] = batch->backlog[i];
+			((uint32_t *)views[3].buf)[n] = (uint32_t)batch->time[i];
+		}
+	}
+done:
+	Py_END_ALLOW_THREADS
+
+	free(batch);
+	free(gen);
+	for (k = 0; k < 4; k++)
+		PyBuffer_Release(&views[k]);
+	return PyLong_FromSsize_t(n);
+
+release:
+	for (k = 0; k < got; k++)
+		PyBuffer_Release(&views[k]);
+	return NULL;
+}
+
+static PyMethodDef fpbulk_methods[] = {
+	{"generate_requests", (PyCFunction)fpbulk_generate_requests,
+			METH_VARARGS | METH_KEYWORDS, generate_requests_doc},
+	{NULL}
+};
+
+static struct PyModuleDef fpbulk_module = {
+	PyModuleDef_HEAD_INIT,
+	.m_name = "fpbulk",
+	.m_doc = "Bulk interface to the timeslot allocator.",
+	.m_size = -1,
+	.m_methods = fpbulk_methods,
+};
+
+PyMODINIT_FUNC PyInit_fpbulk(void)
+{
+	PyObject *m;
+
+	if (PyType_Ready(&AllocatorType) < 0)
+		return NULL;
+
+	m = PyModule_Create(&fpbulk_module);
+	if (m == NULL)
+		return NULL;
+
+	Py_INCREF(&AllocatorType);
+	if (PyModule_AddObject(m, "Allocator", (PyObject *)&AllocatorType) < 0) {
+		Py_DECREF(&AllocatorType);
+		Py_DECREF(m);
+		return NULL;
+	}
+	PyModule_AddIntConstant(m, "BATCH_SIZE", BATCH_SIZE);
+	PyModule_AddIntConstant(m, "MAX_NODES", MAX_NODES);
+	PyModule_AddIntConstant(m, "PATH_SHIFT", PATH_SHIFT);
+	PyModule_AddIntConstant(m, "PATH_MASK", PATH_MASK);
+	return m;
+}
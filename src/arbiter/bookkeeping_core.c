@@ -0,0 +1,27 @@
+
+#include "bookkeeping_core.h"
+
+int exec_bookkeeping_core(void *void_cmd_p)
+{
+	struct bookkeeping_core_cmd *cmd = (struct bookkeeping_core_cmd *)void_cmd_p;
+	void *msgs[BOOKKEEPING_DEQUEUE_BURST];
+	int n, i;
+
+	while (1) {
+		/* add the comm core's new demands */
+		n = rte_ring_dequeue_burst(cmd->q_demands, &msgs[0],
+				BOOKKEEPING_DEQUEUE_BURST);
+		for (i = 0; i < n; i++)
+			demand_msg_apply(msgs[i]);
+
+		/* Process the spent demands, launching a new demand for demands where
+		 * backlog increased while the original demand was being allocated */
+		handle_spent_demands(g_admissible_status());
+
+		/* once caught up with the comm core, flush the partial bin to q_head
+		 * rather than wait for it to fill */
+		if (n < BOOKKEEPING_DEQUEUE_BURST)
+			flush_backlog(g_admissible_status());
+	}
+	return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * bookkeeping_core.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef BOOKKEEPING_CORE_H_
+#define BOOKKEEPING_CORE_H_
+
+#include <stdint.h>
+#include <rte_ring.h>
+#include "control.h"
+#include "comm_log.h"
+#include "admission_core.h"
+#include "demand_msg.h"
+#include "../graph-algo/admissible.h"
+
+/**
+ * The bookkeeping core owns the allocator's demand input: it adds backlog
+ *    for the demand increases the comm core receives, re-launches spent
+ *    demands whose backlog grew while they were being allocated, and flushes
+ *    new demands to q_head. The comm core only passes demand changes to it
+ *    over q_demands, so it is left with I/O and the protocol.
+ *
+ * Without a bookkeeping core (N_BOOKKEEPING_CORES == 0), the comm core does
+ *    the bookkeeping itself, as before.
+ */
+
+#define DEMAND_RING_SIZE				(64 * 1024)
+#define DEMAND_BUF_SIZE					256
+#define BOOKKEEPING_DEQUEUE_BURST		256
+
+/* Specifications for bookkeeping core thread */
+struct bookkeeping_core_cmd {
+	struct rte_ring *q_demands;
+};
+
+/**
+ * Demand changes made by a comm core, not yet passed to the bookkeeping core
+ */
+struct demand_buf {
+	struct rte_ring *q_demands;
+	uint32_t len;
+	void *msgs[DEMAND_BUF_SIZE];
+};
+
+int exec_bookkeeping_core(void *void_cmd_p);
+
+static inline void demand_msg_apply(void *msg)
+{
+	uint16_t src = demand_msg_src(msg);
+	uint16_t dst = demand_msg_dst(msg);
+	uint32_t amount = demand_msg_amount(msg);
+
+	switch (demand_msg_type(msg)) {
+	case DEMAND_MSG_NORMAL:
+		add_backlog(g_admissible_status(), src, dst, amount);
+		break;
+	case DEMAND_MSG_URGENT:
+		add_urgent_backlog(g_admissible_status(), src, dst, amount);
+		break;
+	case DEMAND_MSG_RESET_SENDER:
+		reset_sender(g_admissible_status(), src);
+		break;
+	}
+}
+
+static inline void demand_buf_init(struct demand_buf *buf,
+		struct rte_ring *q_demands)
+{
+	buf->q_demands = q_demands;
+	buf->len = 0;
+}
+
+/**
+ * Passes all buffered demand changes to the bookkeeping core
+ */
+static inline void demand_buf_send(struct demand_buf *buf)
+{
+	uint32_t sent = 0;
+
+	while (sent < buf->len) {
+		sent += rte_ring_enqueue_burst(buf->q_demands, &buf->msgs[sent],
+				buf->len - sent);
+		if (unlikely(sent < buf->len))
+			comm_log_demand_ring_full();
+	}
+	comm_log_sent_demand_msgs(buf->len);
+	buf->len = 0;
+}
+
+/**
+ * Records a demand change of the comm core
+ */
+static inline void demand_buf_add(struct demand_buf *buf, uint8_t type,
+		uint16_t src, uint16_t dst, uint32_t amount)
+{
+	void *msg = demand_msg_encode(type, src, dst, amount);
+
+	if (N_BOOKKEEPING_CORES == 0) {
+		demand_msg_apply(msg);
+		return;
+	}
+
+	buf->msgs[buf->len++] = msg;
+	if (unlikely(buf->len == DEMAND_BUF_SIZE)) {
+		comm_log_flushed_buffer_in_add_backlog();
+		demand_buf_send(buf);
+	}
+}
+
+/**
+ * Called once per comm core loop: hands the loop's demand changes to the
+ *    bookkeeping core, or does the bookkeeping in place if there is none
+ */
+static inline void demand_buf_flush(struct demand_buf *buf)
+{
+	if (N_BOOKKEEPING_CORES == 0) {
+		/* Process the spent demands, launching a new demand for demands where
+		 * backlog increased while the original demand was being allocated */
+		handle_spent_demands(g_admissible_status());
+
+		/* RX, retrans timers, and new traffic might push traffic into the
+		 * q_head buffer; flush it now. */
+		flush_backlog(g_admissible_status());
+		return;
+	}
+
+	if (buf->len > 0)
+		demand_buf_send(buf);
+}
+
+#endif /* BOOKKEEPING_CORE_H_ */
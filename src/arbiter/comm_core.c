@@ -265,6 +265,7 @@ static void handle_areq(void *param, u16 *dst_and_count, int n)
 	struct end_node_state *en = (struct end_node_state *)param;
 	struct comm_core_state *core = &ccore_state[rte_lcore_id()];
 	u16 dst, count;
+	bool urgent;
 	u32 demand;
 	u32 orig_demand;
 	u32 node_id = en - end_nodes;
@@ -276,6 +277,8 @@ static void handle_areq(void *param, u16 *dst_and_count, int n)
 	for (i = 0; i < n; i++) {
 		dst = rte_be_to_cpu_16(dst_and_count[2*i]);
 		count = rte_be_to_cpu_16(dst_and_count[2*i + 1]);
+		urgent = !!(dst & FASTPASS_AREQ_URGENT);
+		dst &= FASTPASS_AREQ_DST_MASK;
 		if (unlikely(!(dst < MAX_NODES))) {
 			comm_log_areq_invalid_dst(node_id, dst);
 			return;
@@ -287,7 +290,9 @@ static void handle_areq(void *param, u16 *dst_and_count, int n)
 		demand_diff = (s32)demand - (s32)orig_demand;
 		if (demand_diff > 0) {
 			comm_log_demand_increased(node_id, dst, orig_demand, demand, demand_diff);
-			add_backlog(g_admissible_status(), node_id, dst, demand_diff);
+			demand_buf_add(&core->demands,
+					urgent ? DEMAND_MSG_URGENT : DEMAND_MSG_NORMAL, node_id,
+					dst, demand_diff);
 			en->demands[dst] = demand;
 			num_increases++;
 		} else {
@@ -301,11 +306,12 @@ static void handle_areq(void *param, u16 *dst_and_count, int n)
 static void handle_reset(void *param)
 {
 	struct end_node_state *en = (struct end_node_state *)param;
+	struct comm_core_state *core = &ccore_state[rte_lcore_id()];
 	uint16_t node_id = en - end_nodes;
 
 	comm_log_handle_reset(node_id, en->conn.in_sync);
 
-	reset_sender(g_admissible_status(), node_id);
+	demand_buf_add(&core->demands, DEMAND_MSG_RESET_SENDER, node_id, 0, 0);
 	memset(&en->demands[0], 0, MAX_NODES * sizeof(uint32_t));
 	memset(en->alloc_to_dst, 0, sizeof(en->alloc_to_dst));
 	memset(en->acked_allocs, 0, sizeof(en->acked_allocs));
@@ -543,6 +549,14 @@ comm_rx(struct rte_mbuf *m, uint8_t portid)
 	req_src = fp_map_mac_to_id(mac_addr);
 	en = &end_nodes[req_src];
 
+	/* partitioned arbiters only serve their own sources: another arbiter
+	 * allocates this one, and serving it here too would double-book it */
+	if (unlikely(partition_count > 1 && dst_res_src_owner(req_src, NUM_NODES,
+			partition_count) != partition_index)) {
+		comm_log_rx_foreign_src_pkt(req_src);
+		goto cleanup;
+	}
+
 	/* copy most recent ethernet and IP addresses, for return packets */
 	ether_addr_copy(&eth_hdr->s_addr, &en->dst_ether);
 	en->dst_ip = ipv4_hdr->src_addr;
@@ -555,6 +569,14 @@ comm_rx(struct rte_mbuf *m, uint8_t portid)
 
 
 	if (req_src < MAX_NODES) {
+		/* after a takeover, the node's connection state is the old master's:
+		 * reset it, so the node re-requests its demand from us */
+		if (unlikely(arb_role_needs_resync(&ccore_state[rte_lcore_id()].role,
+				req_src))) {
+			comm_log_resynced_node(req_src);
+			fpproto_force_reset(&en->conn);
+			handle_reset(en);
+		}
 		fpproto_handle_rx_complete(&end_nodes[req_src].conn, req_pkt,
 				ip_total_len - 4 * (ipv4_hdr->version_ihl & 0xF),
 				ipv4_hdr->src_addr, ipv4_hdr->dst_addr);
@@ -620,21 +642,112 @@ static inline bool do_rx_burst(struct lcore_conf* qconf)
 	return saw_watchdog;
 }
 
-static inline void process_allocated_traffic(struct comm_core_state *core,
-		struct rte_ring *q_admitted)
+/**
+ * Groups the admitted edges in the batch by source, using a counting sort.
+ *    Edges of each source keep their batch order, so timeslots are ascending
+ *    within a partition.
+ * @return the number of distinct sources in the batch
+ */
+static inline uint32_t group_admitted_by_src(struct comm_core_state *core,
+		struct admitted_traffic **admitted, int n_admitted)
 {
-	int rc;
 	int i, j;
-	struct admitted_traffic* admitted[MAX_ADMITTED_PER_LOOP];
-        uint16_t partition;
-	uint64_t current_timeslot;
-	struct end_node_state *en;
-	struct fp_window *wnd;
 	uint16_t src;
+	uint32_t n_srcs = 0;
+	uint32_t pos;
+
+	memset(core->src_count, 0, sizeof(core->src_count));
+
+	/* count edges per source */
+	for (i = 0; i < n_admitted; i++)
+		for (j = 0; j < get_num_admitted(admitted[i]); j++)
+			core->src_count[admitted[i]->edges[j].src]++;
+
+	/* prefix sum */
+	pos = 0;
+	for (src = 0; src < MAX_NODES; src++) {
+		core->src_offset[src] = pos;
+		pos += core->src_count[src];
+		n_srcs += (core->src_count[src] != 0);
+	}
+	core->src_offset[MAX_NODES] = pos;
+
+	/* scatter (src_offset[src] ends up at the end of the source's edges) */
+	for (i = 0; i < n_admitted; i++) {
+		for (j = 0; j < get_num_admitted(admitted[i]); j++) {
+			src = admitted[i]->edges[j].src;
+			pos = core->src_offset[src]++;
+			core->grouped[pos].dst = admitted[i]->edges[j].dst;
+			core->grouped[pos].tslot_ind = i;
+		}
+	}
+
+	return n_srcs;
+}
+
+/**
+ * Adds the grouped allocations of a single source to its pending window
+ */
+static inline void add_src_allocs(struct comm_core_state *core, uint16_t src,
+		struct grouped_alloc *allocs, uint32_t n_allocs)
+{
+	struct end_node_state *en = &end_nodes[src];
+	struct fp_window *wnd = &en->pending;
+	uint64_t max_timeslot = 0;
+	uint64_t timeslot;
 	uint16_t dst;
+	uint32_t k;
 	u64 tslot;
 	int32_t gap;
 
+	for (k = 0; k < n_allocs; k++) {
+		timeslot = core->batch_tslots[allocs[k].tslot_ind];
+		max_timeslot = time_after64(timeslot, max_timeslot) ? timeslot : max_timeslot;
+	}
+
+	/* are there timeslots sliding out of the window? */
+	tslot = max_timeslot - FASTPASS_WND_LEN;
+	tslot = time_before64(wnd_head(wnd), tslot) ? wnd_head(wnd) : tslot;
+	while ((gap = wnd_at_or_before(wnd, tslot)) >= 0) {
+		tslot -= gap;
+		uint16_t thrown_alloc = en->allocs[wnd_pos(tslot)];
+		/* throw away that timeslot */
+		wnd_clear(wnd, tslot);
+
+		/* also log them */
+		comm_log_alloc_fell_off_window(tslot, max_timeslot, src,
+				thrown_alloc);
+	}
+
+	/* advance the window once for all of the source's allocations */
+	if (time_after64(max_timeslot, wnd_head(wnd)))
+		wnd_advance(wnd, max_timeslot - wnd_head(wnd));
+
+	/* add the allocations */
+	for (k = 0; k < n_allocs; k++) {
+		timeslot = core->batch_tslots[allocs[k].tslot_ind];
+		dst = allocs[k].dst;
+		wnd_mark(wnd, timeslot);
+		en->allocs[wnd_pos(timeslot)] = dst;
+		en->alloc_to_dst[dst % MAX_NODES]++;
+		trigger_report(en, &en->report_queue, dst % MAX_NODES);
+		/* trigger_report will make sure a TX is triggerred */
+	}
+	en->total_alloc += n_allocs;
+}
+
+static inline void process_allocated_traffic(struct comm_core_state *core,
+		struct rte_ring *q_admitted)
+{
+	int rc;
+	int i;
+	struct admitted_traffic* admitted[MAX_ADMITTED_PER_LOOP];
+	uint16_t partition;
+	uint16_t src;
+	uint32_t begin;
+	uint32_t n_srcs;
+	uint64_t start_tsc;
+
 	/* Process newly allocated timeslots */
 	rc = rte_ring_dequeue_burst(q_admitted, (void **) &admitted[0],
 								MAX_ADMITTED_PER_LOOP);
@@ -644,56 +757,34 @@ static inline void process_allocated_traffic(struct comm_core_state *core,
 		return;
 	}
 
+	start_tsc = rte_get_tsc_cycles();
+
 	for (i = 0; i < rc; i++) {
-                partition = get_admitted_partition(admitted[i]);
-		current_timeslot = ++core->latest_timeslot[partition];
+		partition = get_admitted_partition(admitted[i]);
+		core->batch_tslots[i] = ++core->latest_timeslot[partition];
 		comm_log_got_admitted_tslot(get_num_admitted(admitted[i]),
-					    current_timeslot, partition);
-		for (j = 0; j < get_num_admitted(admitted[i]); j++) {
-			/* process this node's allocation */
+					    core->batch_tslots[i], partition);
+	}
+
 #if defined(EMULATION_ALGO)
-			/* TODO: implement this for emulation */
-			src = 0;
-			dst = 0;
+	/* TODO: implement this for emulation */
+	(void)src;(void)begin;(void)n_srcs;
 #else
-			src = admitted[i]->edges[j].src;
-			dst = admitted[i]->edges[j].dst;
-#endif
+	/* group edges by source, so each end node is touched once per batch */
+	n_srcs = group_admitted_by_src(core, admitted, rc);
 
-			/* get the node's structure */
-			en = &end_nodes[src];
-			wnd = &en->pending;
-
-			/* are there timeslots sliding out of the window? */
-			tslot = current_timeslot - FASTPASS_WND_LEN;
-			tslot = time_before64(wnd_head(wnd), tslot) ? wnd_head(wnd) : tslot;
-			while ((gap = wnd_at_or_before(wnd, tslot)) >= 0) {
-				tslot -= gap;
-				uint16_t thrown_alloc = en->allocs[wnd_pos(tslot)];
-				/* throw away that timeslot */
-				wnd_clear(wnd, tslot);
-
-				/* also log them */
-				comm_log_alloc_fell_off_window(tslot, current_timeslot, src,
-						thrown_alloc);
-			}
-
-			/* advance the window */
-			wnd_advance(wnd, current_timeslot - wnd_head(wnd));
-
-//			COMM_DEBUG("advanced window flow %lu. current %lu head %llu\n",
-//					en - end_nodes, current_timeslot, wnd_head(wnd));
+	begin = 0;
+	for (src = 0; src < MAX_NODES; src++) {
+		if (core->src_count[src] == 0)
+			continue;
+		add_src_allocs(core, src, &core->grouped[begin], core->src_count[src]);
+		begin += core->src_count[src];
+	}
 
-			/* add the allocation */
-			wnd_mark(wnd, current_timeslot);
-			en->allocs[wnd_pos(current_timeslot)] = dst;
-			en->alloc_to_dst[dst % MAX_NODES]++;
-			en->total_alloc++;
-			trigger_report(en, &en->report_queue, dst % MAX_NODES);
+	comm_log_processed_alloc_batch(begin, n_srcs,
+			rte_get_tsc_cycles() - start_tsc);
+#endif
 
-			/* trigger_report will make sure a TX is triggerred */
-		}
-	}
 	/* free memory */
 	rte_mempool_put_bulk(admitted_traffic_pool[0], (void **) admitted, rc);
 }
@@ -889,6 +980,10 @@ cleanup:
 	return retval;
 }
 
+/**
+ * Runs the standby: listens for the master's watchdogs, and returns once
+ *    they stopped for longer than WATCHDOG_TRIGGER_THRESHOLD_SEC
+ */
 void watchdog_loop(struct comm_core_cmd * cmd)
 {
 	const unsigned lcore_id = rte_lcore_id();
@@ -901,9 +996,9 @@ void watchdog_loop(struct comm_core_cmd * cmd)
 	uint8_t queueid;
 
     now = rte_get_timer_cycles();
-    core->last_rx_watchdog = now;
+    arb_role_saw_watchdog(&core->role, now);
 
-    while (core->last_rx_watchdog - now < WATCHDOG_TRIGGER_THRESHOLD_SEC * rte_get_timer_hz()) {
+    while (!arb_role_should_take_over(&core->role, now)) {
         now = rte_get_timer_cycles();
 
     	for (i = 0; i < qconf->n_rx_queue; ++i) {
@@ -914,7 +1009,7 @@ void watchdog_loop(struct comm_core_cmd * cmd)
     		/* Prefetch and handle already prefetched packets */
     		for (j = 0; j < nb_rx; j++) {
     			if (watchdog_rx(pkts_burst[j], portid) == true)
-    				core->last_rx_watchdog = rte_get_timer_cycles();
+    				arb_role_saw_watchdog(&core->role, rte_get_timer_cycles());
     		}
 
     		comm_log_processed_batch(nb_rx, now);
@@ -923,10 +1018,10 @@ void watchdog_loop(struct comm_core_cmd * cmd)
     	/* Still need to process newly allocated timeslots, which would be empty */
 		process_allocated_traffic(core, cmd->q_allocated);
 
-		/* send IGMP */
+		/* send IGMP, to keep receiving watchdogs. The controller IP is the
+		 * master's, so no gratuitous ARP until taking over */
 		if (now - core->last_igmp > IGMP_SEND_INTERVAL_SEC * rte_get_timer_hz()) {
 			core->last_igmp = now;
-			send_gratuitous_arp(portid, controller_ip());
 			send_igmp(portid, controller_ip());
 		}
 
@@ -938,6 +1033,29 @@ void watchdog_loop(struct comm_core_cmd * cmd)
     /* no watchdog too long - watchdog should fire! */
 }
 
+/**
+ * Takes over from a silent master: claims the controller IP, and marks all
+ *    connections to be reset on their next packet, so endpoints re-request
+ *    their demand from this arbiter.
+ */
+static void take_over(struct lcore_conf *qconf, struct comm_core_state *core)
+{
+	uint64_t now = rte_get_timer_cycles();
+	uint8_t portid;
+	int i;
+
+	comm_log_took_over(now - core->role.last_watchdog);
+	arb_role_take_over(&core->role, now);
+
+	for (i = 0; i < qconf->n_rx_queue; i++) {
+		portid = qconf->rx_queue_list[i].port_id;
+		send_gratuitous_arp(portid, controller_ip());
+		send_igmp(portid, controller_ip());
+	}
+	core->last_igmp = now;
+	core->last_tx_watchdog = now;
+}
+
 void exec_comm_core(struct comm_core_cmd * cmd)
 {
 	int i;
@@ -957,6 +1075,7 @@ void exec_comm_core(struct comm_core_cmd * cmd)
 	qconf = &lcore_conf[lcore_id];
 
 	comm_log_init(&comm_core_logs[lcore_id]);
+	demand_buf_init(&core->demands, cmd->q_demands);
 
 	if (qconf->n_rx_queue == 0) {
 		RTE_LOG(INFO, BENCHAPP, "lcore %u has nothing to do\n", rte_lcore_id());
@@ -970,28 +1089,35 @@ void exec_comm_core(struct comm_core_cmd * cmd)
 		queueid = qconf->rx_queue_list[i].queue_id;
 		RTE_LOG(INFO, BENCHAPP, "comm_core -- lcoreid=%u portid=%hhu rxqueueid=%hhu\n",
 				rte_lcore_id(), portid, queueid);
-		send_gratuitous_arp(portid, controller_ip());
+		if (start_as_master)
+			send_gratuitous_arp(portid, controller_ip());
 	}
 
 	while (rte_get_timer_cycles() < cmd->start_time);
 
 	for (i = 0; i < qconf->n_rx_queue; i++) {
 		portid = qconf->rx_queue_list[i].port_id;
-		send_gratuitous_arp(portid, controller_ip());
+		if (start_as_master)
+			send_gratuitous_arp(portid, controller_ip());
 		send_igmp(portid, controller_ip());
 	}
 
 	fp_init_timers(&core->timeout_timers, rte_get_timer_cycles());
 	fp_init_timers(&core->tx_timers, rte_get_timer_cycles());
 
+	arb_role_init(&core->role, start_as_master, rte_get_timer_cycles(),
+			WATCHDOG_TRIGGER_THRESHOLD_SEC * rte_get_timer_hz());
+	if (!arb_role_is_master(&core->role)) {
+		watchdog_loop(cmd);
+		take_over(qconf, core);
+	}
+
 	/* MAIN LOOP */
 	while (1) {
 		/* read packets from RX queues */
 		saw_watchdog = do_rx_burst(qconf);
-		if (saw_watchdog && !I_AM_MASTER) {
-			watchdog_loop(cmd);
-			continue;
-		}
+		if (unlikely(saw_watchdog))
+			comm_log_watchdog_while_master();
 
 		/* process retrans timers */
 		now = rte_get_timer_cycles();
@@ -1010,13 +1136,8 @@ void exec_comm_core(struct comm_core_cmd * cmd)
 		/* Process newly allocated timeslots */
 		process_allocated_traffic(core, cmd->q_allocated);
 
-		/* Process the spent demands, launching a new demand for demands where
-		 * backlog increased while the original demand was being allocated */
-		handle_spent_demands(g_admissible_status());
-
-		/* RX, retrans timers, and new traffic might push traffic into the
-		 * q_head buffer; flush it now. */
-		flush_backlog(g_admissible_status());
+		/* pass new demands to the bookkeeping core */
+		demand_buf_flush(&core->demands);
 
 		/* process tx timers */
 		fp_timer_get_expired(&core->tx_timers, now, &lst);
@@ -5,9 +5,11 @@
 #include <stdint.h>
 #include <rte_ip.h>
 #include "../grant-accept/partitioning.h"
+#include "../protocol/arbiter_role.h"
 #include "../protocol/fpproto.h"
 #include "../protocol/stat_print.h"
 #include "../protocol/topology.h"
+#include "bookkeeping_core.h"
 #include "fp_timer.h"
 #include "main.h"
 #include "watchdog.h"
@@ -45,23 +47,48 @@ struct comm_core_cmd {
 	uint32_t tslot_offset; /**< How many offsets in the future the controller allocates */
 
 	struct rte_ring *q_allocated;
+	struct rte_ring *q_demands;
+};
+
+/**
+ * An admitted edge after grouping by source
+ * @dst: the destination of the allocation
+ * @tslot_ind: index of the timeslot in the batch being processed
+ */
+struct grouped_alloc {
+	uint16_t dst;
+	uint16_t tslot_ind;
 };
 
 /*
  * Per-comm-core state
  * @alloc_enc_space: space used to encode ALLOCs, set to zeros when not inside
  *    the ALLOC code.
+ * @src_count: number of admitted edges per source in the current batch
+ * @src_offset: start of each source's edges in @grouped
+ * @grouped: admitted edges of the current batch, grouped by source
+ * @batch_tslots: the timeslot of each admitted_traffic in the current batch
+ * @demands: demand changes not yet passed to the bookkeeping core
+ * @role: master or standby, and the nodes to resync after a takeover
  */
 struct comm_core_state {
 	uint8_t alloc_enc_space[MAX_NODES * MAX_PATHS];
 	uint64_t latest_timeslot[N_PARTITIONS];
 
+	uint16_t src_count[MAX_NODES];
+	uint32_t src_offset[MAX_NODES + 1];
+	struct grouped_alloc grouped[MAX_ADMITTED_PER_LOOP * MAX_NODES];
+	uint64_t batch_tslots[MAX_ADMITTED_PER_LOOP];
+
+	struct demand_buf demands;
+
 	struct fp_timers timeout_timers;
 	struct fp_timers tx_timers;
 
-	uint64_t last_rx_watchdog;
 	uint64_t last_tx_watchdog;
 	uint64_t last_igmp;
+
+	struct fp_arb_role role;
 };
 extern struct comm_core_state ccore_state[RTE_MAX_LCORE];
 
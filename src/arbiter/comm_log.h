@@ -29,6 +29,7 @@ struct comm_log {
 	uint64_t rx_non_ipv4_pkts;
 	uint64_t rx_ipv4_non_fastpss_pkts;
 	uint64_t rx_watchdog_pkts;
+	uint64_t rx_foreign_src_pkts;
 	uint64_t tx_watchdog_pkts;
 	uint64_t tx_pkt;
 	uint64_t tx_bytes;
@@ -43,6 +44,10 @@ struct comm_log {
 	uint64_t non_empty_tslots;
 	uint64_t occupied_node_tslots;
 	uint64_t alloc_fell_off_window;
+	uint64_t alloc_batches;
+	uint64_t alloc_batch_edges;
+	uint64_t alloc_batch_srcs;
+	uint64_t alloc_batch_cycles;
 	uint64_t handle_reset;
 	uint64_t timer_cancel;
 	uint64_t timer_set;
@@ -53,6 +58,8 @@ struct comm_log {
 	uint64_t neg_ack_timeslots;
 	uint64_t error_encoding_packet;
 	uint64_t flush_buffer_in_add_backlog;
+	uint64_t demand_msgs_sent;
+	uint64_t demand_ring_full;
 	uint64_t neg_ack_triggered_reports;
 	uint64_t reports_triggered;
 	uint64_t total_demand;
@@ -62,6 +69,9 @@ struct comm_log {
 	uint64_t dropped_rx_due_to_deadline;
 	uint64_t failed_to_allocate_watchdog;
 	uint64_t failed_to_burst_watchdog;
+	uint64_t watchdog_while_master;
+	uint64_t takeovers;
+	uint64_t resynced_nodes;
         double mean_t_btwn_requests; /* used only in stress test */
         uint64_t stress_test_mode; /* used only in stress test */
         uint64_t stress_test_max_node_tslots; /* used only in stress test */
@@ -135,6 +145,12 @@ static inline void comm_log_rx_ip_non_fastpass_pkt(uint8_t portid) {
 	COMM_DEBUG("got an IPv4 non-fastpass packet on portid %d\n", portid);
 }
 
+static inline void comm_log_rx_foreign_src_pkt(uint16_t node_id) {
+	(void)node_id;
+	CL->rx_foreign_src_pkts++;
+	COMM_DEBUG("dropped packet from node %d of another partition\n", node_id);
+}
+
 static inline void comm_log_tx_pkt(uint32_t node_id, uint64_t when,
 		uint32_t n_bytes) {
 	(void)node_id;
@@ -222,6 +238,16 @@ static inline void comm_log_alloc_fell_off_window(uint64_t thrown_tslot,
 			thrown_tslot, src, thrown_alloc, current_timeslot);
 }
 
+static inline void comm_log_processed_alloc_batch(uint32_t n_edges,
+		uint32_t n_srcs, uint64_t cycles) {
+	if (n_edges == 0)
+		return;
+	CL->alloc_batches++;
+	CL->alloc_batch_edges += n_edges;
+	CL->alloc_batch_srcs += n_srcs;
+	CL->alloc_batch_cycles += cycles;
+}
+
 static inline void comm_log_handle_reset(uint16_t node_id, int in_sync) {
 	(void)node_id;(void)in_sync;
 	CL->handle_reset++;
@@ -294,6 +320,14 @@ static inline void comm_log_flushed_buffer_in_add_backlog() {
 	CL->flush_buffer_in_add_backlog++;
 }
 
+static inline void comm_log_sent_demand_msgs(uint32_t n) {
+	CL->demand_msgs_sent += n;
+}
+
+static inline void comm_log_demand_ring_full() {
+	CL->demand_ring_full++;
+}
+
 static inline void comm_log_dropped_rx_passed_deadline() {
 	CL->dropped_rx_due_to_deadline++;
 }
@@ -306,6 +340,22 @@ static inline void comm_log_failed_to_burst_watchdog() {
 	CL->failed_to_burst_watchdog++;
 }
 
+static inline void comm_log_watchdog_while_master() {
+	CL->watchdog_while_master++;
+}
+
+static inline void comm_log_took_over(uint64_t silence) {
+	CL->takeovers++;
+	RTE_LOG(INFO, COMM, "core %d taking over as master, after %lu cycles without watchdog\n",
+			rte_lcore_id(), silence);
+}
+
+static inline void comm_log_resynced_node(uint16_t node_id) {
+	(void)node_id;
+	CL->resynced_nodes++;
+	COMM_DEBUG("resetting connection of node %d after takeover\n", node_id);
+}
+
 static inline void comm_log_sent_watchdog() {
 	CL->tx_watchdog_pkts++;
 }
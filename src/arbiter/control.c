@@ -9,6 +9,7 @@
 #include "admission_core.h"
 #include "admission_core_common.h"
 #include "path_sel_core.h"
+#include "bookkeeping_core.h"
 #include "log_core.h"
 #include "stress_test_core.h"
 
@@ -21,9 +22,11 @@ int control_do_queue_allocation(void)
 		return 0;
 	}
 
-	if(n_enabled_lcore < N_ADMISSION_CORES + N_COMM_CORES + N_LOG_CORES + N_PATH_SEL_CORES) {
-		rte_exit(EXIT_FAILURE, "Need #alloc + #comm + #log + #path_sel cores (need %d, got %d)\n",
-				N_ADMISSION_CORES + N_COMM_CORES + N_LOG_CORES + N_PATH_SEL_CORES,
+	if(n_enabled_lcore < N_ADMISSION_CORES + N_COMM_CORES + N_LOG_CORES
+			+ N_PATH_SEL_CORES + N_BOOKKEEPING_CORES) {
+		rte_exit(EXIT_FAILURE, "Need #alloc + #comm + #log + #path_sel + #bookkeeping cores (need %d, got %d)\n",
+				N_ADMISSION_CORES + N_COMM_CORES + N_LOG_CORES
+				+ N_PATH_SEL_CORES + N_BOOKKEEPING_CORES,
 				n_enabled_lcore);
 	}
 
@@ -54,7 +57,7 @@ int control_do_queue_allocation(void)
 
 void launch_comm_cores(uint64_t start_time, uint64_t end_time,
 		uint64_t first_time_slot, struct rte_ring* q_path_selected,
-		struct rte_ring* q_admitted)
+		struct rte_ring* q_admitted, struct rte_ring* q_demands)
 {
 	struct comm_core_cmd comm_cmd;
 
@@ -63,6 +66,7 @@ void launch_comm_cores(uint64_t start_time, uint64_t end_time,
 	comm_cmd.end_time = end_time;
 	comm_cmd.q_allocated =
 			((N_PATH_SEL_CORES > 0) ? q_path_selected : q_admitted);
+	comm_cmd.q_demands = q_demands;
 
 	/* initialize comm core on this core */
 	comm_init_core(rte_lcore_id(), first_time_slot);
@@ -74,7 +78,7 @@ void launch_comm_cores(uint64_t start_time, uint64_t end_time,
 void launch_stress_test_cores(uint64_t start_time,
 		uint64_t end_time, uint64_t first_time_slot,
 		struct rte_ring* q_path_selected,
-		struct rte_ring* q_admitted)
+		struct rte_ring* q_admitted, struct rte_ring* q_demands)
 {
 	struct stress_test_core_cmd cmd;
 	uint64_t hz = rte_get_timer_hz();
@@ -90,7 +94,7 @@ void launch_stress_test_cores(uint64_t start_time,
 	cmd.initial_flow_size = STRESS_TEST_INITIAL_FLOW_SIZE;
 	cmd.q_allocated =
 			((N_PATH_SEL_CORES > 0) ? q_path_selected : q_admitted);
-
+	cmd.q_demands = q_demands;
 
 	/** Run the controller on this core */
 	exec_stress_test_core(&cmd, first_time_slot);
@@ -111,17 +115,22 @@ void launch_cores(void)
 	int i; (void)i;
 	struct admission_core_cmd admission_cmd[N_ADMISSION_CORES];
 	struct path_sel_core_cmd path_sel_cmd;
+	struct bookkeeping_core_cmd bookkeeping_cmd;
 	struct log_core_cmd log_cmd;
 	uint64_t first_time_slot;
 	uint64_t now;
 	struct rte_ring *q_admitted;
 	struct rte_ring *q_path_selected;
+	struct rte_ring *q_demands;
 
 	benchmark_cost_of_get_time();
 
 	/* decide what the first time slot to be output is */
 	now = fp_get_time_ns();
 	first_time_slot = ((now + INIT_MAX_TIME_NS) * TIMESLOT_MUL) >> TIMESLOT_SHIFT;
+	/* partitioned arbiters must agree on where batches start */
+	if (partition_count > 1)
+		first_time_slot = (first_time_slot + BATCH_SIZE - 1) & ~(BATCH_SIZE - 1ULL);
 	CONTROL_INFO("now %lu first time slot will be %lu\n", now, first_time_slot);
 
 	/*** LOGGING OUTPUT ***/
@@ -147,6 +156,13 @@ void launch_cores(void)
 		rte_exit(EXIT_FAILURE,
 				"Cannot init q_path_selected: %s\n", rte_strerror(rte_errno));
 
+	/* create q_demands, from the comm core to the bookkeeping core */
+	q_demands = rte_ring_create("q_demands", DEMAND_RING_SIZE, 0,
+			RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (q_demands == NULL)
+		rte_exit(EXIT_FAILURE,
+				"Cannot init q_demands: %s\n", rte_strerror(rte_errno));
+
 	/* initialize admission core global data */
 	admission_init_global(q_admitted);
 
@@ -184,6 +200,14 @@ void launch_cores(void)
 		rte_eal_remote_launch(exec_admission_core, &admission_cmd[i], lcore_id);
 	}
 
+	/*** BOOKKEEPING CORE ***/
+	bookkeeping_cmd.q_demands = q_demands;
+
+	/* launch bookkeeping core */
+	if (N_BOOKKEEPING_CORES > 0)
+		rte_eal_remote_launch(exec_bookkeeping_core, &bookkeeping_cmd,
+				enabled_lcore[FIRST_BOOKKEEPING_CORE]);
+
 	/*** LOG CORE ***/
 	log_cmd.log_gap_ticks = (uint64_t)(LOG_GAP_SECS * rte_get_timer_hz());
 	log_cmd.start_time = start_time;
@@ -198,10 +222,11 @@ void launch_cores(void)
 	if (IS_STRESS_TEST) {
 		launch_stress_test_cores(start_time + STRESS_TEST_START_GAP_SEC * rte_get_timer_hz(),
                                          end_time + STRESS_TEST_START_GAP_SEC * rte_get_timer_hz(),
-                                         first_time_slot, q_path_selected, q_admitted);
+                                         first_time_slot, q_path_selected, q_admitted,
+                                         q_demands);
 	} else {
 		launch_comm_cores(start_time, end_time, first_time_slot, q_path_selected,
-				q_admitted);
+				q_admitted, q_demands);
 	}
 
 	printf("waiting for all cores..\n");
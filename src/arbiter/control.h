@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include "../graph-algo/algo_config.h"
 
+/* role when neither --master nor --standby is given */
 #define I_AM_MASTER				1
 #define IS_STRESS_TEST			1
 #define IS_AUTOMATED_STRESS_TEST        1
@@ -43,12 +44,14 @@
 #define N_PATH_SEL_CORES		0
 #define N_COMM_CORES			1
 #define N_LOG_CORES				1
+#define N_BOOKKEEPING_CORES		1
 
 /* Core indices */
 #define FIRST_COMM_CORE			0
 #define FIRST_ADMISSION_CORE	(FIRST_COMM_CORE + N_COMM_CORES)
 #define FIRST_PATH_SEL_CORE		(FIRST_ADMISSION_CORE + N_ADMISSION_CORES)
-#define FIRST_LOG_CORE			(FIRST_PATH_SEL_CORE + N_PATH_SEL_CORES)
+#define FIRST_BOOKKEEPING_CORE	(FIRST_PATH_SEL_CORE + N_PATH_SEL_CORES)
+#define FIRST_LOG_CORE			(FIRST_BOOKKEEPING_CORE + N_BOOKKEEPING_CORES)
 
 
 #define NUM_RACKS				1
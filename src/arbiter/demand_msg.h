@@ -0,0 +1,54 @@
+/*
+ * demand_msg.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DEMAND_MSG_H_
+#define DEMAND_MSG_H_
+
+#include <stdint.h>
+
+/**
+ * A demand change a comm core passes to the bookkeeping core over q_demands
+ *    (see bookkeeping_core.h), packed into the ring's pointer so nothing is
+ *    allocated: src in bits 0-15, dst in 16-31, amount in 32-61 and the type
+ *    in 62-63. Kept free of DPDK so benchmarks can build it.
+ */
+
+/* demand changes passed to the bookkeeping core */
+enum {
+	DEMAND_MSG_NORMAL,
+	DEMAND_MSG_URGENT,
+	DEMAND_MSG_RESET_SENDER,
+};
+
+static inline void *demand_msg_encode(uint8_t type, uint16_t src, uint16_t dst,
+		uint32_t amount)
+{
+	return (void *)(((uintptr_t)type << 62)
+			| ((uintptr_t)(amount & 0x3FFFFFFF) << 32)
+			| ((uintptr_t)dst << 16) | src);
+}
+
+static inline uint8_t demand_msg_type(void *msg)
+{
+	return (uintptr_t)msg >> 62;
+}
+
+static inline uint16_t demand_msg_src(void *msg)
+{
+	return (uintptr_t)msg & 0xFFFF;
+}
+
+static inline uint16_t demand_msg_dst(void *msg)
+{
+	return ((uintptr_t)msg >> 16) & 0xFFFF;
+}
+
+static inline uint32_t demand_msg_amount(void *msg)
+{
+	return ((uintptr_t)msg >> 32) & 0x3FFFFFFF;
+}
+
+#endif /* DEMAND_MSG_H_ */
@@ -57,20 +57,27 @@ void print_comm_log(uint16_t lcore_id)
 	printf("\n  %lu total demand from %lu demand increases %lu demand remained, %lu neg-ack with alloc, %lu demands",
 			D(total_demand), D(demand_increased), D(demand_remained), D(neg_acks_with_alloc),
 			D(neg_ack_timeslots));
+	if (N_BOOKKEEPING_CORES > 0)
+		printf("\n  %lu demand changes passed to bookkeeping", D(demand_msgs_sent));
 	printf("\n  %lu informative acks for %lu allocations, %lu non-informative",
 			D(acks_with_alloc), D(total_acked_timeslots), D(acks_without_alloc));
 	printf("\n  processed %lu tslots (%lu non-empty ptn) with %lu node-tslots, diff: %ld",
                D(processed_tslots), D(non_empty_tslots), D(occupied_node_tslots), D(total_demand) - D(occupied_node_tslots));
 	printf("\n  TX %lu pkts, %lu bytes, %lu triggers, %lu report-triggers",
 			D(tx_pkt), D(tx_bytes), D(triggered_send), D(reports_triggered));
+	if (D(alloc_batch_edges))
+		printf("\n  alloc batches %lu with %lu edges from %lu srcs, %.1f cycles per edge",
+				D(alloc_batches), D(alloc_batch_edges), D(alloc_batch_srcs),
+				(double)D(alloc_batch_cycles) / D(alloc_batch_edges));
 #undef D
 	printf("\n");
 
 	printf("\n  RX %lu pkts, %lu bytes in %lu batches (%lu non-empty batches), %lu dropped",
 			cl->rx_pkts, cl->rx_bytes, cl->rx_batches, cl->rx_non_empty_batches,
 			cl->dropped_rx_due_to_deadline);
-	printf("\n  %lu watchdog, %lu non-IPv4, %lu IPv4 non-fastpass",
-			cl->rx_watchdog_pkts, cl->rx_non_ipv4_pkts, cl->rx_ipv4_non_fastpss_pkts);
+	printf("\n  %lu watchdog, %lu non-IPv4, %lu IPv4 non-fastpass, %lu from other partitions",
+			cl->rx_watchdog_pkts, cl->rx_non_ipv4_pkts, cl->rx_ipv4_non_fastpss_pkts,
+			cl->rx_foreign_src_pkts);
 	printf("\n  %lu total demand from %lu demand increases, %lu demand remained",
 			cl->total_demand, cl->demand_increased, cl->demand_remained);
 	printf("\n  %lu informative acks for %lu allocations, %lu non-informative",
@@ -88,6 +95,9 @@ void print_comm_log(uint16_t lcore_id)
 			cl->neg_acks_without_alloc, cl->neg_acks_with_alloc,
 			cl->neg_ack_timeslots, cl->neg_ack_destinations);
 
+	if (cl->takeovers)
+		printf("\n  took over as master %lu times, resynced %lu nodes",
+				cl->takeovers, cl->resynced_nodes);
 	printf("\n errors:");
 	if (cl->tx_cannot_alloc_mbuf)
 		printf("\n  %lu failures to allocate mbuf", cl->tx_cannot_alloc_mbuf);
@@ -109,11 +119,16 @@ void print_comm_log(uint16_t lcore_id)
 				cl->failed_to_burst_watchdog);
 
 	printf("\n warnings:");
+	if (cl->watchdog_while_master)
+		printf("\n  %lu watchdogs from another master", cl->watchdog_while_master);
 	if (cl->alloc_fell_off_window)
 		printf("\n  %lu alloc fell off window", cl->alloc_fell_off_window);
 	if (cl->flush_buffer_in_add_backlog)
 		printf("\n  %lu buffer flushes in add backlog (buffer might be too small)",
 				cl->flush_buffer_in_add_backlog);
+	if (cl->demand_ring_full)
+		printf("\n  %lu waits for space in q_demands (bookkeeping core lagging)",
+				cl->demand_ring_full);
 	printf("\n");
 
 	memcpy(&saved_comm_log, &comm_core_logs[lcore_id], sizeof(saved_comm_log));
@@ -150,6 +165,9 @@ void print_global_admission_log() {
 			st->backlog_flush_forced);
 	printf("\n    %lu spent bins (+%lu), %lu spent demands (+%lu)",
 			st->spent_bins, D(spent_bins), st->spent_demands, D(spent_demands));
+	printf("\n    %lu urgent adds (+%lu) totalling %lu timeslots (+%lu)",
+			st->added_urgent_backlog, D(added_urgent_backlog),
+			st->urgent_backlog_sum, D(urgent_backlog_sum));
 	printf("\n");
 #undef D
 
@@ -165,11 +183,11 @@ void print_admission_core_log(uint16_t lcore, uint16_t adm_core_index) {
 	struct admission_core_statistics *sv = &saved_admission_core_statistics[adm_core_index];
 
 #define D(X) (st->X - sv->X)
-	printf("admission lcore %d: %lu no_timeslot, %lu need more (avg %0.2f), %lu done",
+	printf("admission lcore %d: %lu no_timeslot, %lu need more (avg %0.2f), %lu done, %lu urgent in %lu urgent bins",
 			lcore, st->no_available_timeslots_for_bin_entry,
 			st->allocated_backlog_remaining,
 			(float)st->backlog_sum / (float)(st->allocated_backlog_remaining+1),
-			st->allocated_no_backlog);
+			st->allocated_no_backlog, st->allocated_urgent, st->urgent_bins);
 	printf("\n  %lu skipped %lu fail_alloc_admitted, %lu q_admitted_full. %lu bin_alloc_fail, %lu q_out_full, %lu q_spent_full, %lu wait_token",
 			al->batches_skipped,
 			st->admitted_traffic_alloc_failed, st->wait_for_space_in_q_admitted_out,
@@ -184,6 +202,15 @@ void print_admission_core_log(uint16_t lcore, uint16_t adm_core_index) {
 			st->passed_bins_during_run,
 			st->passed_bins_during_wrap_up,
 				st->wrap_up_non_empty_bin, st->wrap_up_non_empty_bin_demands);
+	printf("\n  %lu deadline infeasible (+%lu): %lu timeslots dropped (+%lu), %lu degraded (+%lu)",
+			st->deadline_infeasible, D(deadline_infeasible),
+			st->deadline_dropped_tslots, D(deadline_dropped_tslots),
+			st->deadline_degraded, D(deadline_degraded));
+	printf("\n  %lu batches over alloc budget (+%lu), carried %lu bins (+%lu)",
+			st->alloc_budget_exceeded, D(alloc_budget_exceeded),
+			st->alloc_budget_carried_bins, D(alloc_budget_carried_bins));
+	printf("\n  %lu destination timeslots taken by other arbiters (+%lu)",
+			st->dst_reservation_conflicts, D(dst_reservation_conflicts));
 	#ifdef PARALLEL_ALGO
 	printf("\n    %lu phases completed, %lu not ready, %lu out of order",
                st->phase_finished, st->phase_none_ready, st->phase_out_of_order);
@@ -181,6 +181,9 @@ static const struct rte_eth_txconf tx_conf = {
 static uint32_t enabled_port_mask = 0;
 static int promiscuous_on = 0; /**< Ports set in promiscuous mode off by default. */
 static int numa_on = 1; /**< NUMA is enabled by default. */
+uint8_t start_as_master = I_AM_MASTER; /**< --master / --standby */
+uint16_t partition_index = 0; /**< --partition index:count */
+uint16_t partition_count = 1;
 
 /* mbuf pool for RX packets */
 static struct rte_mempool* rx_pktmbuf_pool[NB_SOCKETS];
@@ -752,7 +755,11 @@ print_usage(const char *prgname)
 	printf ("%s [EAL options] -- -p PORTMASK -P"
 		"  [--config (port,queue,lcore)[,(port,queue,lcore]]\n"
 		"  -p PORTMASK: hexadecimal bitmask of ports to configure\n"
-		"  --no-numa: optional, disable numa awareness\n",
+		"  --no-numa: optional, disable numa awareness\n"
+		"  --master | --standby: optional, the arbiter's role at start\n"
+		"  --partition INDEX:COUNT: optional, allocate for the INDEX-th of COUNT\n"
+		"      arbiters that own the sources, sharing destinations on this host;\n"
+		"      packets from other arbiters' sources are dropped\n",
 		prgname);
 }
 
@@ -783,6 +790,9 @@ parse_args(int argc, char **argv)
 	char *prgname = argv[0];
 	static struct option lgopts[] = {
 		{"no-numa", 0, 0, 0},
+		{"master", 0, 0, 0},
+		{"standby", 0, 0, 0},
+		{"partition", 1, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -812,6 +822,23 @@ parse_args(int argc, char **argv)
 				printf("numa is disabled \n");
 				numa_on = 0;
 			}
+			if (!strcmp(lgopts[option_index].name, "master"))
+				start_as_master = 1;
+			if (!strcmp(lgopts[option_index].name, "standby")) {
+				printf("starting as standby\n");
+				start_as_master = 0;
+			}
+			if (!strcmp(lgopts[option_index].name, "partition")) {
+				if (sscanf(optarg, "%hu:%hu", &partition_index,
+						&partition_count) != 2 || partition_count == 0 ||
+						partition_index >= partition_count) {
+					printf("invalid partition\n");
+					print_usage(prgname);
+					return -1;
+				}
+				printf("allocating partition %hu of %hu\n", partition_index,
+						partition_count);
+			}
 			break;
 
 		default:
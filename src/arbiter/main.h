@@ -90,6 +90,11 @@ extern uint8_t enabled_lcore[RTE_MAX_LCORE];
 extern uint8_t n_enabled_port;
 // The port index of each enabled port
 extern uint8_t enabled_port[MAX_PORTS];
+// Whether the arbiter starts as master (or as standby)
+extern uint8_t start_as_master;
+// This arbiter's share of the sources, when several arbiters partition them
+extern uint16_t partition_index;
+extern uint16_t partition_count;
 
 /* Immediately sends given packet */
 static inline int
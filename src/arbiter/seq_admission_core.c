@@ -28,10 +28,15 @@ struct rte_ring *q_bin[2 * N_ADMISSION_CORES];
 #define NSEC_PER_SEC (1000*1000*1000)
 #endif
 
+/* fraction of a core's time per batch that may be spent allocating. bins left
+ * when it runs out are carried over, so the batch still admits what it has */
+#define ALLOC_BUDGET_FRACTION		0.75
+
 void seq_admission_init_global(struct rte_ring *q_admitted_out)
 {
 	int i;
 	char s[64];
+	double tslot_len_cycles;
 	struct rte_ring *q_head;
     struct fp_ring *q_spent;
 	struct rte_mempool *bin_mempool;
@@ -107,6 +112,20 @@ void seq_admission_init_global(struct rte_ring *q_admitted_out)
 				   NUM_NODES, q_head, q_admitted_out, q_spent, bin_mempool,
 				   admitted_traffic_pool[0], &q_bin[0]);
 
+	/* partitioned arbiters on this host share destinations */
+	if (partition_count > 1) {
+		struct dst_reservations *res = dst_res_attach(DST_RES_SHM_NAME);
+		if (res == NULL)
+			rte_exit(EXIT_FAILURE, "Cannot attach destination reservations\n");
+		seq_set_dst_reservations(&g_seq_admissible_status, res);
+	}
+
+	/* each core allocates one batch every N_ADMISSION_CORES batches */
+	tslot_len_cycles = ((double)(1 << TIMESLOT_SHIFT)) /
+			((double)TIMESLOT_MUL * NSEC_PER_SEC) * rte_get_timer_hz();
+	seq_set_alloc_budget(&g_seq_admissible_status,
+			(uint64_t)(ALLOC_BUDGET_FRACTION * BATCH_SIZE * N_ADMISSION_CORES
+					* tslot_len_cycles));
 }
 
 void seq_admission_init_core(uint16_t lcore_id)
@@ -152,6 +171,10 @@ int exec_seq_admission_core(void *void_cmd_p)
 		/* perform allocation */
 		admission_log_allocation_begin(logical_timeslot,
 				start_time_first_timeslot);
+		if (seq_set_batch_timeslot(&g_seq_admissible_status, core_ind,
+				logical_timeslot) != 0)
+			rte_exit(EXIT_FAILURE, "batch timeslot %lu is not aligned to "
+					"the batch size\n", logical_timeslot);
 		seq_get_admissible_traffic(&g_seq_admissible_status, core_ind,
 					   logical_timeslot + (rdtsc_tslot - real_tslot),
 					   rdtsc_mul, rdtsc_shift);
@@ -12,7 +12,7 @@
 #include "control.h"
 #include "main.h"
 #include "../graph-algo/admissible.h"
-#include "../graph-algo/generate_requests.h"
+#include "../graph-algo/generate_requests_batch.h"
 #include "admission_core.h"
 #include "admission_core_common.h"
 #include "../protocol/stat_print.h"
@@ -84,10 +84,10 @@ static void add_initial_requests(struct comm_core_state *core,
 	uint32_t i;
 	for (src = 0; src < num_srcs; src++)
 		for (i = 0; i < num_dsts_per_src; i++)
-			add_backlog(g_admissible_status(),
+			demand_buf_add(&core->demands, DEMAND_MSG_NORMAL,
 					src, (src + 1 + i) % num_srcs , flow_size);
 
-	flush_backlog(g_admissible_status());
+	demand_buf_flush(&core->demands);
 }
 
 void exec_stress_test_core(struct stress_test_core_cmd * cmd,
@@ -96,8 +96,9 @@ void exec_stress_test_core(struct stress_test_core_cmd * cmd,
 	int i;
 	const unsigned lcore_id = rte_lcore_id();
 	uint64_t now;
-	struct request_generator gen;
-	struct request next_request;
+	struct batch_request_generator gen;
+	struct request_batch batch;
+	uint32_t batch_pos;
 	struct comm_core_state *core = &ccore_state[lcore_id];
 	uint64_t min_next_iteration_time;
 	uint64_t loop_minimum_iteration_time =
@@ -115,6 +116,7 @@ void exec_stress_test_core(struct stress_test_core_cmd * cmd,
                 core->latest_timeslot[i] = first_time_slot - 1;
 	stress_test_log_init(&stress_test_core_logs[lcore_id]);
 	comm_log_init(&comm_core_logs[lcore_id]);
+	demand_buf_init(&core->demands, cmd->q_demands);
 
 	/* Add initial demands */
 	assert(cmd->num_initial_srcs <= cmd->num_nodes);
@@ -137,8 +139,10 @@ void exec_stress_test_core(struct stress_test_core_cmd * cmd,
 	now = rte_get_timer_cycles();
 	next_rate_increase_time = now;
 
-	init_request_generator(&gen, next_mean_t_btwn_requests,
-						now, cmd->num_nodes, cmd->demand_tslots);
+	batch_gen_init(&gen, rte_rdtsc(), next_mean_t_btwn_requests, now,
+			cmd->num_nodes, cmd->demand_tslots);
+	batch_gen_fill(&gen, &batch, REQ_BATCH_SIZE);
+	batch_pos = 0;
 
 	/* MAIN LOOP */
 	while (now < cmd->end_time) {
@@ -188,9 +192,9 @@ void exec_stress_test_core(struct stress_test_core_cmd * cmd,
                 if (re_init_gen) {
                         /* reinitialize the request generator */
                         comm_log_mean_t(next_mean_t_btwn_requests);
-			reinit_request_generator(&gen, next_mean_t_btwn_requests,
-					now, cmd->num_nodes, cmd->demand_tslots);
-			get_next_request(&gen, &next_request);
+			batch_gen_reinit(&gen, next_mean_t_btwn_requests, now);
+			batch_gen_fill(&gen, &batch, REQ_BATCH_SIZE);
+			batch_pos = 0;
 
 			next_rate_increase_time = rte_get_timer_cycles() +
 					rte_get_timer_hz() * STRESS_TEST_RATE_INCREASE_GAP_SEC;
@@ -201,19 +205,24 @@ void exec_stress_test_core(struct stress_test_core_cmd * cmd,
 
 		/* if time to enqueue request, do so now */
 		for (i = 0; i < MAX_ENQUEUES_PER_LOOP; i++) {
-			if (next_request.time > now)
+			if (batch.time[batch_pos] > now)
 				break;
 
 			/* enqueue the request */
-			add_backlog(g_admissible_status(),
-					next_request.src, next_request.dst, next_request.backlog);
-			comm_log_demand_increased(next_request.src, next_request.dst, 0,
-					next_request.backlog, next_request.backlog);
+			demand_buf_add(&core->demands, DEMAND_MSG_NORMAL,
+					batch.src[batch_pos], batch.dst[batch_pos],
+					batch.backlog[batch_pos]);
+			comm_log_demand_increased(batch.src[batch_pos],
+					batch.dst[batch_pos], 0, batch.backlog[batch_pos],
+					batch.backlog[batch_pos]);
 
 			n_processed_requests++;
 
-			/* generate the next request */
-			get_next_request(&gen, &next_request);
+			/* generate the next batch of requests when this one is used up */
+			if (++batch_pos == batch.n) {
+				batch_gen_fill(&gen, &batch, REQ_BATCH_SIZE);
+				batch_pos = 0;
+			}
 		}
 
 		comm_log_processed_batch(n_processed_requests, now);
@@ -221,12 +230,8 @@ void exec_stress_test_core(struct stress_test_core_cmd * cmd,
 		/* Process newly allocated timeslots */
 		process_allocated_traffic(core, cmd->q_allocated);
 
-		/* Process the spent demands, launching a new demand for demands where
-		 * backlog increased while the original demand was being allocated */
-		handle_spent_demands(g_admissible_status());
-
-		/* flush q_head's buffer into q_head */
-		flush_backlog(g_admissible_status());
+		/* pass new demands to the bookkeeping core */
+		demand_buf_flush(&core->demands);
 
 		/* wait until at least loop_minimum_iteration_time has passed from
 		 * beginning of loop */
@@ -28,6 +28,7 @@ struct stress_test_core_cmd {
 	uint32_t initial_flow_size;
 
 	struct rte_ring *q_allocated;
+	struct rte_ring *q_demands;
 };
 
 //struct stress_test_core_state {
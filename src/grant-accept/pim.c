@@ -101,10 +101,10 @@ void pim_add_backlog(struct pim_state *state, uint16_t src, uint16_t dst,
                              &state->stat) == false)
                 return; /* no need to enqueue */
 
-        /* add to state->new_demands for the src partition
-         * leave the 'metric' unused */
+        /* add to state->new_demands for the src partition, carrying the
+         * amount as the pipelined allocator does. leave the 'metric' unused */
         uint16_t partition_index = PARTITION_OF(src);
-        enqueue_bin(state->new_demands[partition_index], src, dst, 0);
+        enqueue_bin(state->new_demands[partition_index], src, dst, amount, 0);
 
         if (bin_size(state->new_demands[partition_index]) == SMALL_BIN_SIZE) {
                 adm_log_backlog_flush_bin_full(&state->stat);
@@ -129,6 +129,7 @@ void process_incoming_bin(struct pim_state *state, uint16_t partition_index,
         for (i = 0; i < bin_size(bin); i++) {
                 /* add the edge to requests for this partition */
                 struct backlog_edge *edge = bin_get(bin, i);
+                backlog_add(&state->backlog, edge->src, edge->dst, edge->backlog);
                 ga_adj_add_edge_by_src(&state->requests_by_src[partition_index],
                                        PARTITION_IDX(edge->src), edge->dst);
         }
@@ -185,9 +186,8 @@ void pim_prepare(struct pim_state *state, uint16_t partition_index) {
  *    first iteration only.
  */
 void pim_do_grant_first_it(struct pim_state *state, uint16_t partition_index) {
-        uint16_t count, src_partition, dst_adj_index, dst;
+        uint16_t dst_adj_index, dst;
         struct pim_core_state *core = &state->cores[partition_index];
-        struct admission_core_statistics *core_stat = &core->stat;
 
         /* reset grant edgelist */
         ga_partd_edgelist_src_reset(&state->grants, partition_index);
@@ -219,9 +219,7 @@ void pim_do_grant_first_it(struct pim_state *state, uint16_t partition_index) {
  *    selects edges to grant. These are added to 'grants'.
  */
 void pim_do_grant(struct pim_state *state, uint16_t partition_index) {
-        uint16_t count, src_partition;
         struct pim_core_state *core = &state->cores[partition_index];
-        struct admission_core_statistics *core_stat = &core->stat;
 
         /* reset grant edgelist */
         ga_partd_edgelist_src_reset(&state->grants, partition_index);
@@ -266,12 +264,14 @@ void pim_do_grant(struct pim_state *state, uint16_t partition_index) {
  *    added to 'accepts'
  */
 void pim_do_accept(struct pim_state *state, uint16_t partition_index) {
-        uint16_t count, src_partition;
+        uint16_t src_partition;
         struct ga_edgelist *edgelist;
 	struct pim_core_state *core = &state->cores[partition_index];
-        struct admission_core_statistics *core_stat = &core->stat;
 
 #ifndef PIM_SINGLE_ADMISSION_CORE
+        uint16_t count;
+        struct admission_core_statistics *core_stat = &core->stat;
+
         /* indicate that this partition finished its phase */
         phase_finished(&state->phase, partition_index, core_stat);
 #endif
@@ -370,11 +370,13 @@ void process_accepts_from_partition(struct pim_state *state, uint16_t src_partit
  * Process all of the accepts, after each iteration
  */
 void pim_process_accepts(struct pim_state *state, uint16_t partition_index) {
+        uint16_t dst_partition;
+
+#ifndef PIM_SINGLE_ADMISSION_CORE
 	struct pim_core_state *core = &state->cores[partition_index];
         struct admission_core_statistics *core_stat = &core->stat;
-        uint16_t dst_partition, count;
+        uint16_t count;
 
-#ifndef PIM_SINGLE_ADMISSION_CORE
         /* indicate that this partition finished its phase */
         phase_finished(&state->phase, partition_index, core_stat);
 #endif
@@ -54,7 +54,7 @@ bool pim_is_valid_admitted_traffic(struct pim_state *state)
 
         printf("PIM finished. Accepted edges:\n");
         uint16_t partition;
-        struct admitted_traffic *admitted;
+        struct admitted_traffic *admitted = NULL;
         for (partition = 0; partition < N_PARTITIONS; partition++) {
                 fp_ring_dequeue(state->q_admitted_out, (void **) &admitted);
 
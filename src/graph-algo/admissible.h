@@ -34,6 +34,20 @@ void add_backlog(struct admissible_state *state, uint16_t src,
         pim_add_backlog((struct pim_state *) state, src, dst, amount);
 }
 
+/* pim has no deadline policy; deadlines are ignored */
+static inline
+void add_backlog_deadline(struct admissible_state *state, uint16_t src,
+                          uint16_t dst, uint32_t amount, uint32_t deadline) {
+        pim_add_backlog((struct pim_state *) state, src, dst, amount);
+}
+
+/* pim has no demand classes; urgent demands are treated as normal ones */
+static inline
+void add_urgent_backlog(struct admissible_state *state, uint16_t src,
+                        uint16_t dst, uint32_t amount) {
+        pim_add_backlog((struct pim_state *) state, src, dst, amount);
+}
+
 static inline
 void flush_backlog(struct admissible_state *state) {
         pim_flush_backlog((struct pim_state *) state);
@@ -107,6 +121,20 @@ void add_backlog(struct admissible_state *status, uint16_t src,
         seq_add_backlog((struct seq_admissible_status *) status, src, dst, amount);
 }
 
+static inline
+void add_backlog_deadline(struct admissible_state *status, uint16_t src,
+                          uint16_t dst, uint32_t amount, uint32_t deadline) {
+        seq_add_backlog_deadline((struct seq_admissible_status *) status, src,
+                                 dst, amount, deadline);
+}
+
+static inline
+void add_urgent_backlog(struct admissible_state *status, uint16_t src,
+                        uint16_t dst, uint32_t amount) {
+        seq_add_urgent_backlog((struct seq_admissible_status *) status, src, dst,
+                               amount);
+}
+
 static inline
 void flush_backlog(struct admissible_state *status) {
         seq_flush_backlog((struct seq_admissible_status *) status);
@@ -173,6 +201,37 @@ void handle_spent_demands(struct admissible_state *state)
     struct seq_admissible_status *status = (struct seq_admissible_status *) state;
     seq_handle_spent(status);
 }
+
+static inline
+void set_alloc_policy(struct admissible_state *state, uint8_t policy,
+                      uint8_t deadline_action)
+{
+    seq_set_alloc_policy((struct seq_admissible_status *) state, policy,
+                         deadline_action);
+}
+
+static inline
+int set_bin_geometry(struct admissible_state *state, uint8_t mode,
+                     uint8_t num_bins, uint16_t width)
+{
+    return seq_set_bin_geometry((struct seq_admissible_status *) state, mode,
+                                num_bins, width);
+}
+
+static inline
+void set_dst_reservations(struct admissible_state *state,
+                          struct dst_reservations *res)
+{
+    seq_set_dst_reservations((struct seq_admissible_status *) state, res);
+}
+
+static inline
+uint32_t get_deadline_dropped(struct admissible_state *state, uint16_t src,
+                              uint16_t dst)
+{
+    struct seq_admissible_status *status = (struct seq_admissible_status *) state;
+    return status->deadline_dropped[get_status_index(src, dst)];
+}
 #endif
 
 #endif /* ADMISSIBLE_H_ */
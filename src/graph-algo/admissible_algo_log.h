@@ -30,6 +30,14 @@ struct admission_core_statistics {
 	uint64_t allocated_backlog_remaining;
 	uint64_t backlog_sum;
 	uint64_t allocated_no_backlog;
+	uint64_t allocated_urgent;
+	uint64_t deadline_infeasible;
+	uint64_t deadline_dropped_tslots;
+	uint64_t deadline_degraded;
+	uint64_t alloc_budget_exceeded;
+	uint64_t alloc_budget_carried_bins;
+	uint64_t urgent_bins;
+	uint64_t dst_reservation_conflicts;
 	uint64_t backlog_histogram[BACKLOG_HISTOGRAM_NUM_BINS];
 	uint64_t bin_size_histogram[BIN_SIZE_HISTOGRAM_NUM_BINS];
 	uint64_t core_bins_histogram[CORE_BIN_HISTOGRAM_NUM_BINS];
@@ -73,6 +81,9 @@ struct admission_statistics {
 	uint64_t backlog_sum_inc_to_queue;
 	uint64_t backlog_flush_forced;
 	uint64_t backlog_flush_bin_full;
+	/* urgent class */
+	uint64_t added_urgent_backlog;
+	uint64_t urgent_backlog_sum;
 	/* spent demand handling */
 	uint64_t spent_bins;
 	uint64_t spent_demands;
@@ -114,6 +125,15 @@ void adm_log_increased_backlog_atomically(
 	}
 }
 
+static inline __attribute__((always_inline))
+void adm_log_increased_urgent_backlog(
+		struct admission_statistics *ast, uint32_t amt) {
+	if (MAINTAIN_ADM_LOG_COUNTERS) {
+		ast->added_urgent_backlog++;
+		ast->urgent_backlog_sum += amt;
+	}
+}
+
 static inline __attribute__((always_inline))
 void adm_log_forced_backlog_flush(
 		struct admission_statistics *st) {
@@ -175,6 +195,51 @@ void adm_log_allocator_no_backlog(
 		st->allocated_no_backlog++;
 }
 
+static inline __attribute__((always_inline))
+void adm_log_allocated_urgent(
+		struct admission_core_statistics *st, uint16_t src, uint16_t dst) {
+	(void)src;(void)dst;
+	if (MAINTAIN_ADM_LOG_COUNTERS)
+		st->allocated_urgent++;
+}
+
+static inline __attribute__((always_inline))
+void adm_log_deadline_infeasible(
+		struct admission_core_statistics *st, uint16_t src, uint16_t dst,
+		uint16_t backlog, bool dropped) {
+	(void)src;(void)dst;
+	if (MAINTAIN_ADM_LOG_COUNTERS) {
+		st->deadline_infeasible++;
+		if (dropped)
+			st->deadline_dropped_tslots += backlog;
+		else
+			st->deadline_degraded++;
+	}
+}
+
+static inline __attribute__((always_inline))
+void adm_log_alloc_budget_exceeded(
+		struct admission_core_statistics *st, uint16_t bins_left) {
+	if (MAINTAIN_ADM_LOG_COUNTERS) {
+		st->alloc_budget_exceeded++;
+		st->alloc_budget_carried_bins += bins_left;
+	}
+}
+
+static inline __attribute__((always_inline))
+void adm_log_dst_reservation_conflict(
+		struct admission_core_statistics *st) {
+	if (MAINTAIN_ADM_LOG_COUNTERS)
+		st->dst_reservation_conflicts++;
+}
+
+static inline __attribute__((always_inline))
+void adm_log_processed_urgent_bin(
+		struct admission_core_statistics *st) {
+	if (MAINTAIN_ADM_LOG_COUNTERS)
+		st->urgent_bins++;
+}
+
 static inline __attribute__((always_inline))
 void adm_log_dequeued_bin_in(
 		struct admission_core_statistics *st, uint16_t bin_size) {
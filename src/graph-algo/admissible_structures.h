@@ -22,37 +22,65 @@
 #include "backlog.h"
 #include "batch.h"
 #include "bin.h"
+#include "dst_reservations.h"
+#include "bin_geometry.h"
 #include "admitted.h"
 
 #define SMALL_BIN_SIZE (32) // TODO: try smaller values
 #define LARGE_BIN_SIZE (MAX_NODES * MAX_NODES) // TODO: try smaller values
-#define NUM_BINS_SHIFT 5
-#define NUM_BINS 32 // 2^NUM_BINS_SHIFT
 #define NUM_SRC_DST_PAIRS (MAX_NODES * (MAX_NODES))  // include dst == out of boundary
 
 #define BIN_MASK_SIZE		((NUM_BINS + BATCH_SIZE + 63) / 64)
 
+/* allocation policies */
+#define ADM_POLICY_MAX_MIN		0	/* order by last allocated timeslot */
+#define ADM_POLICY_EDF			1	/* order by earliest deadline */
+
+/* what to do with a demand that cannot meet its deadline (EDF only) */
+#define ADM_DEADLINE_DROP		0	/* discard the demand */
+#define ADM_DEADLINE_DEGRADE	1	/* keep it, and serve it late */
+
+/* deadline of demands that do not have one */
+#define ADM_NO_DEADLINE			0xFFFFFFFF
+
+/* allocation cycle budget of a batch, when none is set */
+#define ADM_NO_BUDGET			0xFFFFFFFFFFFFFFFFULL
+/* urgent edges allocated between reads of the clock, when budgeted */
+#define ADM_URGENT_BUDGET_CHECK_EDGES	16
+
+/* urgent edges re-enter the urgent bin after each allocation in a batch */
+#define URGENT_BIN_SIZE		(LARGE_BIN_SIZE + MAX_NODES * BATCH_SIZE)
+
 // Data structures associated with one allocation core
 struct seq_admission_core_state {
 	struct bin *new_request_bins[NUM_BINS + BATCH_SIZE]; // pool of backlog bins for incoming requests
+	struct bin *urgent_bin; // urgent demands, allocated before all other bins
 	uint64_t non_empty_bins[BIN_MASK_SIZE];
 	uint64_t allowed_bins[BIN_MASK_SIZE];
 	struct batch_state batch_state;
     struct admitted_traffic *admitted[BATCH_SIZE];
     struct bin *out_bin;
     struct bin *spent_bin;
+    struct bin *urgent_out_bin; // urgent demands to retry in the next batch
     struct admission_core_statistics stat;
     uint64_t current_timeslot;
+    uint64_t batch_timeslot; // absolute first timeslot of the batch, keys dst_res
+    struct bin_geometry geometry; // per core, so adaptive retuning needs no locks
 }  __attribute__((aligned(64))) /* don't want sharing between cores */;
 
 // Tracks status for admissible traffic (last send time and demand for all flows, etc.)
 // over the lifetime of a controller
 struct seq_admissible_status {
     bool oversubscribed;
+    uint8_t policy;
+    uint8_t deadline_action;
+    uint64_t alloc_budget_cycles;  // per batch, ADM_NO_BUDGET if unlimited
     uint16_t out_of_boundary_capacity;
     uint16_t inter_rack_capacity;  // Only valid if oversubscribed is true
     uint16_t num_nodes;
     uint64_t last_alloc_tslot[NUM_SRC_DST_PAIRS];
+    uint32_t deadline[NUM_SRC_DST_PAIRS];
+    uint32_t deadline_dropped[NUM_SRC_DST_PAIRS];
     struct backlog backlog;
     struct bin *new_demands;
     struct fp_ring *q_head;
@@ -61,6 +89,7 @@ struct seq_admissible_status {
     struct fp_mempool *bin_mempool;
     struct fp_mempool *core_bin_mempool;
     struct fp_mempool *admitted_traffic_mempool;
+    struct dst_reservations *dst_res;  // shared with other arbiters, or NULL
     struct seq_admission_core_state cores[ALGO_N_CORES];
     struct fp_ring *q_bin[ALGO_N_CORES];
     struct admission_statistics stat;
@@ -86,8 +115,11 @@ void seq_reset_admissible_status(struct seq_admissible_status *status, bool over
     status->num_nodes = num_nodes;
 
     uint32_t i;
-    for (i = 0; i < NUM_SRC_DST_PAIRS; i++)
+    for (i = 0; i < NUM_SRC_DST_PAIRS; i++) {
         status->last_alloc_tslot[i] = 0;
+        status->deadline[i] = ADM_NO_DEADLINE;
+        status->deadline_dropped[i] = 0;
+    }
 
     backlog_init(&status->backlog);
 }
@@ -98,6 +130,73 @@ uint32_t get_status_index(uint16_t src, uint16_t dst) {
     return (src << FP_NODES_SHIFT) + dst;
 }
 
+// Sets the allocation policy, and the action on infeasible deadlines for EDF
+static inline
+void seq_set_alloc_policy(struct seq_admissible_status *status, uint8_t policy,
+                          uint8_t deadline_action)
+{
+    assert(status != NULL);
+
+    status->policy = policy;
+    status->deadline_action = deadline_action;
+}
+
+// Sets the cycles each core may spend allocating in one batch. Bins left over
+// when the budget runs out are carried over to the next batch.
+static inline
+void seq_set_alloc_budget(struct seq_admissible_status *status,
+                          uint64_t alloc_budget_cycles)
+{
+    assert(status != NULL);
+
+    status->alloc_budget_cycles = alloc_budget_cycles;
+}
+
+// Sets how flows are spread over the metric bins, on all cores. Only call
+// while no core is allocating. Returns 0 on success, -1 on bad parameters.
+static inline
+int seq_set_bin_geometry(struct seq_admissible_status *status, uint8_t mode,
+                         uint8_t num_bins, uint16_t width)
+{
+    uint32_t i;
+
+    assert(status != NULL);
+
+    for (i = 0; i < ALGO_N_CORES; i++)
+        if (bin_geometry_init(&status->cores[i].geometry, mode, num_bins,
+                              width) != 0)
+            return -1;
+    return 0;
+}
+
+// Shares destinations with other arbiters, each allocating its own sources:
+// timeslots of a destination are claimed in res before they are admitted.
+// NULL (the default) if this arbiter owns all sources.
+static inline
+void seq_set_dst_reservations(struct seq_admissible_status *status,
+                              struct dst_reservations *res)
+{
+    assert(status != NULL);
+
+    status->dst_res = res;
+}
+
+// Sets the absolute timeslot of the core's next batch, which all arbiters
+// sharing destinations agree on. Batches that follow are numbered from it.
+// Returns 0 on success, -1 if destinations are shared and the timeslot is
+// not a multiple of BATCH_SIZE.
+static inline
+int seq_set_batch_timeslot(struct seq_admissible_status *status,
+                           uint32_t core_index, uint64_t timeslot)
+{
+    assert(status != NULL);
+
+    if (status->dst_res != NULL && (timeslot & (BATCH_SIZE - 1)) != 0)
+        return -1;
+    status->cores[core_index].batch_timeslot = timeslot;
+    return 0;
+}
+
 // Initializes data structures associated with one allocation core for
 // a new batch of processing
 static inline
@@ -108,6 +207,7 @@ void alloc_core_reset(struct seq_admission_core_state *core,
     uint16_t i;
 	for (i = 0; i < NUM_BINS + BATCH_SIZE; i++)
 		init_bin(core->new_request_bins[i]);
+	init_bin(core->urgent_bin);
 
 	core->allowed_bins[0] = 0x1;
 	for (i = 1; i < BIN_MASK_SIZE; i++)
@@ -124,6 +224,8 @@ void alloc_core_reset(struct seq_admission_core_state *core,
     assert(is_empty_bin(core->out_bin));
     assert(core->spent_bin != NULL);
     assert(is_empty_bin(core->spent_bin));
+    assert(core->urgent_out_bin != NULL);
+    assert(is_empty_bin(core->urgent_out_bin));
 }
 
 
@@ -144,6 +246,10 @@ static inline int alloc_core_init(struct seq_admissible_status *status,
 			return -1;
 	}
 
+	core->urgent_bin = create_bin(URGENT_BIN_SIZE);
+	if (core->urgent_bin == NULL)
+		return -1;
+
 	 if (fp_mempool_get(status->bin_mempool,
 			 (void**)&core->out_bin) != 0)
 		 return -1;
@@ -154,7 +260,13 @@ static inline int alloc_core_init(struct seq_admissible_status *status,
 		 return -1;
 	init_bin(core->spent_bin);
 
+	 if (fp_mempool_get(status->bin_mempool,
+			 (void**)&core->urgent_out_bin) != 0)
+		 return -1;
+	init_bin(core->urgent_out_bin);
+
 	core->current_timeslot = timeslot;
+	core->batch_timeslot = timeslot;
 
 	return 0;
 }
@@ -178,6 +290,10 @@ int seq_init_admissible_status(struct seq_admissible_status *status,
 
     seq_reset_admissible_status(status, oversubscribed, inter_rack_capacity,
                                 out_of_boundary_capacity, num_nodes);
+    seq_set_alloc_policy(status, ADM_POLICY_MAX_MIN, ADM_DEADLINE_DROP);
+    seq_set_alloc_budget(status, ADM_NO_BUDGET);
+    seq_set_bin_geometry(status, BIN_GEOM_FOLDED, BIN_GEOM_MAX_HISTORY_BINS, 1);
+    seq_set_dst_reservations(status, NULL);
 
     status->q_head = q_head;
     status->q_admitted_out = q_admitted_out;
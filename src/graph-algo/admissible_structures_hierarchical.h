@@ -0,0 +1,131 @@
+/*
+ * admissible_structures_hierarchical.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Data structures of the rack-aggregated (hierarchical) allocator. Hosts are
+ * grouped into racks of 2^rack_shift consecutive ids. Each timeslot is
+ * allocated at two levels: rack-to-rack capacity first, then host edges
+ * within each pair of racks.
+ */
+
+#ifndef ADMISSIBLE_STRUCTURES_HIERARCHICAL_H_
+#define ADMISSIBLE_STRUCTURES_HIERARCHICAL_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "admitted.h"
+#include "../protocol/topology.h"
+
+#define HIER_MAX_RACKS          64
+#define HIER_MIN_RACK_SHIFT     2
+#define HIER_BITMAP_WORDS       ((MAX_NODES + 63) / 64)
+#define HIER_NUM_ITERATIONS     3   // request/accept rounds per timeslot
+#define HIER_NONE               0xFFFF
+
+#if HIER_BITMAP_WORDS > 64
+#error "active_words needs MAX_NODES <= 4096"
+#endif
+
+// State of the hierarchical allocator
+struct hier_admissible_status {
+    uint16_t num_nodes;
+    uint16_t num_racks;
+    uint8_t rack_shift;
+    uint16_t inter_rack_capacity;   // per rack per timeslot, each direction
+    uint16_t rack_rr;               // rotates rack-level allocation order
+
+    // host level: demands, and round-robin pointers for fairness
+    uint32_t backlog[MAX_NODES * MAX_NODES];
+    uint64_t active[MAX_NODES][HIER_BITMAP_WORDS]; // src -> dsts with backlog
+    uint64_t active_words[MAX_NODES]; // src -> non-zero words of active
+    uint16_t src_rr[MAX_NODES];     // next dst a src prefers
+    uint16_t dst_rr[MAX_NODES];     // next src a dst prefers
+
+    // rack level: how many hosts of each rack have backlog to each rack
+    uint16_t src_to_rack[MAX_NODES][HIER_MAX_RACKS];   // active dsts in rack
+    uint16_t dst_from_rack[MAX_NODES][HIER_MAX_RACKS]; // active srcs in rack
+    uint16_t rack_srcs[HIER_MAX_RACKS][HIER_MAX_RACKS]; // [src rack][dst rack]
+    uint16_t rack_dsts[HIER_MAX_RACKS][HIER_MAX_RACKS]; // [src rack][dst rack]
+
+    // per-timeslot state
+    uint16_t quota[HIER_MAX_RACKS][HIER_MAX_RACKS]; // edges rack pair may add
+    uint64_t src_busy[HIER_BITMAP_WORDS];
+    uint64_t dst_busy[HIER_BITMAP_WORDS];
+    uint16_t proposal[MAX_NODES];   // dst a src proposed to, or HIER_NONE
+    uint16_t best_proposal[MAX_NODES]; // src a dst will accept, or HIER_NONE
+    // proposals from src rack to dst rack, [dst_rack][src_rack][i]
+    uint16_t *proposers;
+    uint16_t num_proposers[HIER_MAX_RACKS][HIER_MAX_RACKS];
+    uint64_t proposing_racks[HIER_MAX_RACKS]; // dst rack -> src racks
+};
+
+static inline __attribute__((always_inline))
+uint16_t hier_rack(struct hier_admissible_status *status, uint16_t node)
+{
+    return node >> status->rack_shift;
+}
+
+static inline __attribute__((always_inline))
+uint16_t *hier_proposers(struct hier_admissible_status *status,
+                         uint16_t dst_rack, uint16_t src_rack)
+{
+    return &status->proposers[((dst_rack * status->num_racks) + src_rack)
+                              << status->rack_shift];
+}
+
+/**
+ * Creates the allocator for @num_nodes hosts in racks of 2^@rack_shift, where
+ *    each rack may send and receive @inter_rack_capacity edges per timeslot
+ *    to and from other racks
+ * @return the state, or NULL on error
+ */
+static inline
+struct hier_admissible_status *
+create_hier_admissible_status(uint16_t num_nodes, uint8_t rack_shift,
+                              uint16_t inter_rack_capacity)
+{
+    struct hier_admissible_status *status;
+    uint16_t num_racks = (num_nodes + (1 << rack_shift) - 1) >> rack_shift;
+
+    if (num_nodes > MAX_NODES || rack_shift < HIER_MIN_RACK_SHIFT ||
+        num_racks > HIER_MAX_RACKS || inter_rack_capacity == 0)
+        return NULL;
+
+    status = fp_malloc("hier_admissible_status",
+                       sizeof(struct hier_admissible_status));
+    if (status == NULL)
+        return NULL;
+    memset(status, 0, sizeof(struct hier_admissible_status));
+
+    status->proposers = fp_malloc("hier_proposers",
+            ((uint32_t) num_racks * num_racks << rack_shift) * sizeof(uint16_t));
+    if (status->proposers == NULL) {
+        free(status);
+        return NULL;
+    }
+
+    status->num_nodes = num_nodes;
+    status->num_racks = num_racks;
+    status->rack_shift = rack_shift;
+    status->inter_rack_capacity = inter_rack_capacity;
+    memset(status->proposal, 0xFF, sizeof(status->proposal));
+    memset(status->best_proposal, 0xFF, sizeof(status->best_proposal));
+
+    return status;
+}
+
+static inline
+void destroy_hier_admissible_status(struct hier_admissible_status *status)
+{
+    assert(status != NULL);
+
+    free(status->proposers);
+    free(status);
+}
+
+#endif /* ADMISSIBLE_STRUCTURES_HIERARCHICAL_H_ */
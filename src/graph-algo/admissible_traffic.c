@@ -51,10 +51,10 @@ void core_flush_q_spent(struct seq_admission_core_state *core,
 static inline __attribute__((always_inline))
 void core_enqueue_to_q_spent(struct seq_admission_core_state *core,
 		struct fp_ring *queue_spent, struct fp_mempool *bin_mempool,
-		uint16_t src, uint16_t dst, uint32_t metric)
+		uint16_t src, uint16_t dst, uint32_t metric, uint16_t prio)
 {
 	/* add to status->new_demands */
-	enqueue_bin(core->spent_bin, src, dst, 0, metric);
+	enqueue_bin_prio(core->spent_bin, src, dst, 0, metric, prio);
 
 	if (unlikely(bin_size(core->spent_bin) == SMALL_BIN_SIZE)) {
 		adm_log_q_spent_flush_bin_full(&core->stat);
@@ -108,6 +108,34 @@ void core_enqueue_to_q_out_edge(struct seq_admission_core_state *core,
 	}
 }
 
+/**
+ * Flushes urgent demands that could not be allocated to q_head, so the core
+ *    allocating the next batch picks them up ahead of the pipeline's q_bin
+ */
+static inline __attribute__((always_inline))
+void core_flush_q_urgent(struct seq_admission_core_state *core,
+		struct seq_admissible_status *status)
+{
+	while(fp_ring_enqueue(status->q_head, core->urgent_out_bin) == -ENOBUFS)
+		adm_log_wait_for_space_in_q_head(&status->stat);
+
+	while(fp_mempool_get(status->bin_mempool,
+			(void**)&core->urgent_out_bin) == -ENOENT)
+		adm_log_out_bin_alloc_failed(&core->stat);
+
+	init_bin(core->urgent_out_bin);
+}
+
+static inline __attribute__((always_inline))
+void core_enqueue_to_q_urgent(struct seq_admission_core_state *core,
+		struct seq_admissible_status *status, struct backlog_edge *edge)
+{
+	enqueue_bin_edge(core->urgent_out_bin, edge);
+
+	if (unlikely(bin_size(core->urgent_out_bin) == SMALL_BIN_SIZE))
+		core_flush_q_urgent(core, status);
+}
+
 /**
  * Flushes bin to queue, and allocates a new bin
  */
@@ -135,11 +163,14 @@ void seq_flush_backlog(struct seq_admissible_status *status) {
 }
 
 void enqueue_new_demand(struct seq_admissible_status* status, uint16_t src,
-		uint16_t dst, uint32_t amount)
+		uint16_t dst, uint32_t amount, uint16_t prio)
 {
+	uint32_t index = get_status_index(src, dst);
+	uint32_t metric = (status->policy == ADM_POLICY_EDF) ?
+			status->deadline[index] : status->last_alloc_tslot[index];
+
 	/* add to status->new_demands */
-	enqueue_bin(status->new_demands, src, dst, amount,
-			status->last_alloc_tslot[get_status_index(src, dst)]);
+	enqueue_bin_prio(status->new_demands, src, dst, amount, metric, prio);
 
 	if (unlikely(bin_size(status->new_demands) == SMALL_BIN_SIZE)) {
 		adm_log_backlog_flush_bin_full(&status->stat);
@@ -155,7 +186,32 @@ void seq_add_backlog(struct seq_admissible_status *status,
 		return; /* no need to enqueue */
 
 	/* add to status->new_demands */
-	enqueue_new_demand(status, src, dst, amount);
+	enqueue_new_demand(status, src, dst, amount, ADM_PRIO_NORMAL);
+}
+
+void seq_add_backlog_deadline(struct seq_admissible_status *status,
+		uint16_t src, uint16_t dst, uint32_t amount, uint32_t deadline)
+{
+	uint32_t *pair_deadline = &status->deadline[get_status_index(src, dst)];
+
+	/* the pair's backlog is allocated in order, so it is due by the latest
+	 * deadline requested. Timeslots wrap around, so compare differences. */
+	if (*pair_deadline == ADM_NO_DEADLINE
+			|| (deadline != ADM_NO_DEADLINE
+				&& (int32_t)(deadline - *pair_deadline) > 0))
+		*pair_deadline = deadline;
+	seq_add_backlog(status, src, dst, amount);
+}
+
+void seq_add_urgent_backlog(struct seq_admissible_status *status,
+		uint16_t src, uint16_t dst, uint32_t amount)
+{
+	if (backlog_urgent_increase(&status->backlog, src, dst, amount,
+			&status->stat) == false)
+		return; /* no need to enqueue */
+
+	/* add to status->new_demands */
+	enqueue_new_demand(status, src, dst, amount, ADM_PRIO_URGENT);
 }
 
 void seq_handle_spent(struct seq_admissible_status *status)
@@ -177,14 +233,30 @@ void seq_handle_spent(struct seq_admissible_status *status)
     		struct backlog_edge *edge = bin_get(bins[bin], i);
     		uint16_t src = edge->src;
     		uint16_t dst = edge->dst;
-    		uint32_t backlog = backlog_get(&status->backlog, src, dst);
+    		uint32_t backlog;
+
+    		if (unlikely(edge->prio == ADM_PRIO_URGENT)) {
+    			/* urgent allocations do not affect the flow's metric */
+    			backlog = backlog_urgent_get(&status->backlog, src, dst);
+    			if (backlog == 0) {
+    				backlog_urgent_non_active(&status->backlog, src, dst);
+    			} else {
+    				backlog_urgent_reset_pair(&status->backlog, src, dst);
+    				enqueue_new_demand(status, src, dst, backlog, ADM_PRIO_URGENT);
+    			}
+    			continue;
+    		}
 
+    		backlog = backlog_get(&status->backlog, src, dst);
     		if (backlog == 0) {
-    			status->last_alloc_tslot[get_status_index(src, dst)] = edge->metric;
+    			/* under EDF the metric is the deadline */
+    			if (status->policy == ADM_POLICY_MAX_MIN)
+    				status->last_alloc_tslot[get_status_index(src, dst)] = edge->metric;
+    			status->deadline[get_status_index(src, dst)] = ADM_NO_DEADLINE;
     			backlog_non_active(&status->backlog, src, dst);
     		} else {
     			backlog_reset_pair(&status->backlog, src, dst);
-    			enqueue_new_demand(status, src, dst, backlog);
+    			enqueue_new_demand(status, src, dst, backlog, ADM_PRIO_NORMAL);
     		}
     	}
 		fp_mempool_put(status->bin_mempool, bins[bin]);
@@ -198,6 +270,17 @@ void set_bin_non_empty(struct seq_admission_core_state *core, uint16_t bin_index
 	asm("bts %1,%0" : "+m" (*(uint64_t *)&core->non_empty_bins[0]) : "r" (bin_index));
 }
 
+static inline __attribute__((always_inline))
+uint16_t core_bin_index(struct seq_admissible_status *status,
+		struct seq_admission_core_state *core, uint32_t metric)
+{
+	if (status->policy == ADM_POLICY_EDF)
+		return bin_index_from_deadline(metric, core->current_timeslot);
+	if (likely(core->geometry.mode == BIN_GEOM_FOLDED))
+		return bin_index_from_timeslot(metric, core->current_timeslot);
+	return bin_geometry_index(&core->geometry, metric, core->current_timeslot);
+}
+
 static inline __attribute__((always_inline))
 void incoming_bin_to_core(struct seq_admissible_status *status,
 		struct seq_admission_core_state *core, struct bin *bin)
@@ -205,9 +288,14 @@ void incoming_bin_to_core(struct seq_admissible_status *status,
 	uint32_t n = bin_size(bin);
 	uint32_t i;
 	for (i = 0; i < n; i++) {
+		/* urgent demands skip the metric bins */
+		if (unlikely(bin_get(bin, i)->prio == ADM_PRIO_URGENT)) {
+			enqueue_bin_edge(core->urgent_bin, bin_get(bin, i));
+			continue;
+		}
 		/* where to put the entry? */
-		uint16_t bin_index = bin_index_from_timeslot(bin_get(bin, i)->metric,
-													core->current_timeslot);
+		uint16_t bin_index = core_bin_index(status, core,
+				bin_get(bin, i)->metric);
 		/* put it there */
 		enqueue_bin_edge(core->new_request_bins[bin_index], bin_get(bin, i));
 		/* mark that the bin is non-empty */
@@ -232,6 +320,10 @@ void move_core_to_q_out(struct seq_admissible_status *status,
         struct fp_mempool *bin_mp_out)
 {
 	uint32_t bin_mask_ind;
+	uint32_t i;
+
+	for (i = 0; i < bin_size(core->urgent_bin); i++)
+		core_enqueue_to_q_urgent(core, status, bin_get(core->urgent_bin, i));
 
 	for (bin_mask_ind = 0; bin_mask_ind < BIN_MASK_SIZE; bin_mask_ind++) {
 		uint64_t mask = core->non_empty_bins[bin_mask_ind];
@@ -249,6 +341,30 @@ void move_core_to_q_out(struct seq_admissible_status *status,
 	}
 }
 
+/**
+ * When several arbiters share the destinations, claims the earliest timeslot
+ *    of @timeslot_bitmap that no other arbiter took for @dst.
+ * Returns the timeslots to allocate from: @timeslot_bitmap when not shared,
+ *    otherwise the claimed timeslot's bit, or 0 if all were taken.
+ */
+static inline __attribute__((always_inline))
+uint64_t claim_dst_timeslot(struct seq_admission_core_state *core,
+		struct seq_admissible_status *status, uint16_t dst,
+		uint64_t timeslot_bitmap)
+{
+	uint64_t set_bit;
+
+	if (likely(status->dst_res == NULL) || dst == OUT_OF_BOUNDARY_NODE_ID ||
+			timeslot_bitmap == 0ULL)
+		return timeslot_bitmap;
+
+	set_bit = dst_res_claim_first(status->dst_res,
+			core->batch_timeslot >> BATCH_SHIFT, dst, timeslot_bitmap);
+	if (set_bit != (timeslot_bitmap & (-timeslot_bitmap)))
+		adm_log_dst_reservation_conflict(&core->stat);
+	return set_bit;
+}
+
 /**
  * Try to allocate the given edge
  * Returns false, if the flow will be handled internally,
@@ -256,15 +372,15 @@ void move_core_to_q_out(struct seq_admissible_status *status,
  */
 static inline __attribute__((always_inline))
 bool try_allocation(uint16_t src, uint16_t dst, uint16_t backlog,
-		uint32_t metric, struct seq_admission_core_state *core,
+		uint32_t metric, uint16_t prio, struct seq_admission_core_state *core,
 		struct seq_admissible_status *status)
 {
 
     assert(core != NULL);
     assert(status != NULL);
 
-	uint64_t timeslot_bitmap = batch_state_get_avail_bitmap(
-			&core->batch_state, src, dst);
+	uint64_t timeslot_bitmap = claim_dst_timeslot(core, status, dst,
+			batch_state_get_avail_bitmap(&core->batch_state, src, dst));
 
     if (timeslot_bitmap == 0ULL) {
     	adm_algo_log_no_available_timeslots_for_bin_entry(&core->stat, src, dst);
@@ -289,6 +405,18 @@ bool try_allocation(uint16_t src, uint16_t dst, uint16_t backlog,
 
 	insert_admitted_edge(core->admitted[batch_timeslot], src, dst);
 
+	if (prio == ADM_PRIO_URGENT) {
+		adm_log_allocated_urgent(&core->stat, src, dst);
+		if (backlog != 0)
+			/* stays urgent: try again in the next available timeslot */
+			enqueue_bin_prio(core->urgent_bin, src, dst, backlog, metric,
+					ADM_PRIO_URGENT);
+		else
+			core_enqueue_to_q_spent(core, status->q_spent,
+					status->bin_mempool, src, dst, metric, ADM_PRIO_URGENT);
+		return false;
+	}
+
 	if (backlog != 0) {
     	adm_log_allocated_backlog_remaining(&core->stat, src, dst, backlog);
     	uint16_t bin_index = bin_after_alloc(src, dst, metric, batch_timeslot,
@@ -298,7 +426,7 @@ bool try_allocation(uint16_t src, uint16_t dst, uint16_t backlog,
 	} else {
 		adm_log_allocator_no_backlog(&core->stat, src, dst);
 		core_enqueue_to_q_spent(core, status->q_spent, status->bin_mempool,
-				src, dst, metric);
+				src, dst, metric, ADM_PRIO_NORMAL);
 	}
 
 	return false;
@@ -320,7 +448,8 @@ void try_allocation_bin(struct seq_admission_core_state *core, uint64_t bin_inde
 		uint32_t backlog = bin_get(bin, i)->backlog;
 		uint32_t metric = bin_get(bin, i)->metric;
 
-        rc = try_allocation(src, dst, backlog, metric, core, status);
+        rc = try_allocation(src, dst, backlog, metric, ADM_PRIO_NORMAL, core,
+        		status);
         if (rc == true) {
 			// We cannot allocate this edge now - copy to queue_out
 			core_enqueue_to_q_out(core, queue_out, bin_mp_out,
@@ -329,18 +458,189 @@ void try_allocation_bin(struct seq_admission_core_state *core, uint64_t bin_inde
     }
 }
 
+/**
+ * Allocates an edge under the EDF policy. The edge gets as many timeslots as
+ *    it can use before its deadline in this batch, and the rest goes to the
+ *    next batch. Demands that cannot finish by their deadline even if they got
+ *    every remaining timeslot are dropped, or degraded to be served late, per
+ *    deadline_action.
+ */
 static inline __attribute__((always_inline))
-void try_allocation_core(struct seq_admission_core_state *core,
+void try_allocation_edf(struct backlog_edge *edge,
+		struct seq_admission_core_state *core, struct fp_ring *queue_out,
+		struct seq_admissible_status *status, struct fp_mempool *bin_mp_out)
+{
+	uint16_t src = edge->src;
+	uint16_t dst = edge->dst;
+	uint16_t backlog = edge->backlog;
+	uint32_t deadline = edge->metric;
+	uint64_t deadline_mask = ~0ULL;
+	uint64_t timeslot_bitmap;
+	uint64_t batch_timeslot;
+	uint64_t set_bit;
+
+	if (deadline != ADM_NO_DEADLINE) {
+		int32_t slack = (int32_t)(deadline - (uint32_t)core->current_timeslot);
+		uint32_t remaining;
+
+		/* only timeslots up to the deadline are useful */
+		if (slack < BATCH_SIZE - 1)
+			deadline_mask = (slack < 0) ? 0 : ((2ULL << slack) - 1);
+
+		/* free timeslots in this batch, and all timeslots in later batches */
+		remaining = __builtin_popcountll(deadline_mask &
+				batch_state_get_avail_bitmap(&core->batch_state, src, dst));
+		if (slack >= BATCH_SIZE)
+			remaining += slack - BATCH_SIZE + 1;
+
+		if (unlikely(backlog > remaining)) {
+			if (status->deadline_action == ADM_DEADLINE_DROP) {
+				adm_log_deadline_infeasible(&core->stat, src, dst, backlog, true);
+				status->deadline_dropped[get_status_index(src, dst)] += backlog;
+				core_enqueue_to_q_spent(core, status->q_spent,
+						status->bin_mempool, src, dst, deadline, ADM_PRIO_NORMAL);
+				return;
+			}
+
+			/* keep the deadline, but serve as soon as possible even if late */
+			adm_log_deadline_infeasible(&core->stat, src, dst, backlog, false);
+			deadline_mask = ~0ULL;
+		}
+	}
+
+	timeslot_bitmap = claim_dst_timeslot(core, status, dst, deadline_mask &
+			batch_state_get_avail_bitmap(&core->batch_state, src, dst));
+	if (timeslot_bitmap == 0ULL)
+		adm_algo_log_no_available_timeslots_for_bin_entry(&core->stat, src, dst);
+
+	while (backlog != 0 && timeslot_bitmap != 0ULL) {
+		asm("bsfq %1,%0" : "=r"(batch_timeslot) : "r"(timeslot_bitmap));
+		batch_timeslot &= ((1 << BATCH_SHIFT) - 1);
+		set_bit = timeslot_bitmap & (-timeslot_bitmap);
+
+		backlog--;
+		batch_state_set_occupied_conditional(&core->batch_state, src, dst,
+				batch_timeslot, set_bit);
+		insert_admitted_edge(core->admitted[batch_timeslot], src, dst);
+
+		timeslot_bitmap = claim_dst_timeslot(core, status, dst, deadline_mask &
+				batch_state_get_avail_bitmap(&core->batch_state, src, dst));
+	}
+
+	if (backlog != 0) {
+		adm_log_allocated_backlog_remaining(&core->stat, src, dst, backlog);
+		core_enqueue_to_q_out(core, queue_out, bin_mp_out, src, dst, backlog,
+				deadline);
+	} else {
+		adm_log_allocator_no_backlog(&core->stat, src, dst);
+		core_enqueue_to_q_spent(core, status->q_spent, status->bin_mempool,
+				src, dst, deadline, ADM_PRIO_NORMAL);
+	}
+}
+
+static inline __attribute__((always_inline))
+void try_allocation_bin_edf(struct seq_admission_core_state *core,
+		uint64_t bin_index, struct fp_ring *queue_out,
+		struct seq_admissible_status *status, struct fp_mempool *bin_mp_out)
+{
+    uint32_t i;
+    struct bin *bin = core->new_request_bins[bin_index];
+    uint32_t n_elem = bin_size(bin);
+
+    for (i = 0; i < n_elem; i++)
+    	try_allocation_edf(bin_get(bin, i), core, queue_out, status, bin_mp_out);
+}
+
+/**
+ * Allocates the urgent bin. Runs before any of the metric bins, and is not
+ *    subject to allowed_bins, so urgent demands get the earliest timeslots in
+ *    the batch that are free for their src and dst.
+ * The cycles since @start_cycles count against @budget, checked every
+ *    ADM_URGENT_BUDGET_CHECK_EDGES edges; @now_cycles is the last reading.
+ *    Returns true if the budget ran out; the unprocessed urgent edges go to
+ *    the next batch.
+ */
+static inline __attribute__((always_inline))
+bool try_allocation_urgent(struct seq_admission_core_state *core,
+                    struct seq_admissible_status *status, uint64_t start_cycles,
+                    uint64_t budget, uint64_t *now_cycles)
+{
+	bool rc;
+    uint32_t i, j;
+    struct bin *bin = core->urgent_bin;
+
+    adm_log_processed_urgent_bin(&core->stat);
+
+    /* edges with remaining backlog are appended to the bin, so re-read size */
+    for (i = 0; i < bin_size(bin); i++) {
+    	struct backlog_edge *edge = bin_get(bin, i);
+
+        rc = try_allocation(edge->src, edge->dst, edge->backlog, edge->metric,
+        		ADM_PRIO_URGENT, core, status);
+        if (rc == true) {
+			// We cannot allocate this edge in this batch - retry in the next
+			core_enqueue_to_q_urgent(core, status, edge);
+        }
+
+        if (budget != ADM_NO_BUDGET &&
+        		(i % ADM_URGENT_BUDGET_CHECK_EDGES) == ADM_URGENT_BUDGET_CHECK_EDGES - 1) {
+        	*now_cycles = fp_get_cycles();
+        	if (unlikely(*now_cycles - start_cycles >= budget)) {
+        		for (j = i + 1; j < bin_size(bin); j++)
+        			core_enqueue_to_q_urgent(core, status, bin_get(bin, j));
+        		init_bin(bin);
+        		return true;
+        	}
+        }
+    }
+
+    init_bin(bin);
+    if (budget != ADM_NO_BUDGET)
+    	*now_cycles = fp_get_cycles();
+    return false;
+}
+
+/**
+ * Allocates the urgent bin, then the non-empty allowed bins, charging the
+ *    cycles spent on both to @budget.
+ * Returns true if the budget ran out; the bins not yet processed stay in the
+ *    core.
+ */
+static inline __attribute__((always_inline))
+bool try_allocation_core(struct seq_admission_core_state *core,
                     struct fp_ring *queue_out, struct seq_admissible_status *status,
-                    struct fp_mempool *bin_mp_out)
+                    struct fp_mempool *bin_mp_out, uint64_t *budget)
 {
 	uint32_t bin_mask_ind;
+	bool budgeted = (*budget != ADM_NO_BUDGET);
+	uint64_t start_cycles = 0;
+	uint64_t now_cycles = 0;
+
+	/* strict priority: urgent demands before all other bins */
+	if (unlikely(!is_empty_bin(core->urgent_bin))) {
+		if (budgeted)
+			start_cycles = fp_get_cycles();
+		if (try_allocation_urgent(core, status, start_cycles, *budget,
+				&now_cycles)) {
+			*budget = 0;
+			return true;
+		}
+		/* the pass checks the clock only every few edges, so its tail may
+		 * have overrun the budget */
+		if (budgeted && unlikely(now_cycles - start_cycles >= *budget)) {
+			*budget = 0;
+			return true;
+		}
+	}
 
 	for (bin_mask_ind = 0; bin_mask_ind < BIN_MASK_SIZE; bin_mask_ind++) {
 		uint64_t allowed = core->allowed_bins[bin_mask_ind];
 		uint64_t mask = core->non_empty_bins[bin_mask_ind] & allowed;
 		uint64_t bin_index;
 		while (mask) {
+			if (budgeted && start_cycles == 0)
+				start_cycles = now_cycles = fp_get_cycles();
+
 			/* get the index of the lsb that is set */
 			asm("bsfq %1,%0" : "=r"(bin_index) : "r"(mask));
 			/* turn off the set bit in the mask */
@@ -349,14 +649,42 @@ void try_allocation_core(struct seq_admission_core_state *core,
 
 			adm_log_processed_core_bin(&core->stat, bin_index,
 					bin_size(core->new_request_bins[bin_index]));
-			try_allocation_bin(core, bin_index,
-					queue_out, status, bin_mp_out);
+			if (status->policy == ADM_POLICY_EDF)
+				try_allocation_bin_edf(core, bin_index,
+						queue_out, status, bin_mp_out);
+			else
+				try_allocation_bin(core, bin_index,
+						queue_out, status, bin_mp_out);
 			init_bin(core->new_request_bins[bin_index]);
 
+			if (budgeted) {
+				now_cycles = fp_get_cycles();
+				if (unlikely(now_cycles - start_cycles >= *budget)) {
+					*budget = 0;
+					return true;
+				}
+			}
+
 			/* re-read mask */
 			mask = core->non_empty_bins[bin_mask_ind] & allowed;
 		}
 	}
+
+	/* the budget is unsigned: stop at 0 rather than wrap around */
+	if (budgeted)
+		*budget = (now_cycles - start_cycles >= *budget) ? 0
+				: *budget - (now_cycles - start_cycles);
+	return false;
+}
+
+static inline uint16_t count_non_empty_bins(struct seq_admission_core_state *core)
+{
+	uint16_t n = 0;
+	uint32_t i;
+
+	for (i = 0; i < BIN_MASK_SIZE; i++)
+		n += __builtin_popcountll(core->non_empty_bins[i]);
+	return n;
 }
 
 // Sets the last send time for new requests based on the contents of status
@@ -424,6 +752,11 @@ void seq_get_admissible_traffic(struct seq_admissible_status *status,
     // Initialize this core for a new batch of processing
     alloc_core_reset(core, status);
 
+    // Between batches, follow the workload's distribution of metrics
+    if (unlikely(core->geometry.mode == BIN_GEOM_ADAPTIVE &&
+    		core->geometry.n_samples >= BIN_GEOM_RETUNE_SAMPLES))
+    	bin_geometry_retune(&core->geometry);
+
     assert(core->out_bin != NULL);
     assert(is_empty_bin(core->out_bin));
     assert(core->spent_bin != NULL);
@@ -438,6 +771,8 @@ void seq_get_admissible_traffic(struct seq_admissible_status *status,
 	uint32_t i;
     bool should_process_new_req = false;
     uint64_t n_processed = 0;
+    uint64_t alloc_budget = status->alloc_budget_cycles;
+    bool budget_exceeded = false;
 	int64_t slot_gap;
 #ifdef NO_DPDK
     uint64_t prev_timeslot = first_timeslot - NUM_BINS - 2;
@@ -532,7 +867,15 @@ handle_inputs:
 		}
 
 try_alloc:
-		try_allocation_core(core, queue_out, status, bin_mp_out);
+		if (likely(!budget_exceeded)) {
+			budget_exceeded = try_allocation_core(core, queue_out, status,
+					bin_mp_out, &alloc_budget);
+			/* keep sending out the partial allocation on time; the remaining
+			 * bins are carried over at wrap up */
+			if (unlikely(budget_exceeded))
+				adm_log_alloc_budget_exceeded(&core->stat,
+						count_non_empty_bins(core));
+		}
     }
 
 wrap_up:
@@ -543,6 +886,9 @@ wrap_up:
 		adm_log_q_out_flush_batch_finished(&core->stat);
 		core_flush_q_out(core, queue_out, bin_mp_out);
 	}
+	/* hand unallocated urgent demands to the next batch */
+	if (!is_empty_bin(core->urgent_out_bin))
+		core_flush_q_urgent(core, status);
 	/* flush q_spent if there is more there */
 	if (!is_empty_bin(core->spent_bin)) {
 		adm_log_q_spent_flush_batch_finished(&core->stat);
@@ -554,6 +900,7 @@ wrap_up:
 	adm_log_passed_bins_during_wrap_up(&core->stat, n);
 	// Update current timeslot
     core->current_timeslot += ALGO_N_CORES * BATCH_SIZE;
+    core->batch_timeslot += ALGO_N_CORES * BATCH_SIZE;
 }
 
 // Reset state of all flows for which src is the sender
@@ -566,5 +913,6 @@ void seq_reset_sender(struct seq_admissible_status *status, uint16_t src) {
     uint16_t dst;
     for (dst = 0; dst < MAX_NODES; dst++) {
         backlog_reset_pair(&status->backlog, src, dst);
+        backlog_urgent_reset_pair(&status->backlog, src, dst);
     }
 }
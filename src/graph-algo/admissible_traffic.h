@@ -18,6 +18,16 @@ void seq_add_backlog(struct seq_admissible_status *status,
                      uint16_t src, uint16_t dst,
                      uint32_t amount);
 
+// Increase the urgent-class backlog from src to dst
+void seq_add_urgent_backlog(struct seq_admissible_status *status,
+                            uint16_t src, uint16_t dst,
+                            uint32_t amount);
+
+// Increase the backlog from src to dst, which should be allocated by deadline
+void seq_add_backlog_deadline(struct seq_admissible_status *status,
+                              uint16_t src, uint16_t dst,
+                              uint32_t amount, uint32_t deadline);
+
 // Flushes the backlog into admissible_status
 void seq_flush_backlog(struct seq_admissible_status *status);
 
@@ -71,6 +81,27 @@ uint16_t bin_index_from_timeslot(uint32_t last_allocated,
 	return BATCH_SIZE - 1 - (bin_gap & (BATCH_SIZE-1));
 }
 
+/**
+ * Returns the bin index for a flow with deadline @deadline, under the EDF
+ *    policy, when allocating a batch that starts with @current_timeslot.
+ *    Deadlines within NUM_BINS timeslots get a bin each, further deadlines
+ *    share a bin per power of two, and flows without a deadline go last.
+ */
+static inline __attribute__((always_inline))
+uint16_t bin_index_from_deadline(uint32_t deadline, uint64_t current_timeslot)
+{
+	int32_t slack = (int32_t)(deadline - (uint32_t)current_timeslot);
+	uint16_t index;
+
+	if (deadline == ADM_NO_DEADLINE)
+		return NUM_BINS + BATCH_SIZE - 1;
+	if (slack < NUM_BINS)
+		return (slack < 0) ? 0 : slack;
+
+	index = NUM_BINS + (31 - __builtin_clz(slack)) - NUM_BINS_SHIFT;
+	return (index < NUM_BINS + BATCH_SIZE - 1) ? index : NUM_BINS + BATCH_SIZE - 2;
+}
+
 static inline __attribute__((always_inline))
 uint32_t new_metric_after_alloc(uint16_t src, uint16_t dst, uint32_t old_metric,
 		uint16_t batch_timeslot,
@@ -0,0 +1,330 @@
+/*
+ * admissible_traffic_hierarchical.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "admissible_traffic_hierarchical.h"
+
+// Returns the first dst at or cyclically after start that src has backlog to
+// and allowed has set, or HIER_NONE. Only words of src's backlog bitmap that
+// are not empty are visited.
+static inline __attribute__((always_inline))
+uint16_t hier_next_dst(struct hier_admissible_status *status, uint16_t src,
+                       const uint64_t *allowed, uint16_t start)
+{
+    const uint64_t *active = status->active[src];
+    uint64_t words = status->active_words[src];
+    uint16_t w = start >> 6;
+    uint64_t word = active[w] & allowed[w] & (~0ULL << (start & 63));
+    uint64_t later, earlier;
+
+    if (word)
+        return (w << 6) + __builtin_ctzll(word);
+
+    /* words after w, then words up to and including w */
+    later = (w == 63) ? 0 : words & (~0ULL << (w + 1));
+    earlier = words & ((w == 63) ? ~0ULL : (2ULL << w) - 1);
+    while (later | earlier) {
+        if (later) {
+            w = __builtin_ctzll(later);
+            later &= later - 1;
+        } else {
+            w = __builtin_ctzll(earlier);
+            earlier &= earlier - 1;
+        }
+        word = active[w] & allowed[w];
+        if (word)
+            return (w << 6) + __builtin_ctzll(word);
+    }
+    return HIER_NONE;
+}
+
+static inline __attribute__((always_inline))
+void hier_set_bit(uint64_t *bitmap, uint16_t node)
+{
+    bitmap[node >> 6] |= 1ULL << (node & 63);
+}
+
+static inline __attribute__((always_inline))
+void hier_clear_bit(uint64_t *bitmap, uint16_t node)
+{
+    bitmap[node >> 6] &= ~(1ULL << (node & 63));
+}
+
+static inline __attribute__((always_inline))
+bool hier_test_bit(const uint64_t *bitmap, uint16_t node)
+{
+    return (bitmap[node >> 6] >> (node & 63)) & 1;
+}
+
+static inline __attribute__((always_inline))
+uint16_t hier_rack_size(struct hier_admissible_status *status, uint16_t rack)
+{
+    uint16_t first = rack << status->rack_shift;
+    uint16_t size = 1 << status->rack_shift;
+
+    return (status->num_nodes - first < size) ? status->num_nodes - first : size;
+}
+
+// Clears the bits of all hosts in rack
+static inline
+void hier_clear_rack(struct hier_admissible_status *status, uint64_t *bitmap,
+                     uint16_t rack)
+{
+    uint16_t node = rack << status->rack_shift;
+    uint16_t end = node + hier_rack_size(status, rack);
+    uint16_t n;
+
+    /* racks are aligned, so a rack smaller than a word is within one word */
+    while (node < end) {
+        n = (end - node < 64) ? end - node : 64;
+        bitmap[node >> 6] &= ~(((n == 64) ? ~0ULL : (1ULL << n) - 1) << (node & 63));
+        node += n;
+    }
+}
+
+void hier_add_backlog(struct hier_admissible_status *status, uint16_t src,
+                      uint16_t dst, uint32_t amount)
+{
+    uint32_t index = (src << FP_NODES_SHIFT) + dst;
+    uint16_t src_rack = hier_rack(status, src);
+    uint16_t dst_rack = hier_rack(status, dst);
+
+    assert(src < status->num_nodes && dst < status->num_nodes);
+
+    if (amount == 0)
+        return;
+
+    if (status->backlog[index] == 0) {
+        hier_set_bit(status->active[src], dst);
+        status->active_words[src] |= 1ULL << (dst >> 6);
+        if (status->src_to_rack[src][dst_rack]++ == 0)
+            status->rack_srcs[src_rack][dst_rack]++;
+        if (status->dst_from_rack[dst][src_rack]++ == 0)
+            status->rack_dsts[src_rack][dst_rack]++;
+    }
+    status->backlog[index] += amount;
+}
+
+/**
+ * Rack-to-rack quotas are handed out one edge at a time, round-robin over
+ *    the rack pairs, until racks run out of hosts or inter-rack capacity. A
+ *    pair wants as many edges as the fewer of its backlogged sources and
+ *    destinations, so quotas are max-min fair over what hosts can use.
+ */
+void hier_allocate_racks(struct hier_admissible_status *status)
+{
+    uint16_t src_cap[HIER_MAX_RACKS], dst_cap[HIER_MAX_RACKS];
+    uint16_t out_cap[HIER_MAX_RACKS], in_cap[HIER_MAX_RACKS];
+    uint16_t pairs[HIER_MAX_RACKS * HIER_MAX_RACKS];
+    uint16_t want[HIER_MAX_RACKS * HIER_MAX_RACKS];
+    uint16_t num_racks = status->num_racks;
+    uint16_t num_pairs = 0, num_left;
+    uint16_t i, j, src_rack, dst_rack;
+
+    for (i = 0; i < num_racks; i++) {
+        src_cap[i] = dst_cap[i] = hier_rack_size(status, i);
+        out_cap[i] = in_cap[i] = status->inter_rack_capacity;
+        memset(status->quota[i], 0, num_racks * sizeof(uint16_t));
+    }
+
+    /* pairs with demand, in an order that rotates every timeslot */
+    for (i = 0; i < num_racks; i++) {
+        src_rack = (i + status->rack_rr) % num_racks;
+        for (j = 0; j < num_racks; j++) {
+            dst_rack = (src_rack + j + status->rack_rr) % num_racks;
+            uint16_t n = status->rack_srcs[src_rack][dst_rack];
+            if (status->rack_dsts[src_rack][dst_rack] < n)
+                n = status->rack_dsts[src_rack][dst_rack];
+            if (n == 0)
+                continue;
+            want[num_pairs] = n;
+            pairs[num_pairs++] = src_rack * HIER_MAX_RACKS + dst_rack;
+        }
+    }
+    status->rack_rr = (status->rack_rr + 1) % num_racks;
+
+    /* one edge per pair per round; pairs that are done drop out */
+    while (num_pairs > 0) {
+        num_left = 0;
+        for (i = 0; i < num_pairs; i++) {
+            src_rack = pairs[i] / HIER_MAX_RACKS;
+            dst_rack = pairs[i] % HIER_MAX_RACKS;
+            if (src_cap[src_rack] == 0 || dst_cap[dst_rack] == 0)
+                continue;
+            if (src_rack != dst_rack) {
+                if (out_cap[src_rack] == 0 || in_cap[dst_rack] == 0)
+                    continue;
+                out_cap[src_rack]--;
+                in_cap[dst_rack]--;
+            }
+            src_cap[src_rack]--;
+            dst_cap[dst_rack]--;
+            if (++status->quota[src_rack][dst_rack] < want[i]) {
+                want[num_left] = want[i];
+                pairs[num_left++] = pairs[i];
+            }
+        }
+        num_pairs = num_left;
+    }
+}
+
+/**
+ * Each free host of src_rack proposes to its next backlogged destination, in
+ *    round-robin order, among free hosts of racks it still has quota to.
+ *    Touches only src_rack's hosts, quotas and proposal lists.
+ */
+void hier_request_rack(struct hier_admissible_status *status,
+                       uint16_t src_rack)
+{
+    uint64_t allowed[HIER_BITMAP_WORDS];
+    uint16_t num_words = (status->num_nodes + 63) / 64;
+    uint16_t src = src_rack << status->rack_shift;
+    uint16_t end = src + hier_rack_size(status, src_rack);
+    uint16_t dst, dst_rack, w;
+
+    for (w = 0; w < num_words; w++)
+        allowed[w] = ~status->dst_busy[w];
+    for (dst_rack = 0; dst_rack < status->num_racks; dst_rack++)
+        if (status->quota[src_rack][dst_rack] == 0)
+            hier_clear_rack(status, allowed, dst_rack);
+
+    for (; src < end; src++) {
+        if (status->active_words[src] == 0 ||
+            hier_test_bit(status->src_busy, src))
+            continue;
+
+        dst = hier_next_dst(status, src, allowed, status->src_rr[src]);
+        if (dst == HIER_NONE)
+            continue;
+
+        dst_rack = hier_rack(status, dst);
+        status->proposal[src] = dst;
+        hier_proposers(status, dst_rack, src_rack)
+            [status->num_proposers[dst_rack][src_rack]++] = src;
+        status->proposing_racks[dst_rack] |= 1ULL << src_rack;
+        if (--status->quota[src_rack][dst_rack] == 0)
+            hier_clear_rack(status, allowed, dst_rack);
+    }
+}
+
+// Admits src->dst, and updates backlog and round-robin pointers
+static inline __attribute__((always_inline))
+void hier_admit(struct hier_admissible_status *status, uint16_t src,
+                uint16_t dst, struct admitted_traffic *admitted)
+{
+    uint32_t index = (src << FP_NODES_SHIFT) + dst;
+    uint16_t src_rack = hier_rack(status, src);
+    uint16_t dst_rack = hier_rack(status, dst);
+
+    insert_admitted_edge(admitted, src, dst);
+    hier_set_bit(status->src_busy, src);
+    hier_set_bit(status->dst_busy, dst);
+    status->src_rr[src] = (dst + 1 == status->num_nodes) ? 0 : dst + 1;
+    status->dst_rr[dst] = (src + 1 == status->num_nodes) ? 0 : src + 1;
+
+    if (--status->backlog[index] > 0)
+        return;
+
+    hier_clear_bit(status->active[src], dst);
+    if (status->active[src][dst >> 6] == 0)
+        status->active_words[src] &= ~(1ULL << (dst >> 6));
+    if (--status->src_to_rack[src][dst_rack] == 0)
+        status->rack_srcs[src_rack][dst_rack]--;
+    if (--status->dst_from_rack[dst][src_rack] == 0)
+        status->rack_dsts[src_rack][dst_rack]--;
+}
+
+// How far node is after the round-robin pointer rr
+static inline __attribute__((always_inline))
+uint16_t hier_rr_distance(uint16_t node, uint16_t rr, uint16_t num_nodes)
+{
+    return (node >= rr) ? node - rr : node + num_nodes - rr;
+}
+
+/**
+ * Each host of dst_rack accepts the proposal from the source nearest after
+ *    its round-robin pointer. Rejected proposals return their quota. Touches
+ *    only dst_rack's hosts, quotas and proposal lists, and the (distinct)
+ *    sources that proposed to it.
+ */
+void hier_accept_rack(struct hier_admissible_status *status,
+                      uint16_t dst_rack, struct admitted_traffic *admitted)
+{
+    uint16_t num_nodes = status->num_nodes;
+    uint64_t racks = status->proposing_racks[dst_rack];
+    uint64_t left;
+    uint16_t src_rack, i, n, src, dst, best;
+    uint16_t *proposers;
+
+    /* pick the winner for each destination */
+    for (left = racks; left; left &= left - 1) {
+        src_rack = __builtin_ctzll(left);
+        proposers = hier_proposers(status, dst_rack, src_rack);
+        n = status->num_proposers[dst_rack][src_rack];
+        for (i = 0; i < n; i++) {
+            src = proposers[i];
+            dst = status->proposal[src];
+            best = status->best_proposal[dst];
+            if (best == HIER_NONE ||
+                hier_rr_distance(src, status->dst_rr[dst], num_nodes) <
+                hier_rr_distance(best, status->dst_rr[dst], num_nodes))
+                status->best_proposal[dst] = src;
+        }
+    }
+
+    /* admit winners, and return the quota of the rest */
+    for (left = racks; left; left &= left - 1) {
+        src_rack = __builtin_ctzll(left);
+        proposers = hier_proposers(status, dst_rack, src_rack);
+        n = status->num_proposers[dst_rack][src_rack];
+        for (i = 0; i < n; i++) {
+            src = proposers[i];
+            dst = status->proposal[src];
+            status->proposal[src] = HIER_NONE;
+            if (status->best_proposal[dst] == src) {
+                status->best_proposal[dst] = HIER_NONE;
+                hier_admit(status, src, dst, admitted);
+            } else {
+                status->quota[src_rack][dst_rack]++;
+            }
+        }
+        status->num_proposers[dst_rack][src_rack] = 0;
+    }
+    status->proposing_racks[dst_rack] = 0;
+}
+
+/**
+ * Allocates each timeslot on its own: rack quotas, then HIER_NUM_ITERATIONS
+ *    rounds of requests by every source rack followed by accepts by every
+ *    destination rack. A parallel driver would run the racks of each phase on
+ *    separate cores, each accepting into its own admitted_traffic, the way
+ *    pim emits one per partition.
+ */
+void hier_get_admissible_traffic(struct hier_admissible_status *status,
+                                 struct admitted_traffic **admitted,
+                                 uint16_t n_timeslots)
+{
+    uint16_t t, iter, rack;
+
+    for (t = 0; t < n_timeslots; t++) {
+        init_admitted_traffic(admitted[t]);
+        memset(status->src_busy, 0, sizeof(status->src_busy));
+        memset(status->dst_busy, 0, sizeof(status->dst_busy));
+
+        hier_allocate_racks(status);
+
+        for (iter = 0; iter < HIER_NUM_ITERATIONS; iter++) {
+            uint16_t prev_size = admitted[t]->size;
+
+            for (rack = 0; rack < status->num_racks; rack++)
+                hier_request_rack(status, rack);
+            for (rack = 0; rack < status->num_racks; rack++)
+                hier_accept_rack(status, rack, admitted[t]);
+
+            if (admitted[t]->size == prev_size)
+                break;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * admissible_traffic_hierarchical.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * A rack-aggregated allocator. Each timeslot, rack-to-rack capacity is
+ * allocated first, max-min fairly over the backlogged host pairs between
+ * racks. Host edges are then matched in rounds of requests and accepts: each
+ * source rack proposes edges within its quotas, and each destination rack
+ * accepts at most one proposal per host. Within a round, racks touch disjoint
+ * state, so the per-rack sub-allocators can run in parallel.
+ */
+
+#ifndef ADMISSIBLE_TRAFFIC_HIERARCHICAL_H_
+#define ADMISSIBLE_TRAFFIC_HIERARCHICAL_H_
+
+#include "admissible_structures_hierarchical.h"
+
+// Increase the backlog from src to dst
+void hier_add_backlog(struct hier_admissible_status *status, uint16_t src,
+                      uint16_t dst, uint32_t amount);
+
+// Allocate the next n_timeslots timeslots, one admitted_traffic each
+void hier_get_admissible_traffic(struct hier_admissible_status *status,
+                                 struct admitted_traffic **admitted,
+                                 uint16_t n_timeslots);
+
+// Allocate rack-to-rack quotas for one timeslot
+void hier_allocate_racks(struct hier_admissible_status *status);
+
+// Propose edges from the hosts of src_rack, within its quotas
+void hier_request_rack(struct hier_admissible_status *status,
+                       uint16_t src_rack);
+
+// Accept at most one proposal per host of dst_rack, into admitted
+void hier_accept_rack(struct hier_admissible_status *status,
+                      uint16_t dst_rack, struct admitted_traffic *admitted);
+
+#endif /* ADMISSIBLE_TRAFFIC_HIERARCHICAL_H_ */
@@ -18,16 +18,21 @@
 /**
  * Keeps backlogs between every source and destination
  *    n: the backlog for each pair
+ *    urgent: the urgent-class backlog for each pair, kept apart from n
  */
 struct backlog {
 	uint32_t n[MAX_NODES * MAX_NODES];
 	uint64_t is_active[(MAX_NODES * MAX_NODES + 63) / 64];
+	uint32_t urgent[MAX_NODES * MAX_NODES];
+	uint64_t urgent_is_active[(MAX_NODES * MAX_NODES + 63) / 64];
 };
 
 static void backlog_init(struct backlog *backlog) {
 	int i;
 	memset(backlog->n, 0 , sizeof(backlog->n));
 	memset(backlog->is_active, 0, sizeof(backlog->is_active));
+	memset(backlog->urgent, 0 , sizeof(backlog->urgent));
+	memset(backlog->urgent_is_active, 0, sizeof(backlog->urgent_is_active));
 }
 
 // Internal. Get the index of this flow in the status data structure
@@ -61,6 +66,30 @@ void backlog_reset_pair(struct backlog *backlog, uint16_t src,
     backlog->n[_backlog_index(src, dst)] = 0;
 }
 
+static inline __attribute__((always_inline))
+uint32_t backlog_urgent_get(struct backlog *backlog, uint16_t src, uint16_t dst) {
+	return backlog->urgent[_backlog_index(src, dst)];
+}
+
+/**
+ * Marks the urgent class of the (src,dst) pair as not being in the allocator
+ */
+static inline __attribute__((always_inline))
+void backlog_urgent_non_active(struct backlog *backlog, uint16_t src,
+		uint16_t dst) {
+	arr_unset_bit(backlog->urgent_is_active, _backlog_index(src, dst));
+}
+
+// Resets the urgent backlog for this src/dst pair
+static inline
+void backlog_urgent_reset_pair(struct backlog *backlog, uint16_t src,
+		uint16_t dst)
+{
+    assert(backlog != NULL);
+
+    backlog->urgent[_backlog_index(src, dst)] = 0;
+}
+
 /**
  * Increases backlog for (src,dst) by 'amount'.
  * @return true if backlog was 0 before the increase, false o/w
@@ -93,4 +122,54 @@ already_active:
 	return false;
 }
 
+/**
+ * Adds the amount carried by a newly active edge to the backlog, for
+ *    allocators that keep the whole backlog here (PIM) rather than in the edge
+ */
+static inline __attribute__((always_inline))
+void backlog_add(struct backlog *backlog, uint16_t src, uint16_t dst,
+		uint32_t amount) {
+	backlog->n[_backlog_index(src, dst)] += amount;
+}
+
+/**
+ * Decreases backlog for the (src,dst) pair by 1, for allocators that keep the
+ *    whole backlog here. When it reaches 0 the pair is no longer active.
+ * @return the remaining backlog
+ */
+static inline __attribute__((always_inline))
+uint32_t backlog_decrease(struct backlog *backlog, uint16_t src, uint16_t dst) {
+	uint32_t index = _backlog_index(src, dst);
+	uint32_t remaining = --backlog->n[index];
+
+	if (remaining == 0)
+		arr_unset_bit(backlog->is_active, index);
+	return remaining;
+}
+
+/**
+ * Increases the urgent backlog for (src,dst) by 'amount'.
+ * @return true if the urgent class was not active before the increase, false o/w
+ */
+static inline
+bool backlog_urgent_increase(struct backlog *backlog, uint16_t src,
+        uint16_t dst, uint32_t amount, struct admission_statistics *stat)
+{
+    assert(backlog != NULL);
+    assert(amount != 0);
+
+    uint32_t index = _backlog_index(src, dst);
+
+    adm_log_increased_urgent_backlog(stat, amount);
+    set_and_jmp_if_was_set(backlog->urgent_is_active, index, already_active);
+
+    assert(backlog->urgent[index] == 0);
+	return true;
+
+already_active:
+	/* the new backlog will get enqueued as the current one is spent */
+	backlog->urgent[index] += amount;
+	return false;
+}
+
 #endif /* BACKLOG_H_ */
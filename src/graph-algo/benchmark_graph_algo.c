@@ -12,6 +12,7 @@
 #include "algo_config.h"
 #include "fp_ring.h"
 #include "generate_requests.h"
+#include "generate_requests_batch.h"
 #include "admissible.h"
 #include "path_selection.h"
 #include "platform.h"
@@ -28,6 +29,24 @@
 #define ADMITTED_TRAFFIC_MEMPOOL_SIZE	(51*1000)
 #define ADMITTED_OUT_RING_LOG_SIZE		16
 #define READY_PARTITIONS_Q_SIZE                 2
+#define URGENT_FRACTION         0.95
+#define URGENT_NUM_NODES        256
+#define URGENT_PROBE_PERIOD     64  // one in this many requests is a probe
+#define NUM_FRACTIONS_D         7
+#define NUM_POLICIES_D          3
+#define DEADLINE_NUM_NODES      256
+#define DEADLINE_SLACK_FACTOR   2   // deadline slack per requested timeslot
+#define DEADLINE_SLACK_BASE     (2 * BATCH_SIZE)
+#define DEADLINE_NONE           0xFFFFFFFF  // no request pending
+#define NUM_FRACTIONS_G         2
+#define NUM_GEOMETRIES_G        6
+#define GEOMETRY_NUM_NODES      256
+#define GEOMETRY_SKEWED_MEAN    200  // mean request size of long-backlog flows
+#define GEOMETRY_MAX_GAP        (1 << 16)
+#define GENERATION_NUM_NODES    256
+#define GENERATION_NUM_REQUESTS (10 * 1000 * 1000)
+#define GENERATION_PARETO_ALPHA 1.5
+#define GENERATION_NUM_EMPIRICAL 6
 
 const double admissible_fractions [NUM_FRACTIONS_A] =
     {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99};
@@ -35,15 +54,66 @@ const uint32_t admissible_sizes [NUM_SIZES_A] =
     {256, /*2048, 1024, 512, 128, 64, 32, 16*/};
 const double path_fractions [NUM_FRACTIONS_P] =
     {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99};
+const double deadline_fractions [NUM_FRACTIONS_D] =
+    {0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99};
+const double geometry_fractions [NUM_FRACTIONS_G] =
+    {0.8, 0.95};
 const uint16_t path_capacities [NUM_CAPACITIES_P] =
     {4, 8, 16, 32};  // inter-rack capacities (32 machines per rack)
 const uint8_t path_num_racks [NUM_RACKS_P] =
     {32, 16, 8, 4};
+// a heavy-tailed empirical flow size distribution, in timeslots
+const uint16_t generation_empirical_sizes [GENERATION_NUM_EMPIRICAL] =
+    {1, 2, 4, 10, 100, 1000};
+const double generation_empirical_weights [GENERATION_NUM_EMPIRICAL] =
+    {0.4, 0.2, 0.15, 0.15, 0.07, 0.03};
 
 enum benchmark_type {
     ADMISSIBLE,
     PATH_SELECTION_OVERSUBSCRIPTION,
-    PATH_SELECTION_RACKS
+    PATH_SELECTION_RACKS,
+    URGENT_LATENCY,
+    DEADLINE_MISS,
+    BIN_GEOMETRY,
+    REQUEST_GENERATION
+};
+
+// Tracks how long backlogged flows wait between allocations, in the bin
+// geometry benchmark
+struct service_gap_state {
+    uint32_t pending[MAX_NODES * MAX_NODES];
+    uint32_t waiting_since[MAX_NODES * MAX_NODES];
+    uint32_t gap_histogram[GEOMETRY_MAX_GAP + 1];
+    uint64_t num_gaps;
+};
+
+// Tracks the outcome of each request in the deadline benchmark. Requests of a
+// flow are served in FIFO order; each is either met, missed, or dropped by the
+// allocator.
+struct deadline_state {
+    uint32_t *deadline;                         // per request
+    uint16_t *remaining;                        // per request
+    uint32_t *next;                             // per request, DEADLINE_NONE ends
+    uint32_t head[MAX_NODES * MAX_NODES];       // per flow
+    uint32_t tail[MAX_NODES * MAX_NODES];       // per flow
+    uint32_t dropped[MAX_NODES * MAX_NODES];    // last seen drop count per flow
+    uint32_t now;                               // allocator's current timeslot
+    uint32_t num_met;
+    uint32_t num_missed;
+    uint32_t num_dropped;
+};
+
+// Tracks latency probes for the urgent-class benchmark. Each flow has at most
+// one outstanding probe. Allocations of a flow are attributed to its urgent
+// demand first, matching the allocator's strict priority.
+struct probe_state {
+    uint32_t pending[2][MAX_NODES * MAX_NODES];  // per class
+    uint32_t served[2][MAX_NODES * MAX_NODES];   // per class
+    uint32_t target[MAX_NODES * MAX_NODES];      // served count completing probe
+    uint32_t issued_at[MAX_NODES * MAX_NODES];   // 0 if no outstanding probe
+    uint8_t prio[MAX_NODES * MAX_NODES];
+    uint32_t *latencies;
+    uint32_t num_latencies;
 };
 
 // Runs one experiment. Returns the number of packets admitted.
@@ -52,7 +122,7 @@ uint32_t run_experiment(struct request_info *requests, uint32_t start_time, uint
                         struct request_info **next_request,
                         uint32_t *per_batch_times)
 {
-    struct admitted_traffic *admitted;
+    struct admitted_traffic *admitted = NULL;
     struct fp_ring *queue_tmp;
 
     uint32_t b, start_b;
@@ -100,6 +170,581 @@ uint32_t run_experiment(struct request_info *requests, uint32_t start_time, uint
 	return num_admitted;
 }
 
+static inline void probe_add_demand(struct probe_state *ps,
+                                    struct admissible_state *status,
+                                    struct request_info *req, uint32_t timeslot,
+                                    bool is_probe, uint8_t probe_prio)
+{
+    uint32_t index = (req->src << FP_NODES_SHIFT) + req->dst;
+    uint8_t prio = ADM_PRIO_NORMAL;
+
+    if (is_probe && ps->issued_at[index] == 0)
+        prio = probe_prio;
+    else
+        is_probe = false;
+
+    if (prio == ADM_PRIO_URGENT)
+        add_urgent_backlog(status, req->src, req->dst, req->backlog);
+    else
+        add_backlog(status, req->src, req->dst, req->backlog);
+    ps->pending[prio][index] += req->backlog;
+
+    if (is_probe) {
+        ps->issued_at[index] = timeslot;
+        ps->prio[index] = prio;
+        ps->target[index] = ps->served[prio][index] + ps->pending[prio][index];
+    }
+}
+
+static inline void probe_admitted_edge(struct probe_state *ps,
+                                       struct admitted_edge *edge,
+                                       uint32_t timeslot, bool record)
+{
+    uint32_t index = (edge->src << FP_NODES_SHIFT) + edge->dst;
+    uint8_t prio = (ps->pending[ADM_PRIO_URGENT][index] > 0) ?
+            ADM_PRIO_URGENT : ADM_PRIO_NORMAL;
+
+    if (ps->pending[prio][index] == 0)
+        return;  // allocation beyond demand
+    ps->pending[prio][index]--;
+    ps->served[prio][index]++;
+
+    if (ps->issued_at[index] != 0 && ps->prio[index] == prio &&
+        ps->served[prio][index] == ps->target[index]) {
+        if (record)
+            ps->latencies[ps->num_latencies++] = timeslot - ps->issued_at[index];
+        ps->issued_at[index] = 0;
+    }
+}
+
+// Runs one experiment, issuing every URGENT_PROBE_PERIOD-th request as a probe
+// of class probe_prio. Records the latency of each probe, from the batch it
+// was issued until its last timeslot was admitted.
+void run_urgent_experiment(struct request_info *requests, uint32_t start_time,
+                           uint32_t end_time, uint32_t num_requests,
+                           struct admissible_state *status,
+                           struct request_info **next_request,
+                           struct probe_state *ps, uint8_t probe_prio,
+                           bool record)
+{
+    struct admitted_traffic *admitted = NULL;
+    uint32_t b;
+    uint16_t i, j;
+    struct request_info *current_request = requests;
+
+    assert(requests != NULL);
+
+    for (b = (start_time >> BATCH_SHIFT); b < (end_time >> BATCH_SHIFT); b++) {
+        // Issue all new requests for this batch
+        while ((current_request->timeslot >> BATCH_SHIFT) == (b % (65536 >> BATCH_SHIFT)) &&
+               current_request < requests + num_requests) {
+            bool is_probe = ((current_request - requests) % URGENT_PROBE_PERIOD == 0);
+            probe_add_demand(ps, status, current_request, b << BATCH_SHIFT,
+                             is_probe, probe_prio);
+            current_request++;
+        }
+        flush_backlog(status);
+
+        // Get admissible traffic
+        get_admissible_traffic(status, 0, 0, 1, 0);
+        handle_spent_demands(status);
+
+        for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+            fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
+            for (j = 0; j < admitted->size; j++)
+                probe_admitted_edge(ps, get_admitted_edge(admitted, j),
+                                    (b << BATCH_SHIFT) + i, record);
+            fp_mempool_put(get_admitted_traffic_mempool(status), admitted);
+        }
+    }
+
+    *next_request = current_request;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Measures latency of probe demands at URGENT_FRACTION load, with the probes
+// in the normal class and then in the urgent class
+void run_urgent_latency(struct admissible_state *status, uint32_t warm_up_duration,
+                        uint32_t duration, double mean)
+{
+    uint8_t probe_prio;
+    uint32_t num_nodes = URGENT_NUM_NODES;
+    uint32_t max_requests = duration * num_nodes;
+    struct request_info *requests = malloc(max_requests * sizeof(struct request_info));
+    struct probe_state *ps = malloc(sizeof(struct probe_state));
+    assert(requests != NULL);
+    assert(ps != NULL);
+    ps->latencies = malloc((max_requests / URGENT_PROBE_PERIOD + 1) * sizeof(uint32_t));
+    assert(ps->latencies != NULL);
+
+    printf("class, target_utilization, nodes, probes, mean_latency, p50_latency, p99_latency, max_latency\n");
+
+    for (probe_prio = ADM_PRIO_NORMAL; probe_prio <= ADM_PRIO_URGENT; probe_prio++) {
+        struct request_info *next_request;
+        uint32_t num_requests;
+        uint64_t sum = 0;
+        uint32_t k, n;
+
+        reset_admissible_state(status, false, 0, 0, num_nodes);
+        memset(ps->pending, 0, sizeof(ps->pending));
+        memset(ps->served, 0, sizeof(ps->served));
+        memset(ps->issued_at, 0, sizeof(ps->issued_at));
+        ps->num_latencies = 0;
+
+        /* same seed for both classes, so they see the same requests */
+        srand(1);
+        num_requests = generate_requests_poisson(requests, max_requests, num_nodes,
+                                                 duration, URGENT_FRACTION, mean);
+
+        run_urgent_experiment(requests, 0, warm_up_duration, num_requests, status,
+                              &next_request, ps, probe_prio, false);
+        run_urgent_experiment(next_request, warm_up_duration, duration,
+                              num_requests - (next_request - requests), status,
+                              &next_request, ps, probe_prio, true);
+
+        n = ps->num_latencies;
+        if (n == 0)
+            continue;
+        qsort(ps->latencies, n, sizeof(uint32_t), compare_u32);
+        for (k = 0; k < n; k++)
+            sum += ps->latencies[k];
+        printf("%s, %f, %d, %u, %f, %u, %u, %u\n",
+               (probe_prio == ADM_PRIO_URGENT) ? "urgent" : "normal",
+               URGENT_FRACTION, num_nodes, n, (double) sum / n,
+               ps->latencies[n / 2], ps->latencies[(n * 99) / 100],
+               ps->latencies[n - 1]);
+    }
+
+    free(ps->latencies);
+    free(ps);
+    free(requests);
+}
+
+static inline void deadline_add_demand(struct deadline_state *ds,
+                                       struct admissible_state *status,
+                                       struct request_info *requests,
+                                       uint32_t req_index, uint32_t timeslot)
+{
+    struct request_info *req = &requests[req_index];
+    uint32_t index = (req->src << FP_NODES_SHIFT) + req->dst;
+    uint32_t deadline = timeslot + DEADLINE_SLACK_FACTOR * req->backlog +
+            DEADLINE_SLACK_BASE;
+
+    add_backlog_deadline(status, req->src, req->dst, req->backlog, deadline);
+
+    ds->deadline[req_index] = deadline;
+    ds->remaining[req_index] = req->backlog;
+    ds->next[req_index] = DEADLINE_NONE;
+    if (ds->head[index] == DEADLINE_NONE)
+        ds->head[index] = req_index;
+    else
+        ds->next[ds->tail[index]] = req_index;
+    ds->tail[index] = req_index;
+}
+
+// Pops the head request of a flow, counting its outcome in counter
+static inline void deadline_pop(struct deadline_state *ds, uint32_t index,
+                                uint32_t *counter, bool record)
+{
+    if (record)
+        (*counter)++;
+    ds->head[index] = ds->next[ds->head[index]];
+}
+
+static inline void deadline_admitted_edge(struct deadline_state *ds,
+                                          struct admitted_edge *edge,
+                                          uint32_t timeslot, bool record)
+{
+    uint32_t index = (edge->src << FP_NODES_SHIFT) + edge->dst;
+    uint32_t req_index = ds->head[index];
+
+    if (req_index == DEADLINE_NONE)
+        return;  // allocation beyond demand
+    if (--ds->remaining[req_index] == 0)
+        deadline_pop(ds, index, (timeslot <= ds->deadline[req_index]) ?
+                     &ds->num_met : &ds->num_missed, record);
+}
+
+// Attributes timeslots dropped by the allocator to the oldest requests of the
+// flow
+static inline void deadline_check_drops(struct deadline_state *ds,
+                                        struct admissible_state *status,
+                                        uint16_t src, uint16_t dst, bool record)
+{
+    uint32_t index = (src << FP_NODES_SHIFT) + dst;
+    uint32_t dropped = get_deadline_dropped(status, src, dst);
+    uint32_t new_drops = dropped - ds->dropped[index];
+
+    ds->dropped[index] = dropped;
+    while (new_drops > 0 && ds->head[index] != DEADLINE_NONE) {
+        uint32_t req_index = ds->head[index];
+        uint16_t n = (new_drops < ds->remaining[req_index]) ?
+                new_drops : ds->remaining[req_index];
+
+        ds->remaining[req_index] -= n;
+        new_drops -= n;
+        if (ds->remaining[req_index] == 0)
+            deadline_pop(ds, index, &ds->num_dropped, record);
+    }
+}
+
+// Runs one experiment with deadlines. Records the outcome of each request
+// resolved during the experiment when record is set.
+void run_deadline_experiment(struct request_info *requests, uint32_t start_index,
+                             uint32_t start_time, uint32_t end_time,
+                             uint32_t num_requests, uint32_t num_nodes,
+                             struct admissible_state *status,
+                             uint32_t *next_index, struct deadline_state *ds,
+                             bool record)
+{
+    struct admitted_traffic *admitted = NULL;
+    uint32_t b;
+    uint16_t i, j, src, dst;
+    uint32_t current = start_index;
+    struct seq_admissible_status *seq_status =
+            (struct seq_admissible_status *) status;
+
+    for (b = (start_time >> BATCH_SHIFT); b < (end_time >> BATCH_SHIFT); b++) {
+        // Deadlines are in the allocator's timeslots, which keep counting
+        // across experiments
+        ds->now = seq_status->cores[0].current_timeslot;
+
+        // Issue all new requests for this batch
+        while (current < num_requests &&
+               (requests[current].timeslot >> BATCH_SHIFT) == (b % (65536 >> BATCH_SHIFT))) {
+            deadline_add_demand(ds, status, requests, current, ds->now);
+            current++;
+        }
+        flush_backlog(status);
+
+        // Get admissible traffic
+        get_admissible_traffic(status, 0, 0, 1, 0);
+        handle_spent_demands(status);
+
+        for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+            fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
+            for (j = 0; j < admitted->size; j++)
+                deadline_admitted_edge(ds, get_admitted_edge(admitted, j),
+                                       ds->now + i, record);
+            fp_mempool_put(get_admitted_traffic_mempool(status), admitted);
+        }
+
+        for (src = 0; src < num_nodes; src++)
+            for (dst = 0; dst < num_nodes; dst++)
+                deadline_check_drops(ds, status, src, dst, record);
+    }
+
+    *next_index = current;
+}
+
+// Measures the fraction of requests that miss their deadline as load varies,
+// under max-min allocation and under EDF with drop or degrade on infeasibility
+void run_deadline_miss(struct admissible_state *status, uint32_t warm_up_duration,
+                       uint32_t duration, double mean)
+{
+    const uint8_t policies[NUM_POLICIES_D] =
+        {ADM_POLICY_MAX_MIN, ADM_POLICY_EDF, ADM_POLICY_EDF};
+    const uint8_t actions[NUM_POLICIES_D] =
+        {ADM_DEADLINE_DROP, ADM_DEADLINE_DROP, ADM_DEADLINE_DEGRADE};
+    const char *names[NUM_POLICIES_D] = {"max_min", "edf_drop", "edf_degrade"};
+    uint32_t num_nodes = DEADLINE_NUM_NODES;
+    uint32_t max_requests = duration * num_nodes;
+    struct request_info *requests = malloc(max_requests * sizeof(struct request_info));
+    struct deadline_state *ds = malloc(sizeof(struct deadline_state));
+    uint8_t f, p;
+    assert(requests != NULL);
+    assert(ds != NULL);
+    ds->deadline = malloc(max_requests * sizeof(uint32_t));
+    ds->remaining = malloc(max_requests * sizeof(uint16_t));
+    ds->next = malloc(max_requests * sizeof(uint32_t));
+    assert(ds->deadline != NULL && ds->remaining != NULL && ds->next != NULL);
+
+    printf("policy, target_utilization, nodes, requests, met, missed, dropped, miss_rate\n");
+
+    for (f = 0; f < NUM_FRACTIONS_D; f++) {
+        for (p = 0; p < NUM_POLICIES_D; p++) {
+            uint32_t num_requests, next_index, index, resolved;
+
+            reset_admissible_state(status, false, 0, 0, num_nodes);
+            set_alloc_policy(status, policies[p], actions[p]);
+            memset(ds->head, 0xFF, sizeof(ds->head));
+            memset(ds->dropped, 0, sizeof(ds->dropped));
+            ds->num_met = ds->num_missed = ds->num_dropped = 0;
+
+            /* same seed for all policies, so they see the same requests */
+            srand(1);
+            num_requests = generate_requests_poisson(requests, max_requests,
+                                                     num_nodes, duration,
+                                                     deadline_fractions[f], mean);
+
+            run_deadline_experiment(requests, 0, 0, warm_up_duration,
+                                    num_requests, num_nodes, status,
+                                    &next_index, ds, false);
+            run_deadline_experiment(requests, next_index, warm_up_duration,
+                                    duration, num_requests, num_nodes, status,
+                                    &next_index, ds, true);
+
+            /* requests still pending past their deadline have missed it */
+            for (index = 0; index < MAX_NODES * MAX_NODES; index++) {
+                uint32_t req_index;
+                for (req_index = ds->head[index]; req_index != DEADLINE_NONE;
+                     req_index = ds->next[req_index])
+                    if ((int32_t) (ds->deadline[req_index] - ds->now) < BATCH_SIZE)
+                        ds->num_missed++;
+            }
+
+            resolved = ds->num_met + ds->num_missed + ds->num_dropped;
+            printf("%s, %f, %d, %u, %u, %u, %u, %f\n", names[p],
+                   deadline_fractions[f], num_nodes, resolved, ds->num_met,
+                   ds->num_missed, ds->num_dropped,
+                   (double) (ds->num_missed + ds->num_dropped) / resolved);
+        }
+    }
+
+    /* leave the default policy for any later experiment */
+    set_alloc_policy(status, ADM_POLICY_MAX_MIN, ADM_DEADLINE_DROP);
+
+    free(ds->next);
+    free(ds->remaining);
+    free(ds->deadline);
+    free(ds);
+    free(requests);
+}
+
+static inline void service_gap_admitted_edge(struct service_gap_state *gs,
+                                             struct admitted_edge *edge,
+                                             uint32_t timeslot, bool record)
+{
+    uint32_t index = (edge->src << FP_NODES_SHIFT) + edge->dst;
+    uint32_t gap;
+
+    if (gs->pending[index] == 0)
+        return;  // allocation beyond demand
+
+    gap = timeslot - gs->waiting_since[index];
+    if (record) {
+        gs->gap_histogram[(gap < GEOMETRY_MAX_GAP) ? gap : GEOMETRY_MAX_GAP]++;
+        gs->num_gaps++;
+    }
+    gs->pending[index]--;
+    gs->waiting_since[index] = timeslot;
+}
+
+// Returns the smallest gap that at least fraction of the gaps are within
+static uint32_t service_gap_percentile(struct service_gap_state *gs,
+                                       double fraction)
+{
+    uint64_t cum = 0;
+    uint32_t gap;
+
+    for (gap = 0; gap < GEOMETRY_MAX_GAP; gap++) {
+        cum += gs->gap_histogram[gap];
+        if (cum >= fraction * gs->num_gaps)
+            break;
+    }
+    return gap;
+}
+
+// Runs one experiment, recording service gaps of backlogged flows. Returns
+// the number of cycles spent allocating.
+uint64_t run_geometry_experiment(struct request_info *requests,
+                                 uint32_t start_time, uint32_t end_time,
+                                 uint32_t num_requests,
+                                 struct admissible_state *status,
+                                 struct request_info **next_request,
+                                 struct service_gap_state *gs,
+                                 uint32_t *num_admitted, bool record)
+{
+    struct admitted_traffic *admitted = NULL;
+    struct request_info *current_request = requests;
+    uint64_t cycles = 0;
+    uint64_t start;
+    uint32_t b;
+    uint16_t i, j;
+
+    for (b = (start_time >> BATCH_SHIFT); b < (end_time >> BATCH_SHIFT); b++) {
+        // Issue all new requests for this batch
+        while ((current_request->timeslot >> BATCH_SHIFT) == (b % (65536 >> BATCH_SHIFT)) &&
+               current_request < requests + num_requests) {
+            uint32_t index = (current_request->src << FP_NODES_SHIFT) +
+                    current_request->dst;
+            add_backlog(status, current_request->src, current_request->dst,
+                        current_request->backlog);
+            if (gs->pending[index] == 0)
+                gs->waiting_since[index] = b << BATCH_SHIFT;
+            gs->pending[index] += current_request->backlog;
+            current_request++;
+        }
+        flush_backlog(status);
+
+        // Get admissible traffic
+        start = current_time();
+        get_admissible_traffic(status, 0, 0, 1, 0);
+        handle_spent_demands(status);
+        cycles += current_time() - start;
+
+        for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+            fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
+            if (record)
+                *num_admitted += admitted->size;
+            for (j = 0; j < admitted->size; j++)
+                service_gap_admitted_edge(gs, get_admitted_edge(admitted, j),
+                                          (b << BATCH_SHIFT) + i, record);
+            fp_mempool_put(get_admitted_traffic_mempool(status), admitted);
+        }
+    }
+
+    *next_request = current_request;
+    return cycles;
+}
+
+// Compares bin geometries on a uniform workload of short requests and a
+// skewed one of long-backlog flows. Reports allocation cost, utilization,
+// and how long backlogged flows wait between allocations (max-min fairness
+// keeps these waits short and even).
+void run_bin_geometry(struct admissible_state *status, uint32_t warm_up_duration,
+                      uint32_t duration, double mean)
+{
+    const uint8_t modes[NUM_GEOMETRIES_G] =
+        {BIN_GEOM_FOLDED, BIN_GEOM_LINEAR, BIN_GEOM_LOG, BIN_GEOM_ADAPTIVE,
+         BIN_GEOM_LINEAR, BIN_GEOM_ADAPTIVE};
+    const uint8_t num_bins[NUM_GEOMETRIES_G] =
+        {BIN_GEOM_MAX_HISTORY_BINS, BIN_GEOM_MAX_HISTORY_BINS,
+         BIN_GEOM_MAX_HISTORY_BINS, BIN_GEOM_MAX_HISTORY_BINS, 8, 8};
+    const uint16_t widths[NUM_GEOMETRIES_G] = {1, 8, 1, 1, 32, 1};
+    const char *mode_names[] = {"folded", "linear", "log", "adaptive"};
+    const double means[2] = {mean, GEOMETRY_SKEWED_MEAN};
+    const char *workload_names[2] = {"uniform", "skewed"};
+    uint32_t num_nodes = GEOMETRY_NUM_NODES;
+    uint32_t max_requests = duration * num_nodes;
+    struct request_info *requests = malloc(max_requests * sizeof(struct request_info));
+    struct service_gap_state *gs = malloc(sizeof(struct service_gap_state));
+    uint8_t w, f, g;
+    assert(requests != NULL);
+    assert(gs != NULL);
+
+    printf("workload, geometry, history_bins, target_utilization, nodes, cycles_per_batch, observed_utilization, p50_gap, p99_gap, max_gap\n");
+
+    for (w = 0; w < 2; w++) {
+        for (f = 0; f < NUM_FRACTIONS_G; f++) {
+            for (g = 0; g < NUM_GEOMETRIES_G; g++) {
+                struct request_info *next_request;
+                uint32_t num_requests, num_admitted = 0;
+                uint32_t max_gap = GEOMETRY_MAX_GAP;
+                uint64_t cycles;
+
+                reset_admissible_state(status, false, 0, 0, num_nodes);
+                set_bin_geometry(status, modes[g], num_bins[g], widths[g]);
+                memset(gs, 0, sizeof(struct service_gap_state));
+
+                /* same seed for all geometries, so they see the same requests */
+                srand(1);
+                num_requests = generate_requests_poisson(requests, max_requests,
+                                                         num_nodes, duration,
+                                                         geometry_fractions[f],
+                                                         means[w]);
+
+                run_geometry_experiment(requests, 0, warm_up_duration,
+                                        num_requests, status, &next_request,
+                                        gs, &num_admitted, false);
+                cycles = run_geometry_experiment(next_request, warm_up_duration,
+                                                 duration,
+                                                 num_requests - (next_request - requests),
+                                                 status, &next_request, gs,
+                                                 &num_admitted, true);
+
+                while (max_gap > 0 && gs->gap_histogram[max_gap] == 0)
+                    max_gap--;
+                printf("%s, %s, %d, %f, %d, %f, %f, %u, %u, %u\n",
+                       workload_names[w], mode_names[modes[g]], num_bins[g],
+                       geometry_fractions[f], num_nodes,
+                       (double) cycles * BATCH_SIZE / (duration - warm_up_duration),
+                       (double) num_admitted / ((duration - warm_up_duration) * num_nodes),
+                       service_gap_percentile(gs, 0.5),
+                       service_gap_percentile(gs, 0.99), max_gap);
+            }
+        }
+    }
+
+    /* leave the default geometry for any later experiment */
+    set_bin_geometry(status, BIN_GEOM_FOLDED, BIN_GEOM_MAX_HISTORY_BINS, 1);
+
+    free(gs);
+    free(requests);
+}
+
+// Prints the rate at which the request generators produce requests, and the
+// demand sizes they produce
+void run_request_generation(double mean)
+{
+    const char *dist_names[] = {"exponential", "pareto", "empirical"};
+    struct request_generator *gen = malloc(sizeof(struct request_generator));
+    struct batch_request_generator *bgen = malloc(sizeof(struct batch_request_generator));
+    struct request_batch *batch = malloc(sizeof(struct request_batch));
+    struct request req;
+    uint64_t start_time, end_time;
+    uint64_t sum_backlog;
+    uint16_t max_backlog;
+    uint32_t i, j;
+    uint8_t d;
+    assert(gen != NULL && bgen != NULL && batch != NULL);
+
+    printf("generator, size_distribution, nodes, requests_per_sec, mean_backlog, max_backlog\n");
+
+    /* per-request generator, with the table of exponentials */
+    srand(1);
+    init_request_generator(gen, mean, 0, GENERATION_NUM_NODES, mean);
+    sum_backlog = 0;
+    max_backlog = 0;
+    start_time = current_time();
+    for (i = 0; i < GENERATION_NUM_REQUESTS; i++) {
+        get_next_request(gen, &req);
+        sum_backlog += req.backlog;
+        if (req.backlog > max_backlog)
+            max_backlog = req.backlog;
+    }
+    end_time = current_time();
+    printf("table, exponential, %d, %f, %f, %u\n", GENERATION_NUM_NODES,
+           GENERATION_NUM_REQUESTS * PROCESSOR_SPEED * 1e9 / (end_time - start_time),
+           (double) sum_backlog / GENERATION_NUM_REQUESTS, max_backlog);
+
+    /* batch generator, for each size distribution */
+    for (d = REQ_SIZE_EXPONENTIAL; d <= REQ_SIZE_EMPIRICAL; d++) {
+        batch_gen_init(bgen, 1, mean, 0, GENERATION_NUM_NODES, mean);
+        if (d == REQ_SIZE_PARETO)
+            batch_gen_set_pareto(bgen, mean, GENERATION_PARETO_ALPHA);
+        else if (d == REQ_SIZE_EMPIRICAL)
+            batch_gen_set_empirical(bgen, generation_empirical_sizes,
+                                    generation_empirical_weights,
+                                    GENERATION_NUM_EMPIRICAL);
+        sum_backlog = 0;
+        max_backlog = 0;
+        start_time = current_time();
+        for (i = 0; i < GENERATION_NUM_REQUESTS; i += REQ_BATCH_SIZE) {
+            batch_gen_fill(bgen, batch, REQ_BATCH_SIZE);
+            for (j = 0; j < REQ_BATCH_SIZE; j++) {
+                sum_backlog += batch->backlog[j];
+                if (batch->backlog[j] > max_backlog)
+                    max_backlog = batch->backlog[j];
+            }
+        }
+        end_time = current_time();
+        printf("batch, %s, %d, %f, %f, %u\n", dist_names[d], GENERATION_NUM_NODES,
+               (double) i * PROCESSOR_SPEED * 1e9 / (end_time - start_time),
+               (double) sum_backlog / i, max_backlog);
+    }
+
+    free(batch);
+    free(bgen);
+    free(gen);
+}
+
 // Runs the admissible algorithm for many timeslots, saving the admitted traffic for
 // further benchmarking
 void run_admissible(struct request_info *requests, uint32_t start_time, uint32_t end_time,
@@ -136,7 +781,7 @@ void run_admissible(struct request_info *requests, uint32_t start_time, uint32_t
 
 void print_usage(char **argv) {
     printf("usage: %s benchmark_type\n", argv[0]);
-    printf("\tbenchmark_type=0 for admissible traffic benchmark, benchmark_type=1 for path selection benchmark (vary oversubscription ratio), benchmark_type=2 for path selection (vary #racks)\n");
+    printf("\tbenchmark_type=0 for admissible traffic benchmark, benchmark_type=1 for path selection benchmark (vary oversubscription ratio), benchmark_type=2 for path selection (vary #racks), benchmark_type=3 for urgent-class latency, benchmark_type=4 for deadline miss rate, benchmark_type=5 for bin geometries, benchmark_type=6 for request generation rate\n");
 }
 
 int main(int argc, char **argv)
@@ -155,6 +800,14 @@ int main(int argc, char **argv)
         benchmark_type = PATH_SELECTION_OVERSUBSCRIPTION;
     else if (type == 2)
         benchmark_type = PATH_SELECTION_RACKS;
+    else if (type == 3)
+        benchmark_type = URGENT_LATENCY;
+    else if (type == 4)
+        benchmark_type = DEADLINE_MISS;
+    else if (type == 5)
+        benchmark_type = BIN_GEOMETRY;
+    else if (type == 6)
+        benchmark_type = REQUEST_GENERATION;
     else {
         print_usage(argv);
         return -1;
@@ -165,6 +818,11 @@ int main(int argc, char **argv)
     uint32_t duration = warm_up_duration + ((50000 + 127) / 128) * 128;
     double mean = 10; // Mean request size and inter-arrival time
 
+    if (benchmark_type == REQUEST_GENERATION) {
+        run_request_generation(mean);
+        return 0;
+    }
+
     /* sanity checks */
 #if (ALGO_N_CORES != 1)
 #error "benchmark only supports ALGO_N_CORES == 1"
@@ -260,6 +918,24 @@ int main(int argc, char **argv)
         exit(-1);
     }
 
+    if (benchmark_type == URGENT_LATENCY) {
+        run_urgent_latency(status, warm_up_duration, duration, mean);
+        free(status);
+        return 0;
+    }
+
+    if (benchmark_type == DEADLINE_MISS) {
+        run_deadline_miss(status, warm_up_duration, duration, mean);
+        free(status);
+        return 0;
+    }
+
+    if (benchmark_type == BIN_GEOMETRY) {
+        run_bin_geometry(status, warm_up_duration, duration, mean);
+        free(status);
+        return 0;
+    }
+
     /* allocate space to record times */
     uint16_t num_batches = (duration - warm_up_duration) / BATCH_SIZE;
     uint32_t *per_batch_times = malloc(sizeof(uint64_t) * num_batches);
@@ -366,7 +1042,7 @@ int main(int argc, char **argv)
                 uint32_t num_admitted = 0;
                 uint64_t prev_time = current_time();
                 for (k = 0; k < duration - warm_up_duration; k++) {
-                    struct admitted_traffic *admitted;
+                    struct admitted_traffic *admitted = NULL;
 
                     /* get admitted traffic */
                     fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
@@ -31,7 +31,7 @@ uint32_t run_experiment(struct request_info *requests, uint32_t start_time, uint
                         struct admission_core_state *core,
                         struct admitted_traffic **admitted_batch)
 {
-    struct admitted_traffic *admitted;
+    struct admitted_traffic *admitted = NULL;
     struct fp_ring *queue_tmp;
 
     uint32_t b;
@@ -10,11 +10,16 @@
 #ifndef BIN_H_
 #define BIN_H_
 
+// Demand classes. Urgent demands are allocated with strict priority
+#define ADM_PRIO_NORMAL		0
+#define ADM_PRIO_URGENT		1
+
 // The backlog info for one src-dst pair
 struct backlog_edge {
     uint16_t src;
     uint16_t dst;
     uint16_t backlog;
+    uint16_t prio;
     uint32_t metric;
 };
 
@@ -37,18 +42,26 @@ bool is_empty_bin(struct bin *bin) {
     return bin->size == 0;
 }
 
-// Insert new edge to the back of this bin
+// Insert new edge of the given demand class to the back of this bin
 static inline __attribute__((always_inline))
-void enqueue_bin(struct bin *bin, uint16_t src, uint16_t dst, uint16_t backlog,
-		uint32_t metric) {
+void enqueue_bin_prio(struct bin *bin, uint16_t src, uint16_t dst,
+		uint16_t backlog, uint32_t metric, uint16_t prio) {
     assert(bin != NULL);
     uint32_t n = bin->size++;
     bin->edges[n].src = src;
     bin->edges[n].dst = dst;
     bin->edges[n].backlog = backlog;
+    bin->edges[n].prio = prio;
     bin->edges[n].metric = metric;
 }
 
+// Insert new edge to the back of this bin
+static inline __attribute__((always_inline))
+void enqueue_bin(struct bin *bin, uint16_t src, uint16_t dst, uint16_t backlog,
+		uint32_t metric) {
+    enqueue_bin_prio(bin, src, dst, backlog, metric, ADM_PRIO_NORMAL);
+}
+
 // Insert new edge to the back of this bin, when given an edge already.
 static inline __attribute__((always_inline))
 void enqueue_bin_edge(struct bin *bin, struct backlog_edge *edge) {
@@ -0,0 +1,178 @@
+/*
+ * bin_geometry.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef BIN_GEOMETRY_H_
+#define BIN_GEOMETRY_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "batch.h"
+
+#define NUM_BINS_SHIFT 5
+#define NUM_BINS 32 // 2^NUM_BINS_SHIFT
+
+/**
+ * A flow's bin is chosen by its gap, the number of timeslots from its last
+ *    allocation to the end of the batch being allocated. Gaps up to BATCH_SIZE
+ *    always get a bin each (NUM_BINS - 1 and up), since flows are re-binned
+ *    there as they are allocated. Older flows go to the history bins below,
+ *    whose layout is the geometry.
+ */
+#define BIN_GEOM_FOLDED			0	/* bin_index_from_timeslot's fixed folding */
+#define BIN_GEOM_LINEAR			1	/* history bins of equal width */
+#define BIN_GEOM_LOG			2	/* history bins doubling in width */
+#define BIN_GEOM_ADAPTIVE		3	/* history bins of equal observed population */
+
+#define BIN_GEOM_MAX_HISTORY_BINS	(NUM_BINS - 1)
+#define BIN_GEOM_MAX_GAP			2047	/* larger gaps share the oldest bin */
+/* adaptive geometry is retuned after this many binned flows */
+#define BIN_GEOM_RETUNE_SAMPLES		(4 * 1024)
+
+struct bin_geometry {
+	uint8_t mode;
+	uint8_t num_bins;		/* history bins in use */
+	uint16_t width;			/* gap covered by each bin, in linear mode */
+	uint32_t n_samples;		/* adaptive: flows binned since last retune */
+	uint8_t gap_to_bin[BIN_GEOM_MAX_GAP + 1];
+	uint32_t gap_hist[BIN_GEOM_MAX_GAP + 1];	/* adaptive: observed gaps */
+};
+
+/* bin index of the k'th newest history bin */
+static inline uint8_t bin_geometry_history_bin(uint16_t k)
+{
+	return NUM_BINS - 2 - k;
+}
+
+/**
+ * Fills the gap table, given the upper gap bound of each history bin.
+ *    @upper is indexed from the newest bin.
+ */
+static inline void bin_geometry_fill(struct bin_geometry *geom,
+		const uint32_t *upper)
+{
+	uint32_t gap;
+	uint16_t k = 0;
+
+	for (gap = 0; gap <= BATCH_SIZE; gap++)
+		geom->gap_to_bin[gap] = NUM_BINS + BATCH_SIZE - 1 - gap;
+
+	for (; gap <= BIN_GEOM_MAX_GAP; gap++) {
+		while (k < geom->num_bins - 1 && gap - BATCH_SIZE > upper[k])
+			k++;
+		geom->gap_to_bin[gap] = bin_geometry_history_bin(k);
+	}
+}
+
+/* layout of history bins doubling in width: 1, 2, 4, ... */
+static inline void bin_geometry_build_log(struct bin_geometry *geom)
+{
+	uint32_t upper[BIN_GEOM_MAX_HISTORY_BINS];
+	uint16_t k;
+
+	for (k = 0; k < geom->num_bins; k++)
+		upper[k] = (2U << k) - 1;
+	bin_geometry_fill(geom, upper);
+}
+
+/**
+ * Retunes adaptive history bins so each holds about the same share of the
+ *    observed flows, then decays the observations so the layout follows
+ *    changes in the workload.
+ */
+static inline void bin_geometry_retune(struct bin_geometry *geom)
+{
+	uint32_t upper[BIN_GEOM_MAX_HISTORY_BINS];
+	uint64_t total = 0;
+	uint64_t cum = 0;
+	uint32_t gap;
+	uint16_t k = 0;
+
+	for (gap = BATCH_SIZE + 1; gap <= BIN_GEOM_MAX_GAP; gap++)
+		total += geom->gap_hist[gap];
+
+	if (total < geom->num_bins) {
+		/* too few old flows to tell */
+		bin_geometry_build_log(geom);
+	} else {
+		for (gap = BATCH_SIZE + 1; gap <= BIN_GEOM_MAX_GAP; gap++) {
+			cum += geom->gap_hist[gap];
+			/* close bin k once it has its share */
+			while (k < geom->num_bins && cum * geom->num_bins >= total * (k + 1))
+				upper[k++] = gap - BATCH_SIZE;
+		}
+		for (; k < geom->num_bins; k++)
+			upper[k] = BIN_GEOM_MAX_GAP;
+		bin_geometry_fill(geom, upper);
+	}
+
+	for (gap = 0; gap <= BIN_GEOM_MAX_GAP; gap++)
+		geom->gap_hist[gap] >>= 1;
+	geom->n_samples = 0;
+}
+
+/**
+ * Initializes a geometry. @num_bins is the number of history bins, at most
+ *    BIN_GEOM_MAX_HISTORY_BINS; @width is only used by the linear mode.
+ *    Returns 0 on success, -1 on bad parameters.
+ */
+static inline int bin_geometry_init(struct bin_geometry *geom, uint8_t mode,
+		uint8_t num_bins, uint16_t width)
+{
+	uint32_t upper[BIN_GEOM_MAX_HISTORY_BINS];
+	uint16_t k;
+
+	if (mode > BIN_GEOM_ADAPTIVE || num_bins == 0 ||
+			num_bins > BIN_GEOM_MAX_HISTORY_BINS ||
+			(mode == BIN_GEOM_LINEAR && width == 0))
+		return -1;
+
+	geom->mode = mode;
+	geom->num_bins = num_bins;
+	geom->width = width;
+	geom->n_samples = 0;
+	memset(geom->gap_hist, 0, sizeof(geom->gap_hist));
+
+	switch (mode) {
+	case BIN_GEOM_LINEAR:
+		for (k = 0; k < num_bins; k++)
+			upper[k] = (uint32_t)(k + 1) * width;
+		bin_geometry_fill(geom, upper);
+		break;
+	case BIN_GEOM_LOG:
+	case BIN_GEOM_ADAPTIVE:
+		/* adaptive starts out logarithmic */
+		bin_geometry_build_log(geom);
+		break;
+	default:
+		/* folded mode computes bins directly */
+		break;
+	}
+	return 0;
+}
+
+/**
+ * Returns the bin index of a flow last allocated at @last_allocated, when
+ *    allocating a batch that starts with @current_timeslot. Not for the folded
+ *    mode.
+ */
+static inline __attribute__((always_inline))
+uint16_t bin_geometry_index(struct bin_geometry *geom, uint32_t last_allocated,
+		uint64_t current_timeslot)
+{
+	uint32_t gap = (uint32_t)(current_timeslot + BATCH_SIZE) - last_allocated;
+
+	if (gap > BIN_GEOM_MAX_GAP)
+		gap = BIN_GEOM_MAX_GAP;
+
+	if (geom->mode == BIN_GEOM_ADAPTIVE) {
+		geom->gap_hist[gap]++;
+		geom->n_samples++;
+	}
+	return geom->gap_to_bin[gap];
+}
+
+#endif /* BIN_GEOMETRY_H_ */
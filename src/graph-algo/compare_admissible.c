@@ -0,0 +1,118 @@
+/*
+ * compare_admissible.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Wraps the allocator selected in admissible.h for compare_allocators. Built
+ * twice: with PIPELINED_ALGO as cmp_pipelined, and with PARALLEL_ALGO as
+ * cmp_pim.
+ */
+
+#include <stdlib.h>
+
+#include "admissible.h"
+#include "compare_allocators.h"
+#include "fp_ring.h"
+#include "platform.h"
+
+#ifdef PARALLEL_ALGO
+#define CMP_ALLOCATOR				cmp_pim
+#define CMP_ALLOCATOR_NAME			"pim"
+#else
+#define CMP_ALLOCATOR				cmp_pipelined
+#define CMP_ALLOCATOR_NAME			"pipelined"
+#endif
+
+/* enough bins for every flow to be backlogged, with room to spare */
+#define CMP_BIN_MEMPOOL_SIZE			(2 * MAX_NODES * MAX_NODES / SMALL_BIN_SIZE)
+#define CMP_ADMITTED_MEMPOOL_SIZE		(4 * ADMITTED_PER_BATCH)
+#define CMP_ADMITTED_OUT_RING_LOG_SIZE	8
+#define CMP_READY_PARTITIONS_LOG_SIZE	2
+
+static void *cmp_create(uint16_t num_nodes)
+{
+	struct fp_ring *q_bin[NUM_BIN_RINGS + 1];
+	struct fp_ring *q_ready_partitions[NUM_BIN_RINGS + 1];
+	struct fp_ring *q_head, *q_admitted_out, *q_spent;
+	struct fp_mempool *bin_mempool, *admitted_traffic_mempool;
+	struct admissible_state *state;
+	int i;
+
+	q_head = fp_ring_create(2 * FP_NODES_SHIFT);
+	q_admitted_out = fp_ring_create(CMP_ADMITTED_OUT_RING_LOG_SIZE);
+	q_spent = fp_ring_create(2 * FP_NODES_SHIFT);
+	bin_mempool = fp_mempool_create(CMP_BIN_MEMPOOL_SIZE,
+			bin_num_bytes(SMALL_BIN_SIZE));
+	admitted_traffic_mempool = fp_mempool_create(CMP_ADMITTED_MEMPOOL_SIZE,
+			sizeof(struct admitted_traffic));
+	if (!q_head || !q_admitted_out || !q_spent || !bin_mempool ||
+			!admitted_traffic_mempool)
+		return NULL;
+
+#ifdef PARALLEL_ALGO
+	for (i = 0; i < NUM_BIN_RINGS; i++) {
+		q_bin[i] = fp_ring_create(BIN_RING_SHIFT);
+		q_ready_partitions[i] = fp_ring_create(CMP_READY_PARTITIONS_LOG_SIZE);
+		if (!q_bin[i] || !q_ready_partitions[i])
+			return NULL;
+	}
+#else
+	(void) i;
+	q_bin[0] = fp_ring_create(2 * FP_NODES_SHIFT);
+	if (!q_bin[0])
+		return NULL;
+#endif
+
+	state = create_admissible_state(false, 0, 0, num_nodes, q_head,
+			q_admitted_out, q_spent, bin_mempool, admitted_traffic_mempool,
+			q_bin, q_bin, q_ready_partitions);
+	return state;
+}
+
+static void cmp_add_backlog(void *state, uint16_t src, uint16_t dst,
+		uint32_t amount)
+{
+	add_backlog((struct admissible_state *) state, src, dst, amount);
+}
+
+/**
+ * Allocates BATCH_SIZE timeslots. The admitted traffic comes out as
+ *    ADMITTED_PER_BATCH structs: one per timeslot for the pipelined allocator,
+ *    one per partition of the timeslot for pim.
+ */
+static void cmp_allocate(void *state, struct cmp_timeslot *out)
+{
+	struct admissible_state *status = (struct admissible_state *) state;
+	struct admitted_traffic *admitted = NULL;
+	uint16_t i, j;
+
+	for (i = 0; i < BATCH_SIZE; i++)
+		out[i].n = 0;
+
+	flush_backlog(status);
+	get_admissible_traffic(status, 0, 0, 1, 0);
+#ifdef PIPELINED_ALGO
+	handle_spent_demands(status);
+#endif
+
+	for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+		struct cmp_timeslot *tslot = &out[i * BATCH_SIZE / ADMITTED_PER_BATCH];
+
+		fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
+		for (j = 0; j < admitted->size; j++) {
+			struct admitted_edge *edge = get_admitted_edge(admitted, j);
+			tslot->src[tslot->n] = edge->src;
+			tslot->dst[tslot->n] = edge->dst;
+			tslot->n++;
+		}
+		fp_mempool_put(get_admitted_traffic_mempool(status), admitted);
+	}
+}
+
+const struct cmp_allocator CMP_ALLOCATOR = {
+	.name = CMP_ALLOCATOR_NAME,
+	.batch_size = BATCH_SIZE,
+	.create = cmp_create,
+	.add_backlog = cmp_add_backlog,
+	.allocate = cmp_allocate,
+};
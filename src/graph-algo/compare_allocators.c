@@ -0,0 +1,402 @@
+/*
+ * compare_allocators.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Feeds the same request trace to each allocator and reports schedule
+ * quality and cost side by side: the pipelined max-min allocator
+ * (admissible_traffic.c), shortest-job-first (admissible_traffic_sjf.c),
+ * pim (../grant-accept) and the rack-aggregated allocator
+ * (admissible_traffic_hierarchical.c). Built with CMP_LARGE_CLUSTER (and a
+ * larger MAX_NODES) as compare_allocators_large, with only the pipelined and
+ * hierarchical allocators, since sjf and pim are sized for 256 nodes.
+ *
+ * Flows arrive as a Poisson process at each sender, with sizes (in MTUs) from
+ * generate_requests_batch.h. An allocator is called every batch_size
+ * timeslots with the demand of the flows that arrived before the call, and
+ * its admitted edges are served from the oldest flow of each (src, dst).
+ * There are no control or network delays, so differences in FCT come from the
+ * allocators alone, batching included. A flow's FCT runs from its arrival to
+ * the end of the timeslot of its last packet.
+ *
+ * For each allocator, over flows that arrive after the warm-up:
+ *  - admitted_util: admitted edges per node per timeslot
+ *  - FCT mean and percentiles, in timeslots
+ *  - jain_fairness: Jain's index of the flows' rates (size / FCT)
+ *  - ns_per_timeslot: wall time spent in the allocator, adding demand and
+ *    allocating, per timeslot
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "compare_allocators.h"
+#include "generate_requests_batch.h"
+
+#define CMP_MAX_FCT_HISTOGRAM           (1 << 20)
+#define CMP_FLOW_NONE                   0xFFFFFFFF
+
+#define CMP_DEFAULT_NODES               256
+#define CMP_DEFAULT_UTILIZATION         0.8
+#define CMP_DEFAULT_WARM_UP             10000
+#define CMP_DEFAULT_DURATION            50000
+#define CMP_DEFAULT_MEAN_SIZE           10
+
+#ifdef CMP_LARGE_CLUSTER
+#define CMP_MAX_ALLOCATORS              2
+static const struct cmp_allocator *all_allocators[CMP_MAX_ALLOCATORS] =
+    { &cmp_pipelined, &cmp_hierarchical };
+#else
+#define CMP_MAX_ALLOCATORS              4
+static const struct cmp_allocator *all_allocators[CMP_MAX_ALLOCATORS] =
+    { &cmp_pipelined, &cmp_sjf, &cmp_pim, &cmp_hierarchical };
+#endif
+
+struct cmp_params {
+    uint16_t num_nodes;
+    double utilization;
+    uint64_t warm_up;
+    uint64_t duration;
+    double mean_size;
+    uint8_t size_dist;
+    double pareto_alpha;
+    uint64_t seed;
+};
+
+// The flows, in order of arrival
+struct cmp_trace {
+    uint32_t n;
+    uint64_t *time;
+    uint16_t *src;
+    uint16_t *dst;
+    uint16_t *size;
+    uint64_t offered;       // packets of flows arriving after the warm-up
+};
+
+struct cmp_result {
+    uint64_t num_admitted;  // in the measurement interval
+    uint64_t num_wasted;    // allocations beyond demand
+    uint64_t num_completed;
+    uint64_t num_incomplete;
+    uint64_t sum_fct;
+    double sum_rate;
+    double sum_rate_sq;
+    uint64_t alloc_ns;
+    uint64_t alloc_timeslots;
+    uint32_t fct_histogram[CMP_MAX_FCT_HISTOGRAM];
+};
+
+// Per-flow state while running one allocator. Flows of each (src, dst) are
+// served in FIFO order.
+struct cmp_flows {
+    uint32_t *next;
+    uint16_t *unsent;       // packets not yet admitted
+    uint32_t head[MAX_NODES * MAX_NODES];
+    uint32_t tail[MAX_NODES * MAX_NODES];
+    uint64_t outstanding;   // recorded flows not yet complete
+};
+
+static void generate_trace(struct cmp_params *p, struct cmp_trace *trace)
+{
+    struct batch_request_generator gen;
+    struct request_batch batch;
+    uint32_t capacity = 0;
+    uint32_t i;
+
+    /* each sender offers utilization of its link */
+    batch_gen_init(&gen, p->seed, p->mean_size / p->utilization, 0,
+                   p->num_nodes, p->mean_size);
+    if (p->size_dist == REQ_SIZE_PARETO)
+        batch_gen_set_pareto(&gen, p->mean_size, p->pareto_alpha);
+
+    memset(trace, 0, sizeof(*trace));
+    for (;;) {
+        batch_gen_fill(&gen, &batch, REQ_BATCH_SIZE);
+        for (i = 0; i < REQ_BATCH_SIZE; i++) {
+            uint64_t time = (uint64_t) batch.time[i];
+            if (time >= p->duration)
+                return;
+
+            if (trace->n == capacity) {
+                capacity = capacity ? 2 * capacity : (1 << 16);
+                trace->time = realloc(trace->time, capacity * sizeof(uint64_t));
+                trace->src = realloc(trace->src, capacity * sizeof(uint16_t));
+                trace->dst = realloc(trace->dst, capacity * sizeof(uint16_t));
+                trace->size = realloc(trace->size, capacity * sizeof(uint16_t));
+                assert(trace->time && trace->src && trace->dst && trace->size);
+            }
+            trace->time[trace->n] = time;
+            trace->src[trace->n] = batch.src[i];
+            trace->dst[trace->n] = batch.dst[i];
+            trace->size[trace->n] = batch.backlog[i];
+            if (time >= p->warm_up)
+                trace->offered += batch.backlog[i];
+            trace->n++;
+        }
+    }
+}
+
+// Admits one packet of the oldest flow from src to dst in timeslot tx_time
+static void serve_packet(struct cmp_params *p, struct cmp_trace *trace,
+                         struct cmp_flows *flows, struct cmp_result *res,
+                         const char *name, FILE *flow_file, uint16_t src,
+                         uint16_t dst, uint64_t tx_time)
+{
+    uint32_t index = (src << FP_NODES_SHIFT) + dst;
+    uint32_t f = flows->head[index];
+    uint64_t fct;
+    double rate;
+
+    if (f == CMP_FLOW_NONE) {
+        res->num_wasted++;
+        return;
+    }
+    if (--flows->unsent[f] > 0)
+        return;
+
+    flows->head[index] = flows->next[f];
+    if (trace->time[f] < p->warm_up)
+        return;
+
+    fct = tx_time + 1 - trace->time[f];
+    rate = (double) trace->size[f] / fct;
+    res->num_completed++;
+    res->sum_fct += fct;
+    res->sum_rate += rate;
+    res->sum_rate_sq += rate * rate;
+    res->fct_histogram[(fct < CMP_MAX_FCT_HISTOGRAM) ?
+                       fct : CMP_MAX_FCT_HISTOGRAM - 1]++;
+    flows->outstanding--;
+    if (flow_file != NULL)
+        fprintf(flow_file, "%s, %f, %" PRIu64 ", %" PRIu64 ", %" PRIu64
+                ", %d, %d, %d\n", name, p->utilization, fct, trace->time[f],
+                trace->time[f] + fct, src, dst, trace->size[f]);
+}
+
+static inline uint64_t elapsed_ns(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000ULL +
+            end->tv_nsec - start->tv_nsec;
+}
+
+/**
+ * Runs the trace through @alloc, until all recorded flows complete, or for at
+ *    most twice the duration
+ * @return 0 on success, -1 if the allocator could not be created
+ */
+static int run_allocator(const struct cmp_allocator *alloc,
+                         struct cmp_params *p, struct cmp_trace *trace,
+                         struct cmp_flows *flows, struct cmp_result *res,
+                         FILE *flow_file)
+{
+    struct cmp_timeslot *out;
+    struct timespec start, end;
+    uint32_t pos = 0;
+    uint64_t t, tx_time;
+    uint32_t i, j;
+    void *state;
+
+    /* pim draws its random seeds from rand() */
+    srand(p->seed);
+    state = alloc->create(p->num_nodes);
+    out = malloc(alloc->batch_size * sizeof(struct cmp_timeslot));
+    if (state == NULL || out == NULL)
+        return -1;
+
+    memset(res, 0, sizeof(*res));
+    memset(flows->head, 0xFF, sizeof(flows->head));
+    flows->outstanding = 0;
+
+    for (t = 0; t < 2 * p->duration; t += alloc->batch_size) {
+        if (t >= p->duration && pos == trace->n && flows->outstanding == 0)
+            break;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (; pos < trace->n && trace->time[pos] < t; pos++) {
+            uint32_t index = (trace->src[pos] << FP_NODES_SHIFT) + trace->dst[pos];
+
+            alloc->add_backlog(state, trace->src[pos], trace->dst[pos],
+                               trace->size[pos]);
+
+            flows->next[pos] = CMP_FLOW_NONE;
+            flows->unsent[pos] = trace->size[pos];
+            if (flows->head[index] == CMP_FLOW_NONE)
+                flows->head[index] = pos;
+            else
+                flows->next[flows->tail[index]] = pos;
+            flows->tail[index] = pos;
+            if (trace->time[pos] >= p->warm_up)
+                flows->outstanding++;
+        }
+        alloc->allocate(state, out);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (t >= p->warm_up && t < p->duration) {
+            res->alloc_ns += elapsed_ns(&start, &end);
+            res->alloc_timeslots += alloc->batch_size;
+        }
+
+        for (i = 0; i < alloc->batch_size; i++) {
+            tx_time = t + i;
+            if (tx_time >= p->warm_up && tx_time < p->duration)
+                res->num_admitted += out[i].n;
+            for (j = 0; j < out[i].n; j++)
+                serve_packet(p, trace, flows, res, alloc->name, flow_file,
+                             out[i].src[j], out[i].dst[j], tx_time);
+        }
+    }
+    res->num_incomplete = flows->outstanding;
+
+    /* allocator state is not freed; fp_mempools cannot be destroyed */
+    free(out);
+    return 0;
+}
+
+// Returns the smallest FCT that at least fraction of the FCTs are within
+static uint32_t fct_percentile(struct cmp_result *res, double fraction)
+{
+    uint64_t cum = 0;
+    uint32_t fct;
+
+    for (fct = 0; fct < CMP_MAX_FCT_HISTOGRAM - 1; fct++) {
+        cum += res->fct_histogram[fct];
+        if (cum >= fraction * res->num_completed)
+            break;
+    }
+    return fct;
+}
+
+static void print_result(const struct cmp_allocator *alloc,
+                         struct cmp_params *p, struct cmp_trace *trace,
+                         struct cmp_result *res)
+{
+    double capacity = (double) (p->duration - p->warm_up) * p->num_nodes;
+    double n = res->num_completed ? res->num_completed : 1;
+
+    printf("%s, %d, %f, %f, %f, %f, %u, %u, %" PRIu64 ", %" PRIu64 ", %f, %f\n",
+           alloc->name, p->num_nodes, p->utilization, trace->offered / capacity,
+           res->num_admitted / capacity, res->sum_fct / n,
+           fct_percentile(res, 0.5), fct_percentile(res, 0.99),
+           res->num_completed, res->num_incomplete,
+           (res->sum_rate_sq > 0) ?
+                   res->sum_rate * res->sum_rate / (n * res->sum_rate_sq) : 0,
+           res->alloc_timeslots ?
+                   (double) res->alloc_ns / res->alloc_timeslots : 0);
+    fflush(stdout);
+}
+
+void print_usage(char **argv) {
+    uint32_t i;
+
+    printf("usage: %s [-a allocator]... [-n nodes] [-u utilization] [-w warm_up] "
+           "[-t duration] [-m mean_flow_size] [-p pareto_alpha] [-s seed] "
+           "[-f flow_file]\n", argv[0]);
+    printf("\tallocators are");
+    for (i = 0; i < CMP_MAX_ALLOCATORS; i++)
+        printf(" %s", all_allocators[i]->name);
+    printf(" (default: all). Times are in timeslots and flow sizes in MTUs. "
+           "Flow sizes are geometric, or Pareto with -p. Nodes are at most %d. "
+           "-f writes each flow's FCT, in the format graph_fct_cdf.R reads.\n",
+           MAX_NODES);
+}
+
+int main(int argc, char **argv)
+{
+    struct cmp_params params = {
+        .num_nodes = CMP_DEFAULT_NODES,
+        .utilization = CMP_DEFAULT_UTILIZATION,
+        .warm_up = CMP_DEFAULT_WARM_UP,
+        .mean_size = CMP_DEFAULT_MEAN_SIZE,
+        .size_dist = REQ_SIZE_EXPONENTIAL,
+        .seed = 1,
+    };
+    const struct cmp_allocator *allocators[CMP_MAX_ALLOCATORS];
+    uint32_t num_allocators = 0;
+    uint64_t duration = CMP_DEFAULT_DURATION;
+    struct cmp_trace trace;
+    struct cmp_flows *flows;
+    struct cmp_result *res;
+    FILE *flow_file = NULL;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:n:u:w:t:m:p:s:f:h")) != -1) {
+        switch (opt) {
+        case 'a':
+            for (i = 0; i < CMP_MAX_ALLOCATORS; i++)
+                if (strcmp(optarg, all_allocators[i]->name) == 0)
+                    break;
+            if (i == CMP_MAX_ALLOCATORS || num_allocators == CMP_MAX_ALLOCATORS) {
+                print_usage(argv);
+                return -1;
+            }
+            allocators[num_allocators++] = all_allocators[i];
+            break;
+        case 'n': params.num_nodes = atoi(optarg); break;
+        case 'u': params.utilization = atof(optarg); break;
+        case 'w': params.warm_up = strtoull(optarg, NULL, 10); break;
+        case 't': duration = strtoull(optarg, NULL, 10); break;
+        case 'm': params.mean_size = atof(optarg); break;
+        case 'p':
+            params.size_dist = REQ_SIZE_PARETO;
+            params.pareto_alpha = atof(optarg);
+            break;
+        case 's': params.seed = strtoull(optarg, NULL, 10); break;
+        case 'f':
+            flow_file = fopen(optarg, "w");
+            if (flow_file == NULL) {
+                printf("could not open %s\n", optarg);
+                return -1;
+            }
+            fprintf(flow_file, "algo, target_util, fct, request_time, "
+                    "completion_time, src, dst, size\n");
+            break;
+        default:
+            print_usage(argv);
+            return -1;
+        }
+    }
+    params.duration = params.warm_up + duration;
+
+    if (params.num_nodes < 2 || params.num_nodes > MAX_NODES ||
+        params.utilization <= 0 || params.mean_size < 1 ||
+        (params.size_dist == REQ_SIZE_PARETO && params.pareto_alpha <= 1)) {
+        print_usage(argv);
+        return -1;
+    }
+    if (num_allocators == 0) {
+        memcpy(allocators, all_allocators, sizeof(allocators));
+        num_allocators = CMP_MAX_ALLOCATORS;
+    }
+
+    generate_trace(&params, &trace);
+
+    flows = malloc(sizeof(struct cmp_flows));
+    res = malloc(sizeof(struct cmp_result));
+    assert(flows != NULL && res != NULL);
+    flows->next = malloc(trace.n * sizeof(uint32_t));
+    flows->unsent = malloc(trace.n * sizeof(uint16_t));
+    assert(flows->next != NULL && flows->unsent != NULL);
+
+    printf("algo, nodes, target_util, offered_util, admitted_util, mean_fct, "
+           "p50_fct, p99_fct, completed_flows, incomplete_flows, jain_fairness, "
+           "ns_per_timeslot\n");
+
+    for (i = 0; i < num_allocators; i++) {
+        if (run_allocator(allocators[i], &params, &trace, flows, res,
+                          flow_file) != 0) {
+            printf("Error initializing allocator %s!\n", allocators[i]->name);
+            exit(-1);
+        }
+        print_result(allocators[i], &params, &trace, res);
+    }
+
+    if (flow_file != NULL)
+        fclose(flow_file);
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * compare_allocators.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * A common interface to the allocators, so compare_allocators can feed each
+ * the same request trace. Each allocator is wrapped in its own translation
+ * unit, since their headers define the same names differently.
+ */
+
+#ifndef COMPARE_ALLOCATORS_H_
+#define COMPARE_ALLOCATORS_H_
+
+#include <inttypes.h>
+
+#include "../protocol/topology.h"
+
+/* the largest number of timeslots an allocator admits per call */
+#define CMP_MAX_BATCH		64
+
+/**
+ * The edges admitted in one timeslot
+ */
+struct cmp_timeslot {
+	uint16_t n;
+	uint16_t src[MAX_NODES];
+	uint16_t dst[MAX_NODES];
+};
+
+/**
+ * An allocator, as the harness sees it
+ *    batch_size: the number of timeslots allocated per call to allocate
+ *    create: returns allocator state for num_nodes, or NULL on error
+ *    add_backlog: increases the demand from src to dst
+ *    allocate: allocates the next batch_size timeslots into out
+ */
+struct cmp_allocator {
+	const char *name;
+	uint32_t batch_size;
+	void *(*create)(uint16_t num_nodes);
+	void (*add_backlog)(void *state, uint16_t src, uint16_t dst,
+			uint32_t amount);
+	void (*allocate)(void *state, struct cmp_timeslot *out);
+};
+
+extern const struct cmp_allocator cmp_pipelined;
+extern const struct cmp_allocator cmp_sjf;
+extern const struct cmp_allocator cmp_pim;
+extern const struct cmp_allocator cmp_hierarchical;
+
+#endif /* COMPARE_ALLOCATORS_H_ */
@@ -0,0 +1,76 @@
+/*
+ * compare_hierarchical.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Wraps the rack-aggregated allocator (admissible_traffic_hierarchical.c) for
+ * compare_allocators. Racks are not oversubscribed, as in the other
+ * allocators' runs, so racks only split the work.
+ */
+
+#include <stdlib.h>
+
+#include "admissible_traffic_hierarchical.h"
+#include "compare_allocators.h"
+
+#define CMP_HIER_BATCH_SIZE		16
+#define CMP_HIER_RACK_SHIFT		5	/* 32 hosts per rack */
+
+struct cmp_hier_state {
+	struct hier_admissible_status *status;
+	struct admitted_traffic *admitted[CMP_HIER_BATCH_SIZE];
+};
+
+static void *cmp_hier_create(uint16_t num_nodes)
+{
+	struct cmp_hier_state *state;
+	uint32_t i;
+
+	state = malloc(sizeof(struct cmp_hier_state));
+	if (!state)
+		return NULL;
+
+	state->status = create_hier_admissible_status(num_nodes,
+			CMP_HIER_RACK_SHIFT, 1 << CMP_HIER_RACK_SHIFT);
+	if (state->status == NULL)
+		return NULL;
+
+	for (i = 0; i < CMP_HIER_BATCH_SIZE; i++) {
+		state->admitted[i] = create_admitted_traffic();
+		if (!state->admitted[i])
+			return NULL;
+	}
+	return state;
+}
+
+static void cmp_hier_add_backlog(void *state, uint16_t src, uint16_t dst,
+		uint32_t amount)
+{
+	hier_add_backlog(((struct cmp_hier_state *) state)->status, src, dst,
+			amount);
+}
+
+static void cmp_hier_allocate(void *state, struct cmp_timeslot *out)
+{
+	struct cmp_hier_state *s = (struct cmp_hier_state *) state;
+	uint16_t i, j;
+
+	hier_get_admissible_traffic(s->status, s->admitted, CMP_HIER_BATCH_SIZE);
+
+	for (i = 0; i < CMP_HIER_BATCH_SIZE; i++) {
+		out[i].n = s->admitted[i]->size;
+		for (j = 0; j < s->admitted[i]->size; j++) {
+			struct admitted_edge *edge = get_admitted_edge(s->admitted[i], j);
+			out[i].src[j] = edge->src;
+			out[i].dst[j] = edge->dst;
+		}
+	}
+}
+
+const struct cmp_allocator cmp_hierarchical = {
+	.name = "hierarchical",
+	.batch_size = CMP_HIER_BATCH_SIZE,
+	.create = cmp_hier_create,
+	.add_backlog = cmp_hier_add_backlog,
+	.allocate = cmp_hier_allocate,
+};
@@ -0,0 +1,104 @@
+/*
+ * compare_sjf.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Wraps the shortest-job-first allocator (admissible_traffic_sjf.c) for
+ * compare_allocators, set up as in benchmark_sjf.
+ */
+
+#include <stdlib.h>
+
+#include "admissible_structures_sjf.h"
+#include "admissible_traffic_sjf.h"
+#include "compare_allocators.h"
+#include "fp_ring.h"
+
+struct cmp_sjf_state {
+	struct admissible_status *status;
+	struct admission_core_state core;
+	struct admitted_traffic *admitted_batch[BATCH_SIZE];
+};
+
+static void *cmp_sjf_create(uint16_t num_nodes)
+{
+	struct cmp_sjf_state *state;
+	struct fp_ring *q_bin, *q_urgent, *q_head, *q_admitted_out;
+	uint32_t i;
+
+	state = malloc(sizeof(struct cmp_sjf_state));
+	q_bin = fp_ring_create(NUM_BINS_SHIFT);
+	q_urgent = fp_ring_create(2 * FP_NODES_SHIFT + 1);
+	q_head = fp_ring_create(2 * FP_NODES_SHIFT);
+	q_admitted_out = fp_ring_create(BATCH_SHIFT);
+	if (!state || !q_bin || !q_urgent || !q_head || !q_admitted_out)
+		return NULL;
+
+	if (alloc_core_init(&state->core, q_bin, q_bin, q_urgent, q_urgent) != 0)
+		return NULL;
+
+	state->status = create_admissible_status(false, 0, 0, 0, q_head,
+			q_admitted_out);
+	if (state->status == NULL)
+		return NULL;
+	reset_admissible_status(state->status, false, 0, 0, num_nodes);
+
+	for (i = 0; i < BATCH_SIZE; i++) {
+		state->admitted_batch[i] = create_admitted_traffic();
+		if (!state->admitted_batch[i])
+			return NULL;
+	}
+
+	/* every bin can hold every flow */
+	for (i = 0; i < NUM_BINS; i++) {
+		struct bin *b = create_bin(LARGE_BIN_SIZE);
+		if (!b)
+			return NULL;
+		fp_ring_enqueue(q_bin, b);
+	}
+	fp_ring_enqueue(q_urgent, (void *) URGENT_Q_HEAD_TOKEN);
+
+	return state;
+}
+
+static void cmp_sjf_add_backlog(void *state, uint16_t src, uint16_t dst,
+		uint32_t amount)
+{
+	struct cmp_sjf_state *s = (struct cmp_sjf_state *) state;
+
+	/* demands are 16 bits here */
+	while (amount > 0xFFFF) {
+		add_backlog(s->status, src, dst, 0xFFFF);
+		amount -= 0xFFFF;
+	}
+	add_backlog(s->status, src, dst, amount);
+}
+
+static void cmp_sjf_allocate(void *state, struct cmp_timeslot *out)
+{
+	struct cmp_sjf_state *s = (struct cmp_sjf_state *) state;
+	struct admitted_traffic *admitted = NULL;
+	uint16_t i, j;
+
+	get_admissible_traffic(&s->core, s->status, s->admitted_batch, 0, 1, 0);
+
+	for (i = 0; i < BATCH_SIZE; i++) {
+		fp_ring_dequeue(s->status->q_admitted_out, (void **)&admitted);
+		out[i].n = admitted->size;
+		for (j = 0; j < admitted->size; j++) {
+			struct admitted_edge *edge = get_admitted_edge(admitted, j);
+			out[i].src[j] = edge->src;
+			out[i].dst[j] = edge->dst;
+		}
+		/* return admitted traffic to core */
+		s->admitted_batch[i] = admitted;
+	}
+}
+
+const struct cmp_allocator cmp_sjf = {
+	.name = "sjf",
+	.batch_size = BATCH_SIZE,
+	.create = cmp_sjf_create,
+	.add_backlog = cmp_sjf_add_backlog,
+	.allocate = cmp_sjf_allocate,
+};
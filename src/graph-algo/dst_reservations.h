@@ -0,0 +1,135 @@
+/*
+ * dst_reservations.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * A destination reservation table, shared by several arbiters that each own
+ * a subset of the sources. An arbiter allocates its own sources as before,
+ * and before it admits an edge, claims the destination's timeslot in the
+ * table, so destinations are never double-booked across arbiters.
+ *
+ * The table keeps one word per destination per batch, for the last
+ * DST_RES_NUM_BATCHES batches: the low BATCH_SIZE bits are the claimed
+ * timeslots, and the rest is the batch number the bits belong to. A word
+ * tagged with an older batch is free, so the table needs no clearing. Batches
+ * are numbered by absolute timeslot (timeslot >> BATCH_SHIFT), so arbiters
+ * must agree on timeslots, and start their batches on multiples of BATCH_SIZE.
+ * An arbiter that falls DST_RES_NUM_BATCHES batches behind another finds its
+ * words reused for later batches, and admits nothing to those destinations.
+ */
+
+#ifndef DST_RESERVATIONS_H_
+#define DST_RESERVATIONS_H_
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "batch.h"
+
+#define DST_RES_NUM_BATCHES_SHIFT	6
+#define DST_RES_NUM_BATCHES			(1 << DST_RES_NUM_BATCHES_SHIFT)
+#define DST_RES_TAG_SHIFT			BATCH_SIZE
+#define DST_RES_CLAIMED_MASK		((1ULL << BATCH_SIZE) - 1)
+#define DST_RES_SHM_NAME			"/fastpass_dst_res"
+
+struct dst_reservations {
+	volatile uint64_t words[DST_RES_NUM_BATCHES][MAX_DSTS];
+} __attribute__((aligned(64)));
+
+/* sources are split into contiguous ranges: the arbiter, out of
+ * @num_arbiters, that allocates for @src */
+static inline
+uint16_t dst_res_src_owner(uint16_t src, uint16_t num_nodes,
+		uint16_t num_arbiters)
+{
+	return ((uint32_t)src * num_arbiters) / num_nodes;
+}
+
+static inline
+void dst_res_init(struct dst_reservations *res)
+{
+	memset((void *)res->words, 0, sizeof(res->words));
+}
+
+/**
+ * Maps the table shared by all arbiters on this host, creating it if it does
+ *    not exist. @name is a POSIX shared memory name, e.g. DST_RES_SHM_NAME.
+ *    Words left by an earlier run are tagged with older batches, so are free.
+ * @return the table, or NULL on error
+ */
+static inline
+struct dst_reservations *dst_res_attach(const char *name)
+{
+	struct dst_reservations *res;
+	int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+
+	if (fd < 0)
+		return NULL;
+	/* a new object is zero-filled, which is an empty table */
+	if (ftruncate(fd, sizeof(struct dst_reservations)) != 0) {
+		close(fd);
+		return NULL;
+	}
+	res = mmap(NULL, sizeof(struct dst_reservations), PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	close(fd);
+	return (res == MAP_FAILED) ? NULL : res;
+}
+
+/* the timeslots of @batch claimed in a table word */
+static inline __attribute__((always_inline))
+uint64_t dst_res_word_claimed(uint64_t word, uint64_t batch)
+{
+	uint64_t tag = word >> DST_RES_TAG_SHIFT;
+
+	if (tag == batch)
+		return word & DST_RES_CLAIMED_MASK;
+	return (tag < batch) ? 0 : DST_RES_CLAIMED_MASK;
+}
+
+/**
+ * Returns the timeslots of @batch already claimed for @dst (lsb is the first
+ *    timeslot of the batch). If the word was reused for a later batch, the
+ *    caller is too far behind, and all timeslots are reported claimed.
+ */
+static inline __attribute__((always_inline))
+uint64_t dst_res_claimed(struct dst_reservations *res, uint64_t batch,
+		uint16_t dst)
+{
+	return dst_res_word_claimed(
+			res->words[batch & (DST_RES_NUM_BATCHES - 1)][dst], batch);
+}
+
+/**
+ * Claims the earliest timeslot in @candidates (a bitmap of timeslots in
+ *    @batch) that no other arbiter has claimed for @dst.
+ * @return the claimed timeslot's bit, or 0 if all candidates were taken
+ */
+static inline __attribute__((always_inline))
+uint64_t dst_res_claim_first(struct dst_reservations *res, uint64_t batch,
+		uint16_t dst, uint64_t candidates)
+{
+	volatile uint64_t *wordp = &res->words[batch & (DST_RES_NUM_BATCHES - 1)][dst];
+	uint64_t old_word, claimed, set_bit;
+
+	while (1) {
+		old_word = *wordp;
+		claimed = dst_res_word_claimed(old_word, batch);
+
+		candidates &= ~claimed;
+		if (candidates == 0)
+			return 0;
+
+		set_bit = candidates & (-candidates);
+		if (__sync_bool_compare_and_swap(wordp, old_word,
+				(batch << DST_RES_TAG_SHIFT) | claimed | set_bit))
+			return set_bit;
+		/* another arbiter claimed a timeslot of dst meanwhile; re-read */
+	}
+}
+
+#endif /* DST_RESERVATIONS_H_ */
@@ -0,0 +1,836 @@
+/*
+ * microbench_primitives.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Measures the cost of the data-structure primitives that bound the
+ * allocator's and the protocol's throughput, in cycles per operation:
+ * fp_ring, fp_mempool, bins, batch_state bitmaps, fp_timer and the fpproto
+ * window, and the comm core's ALLOC window and demand bookkeeping. Each
+ * sample times MB_OPS_PER_SAMPLE consecutive operations with rdtsc, and
+ * percentiles are taken over the samples.
+ *
+ * Output is CSV, one line per primitive, so a run can be saved as a baseline
+ * (see baseline_primitives.txt) and later runs diffed against it, or compared
+ * with -c, which adds the baseline's median and the ratio to it.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "admissible.h"
+#include "admissible_structures.h"
+#include "batch.h"
+#include "bin.h"
+#include "fp_ring.h"
+#include "platform.h"
+#include "rdtsc.h"
+#include "../protocol/platform/debug.h"
+#include "../protocol/window.h"
+#include "../arbiter/demand_msg.h"
+#include "../arbiter/fp_timer.h"
+
+#define MB_OPS_PER_SAMPLE		64
+#define MB_NUM_SAMPLES			(16 * 1024)
+#define MB_RING_LOG_SIZE		12
+#define MB_MEMPOOL_SIZE			(4 * MB_OPS_PER_SAMPLE)
+#define MB_MEMPOOL_ELT_SIZE		64
+#define MB_NUM_NODES			MAX_NODES
+#define MB_MAX_THREADS			16
+#define MB_MAX_BASELINE			128
+#define MB_REGRESSION_RATIO		1.25
+#define MB_SEED					0xDEADBEEFDEADBEEFULL
+
+/* MMIX by Knuth, see LCG on wikipedia */
+#define RAND_A					6364136223846793005ULL
+#define RAND_C					1442695040888963407ULL
+
+/* keeps the compiler from optimizing away a computed value */
+#define mb_use(x)		asm volatile("" : : "r"(x) : "memory")
+
+struct mb_baseline {
+	char key[96];
+	double p50;
+};
+
+static struct mb_baseline baseline[MB_MAX_BASELINE];
+static uint32_t num_baseline;
+
+static uint64_t samples[MB_MAX_THREADS * MB_NUM_SAMPLES];
+static uint16_t rand_src[MB_OPS_PER_SAMPLE];
+static uint16_t rand_dst[MB_OPS_PER_SAMPLE];
+static uint64_t rand_x = MB_SEED;
+
+static inline uint64_t mb_rand(void)
+{
+	rand_x = rand_x * RAND_A + RAND_C;
+	return rand_x >> 32;
+}
+
+/* draws fresh (src, dst) pairs for the next sample */
+static void mb_rand_pairs(void)
+{
+	int i;
+	for (i = 0; i < MB_OPS_PER_SAMPLE; i++) {
+		rand_src[i] = mb_rand() % MB_NUM_NODES;
+		rand_dst[i] = mb_rand() % MB_NUM_NODES;
+	}
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void mb_key(char *key, const char *primitive, const char *variant,
+		uint32_t threads)
+{
+	snprintf(key, sizeof(baseline[0].key), "%s, %s, %u", primitive, variant,
+			threads);
+}
+
+/**
+ * Prints percentiles of cycles per op over @n samples of @ops_per_sample ops
+ */
+static void mb_report(const char *primitive, const char *variant,
+		uint32_t threads, uint64_t *s, uint32_t n, uint32_t ops_per_sample)
+{
+	char key[sizeof(baseline[0].key)];
+	double sum = 0;
+	double p50;
+	uint32_t i;
+
+	qsort(s, n, sizeof(uint64_t), compare_u64);
+	for (i = 0; i < n; i++)
+		sum += s[i];
+	p50 = (double)s[n / 2] / ops_per_sample;
+
+	mb_key(key, primitive, variant, threads);
+	printf("%s, %.2f, %.2f, %.2f, %.2f", key, p50,
+			(double)s[(n * 90) / 100] / ops_per_sample,
+			(double)s[(n * 99) / 100] / ops_per_sample,
+			sum / n / ops_per_sample);
+
+	if (num_baseline > 0) {
+		for (i = 0; i < num_baseline; i++)
+			if (strcmp(baseline[i].key, key) == 0)
+				break;
+		if (i == num_baseline)
+			printf(", , ");
+		else
+			printf(", %.2f, %.2f%s", baseline[i].p50, p50 / baseline[i].p50,
+					(p50 > MB_REGRESSION_RATIO * baseline[i].p50) ?
+							", REGRESSION" : "");
+	}
+	printf("\n");
+}
+
+/**
+ * Reads a baseline, as previously printed by this benchmark
+ * @return 0 on success, -1 if the file cannot be read
+ */
+static int mb_load_baseline(const char *filename)
+{
+	char line[256];
+	char primitive[32], variant[32];
+	uint32_t threads;
+	double p50;
+	FILE *f = fopen(filename, "r");
+
+	if (f == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), f) != NULL &&
+			num_baseline < MB_MAX_BASELINE) {
+		if (sscanf(line, "%31[^,], %31[^,], %u, %lf", primitive, variant,
+				&threads, &p50) != 4)
+			continue;	/* header */
+		mb_key(baseline[num_baseline].key, primitive, variant, threads);
+		baseline[num_baseline].p50 = p50;
+		num_baseline++;
+	}
+	fclose(f);
+	return 0;
+}
+
+static void bench_fp_ring(void)
+{
+	struct fp_ring *ring = fp_ring_create(MB_RING_LOG_SIZE);
+	void *elems[MB_OPS_PER_SAMPLE];
+	uint64_t start;
+	uint32_t i, j;
+	int n;
+
+	for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+		elems[j] = &elems[j];
+
+	/* single */
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_ring_enqueue(ring, elems[j]);
+		samples[i] = current_time() - start;
+		while (fp_ring_dequeue(ring, &elems[0]) == 0)
+			;
+	}
+	mb_report("fp_ring", "enqueue", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_ring_enqueue(ring, &elems[j]);
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_ring_dequeue(ring, &elems[j]);
+		samples[i] = current_time() - start;
+	}
+	mb_report("fp_ring", "dequeue", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	/* bulk, per element */
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		fp_ring_enqueue_bulk(ring, elems, MB_OPS_PER_SAMPLE);
+		samples[i] = current_time() - start;
+		n = fp_ring_dequeue_burst(ring, elems, MB_OPS_PER_SAMPLE);
+		assert(n == MB_OPS_PER_SAMPLE);
+	}
+	mb_report("fp_ring", "enqueue_bulk", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		fp_ring_enqueue_bulk(ring, elems, MB_OPS_PER_SAMPLE);
+		start = current_time();
+		n = fp_ring_dequeue_burst(ring, elems, MB_OPS_PER_SAMPLE);
+		samples[i] = current_time() - start;
+		mb_use(n);
+	}
+	mb_report("fp_ring", "dequeue_burst", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	free(ring);
+}
+
+static void bench_fp_mempool(void)
+{
+	struct fp_mempool *mp = fp_mempool_create(MB_MEMPOOL_SIZE,
+			MB_MEMPOOL_ELT_SIZE);
+	void *objs[MB_OPS_PER_SAMPLE];
+	uint64_t start;
+	uint32_t i, j;
+
+	assert(mp != NULL);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_mempool_get(mp, &objs[j]);
+		samples[i] = current_time() - start;
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_mempool_put(mp, objs[j]);
+	}
+	mb_report("fp_mempool", "get", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_mempool_get(mp, &objs[j]);
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_mempool_put(mp, objs[j]);
+		samples[i] = current_time() - start;
+	}
+	mb_report("fp_mempool", "put", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		fp_mempool_get_bulk(mp, objs, MB_OPS_PER_SAMPLE);
+		samples[i] = current_time() - start;
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_mempool_put(mp, objs[j]);
+	}
+	mb_report("fp_mempool", "get_bulk", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+}
+
+static void bench_bin(void)
+{
+	struct bin *bin = create_bin(MB_OPS_PER_SAMPLE);
+	uint64_t start;
+	uint32_t i, j;
+	uint32_t sum;
+
+	assert(bin != NULL);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		mb_rand_pairs();
+		init_bin(bin);
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			enqueue_bin(bin, rand_src[j], rand_dst[j], j + 1, i);
+		samples[i] = current_time() - start;
+	}
+	mb_report("bin", "enqueue", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	/* the allocator's pass over a bin, reading each edge */
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		sum = 0;
+		start = current_time();
+		for (j = 0; j < bin_size(bin); j++) {
+			struct backlog_edge *edge = bin_get(bin, j);
+			sum += edge->src + edge->dst + edge->backlog;
+		}
+		samples[i] = current_time() - start;
+		mb_use(sum);
+	}
+	mb_report("bin", "scan", 1, samples, MB_NUM_SAMPLES, MB_OPS_PER_SAMPLE);
+
+	destroy_bin(bin);
+}
+
+static void bench_batch_state(void)
+{
+	struct batch_state state;
+	uint64_t start;
+	uint32_t i, j;
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		batch_state_init(&state, false, 0, 0, MB_NUM_NODES);
+		samples[i] = current_time() - start;
+	}
+	mb_report("batch_state", "init", 1, samples, MB_NUM_SAMPLES, 1);
+
+	/* the allocator's inner step: find the first free timeslot for a pair,
+	 * and mark it occupied */
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		mb_rand_pairs();
+		batch_state_init(&state, false, 0, 0, MB_NUM_NODES);
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++) {
+			uint64_t bitmap = batch_state_get_avail_bitmap(&state,
+					rand_src[j], rand_dst[j]);
+			uint64_t set_bit = bitmap & (-bitmap);
+			uint8_t timeslot = (bitmap == 0) ? 0 : __builtin_ctzll(bitmap);
+			batch_state_set_occupied_conditional(&state, rand_src[j],
+					rand_dst[j], timeslot, set_bit);
+		}
+		samples[i] = current_time() - start;
+		mb_use(state.src_endnodes[0]);
+	}
+	mb_report("batch_state", "allocate", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+}
+
+static void bench_fp_timer(void)
+{
+	struct fp_timers *timers = malloc(sizeof(struct fp_timers));
+	struct fp_timer tims[MB_OPS_PER_SAMPLE];
+	struct list_head expired;
+	uint64_t now = TIMER_GRANULARITY;
+	uint64_t start;
+	uint32_t i, j;
+
+	assert(timers != NULL);
+	fp_init_timers(timers, now);
+	for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+		fp_init_timer(&tims[j]);
+
+	/* insert at random times within the wheel */
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_timer_reset(timers, &tims[j], now +
+					(mb_rand() % MAX_TIMER_SLOTS) * TIMER_GRANULARITY);
+		samples[i] = current_time() - start;
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_timer_stop(&tims[j]);
+	}
+	mb_report("fp_timer", "reset", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	/* expire timers spread over the next few slots, per expired timer */
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			fp_timer_reset(timers, &tims[j],
+					now + (j % 4 + 1) * TIMER_GRANULARITY);
+		now += 4 * TIMER_GRANULARITY;
+		list_head_init(&expired);
+		start = current_time();
+		fp_timer_get_expired(timers, now, &expired);
+		samples[i] = current_time() - start;
+	}
+	mb_report("fp_timer", "get_expired", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	free(timers);
+}
+
+static void bench_window(void)
+{
+	struct fp_window wnd;
+	u64 base = 10071;
+	u64 seqnos[MB_OPS_PER_SAMPLE];
+	uint64_t start;
+	uint32_t i, j;
+	u64 sum;
+
+	/* mark each new packet as the window advances, as on transmit */
+	wnd_reset(&wnd, base - 1);
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++) {
+			wnd_advance(&wnd, 1);
+			wnd_mark(&wnd, wnd_head(&wnd));
+		}
+		samples[i] = current_time() - start;
+		/* acks clear what is not needed for the next sample */
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			if (wnd_is_marked(&wnd, wnd_head(&wnd) - j))
+				wnd_clear(&wnd, wnd_head(&wnd) - j);
+	}
+	mb_report("fp_window", "advance_mark", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	/* lookups at random positions of a half-marked window */
+	for (j = 0; j < FASTPASS_WND_LEN; j++)
+		if (mb_rand() & 1)
+			wnd_mark(&wnd, wnd_head(&wnd) - j);
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			seqnos[j] = wnd_head(&wnd) - mb_rand() % FASTPASS_WND_LEN;
+		sum = 0;
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			sum += wnd_at_or_before(&wnd, seqnos[j]);
+		samples[i] = current_time() - start;
+		mb_use(sum);
+	}
+	mb_report("fp_window", "at_or_before", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		sum = 0;
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++) {
+			sum += wnd_earliest_marked(&wnd);
+			mb_use(sum);	/* keeps the lookup inside the loop */
+		}
+		samples[i] = current_time() - start;
+		mb_use(sum);
+	}
+	mb_report("fp_window", "earliest_marked", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+}
+
+/**
+ * Comm-core ALLOC bookkeeping: a batch of admitted timeslots is folded into
+ *    each source's pending window, either edge by edge, or after grouping the
+ *    batch's edges by source so each window is slid and advanced once (see
+ *    process_allocated_traffic in arbiter/comm_core.c). Reports are not
+ *    triggered, so this measures only the window and counter updates.
+ */
+#define MB_ALLOC_TSLOTS			(4 * BATCH_SIZE)
+#define MB_ALLOC_SAMPLES		512
+
+struct mb_alloc_node {
+	struct fp_window pending;
+	uint16_t allocs[FASTPASS_WND_LEN];
+	uint16_t alloc_to_dst[MAX_NODES];
+	uint64_t total_alloc;
+};
+
+struct mb_alloc_edge {
+	uint16_t src;
+	uint16_t dst;
+};
+
+struct mb_alloc_grouped_edge {
+	uint16_t dst;
+	uint16_t tslot_ind;
+};
+
+static struct mb_alloc_node alloc_nodes[MAX_NODES];
+static struct mb_alloc_edge alloc_edges[MB_ALLOC_TSLOTS][MAX_NODES];
+static u64 alloc_tslots[MB_ALLOC_TSLOTS];
+static struct mb_alloc_grouped_edge alloc_grouped[MB_ALLOC_TSLOTS * MAX_NODES];
+static uint32_t alloc_src_count[MAX_NODES];
+static uint32_t alloc_src_offset[MAX_NODES + 1];
+
+/* slides out timeslots more than a window behind @tslot, and advances to it */
+static inline void mb_alloc_slide(struct mb_alloc_node *en, u64 timeslot)
+{
+	struct fp_window *wnd = &en->pending;
+	u64 tslot;
+	int32_t gap;
+
+	tslot = timeslot - FASTPASS_WND_LEN;
+	tslot = time_before64(wnd_head(wnd), tslot) ? wnd_head(wnd) : tslot;
+	while ((gap = wnd_at_or_before(wnd, tslot)) >= 0) {
+		tslot -= gap;
+		mb_use(en->allocs[wnd_pos(tslot)]);
+		wnd_clear(wnd, tslot);
+	}
+	if (time_after64(timeslot, wnd_head(wnd)))
+		wnd_advance(wnd, timeslot - wnd_head(wnd));
+}
+
+static inline void mb_alloc_mark(struct mb_alloc_node *en, u64 timeslot,
+		uint16_t dst)
+{
+	wnd_mark(&en->pending, timeslot);
+	en->allocs[wnd_pos(timeslot)] = dst;
+	en->alloc_to_dst[dst]++;
+}
+
+static void mb_alloc_per_edge(void)
+{
+	struct mb_alloc_node *en;
+	uint32_t i, j;
+
+	for (i = 0; i < MB_ALLOC_TSLOTS; i++) {
+		for (j = 0; j < MAX_NODES; j++) {
+			en = &alloc_nodes[alloc_edges[i][j].src];
+			mb_alloc_slide(en, alloc_tslots[i]);
+			mb_alloc_mark(en, alloc_tslots[i], alloc_edges[i][j].dst);
+			en->total_alloc++;
+		}
+	}
+}
+
+static void mb_alloc_grouped(void)
+{
+	struct mb_alloc_node *en;
+	struct mb_alloc_grouped_edge *edges;
+	u64 max_timeslot;
+	uint32_t i, j, k, src, pos;
+
+	/* counting sort by source */
+	memset(alloc_src_count, 0, sizeof(alloc_src_count));
+	for (i = 0; i < MB_ALLOC_TSLOTS; i++)
+		for (j = 0; j < MAX_NODES; j++)
+			alloc_src_count[alloc_edges[i][j].src]++;
+	pos = 0;
+	for (src = 0; src < MAX_NODES; src++) {
+		alloc_src_offset[src] = pos;
+		pos += alloc_src_count[src];
+	}
+	for (i = 0; i < MB_ALLOC_TSLOTS; i++) {
+		for (j = 0; j < MAX_NODES; j++) {
+			pos = alloc_src_offset[alloc_edges[i][j].src]++;
+			alloc_grouped[pos].dst = alloc_edges[i][j].dst;
+			alloc_grouped[pos].tslot_ind = i;
+		}
+	}
+
+	/* one slide and advance per source */
+	pos = 0;
+	for (src = 0; src < MAX_NODES; src++) {
+		en = &alloc_nodes[src];
+		edges = &alloc_grouped[pos];
+		max_timeslot = 0;
+		for (k = 0; k < alloc_src_count[src]; k++)
+			if (time_after64(alloc_tslots[edges[k].tslot_ind], max_timeslot))
+				max_timeslot = alloc_tslots[edges[k].tslot_ind];
+		mb_alloc_slide(en, max_timeslot);
+		for (k = 0; k < alloc_src_count[src]; k++)
+			mb_alloc_mark(en, alloc_tslots[edges[k].tslot_ind], edges[k].dst);
+		en->total_alloc += alloc_src_count[src];
+		pos += alloc_src_count[src];
+	}
+}
+
+static void bench_alloc_window(void)
+{
+	const char *variants[] = {"per_edge", "grouped"};
+	u64 tslot = 10071;
+	uint64_t start;
+	uint32_t i, j, k, src, v;
+	uint16_t tmp;
+
+	for (v = 0; v < 2; v++) {
+		for (src = 0; src < MAX_NODES; src++)
+			wnd_reset(&alloc_nodes[src].pending, tslot - 1);
+
+		for (i = 0; i < MB_ALLOC_SAMPLES; i++) {
+			/* every timeslot of the batch admits a random permutation, with
+			 * its edges in random order */
+			for (j = 0; j < MB_ALLOC_TSLOTS; j++) {
+				alloc_tslots[j] = tslot++;
+				for (src = 0; src < MAX_NODES; src++) {
+					alloc_edges[j][src].src = src;
+					alloc_edges[j][src].dst = src;
+				}
+				for (src = MAX_NODES - 1; src > 0; src--) {
+					k = mb_rand() % (src + 1);
+					tmp = alloc_edges[j][src].src;
+					alloc_edges[j][src].src = alloc_edges[j][k].src;
+					alloc_edges[j][k].src = tmp;
+					k = mb_rand() % (src + 1);
+					tmp = alloc_edges[j][src].dst;
+					alloc_edges[j][src].dst = alloc_edges[j][k].dst;
+					alloc_edges[j][k].dst = tmp;
+				}
+			}
+
+			start = current_time();
+			if (v == 0)
+				mb_alloc_per_edge();
+			else
+				mb_alloc_grouped();
+			samples[i] = current_time() - start;
+
+			/* acks clear the window before the next batch */
+			for (src = 0; src < MAX_NODES; src++)
+				wnd_reset(&alloc_nodes[src].pending,
+						wnd_head(&alloc_nodes[src].pending));
+		}
+		mb_report("comm_alloc_window", variants[v], 1, samples,
+				MB_ALLOC_SAMPLES, MB_ALLOC_TSLOTS * MAX_NODES);
+	}
+}
+
+/**
+ * Comm-core demand bookkeeping, per demand increase: handled inline, adding
+ *    backlog and flushing new demands to q_head once per loop, or handed off
+ *    to the bookkeeping core, packing each change into a buffer that is
+ *    passed over q_demands once per loop (see arbiter/bookkeeping_core.h).
+ *    The bookkeeping core's side of the handoff is reported as handoff_apply.
+ *    Each sample is one loop's worth of demands to pairs that had no
+ *    backlog, so every increase enqueues a new demand.
+ */
+#define MB_DEMAND_NODES			64
+#define MB_DEMAND_BIN_MEMPOOL	(4 * MAX_NODES * MAX_NODES / SMALL_BIN_SIZE)
+
+static struct admissible_state *mb_create_allocator(struct fp_ring **q_head,
+		struct fp_mempool **bin_mempool)
+{
+	struct fp_ring *q_bin, *q_admitted_out, *q_spent;
+	struct fp_mempool *admitted_traffic_mempool;
+
+	q_bin = fp_ring_create(2 * FP_NODES_SHIFT);
+	*q_head = fp_ring_create(2 * FP_NODES_SHIFT);
+	q_admitted_out = fp_ring_create(8);
+	q_spent = fp_ring_create(2 * FP_NODES_SHIFT);
+	*bin_mempool = fp_mempool_create(MB_DEMAND_BIN_MEMPOOL,
+			bin_num_bytes(SMALL_BIN_SIZE));
+	admitted_traffic_mempool = fp_mempool_create(4 * BATCH_SIZE,
+			sizeof(struct admitted_traffic));
+	assert(q_bin && *q_head && q_admitted_out && q_spent && *bin_mempool &&
+			admitted_traffic_mempool);
+
+	return create_admissible_state(false, 0, 0, MB_DEMAND_NODES, *q_head,
+			q_admitted_out, q_spent, *bin_mempool, admitted_traffic_mempool,
+			&q_bin, NULL, NULL);
+}
+
+/* stands in for the allocator: takes the flushed bins, and forgets the
+ * sample's backlog so its pairs are inactive again */
+static void mb_demand_drain(struct admissible_state *status,
+		struct fp_ring *q_head, struct fp_mempool *bin_mempool)
+{
+	struct seq_admissible_status *seq = (struct seq_admissible_status *)status;
+	struct bin *bin;
+	uint32_t j;
+
+	while (fp_ring_dequeue(q_head, (void **)&bin) == 0)
+		fp_mempool_put(bin_mempool, bin);
+	for (j = 0; j < MB_OPS_PER_SAMPLE; j++) {
+		backlog_reset_pair(&seq->backlog, rand_src[j], rand_dst[j]);
+		backlog_non_active(&seq->backlog, rand_src[j], rand_dst[j]);
+	}
+}
+
+static void mb_demand_pairs(void)
+{
+	int i;
+	for (i = 0; i < MB_OPS_PER_SAMPLE; i++) {
+		rand_src[i] = mb_rand() % MB_DEMAND_NODES;
+		rand_dst[i] = mb_rand() % MB_DEMAND_NODES;
+	}
+}
+
+static void bench_comm_demand(void)
+{
+	struct fp_ring *q_head;
+	struct fp_mempool *bin_mempool;
+	struct admissible_state *status = mb_create_allocator(&q_head,
+			&bin_mempool);
+	struct fp_ring *q_demands = fp_ring_create(MB_RING_LOG_SIZE);
+	void *msgs[MB_OPS_PER_SAMPLE];
+	uint64_t start;
+	uint32_t i, j;
+	int n;
+
+	assert(q_demands != NULL);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		mb_demand_pairs();
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			add_backlog(status, rand_src[j], rand_dst[j], 1 + j);
+		handle_spent_demands(status);
+		flush_backlog(status);
+		samples[i] = current_time() - start;
+		mb_demand_drain(status, q_head, bin_mempool);
+	}
+	mb_report("comm_demand", "inline", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		mb_demand_pairs();
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			msgs[j] = demand_msg_encode(DEMAND_MSG_NORMAL, rand_src[j],
+					rand_dst[j], 1 + j);
+		fp_ring_enqueue_bulk(q_demands, msgs, MB_OPS_PER_SAMPLE);
+		samples[i] = current_time() - start;
+		while (fp_ring_dequeue(q_demands, &msgs[0]) == 0)
+			;
+	}
+	mb_report("comm_demand", "handoff", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		mb_demand_pairs();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			msgs[j] = demand_msg_encode(DEMAND_MSG_NORMAL, rand_src[j],
+					rand_dst[j], 1 + j);
+		fp_ring_enqueue_bulk(q_demands, msgs, MB_OPS_PER_SAMPLE);
+		start = current_time();
+		n = fp_ring_dequeue_burst(q_demands, msgs, MB_OPS_PER_SAMPLE);
+		for (j = 0; j < n; j++)
+			add_backlog(status, demand_msg_src(msgs[j]),
+					demand_msg_dst(msgs[j]), demand_msg_amount(msgs[j]));
+		handle_spent_demands(status);
+		flush_backlog(status);
+		samples[i] = current_time() - start;
+		mb_demand_drain(status, q_head, bin_mempool);
+	}
+	mb_report("comm_demand", "handoff_apply", 1, samples, MB_NUM_SAMPLES,
+			MB_OPS_PER_SAMPLE);
+
+	free(q_demands);
+}
+
+/**
+ * Contended variants. The primitives that several cores update concurrently
+ *    (demand counters in the arbiter, per-destination accounting in the
+ *    endpoint) are atomic read-modify-writes, as rte_atomic32_add_return and
+ *    the kernel's atomic_add_return compile to. Each thread increments either
+ *    a counter shared by all threads or its own cache line.
+ */
+struct mb_counter {
+	int32_t val;
+} __attribute__((aligned(64)));
+
+struct mb_thread_arg {
+	pthread_barrier_t *barrier;
+	struct mb_counter *counter;
+	uint64_t *samples;
+};
+
+static struct mb_counter shared_counter;
+static struct mb_counter private_counters[MB_MAX_THREADS];
+
+static void *mb_atomic_thread(void *void_arg)
+{
+	struct mb_thread_arg *arg = void_arg;
+	uint64_t start;
+	uint32_t i, j;
+
+	pthread_barrier_wait(arg->barrier);
+	for (i = 0; i < MB_NUM_SAMPLES; i++) {
+		start = current_time();
+		for (j = 0; j < MB_OPS_PER_SAMPLE; j++)
+			__sync_add_and_fetch(&arg->counter->val, 1);
+		arg->samples[i] = current_time() - start;
+	}
+	return NULL;
+}
+
+static void bench_atomic_contended(uint32_t max_threads)
+{
+	pthread_t threads[MB_MAX_THREADS];
+	struct mb_thread_arg args[MB_MAX_THREADS];
+	pthread_barrier_t barrier;
+	uint32_t n, t;
+	int shared;
+
+	for (shared = 1; shared >= 0; shared--) {
+		for (n = 1; n <= max_threads; n *= 2) {
+			pthread_barrier_init(&barrier, NULL, n);
+			for (t = 0; t < n; t++) {
+				args[t].barrier = &barrier;
+				args[t].counter = shared ? &shared_counter
+						: &private_counters[t];
+				args[t].samples = &samples[t * MB_NUM_SAMPLES];
+				pthread_create(&threads[t], NULL, mb_atomic_thread, &args[t]);
+			}
+			for (t = 0; t < n; t++)
+				pthread_join(threads[t], NULL);
+			pthread_barrier_destroy(&barrier);
+
+			mb_report("atomic_add_return", shared ? "shared" : "private", n,
+					samples, n * MB_NUM_SAMPLES, MB_OPS_PER_SAMPLE);
+		}
+	}
+}
+
+void print_usage(char **argv) {
+	printf("usage: %s [-t max_threads] [-c baseline_file]\n", argv[0]);
+	printf("\tprints cycles/op percentiles per primitive; with -c, also the "
+			"baseline's median and the ratio to it\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int opt;
+
+	if (max_threads > MB_MAX_THREADS)
+		max_threads = MB_MAX_THREADS;
+
+	while ((opt = getopt(argc, argv, "t:c:h")) != -1) {
+		switch (opt) {
+		case 't':
+			max_threads = atoi(optarg);
+			if (max_threads < 1 || max_threads > MB_MAX_THREADS) {
+				print_usage(argv);
+				return -1;
+			}
+			break;
+		case 'c':
+			if (mb_load_baseline(optarg) != 0) {
+				printf("could not read baseline %s\n", optarg);
+				return -1;
+			}
+			break;
+		default:
+			print_usage(argv);
+			return -1;
+		}
+	}
+
+	printf("primitive, variant, threads, p50_cycles, p90_cycles, p99_cycles, mean_cycles%s\n",
+			(num_baseline > 0) ? ", baseline_p50_cycles, ratio" : "");
+
+	bench_fp_ring();
+	bench_fp_mempool();
+	bench_bin();
+	bench_batch_state();
+	bench_fp_timer();
+	bench_window();
+	bench_alloc_window();
+	bench_comm_demand();
+	bench_atomic_contended(max_threads);
+
+	return 0;
+}
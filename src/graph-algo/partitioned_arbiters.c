@@ -0,0 +1,458 @@
+/*
+ * partitioned_arbiters.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Validates partitioned scheduling: several arbiter processes on one host,
+ * each running the pipelined allocator over its own range of sources, and
+ * sharing destinations through a dst_reservations table. Runs the same trace
+ * through one arbiter, then through the given number of arbiters, and reports
+ * schedule quality and allocation rate for both.
+ *
+ * Flows arrive as a Poisson process at each sender, with sizes (in MTUs) from
+ * generate_requests_batch.h. Each arbiter takes the demand of its sources
+ * that arrived before each batch, and its admitted edges are served from the
+ * oldest flow of each (src, dst), as in compare_allocators. Every admitted
+ * (timeslot, dst) is also counted in shared memory, to check that no
+ * destination is booked twice across arbiters.
+ *
+ * Arbiters run as fast as they can, rather than on the timeslot clock, so an
+ * arbiter waits for the slowest when it is PART_MAX_LAG batches ahead, well
+ * before the table would reuse words the slowest one still needs. The
+ * allocation rate is aggregate admitted edges per second of wall time, and
+ * only scales with the number of arbiters if each gets its own core.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "admissible.h"
+#include "dst_reservations.h"
+#include "fp_ring.h"
+#include "generate_requests_batch.h"
+#include "platform.h"
+
+// enough bins for every flow to be backlogged, with room to spare
+#define PART_BIN_MEMPOOL_SIZE           (2 * MAX_NODES * MAX_NODES / SMALL_BIN_SIZE)
+#define PART_ADMITTED_MEMPOOL_SIZE      (4 * BATCH_SIZE)
+#define PART_ADMITTED_OUT_RING_LOG_SIZE 8
+#define PART_MAX_ARBITERS               16
+#define PART_MAX_FCT_HISTOGRAM          (1 << 16)
+#define PART_MAX_LAG                    (DST_RES_NUM_BATCHES / 2)
+#define PART_FLOW_NONE                  0xFFFFFFFF
+#define PART_DONE                       0xFFFFFFFFFFFFFFFFULL
+
+#define PART_DEFAULT_ARBITERS           4
+#define PART_DEFAULT_NODES              OUT_OF_BOUNDARY_NODE_ID
+#define PART_DEFAULT_UTILIZATION        0.8
+#define PART_DEFAULT_WARM_UP            10000
+#define PART_DEFAULT_DURATION           50000
+#define PART_DEFAULT_MEAN_SIZE          10
+
+struct part_params {
+    uint16_t num_nodes;
+    double utilization;
+    uint64_t warm_up;
+    uint64_t duration;
+    double mean_size;
+    uint64_t seed;
+};
+
+// The flows, in order of arrival
+struct part_trace {
+    uint32_t n;
+    uint64_t *time;
+    uint16_t *src;
+    uint16_t *dst;
+    uint16_t *size;
+};
+
+// One arbiter's results, over flows that arrive after the warm-up
+struct part_result {
+    uint64_t num_admitted;      // in the measurement interval
+    uint64_t num_total_admitted;
+    uint64_t num_completed;
+    uint64_t num_incomplete;
+    uint64_t sum_fct;
+    uint64_t alloc_ns;
+    uint64_t alloc_timeslots;
+    uint64_t dst_conflicts;
+    uint32_t fct_histogram[PART_MAX_FCT_HISTOGRAM];
+};
+
+// Shared by the arbiter processes
+struct part_shared {
+    struct dst_reservations res;
+    volatile uint64_t progress[PART_MAX_ARBITERS];  // batches done, or PART_DONE
+    struct part_result results[PART_MAX_ARBITERS];
+};
+
+// Per-flow state of one arbiter. Flows of each (src, dst) are served in FIFO
+// order.
+struct part_flows {
+    uint32_t *next;
+    uint16_t *unsent;           // packets not yet admitted
+    uint32_t head[MAX_NODES * MAX_NODES];
+    uint32_t tail[MAX_NODES * MAX_NODES];
+    uint64_t outstanding;       // recorded flows not yet complete
+};
+
+static void generate_trace(struct part_params *p, struct part_trace *trace)
+{
+    struct batch_request_generator gen;
+    struct request_batch batch;
+    uint32_t capacity = 0;
+    uint32_t i;
+
+    /* each sender offers utilization of its link */
+    batch_gen_init(&gen, p->seed, p->mean_size / p->utilization, 0,
+                   p->num_nodes, p->mean_size);
+
+    memset(trace, 0, sizeof(*trace));
+    for (;;) {
+        batch_gen_fill(&gen, &batch, REQ_BATCH_SIZE);
+        for (i = 0; i < REQ_BATCH_SIZE; i++) {
+            uint64_t time = (uint64_t) batch.time[i];
+            if (time >= p->duration)
+                return;
+
+            if (trace->n == capacity) {
+                capacity = capacity ? 2 * capacity : (1 << 16);
+                trace->time = realloc(trace->time, capacity * sizeof(uint64_t));
+                trace->src = realloc(trace->src, capacity * sizeof(uint16_t));
+                trace->dst = realloc(trace->dst, capacity * sizeof(uint16_t));
+                trace->size = realloc(trace->size, capacity * sizeof(uint16_t));
+                assert(trace->time && trace->src && trace->dst && trace->size);
+            }
+            trace->time[trace->n] = time;
+            trace->src[trace->n] = batch.src[i];
+            trace->dst[trace->n] = batch.dst[i];
+            trace->size[trace->n] = batch.backlog[i];
+            trace->n++;
+        }
+    }
+}
+
+static struct admissible_state *create_arbiter(uint16_t num_nodes)
+{
+    struct fp_ring *q_bin, *q_head, *q_admitted_out, *q_spent;
+    struct fp_mempool *bin_mempool, *admitted_traffic_mempool;
+
+    q_bin = fp_ring_create(2 * FP_NODES_SHIFT);
+    q_head = fp_ring_create(2 * FP_NODES_SHIFT);
+    q_admitted_out = fp_ring_create(PART_ADMITTED_OUT_RING_LOG_SIZE);
+    q_spent = fp_ring_create(2 * FP_NODES_SHIFT);
+    bin_mempool = fp_mempool_create(PART_BIN_MEMPOOL_SIZE,
+                                    bin_num_bytes(SMALL_BIN_SIZE));
+    admitted_traffic_mempool = fp_mempool_create(PART_ADMITTED_MEMPOOL_SIZE,
+                                                 sizeof(struct admitted_traffic));
+    if (!q_bin || !q_head || !q_admitted_out || !q_spent || !bin_mempool ||
+        !admitted_traffic_mempool)
+        return NULL;
+
+    return create_admissible_state(false, 0, 0, num_nodes, q_head,
+                                   q_admitted_out, q_spent, bin_mempool,
+                                   admitted_traffic_mempool, &q_bin, NULL, NULL);
+}
+
+// Admits one packet of the oldest flow from src to dst in timeslot tx_time
+static void serve_packet(struct part_params *p, struct part_trace *trace,
+                         struct part_flows *flows, struct part_result *res,
+                         uint16_t src, uint16_t dst, uint64_t tx_time)
+{
+    uint32_t index = (src << FP_NODES_SHIFT) + dst;
+    uint32_t f = flows->head[index];
+    uint64_t fct;
+
+    if (f == PART_FLOW_NONE || --flows->unsent[f] > 0)
+        return;
+
+    flows->head[index] = flows->next[f];
+    if (trace->time[f] < p->warm_up)
+        return;
+
+    fct = tx_time + 1 - trace->time[f];
+    res->num_completed++;
+    res->sum_fct += fct;
+    res->fct_histogram[(fct < PART_MAX_FCT_HISTOGRAM) ?
+                       fct : PART_MAX_FCT_HISTOGRAM - 1]++;
+    flows->outstanding--;
+}
+
+static inline uint64_t elapsed_ns(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000ULL +
+            end->tv_nsec - start->tv_nsec;
+}
+
+// Waits until no arbiter is more than PART_MAX_LAG batches behind batch b
+static void wait_for_slowest(struct part_shared *shared, uint16_t num_arbiters,
+                             uint64_t b)
+{
+    uint16_t i;
+
+    if (b <= PART_MAX_LAG)
+        return;
+    for (i = 0; i < num_arbiters; i++)
+        while (shared->progress[i] < b - PART_MAX_LAG)
+            sched_yield();
+}
+
+/**
+ * Runs arbiter @index of @num_arbiters over its sources' flows, until they all
+ *    complete, or for at most twice the duration
+ */
+static void run_arbiter(struct part_params *p, struct part_trace *trace,
+                        struct part_shared *shared, uint8_t *dst_admitted,
+                        uint16_t index, uint16_t num_arbiters)
+{
+    struct part_result *res = &shared->results[index];
+    struct admissible_state *status;
+    struct admitted_traffic *admitted = NULL;
+    struct part_flows *flows;
+    struct timespec start, end;
+    uint32_t pos = 0;
+    uint64_t b, t, tx_time;
+    uint32_t i, j;
+
+    status = create_arbiter(p->num_nodes);
+    flows = malloc(sizeof(struct part_flows));
+    if (status != NULL && flows != NULL) {
+        flows->next = malloc(trace->n * sizeof(uint32_t));
+        flows->unsent = malloc(trace->n * sizeof(uint16_t));
+    }
+    if (status == NULL || flows == NULL || !flows->next || !flows->unsent) {
+        printf("Error initializing arbiter %d!\n", index);
+        exit(-1);
+    }
+    if (num_arbiters > 1)
+        set_dst_reservations(status, &shared->res);
+
+    memset(flows->head, 0xFF, sizeof(flows->head));
+    flows->outstanding = 0;
+
+    for (b = 0; (t = b * BATCH_SIZE) < 2 * p->duration; b++) {
+        if (t >= p->duration && pos == trace->n && flows->outstanding == 0)
+            break;
+
+        wait_for_slowest(shared, num_arbiters, b);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (; pos < trace->n && trace->time[pos] < t; pos++) {
+            uint16_t src = trace->src[pos];
+            uint16_t dst = trace->dst[pos];
+            uint32_t pair = (src << FP_NODES_SHIFT) + dst;
+
+            if (dst_res_src_owner(src, p->num_nodes, num_arbiters) != index)
+                continue;
+
+            add_backlog(status, src, dst, trace->size[pos]);
+
+            flows->next[pos] = PART_FLOW_NONE;
+            flows->unsent[pos] = trace->size[pos];
+            if (flows->head[pair] == PART_FLOW_NONE)
+                flows->head[pair] = pos;
+            else
+                flows->next[flows->tail[pair]] = pos;
+            flows->tail[pair] = pos;
+            if (trace->time[pos] >= p->warm_up)
+                flows->outstanding++;
+        }
+        flush_backlog(status);
+        get_admissible_traffic(status, 0, 0, 1, 0);
+        handle_spent_demands(status);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (t >= p->warm_up && t < p->duration) {
+            res->alloc_ns += elapsed_ns(&start, &end);
+            res->alloc_timeslots += BATCH_SIZE;
+        }
+
+        for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+            tx_time = t + i;
+            fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
+            if (tx_time >= p->warm_up && tx_time < p->duration)
+                res->num_admitted += admitted->size;
+            res->num_total_admitted += admitted->size;
+            for (j = 0; j < admitted->size; j++) {
+                struct admitted_edge *edge = get_admitted_edge(admitted, j);
+                __sync_fetch_and_add(
+                        &dst_admitted[tx_time * p->num_nodes + edge->dst], 1);
+                serve_packet(p, trace, flows, res, edge->src, edge->dst, tx_time);
+            }
+            fp_mempool_put(get_admitted_traffic_mempool(status), admitted);
+        }
+
+        shared->progress[index] = b + 1;
+    }
+
+    shared->progress[index] = PART_DONE;
+    res->num_incomplete = flows->outstanding;
+    res->dst_conflicts =
+        ((struct seq_admissible_status *) status)->cores[0].stat.dst_reservation_conflicts;
+}
+
+// Returns the smallest FCT that at least fraction of the FCTs are within
+static uint32_t fct_percentile(uint32_t *histogram, uint64_t num_completed,
+                               double fraction)
+{
+    uint64_t cum = 0;
+    uint32_t fct;
+
+    for (fct = 0; fct < PART_MAX_FCT_HISTOGRAM - 1; fct++) {
+        cum += histogram[fct];
+        if (cum >= fraction * num_completed)
+            break;
+    }
+    return fct;
+}
+
+/**
+ * Runs the trace through @num_arbiters arbiter processes, and prints a line
+ * @return 0 on success, -1 on error
+ */
+static int run_experiment(struct part_params *p, struct part_trace *trace,
+                          uint16_t num_arbiters)
+{
+    uint64_t max_timeslots = 2 * p->duration + BATCH_SIZE;
+    size_t dst_admitted_size = max_timeslots * p->num_nodes;
+    struct part_shared *shared;
+    struct part_result total;
+    uint8_t *dst_admitted;
+    uint64_t double_booked = 0;
+    uint64_t max_ns_per_timeslot = 0;
+    struct timespec start, end;
+    double capacity, wall_s;
+    uint64_t i;
+    uint32_t k;
+    pid_t pid;
+
+    shared = mmap(NULL, sizeof(struct part_shared), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    dst_admitted = mmap(NULL, dst_admitted_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED || dst_admitted == MAP_FAILED)
+        return -1;
+    /* anonymous mappings are zeroed, so the table starts empty */
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < num_arbiters; k++) {
+        pid = fork();
+        if (pid < 0)
+            return -1;
+        if (pid == 0) {
+            run_arbiter(p, trace, shared, dst_admitted, k, num_arbiters);
+            _exit(0);
+        }
+    }
+    for (k = 0; k < num_arbiters; k++) {
+        int wstatus;
+        if (wait(&wstatus) < 0 || !WIFEXITED(wstatus) ||
+            WEXITSTATUS(wstatus) != 0)
+            return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    wall_s = elapsed_ns(&start, &end) / 1e9;
+
+    memset(&total, 0, sizeof(total));
+    for (k = 0; k < num_arbiters; k++) {
+        struct part_result *res = &shared->results[k];
+        total.num_admitted += res->num_admitted;
+        total.num_total_admitted += res->num_total_admitted;
+        total.num_completed += res->num_completed;
+        total.num_incomplete += res->num_incomplete;
+        total.sum_fct += res->sum_fct;
+        total.dst_conflicts += res->dst_conflicts;
+        for (i = 0; i < PART_MAX_FCT_HISTOGRAM; i++)
+            total.fct_histogram[i] += res->fct_histogram[i];
+        if (res->alloc_timeslots > 0 &&
+            res->alloc_ns / res->alloc_timeslots > max_ns_per_timeslot)
+            max_ns_per_timeslot = res->alloc_ns / res->alloc_timeslots;
+    }
+    for (i = 0; i < dst_admitted_size; i++)
+        double_booked += (dst_admitted[i] > 1);
+
+    capacity = (double) (p->duration - p->warm_up) * p->num_nodes;
+    printf("%d, %d, %f, %f, %f, %u, %u, %" PRIu64 ", %" PRIu64 ", %" PRIu64
+           ", %f, %f, %" PRIu64 "\n",
+           num_arbiters, p->num_nodes, p->utilization,
+           total.num_admitted / capacity,
+           (double) total.sum_fct / (total.num_completed ? total.num_completed : 1),
+           fct_percentile(total.fct_histogram, total.num_completed, 0.5),
+           fct_percentile(total.fct_histogram, total.num_completed, 0.99),
+           total.num_incomplete, total.dst_conflicts, double_booked, wall_s,
+           total.num_total_admitted / wall_s / 1e6, max_ns_per_timeslot);
+    fflush(stdout);
+
+    munmap(shared, sizeof(struct part_shared));
+    munmap(dst_admitted, dst_admitted_size);
+    return 0;
+}
+
+void print_usage(char **argv) {
+    printf("usage: %s [-k arbiters] [-n nodes] [-u utilization] [-w warm_up] "
+           "[-t duration] [-m mean_flow_size] [-s seed]\n", argv[0]);
+    printf("\truns one arbiter, then k arbiters (at most %d) that each own a "
+           "range of sources. Times are in timeslots and flow sizes in MTUs. "
+           "Nodes are at most %d, below the out-of-boundary node.\n",
+           PART_MAX_ARBITERS, OUT_OF_BOUNDARY_NODE_ID);
+}
+
+int main(int argc, char **argv)
+{
+    struct part_params params = {
+        .num_nodes = PART_DEFAULT_NODES,
+        .utilization = PART_DEFAULT_UTILIZATION,
+        .warm_up = PART_DEFAULT_WARM_UP,
+        .mean_size = PART_DEFAULT_MEAN_SIZE,
+        .seed = 1,
+    };
+    uint16_t num_arbiters = PART_DEFAULT_ARBITERS;
+    uint64_t duration = PART_DEFAULT_DURATION;
+    struct part_trace trace;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:n:u:w:t:m:s:h")) != -1) {
+        switch (opt) {
+        case 'k': num_arbiters = atoi(optarg); break;
+        case 'n': params.num_nodes = atoi(optarg); break;
+        case 'u': params.utilization = atof(optarg); break;
+        case 'w': params.warm_up = strtoull(optarg, NULL, 10); break;
+        case 't': duration = strtoull(optarg, NULL, 10); break;
+        case 'm': params.mean_size = atof(optarg); break;
+        case 's': params.seed = strtoull(optarg, NULL, 10); break;
+        default:
+            print_usage(argv);
+            return -1;
+        }
+    }
+    params.duration = params.warm_up + duration;
+
+    if (num_arbiters < 1 || num_arbiters > PART_MAX_ARBITERS ||
+        num_arbiters > params.num_nodes || params.num_nodes < 2 ||
+        params.num_nodes > OUT_OF_BOUNDARY_NODE_ID || params.utilization <= 0 ||
+        params.mean_size < 1) {
+        print_usage(argv);
+        return -1;
+    }
+
+    generate_trace(&params, &trace);
+
+    printf("arbiters, nodes, target_util, admitted_util, mean_fct, p50_fct, "
+           "p99_fct, incomplete_flows, dst_conflicts, double_booked, wall_s, "
+           "medges_per_s, max_ns_per_timeslot\n");
+    if (run_experiment(&params, &trace, 1) != 0 ||
+        (num_arbiters > 1 && run_experiment(&params, &trace, num_arbiters) != 0)) {
+        printf("Error running arbiters!\n");
+        return -1;
+    }
+    return 0;
+}
@@ -17,6 +17,7 @@
 #define fp_calloc(typestr, num, size)           rte_calloc(typestr, num, size, 0)
 #define fp_malloc(typestr, size)		rte_malloc(typestr, size, 0)
 #define fp_pause()								rte_pause()
+#define fp_get_cycles()							rte_rdtsc()
 
 #define fp_mempool	 			rte_mempool
 #define fp_mempool_get	 		rte_mempool_get
@@ -28,12 +29,14 @@
 /** VANILLA **/
 #include <errno.h>
 #include <string.h>
+#include "rdtsc.h"
 
 #define fp_free(ptr)                            free(ptr)
 #define fp_calloc(typestr, num, size)           calloc(num, size)
 #define fp_malloc(typestr, size)		malloc(size)
 #define fp_get_time_ns()				(1UL << 40)
 #define fp_pause()						while (0) {}
+#define fp_get_cycles()					current_time()
 
 #ifndef likely
 #define likely(x)  __builtin_expect((x),1)
@@ -0,0 +1,613 @@
+/*
+ * simulate_fct.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * A discrete-event simulator of endpoints and the arbiter, for predicting
+ * flow completion times without a testbed. The allocator (admissible_traffic.c)
+ * and path selection (path_selection.c) are the real ones; the endpoints and
+ * the network around them are modelled, in units of timeslots:
+ *
+ *  - flows arrive at each sender as a Poisson process, with sizes (in MTUs)
+ *    drawn from generate_requests_batch.h
+ *  - an endpoint requests its new demand from the arbiter, at most once every
+ *    request_gap timeslots; requests take ctrl_delay to reach the arbiter
+ *  - the arbiter allocates a batch of BATCH_SIZE timeslots every BATCH_SIZE
+ *    timeslots, and selects paths for each timeslot
+ *  - the ALLOC reaches the endpoint alloc_delay after the batch, and the
+ *    endpoint sends one packet in each allocated timeslot, from the flow to
+ *    that destination that the endpoint's flow scheduler picks: the oldest
+ *    (FIFO), the next in round robin (DRR, with one-packet quanta), or the one
+ *    with the fewest packets left (SRPT), as in sch_timeslot.c's flow_sched
+ *  - a packet takes one timeslot to transmit, and arrives link_delay later
+ *
+ * Prints one line per completed flow, in the format graph_fct_cdf.R reads, and
+ * a summary on stderr, with separate percentiles for short flows.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "algo_config.h"
+#include "fp_ring.h"
+#include "generate_requests_batch.h"
+#include "admissible.h"
+#include "path_selection.h"
+#include "platform.h"
+
+// enough bins for every flow to be backlogged, with room to spare
+#define SIM_BIN_MEMPOOL_SIZE            (2 * MAX_NODES * MAX_NODES / SMALL_BIN_SIZE)
+#define SIM_ADMITTED_MEMPOOL_SIZE       (4 * BATCH_SIZE)
+#define SIM_ADMITTED_OUT_RING_LOG_SIZE  8
+#define SIM_MAX_FCT_HISTOGRAM           (1 << 20)
+#define SIM_FLOW_NONE                   0xFFFFFFFF
+
+#define SIM_DEFAULT_NODES               256
+#define SIM_DEFAULT_UTILIZATION         0.8
+#define SIM_DEFAULT_WARM_UP             10000
+#define SIM_DEFAULT_DURATION            100000
+#define SIM_DEFAULT_MEAN_SIZE           10
+#define SIM_DEFAULT_PARETO_ALPHA        1.5
+#define SIM_DEFAULT_REQUEST_GAP         2
+#define SIM_DEFAULT_CTRL_DELAY          8
+#define SIM_DEFAULT_ALLOC_DELAY         8
+#define SIM_DEFAULT_LINK_DELAY          1
+#define SIM_DEFAULT_SHORT_SIZE          4
+
+// How an endpoint picks among its flows to one destination
+enum sim_flow_sched {
+    SIM_FLOW_SCHED_FIFO,
+    SIM_FLOW_SCHED_DRR,
+    SIM_FLOW_SCHED_SRPT,
+};
+
+static const char *sim_flow_sched_names[] = { "fifo", "drr", "srpt" };
+
+// Event types, in the order they are handled within a timeslot
+enum sim_event_type {
+    EV_FLOW_ARRIVAL,    // the next generated flow arrives at its sender
+    EV_SEND_REQUEST,    // a sender requests its new demand
+    EV_DEMAND,          // a request reaches the arbiter
+    EV_ALLOCATE,        // the arbiter allocates a batch
+};
+
+struct sim_event {
+    uint64_t time;
+    uint32_t seq;       // breaks ties in insertion order
+    uint8_t type;
+    uint16_t src;
+    uint16_t dst;
+    uint32_t amount;
+};
+
+// A binary min-heap of events, by (time, type, seq)
+struct sim_event_queue {
+    struct sim_event *events;
+    uint32_t size;
+    uint32_t capacity;
+    uint32_t next_seq;
+};
+
+struct sim_params {
+    uint16_t num_nodes;
+    double utilization;
+    uint64_t warm_up;
+    uint64_t duration;
+    double mean_size;
+    uint8_t size_dist;
+    double pareto_alpha;
+    uint32_t request_gap;
+    uint32_t ctrl_delay;
+    uint32_t alloc_delay;
+    uint32_t link_delay;
+    uint8_t flow_sched;
+    uint16_t short_size;    // flows up to this size are reported separately
+    uint64_t seed;
+};
+
+struct sim_flow {
+    uint64_t arrival;
+    uint16_t src;
+    uint16_t dst;
+    uint16_t size;
+    uint16_t unsent;    // packets not yet allocated a timeslot
+    uint32_t next;      // next flow of the same (src, dst), or free list
+    bool record;
+};
+
+// Endpoint state. Flows of each (src, dst) are in a list, in arrival order for
+// FIFO and SRPT, and in round-robin order for DRR.
+struct sim_state {
+    struct sim_params *params;
+    struct sim_event_queue queue;
+
+    struct sim_flow *flows;
+    uint32_t num_flow_slots;
+    uint32_t free_flows;
+    uint32_t head[MAX_NODES * MAX_NODES];
+    uint32_t tail[MAX_NODES * MAX_NODES];
+
+    uint32_t unrequested[MAX_NODES * MAX_NODES];
+    uint16_t dirty_dsts[MAX_NODES][MAX_NODES];
+    uint16_t num_dirty[MAX_NODES];
+    uint64_t last_request[MAX_NODES];
+    bool request_pending[MAX_NODES];
+
+    struct batch_request_generator gen;
+    struct request_batch batch;
+    uint32_t batch_pos;
+
+    // statistics
+    uint64_t num_completed;
+    uint64_t num_incomplete;
+    uint64_t sum_fct;
+    uint64_t max_fct;
+    uint64_t num_allocated;     // in the measurement interval
+    uint64_t num_wasted;        // allocations beyond demand
+    uint64_t num_short;
+    uint32_t fct_histogram[SIM_MAX_FCT_HISTOGRAM];
+    uint32_t short_fct_histogram[SIM_MAX_FCT_HISTOGRAM];
+};
+
+static void sim_queue_push(struct sim_event_queue *q, uint64_t time,
+                           uint8_t type, uint16_t src, uint16_t dst,
+                           uint32_t amount)
+{
+    struct sim_event ev = { .time = time, .seq = q->next_seq++, .type = type,
+                            .src = src, .dst = dst, .amount = amount };
+    uint32_t i;
+
+    if (q->size == q->capacity) {
+        q->capacity = q->capacity ? 2 * q->capacity : 1024;
+        q->events = realloc(q->events, q->capacity * sizeof(struct sim_event));
+        assert(q->events != NULL);
+    }
+
+    // sift up
+    for (i = q->size++; i > 0; i = (i - 1) / 2) {
+        struct sim_event *parent = &q->events[(i - 1) / 2];
+        if (parent->time < ev.time ||
+            (parent->time == ev.time && (parent->type < ev.type ||
+             (parent->type == ev.type && parent->seq < ev.seq))))
+            break;
+        q->events[i] = *parent;
+    }
+    q->events[i] = ev;
+}
+
+static inline bool sim_event_before(struct sim_event *a, struct sim_event *b)
+{
+    if (a->time != b->time)
+        return a->time < b->time;
+    if (a->type != b->type)
+        return a->type < b->type;
+    return a->seq < b->seq;
+}
+
+static void sim_queue_pop(struct sim_event_queue *q, struct sim_event *ev)
+{
+    struct sim_event last;
+    uint32_t i, child;
+
+    assert(q->size > 0);
+    *ev = q->events[0];
+    last = q->events[--q->size];
+
+    // sift down
+    for (i = 0; (child = 2 * i + 1) < q->size; i = child) {
+        if (child + 1 < q->size &&
+            sim_event_before(&q->events[child + 1], &q->events[child]))
+            child++;
+        if (!sim_event_before(&q->events[child], &last))
+            break;
+        q->events[i] = q->events[child];
+    }
+    q->events[i] = last;
+}
+
+static uint32_t sim_alloc_flow(struct sim_state *s)
+{
+    uint32_t i, index;
+
+    if (s->free_flows == SIM_FLOW_NONE) {
+        uint32_t old = s->num_flow_slots;
+        s->num_flow_slots = old ? 2 * old : 1024;
+        s->flows = realloc(s->flows, s->num_flow_slots * sizeof(struct sim_flow));
+        assert(s->flows != NULL);
+        for (i = old; i < s->num_flow_slots; i++)
+            s->flows[i].next = (i + 1 < s->num_flow_slots) ? i + 1 : SIM_FLOW_NONE;
+        s->free_flows = old;
+    }
+
+    index = s->free_flows;
+    s->free_flows = s->flows[index].next;
+    return index;
+}
+
+// Schedules the arrival of the next generated flow
+static void sim_next_flow(struct sim_state *s)
+{
+    struct request_batch *batch = &s->batch;
+    uint64_t time;
+
+    if (s->batch_pos == batch->n) {
+        batch_gen_fill(&s->gen, batch, REQ_BATCH_SIZE);
+        s->batch_pos = 0;
+    }
+
+    time = (uint64_t) batch->time[s->batch_pos];
+    if (time >= s->params->duration)
+        return;
+    sim_queue_push(&s->queue, time, EV_FLOW_ARRIVAL, batch->src[s->batch_pos],
+                   batch->dst[s->batch_pos], batch->backlog[s->batch_pos]);
+    s->batch_pos++;
+}
+
+static void sim_flow_arrival(struct sim_state *s, struct sim_event *ev)
+{
+    uint32_t index = (ev->src << FP_NODES_SHIFT) + ev->dst;
+    uint32_t f = sim_alloc_flow(s);
+    struct sim_flow *flow = &s->flows[f];
+
+    flow->arrival = ev->time;
+    flow->src = ev->src;
+    flow->dst = ev->dst;
+    flow->size = flow->unsent = ev->amount;
+    flow->next = SIM_FLOW_NONE;
+    flow->record = (ev->time >= s->params->warm_up);
+
+    if (s->head[index] == SIM_FLOW_NONE)
+        s->head[index] = f;
+    else
+        s->flows[s->tail[index]].next = f;
+    s->tail[index] = f;
+
+    // the new demand goes out with the sender's next request
+    if (s->unrequested[index] == 0)
+        s->dirty_dsts[ev->src][s->num_dirty[ev->src]++] = ev->dst;
+    s->unrequested[index] += ev->amount;
+    if (!s->request_pending[ev->src]) {
+        uint64_t t = s->last_request[ev->src] + s->params->request_gap;
+        sim_queue_push(&s->queue, (t > ev->time) ? t : ev->time,
+                       EV_SEND_REQUEST, ev->src, 0, 0);
+        s->request_pending[ev->src] = true;
+    }
+
+    sim_next_flow(s);
+}
+
+static void sim_send_request(struct sim_state *s, struct sim_event *ev)
+{
+    uint16_t src = ev->src;
+    uint16_t i;
+
+    for (i = 0; i < s->num_dirty[src]; i++) {
+        uint16_t dst = s->dirty_dsts[src][i];
+        uint32_t index = (src << FP_NODES_SHIFT) + dst;
+
+        sim_queue_push(&s->queue, ev->time + s->params->ctrl_delay, EV_DEMAND,
+                       src, dst, s->unrequested[index]);
+        s->unrequested[index] = 0;
+    }
+    s->num_dirty[src] = 0;
+    s->last_request[src] = ev->time;
+    s->request_pending[src] = false;
+}
+
+// Sends one packet from src to dst in timeslot tx_time, from the flow the
+// flow scheduler picks
+static void sim_send_packet(struct sim_state *s, uint16_t src, uint16_t dst,
+                            uint64_t tx_time)
+{
+    uint32_t index = (src << FP_NODES_SHIFT) + dst;
+    uint32_t f = s->head[index];
+    uint32_t prev = SIM_FLOW_NONE;
+    uint32_t i, before;
+    struct sim_flow *flow;
+    uint64_t fct, bin;
+
+    if (f == SIM_FLOW_NONE) {
+        s->num_wasted++;  // allocation beyond demand
+        return;
+    }
+
+    if (s->params->flow_sched == SIM_FLOW_SCHED_SRPT) {
+        for (before = f, i = s->flows[f].next; i != SIM_FLOW_NONE;
+             before = i, i = s->flows[i].next) {
+            if (s->flows[i].unsent < s->flows[f].unsent) {
+                f = i;
+                prev = before;
+            }
+        }
+    }
+    flow = &s->flows[f];
+
+    if (--flow->unsent > 0) {
+        // DRR: the flow goes to the back of the round
+        if (s->params->flow_sched == SIM_FLOW_SCHED_DRR &&
+            flow->next != SIM_FLOW_NONE) {
+            s->head[index] = flow->next;
+            s->flows[s->tail[index]].next = f;
+            s->tail[index] = f;
+            flow->next = SIM_FLOW_NONE;
+        }
+        return;
+    }
+
+    // the last packet is transmitted, then propagates
+    if (prev == SIM_FLOW_NONE)
+        s->head[index] = flow->next;
+    else
+        s->flows[prev].next = flow->next;
+    if (s->tail[index] == f)
+        s->tail[index] = prev;
+    if (flow->record) {
+        fct = tx_time + 1 + s->params->link_delay - flow->arrival;
+        printf("fastpass, %f, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %d, %d, %d\n",
+               s->params->utilization, fct, flow->arrival, flow->arrival + fct,
+               src, dst, flow->size);
+        s->num_completed++;
+        s->sum_fct += fct;
+        if (fct > s->max_fct)
+            s->max_fct = fct;
+        bin = (fct < SIM_MAX_FCT_HISTOGRAM) ? fct : SIM_MAX_FCT_HISTOGRAM - 1;
+        s->fct_histogram[bin]++;
+        if (flow->size <= s->params->short_size) {
+            s->num_short++;
+            s->short_fct_histogram[bin]++;
+        }
+    }
+    flow->next = s->free_flows;
+    s->free_flows = f;
+}
+
+static void sim_allocate(struct sim_state *s, struct admissible_state *status,
+                         uint8_t num_racks, struct sim_event *ev)
+{
+    struct admitted_traffic *admitted = NULL;
+    uint16_t i, j;
+
+    flush_backlog(status);
+    get_admissible_traffic(status, 0, 0, 1, 0);
+    handle_spent_demands(status);
+
+    for (i = 0; i < ADMITTED_PER_BATCH; i++) {
+        uint64_t tx_time = ev->time + s->params->alloc_delay + i;
+
+        fp_ring_dequeue(get_q_admitted_out(status), (void **)&admitted);
+        select_paths(admitted, num_racks);
+
+        if (tx_time >= s->params->warm_up && tx_time < s->params->duration)
+            s->num_allocated += admitted->size;
+        for (j = 0; j < admitted->size; j++) {
+            struct admitted_edge *edge = get_admitted_edge(admitted, j);
+            sim_send_packet(s, edge->src, edge->dst & PATH_MASK, tx_time);
+        }
+        fp_mempool_put(get_admitted_traffic_mempool(status), admitted);
+    }
+}
+
+static bool sim_flows_pending(struct sim_state *s)
+{
+    uint32_t index;
+
+    for (index = 0; index < MAX_NODES * MAX_NODES; index++)
+        if (s->head[index] != SIM_FLOW_NONE)
+            return true;
+    return false;
+}
+
+// Runs the simulation until all flows complete, or for at most twice the
+// duration
+static void run_simulation(struct sim_state *s, struct admissible_state *status)
+{
+    struct sim_params *p = s->params;
+    uint8_t num_racks = (p->num_nodes + MAX_NODES_PER_RACK - 1) / MAX_NODES_PER_RACK;
+    struct sim_event ev;
+    uint32_t index;
+
+    sim_next_flow(s);
+    sim_queue_push(&s->queue, 0, EV_ALLOCATE, 0, 0, 0);
+
+    while (s->queue.size > 0) {
+        sim_queue_pop(&s->queue, &ev);
+
+        switch (ev.type) {
+        case EV_FLOW_ARRIVAL:
+            sim_flow_arrival(s, &ev);
+            break;
+        case EV_SEND_REQUEST:
+            sim_send_request(s, &ev);
+            break;
+        case EV_DEMAND:
+            add_backlog(status, ev.src, ev.dst, ev.amount);
+            break;
+        case EV_ALLOCATE:
+            sim_allocate(s, status, num_racks, &ev);
+            // once arrivals stop, check for pending flows every so often
+            if (ev.time >= 2 * p->duration ||
+                (ev.time >= p->duration && (ev.time & 0xFFF) == 0 &&
+                 s->queue.size == 0 && !sim_flows_pending(s)))
+                break;
+            sim_queue_push(&s->queue, ev.time + BATCH_SIZE, EV_ALLOCATE, 0, 0, 0);
+            break;
+        }
+    }
+
+    for (index = 0; index < MAX_NODES * MAX_NODES; index++) {
+        uint32_t f;
+        for (f = s->head[index]; f != SIM_FLOW_NONE; f = s->flows[f].next)
+            if (s->flows[f].record)
+                s->num_incomplete++;
+    }
+}
+
+// Returns the smallest FCT that at least fraction of the count FCTs in
+// histogram are within
+static uint32_t sim_fct_percentile(uint32_t *histogram, uint64_t count,
+                                   double fraction)
+{
+    uint64_t cum = 0;
+    uint32_t fct;
+
+    for (fct = 0; fct < SIM_MAX_FCT_HISTOGRAM - 1; fct++) {
+        cum += histogram[fct];
+        if (cum >= fraction * count)
+            break;
+    }
+    return fct;
+}
+
+void print_usage(char **argv) {
+    printf("usage: %s [-n nodes] [-u utilization] [-w warm_up] [-t duration] "
+           "[-m mean_flow_size] [-p pareto_alpha] [-g request_gap] "
+           "[-c ctrl_delay] [-a alloc_delay] [-l link_delay] "
+           "[-f fifo|drr|srpt] [-S short_size] [-s seed]\n", argv[0]);
+    printf("\ttimes are in timeslots and flow sizes in MTUs. Flow sizes are "
+           "geometric, or Pareto with -p. Nodes are at most %d.\n", MAX_NODES);
+    printf("\t-f picks the flow each allocated timeslot serves, among flows "
+           "to one destination. Flows of at most short_size MTUs are "
+           "summarized separately.\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct sim_params params = {
+        .num_nodes = SIM_DEFAULT_NODES,
+        .utilization = SIM_DEFAULT_UTILIZATION,
+        .warm_up = SIM_DEFAULT_WARM_UP,
+        .duration = SIM_DEFAULT_WARM_UP + SIM_DEFAULT_DURATION,
+        .mean_size = SIM_DEFAULT_MEAN_SIZE,
+        .size_dist = REQ_SIZE_EXPONENTIAL,
+        .pareto_alpha = SIM_DEFAULT_PARETO_ALPHA,
+        .request_gap = SIM_DEFAULT_REQUEST_GAP,
+        .ctrl_delay = SIM_DEFAULT_CTRL_DELAY,
+        .alloc_delay = SIM_DEFAULT_ALLOC_DELAY,
+        .link_delay = SIM_DEFAULT_LINK_DELAY,
+        .flow_sched = SIM_FLOW_SCHED_FIFO,
+        .short_size = SIM_DEFAULT_SHORT_SIZE,
+        .seed = 1,
+    };
+    uint64_t duration = SIM_DEFAULT_DURATION;
+    struct sim_state *s;
+    struct admissible_state *status;
+    struct fp_ring *q_bin, *q_head, *q_admitted_out, *q_spent;
+    struct fp_mempool *bin_mempool, *admitted_traffic_mempool;
+    struct timespec start, end;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "n:u:w:t:m:p:g:c:a:l:f:S:s:h")) != -1) {
+        switch (opt) {
+        case 'n': params.num_nodes = atoi(optarg); break;
+        case 'u': params.utilization = atof(optarg); break;
+        case 'w': params.warm_up = strtoull(optarg, NULL, 10); break;
+        case 't': duration = strtoull(optarg, NULL, 10); break;
+        case 'm': params.mean_size = atof(optarg); break;
+        case 'p':
+            params.size_dist = REQ_SIZE_PARETO;
+            params.pareto_alpha = atof(optarg);
+            break;
+        case 'g': params.request_gap = atoi(optarg); break;
+        case 'c': params.ctrl_delay = atoi(optarg); break;
+        case 'a': params.alloc_delay = atoi(optarg); break;
+        case 'l': params.link_delay = atoi(optarg); break;
+        case 'f':
+            for (i = 0; i <= SIM_FLOW_SCHED_SRPT; i++)
+                if (strcmp(optarg, sim_flow_sched_names[i]) == 0)
+                    break;
+            if (i > SIM_FLOW_SCHED_SRPT) {
+                print_usage(argv);
+                return -1;
+            }
+            params.flow_sched = i;
+            break;
+        case 'S': params.short_size = atoi(optarg); break;
+        case 's': params.seed = strtoull(optarg, NULL, 10); break;
+        default:
+            print_usage(argv);
+            return -1;
+        }
+    }
+    params.duration = params.warm_up + duration;
+
+    if (params.num_nodes < 2 || params.num_nodes > MAX_NODES ||
+        params.utilization <= 0 || params.utilization >= 1 ||
+        params.mean_size < 1) {
+        print_usage(argv);
+        return -1;
+    }
+
+    /* init the allocator */
+    q_bin = fp_ring_create(2 * FP_NODES_SHIFT);
+    q_head = fp_ring_create(2 * FP_NODES_SHIFT);
+    q_admitted_out = fp_ring_create(SIM_ADMITTED_OUT_RING_LOG_SIZE);
+    q_spent = fp_ring_create(2 * FP_NODES_SHIFT);
+    bin_mempool = fp_mempool_create(SIM_BIN_MEMPOOL_SIZE, bin_num_bytes(SMALL_BIN_SIZE));
+    admitted_traffic_mempool = fp_mempool_create(SIM_ADMITTED_MEMPOOL_SIZE,
+                                                 sizeof(struct admitted_traffic));
+    if (!q_bin || !q_head || !q_admitted_out || !q_spent || !bin_mempool ||
+        !admitted_traffic_mempool)
+        exit(-1);
+
+    status = create_admissible_state(false, 0, 0, params.num_nodes, q_head,
+                                     q_admitted_out, q_spent, bin_mempool,
+                                     admitted_traffic_mempool, &q_bin, NULL, NULL);
+    if (status == NULL) {
+        printf("Error initializing admissible_status!\n");
+        exit(-1);
+    }
+
+    /* init the endpoints */
+    s = calloc(1, sizeof(struct sim_state));
+    assert(s != NULL);
+    s->params = &params;
+    s->free_flows = SIM_FLOW_NONE;
+    memset(s->head, 0xFF, sizeof(s->head));
+
+    /* each sender offers utilization of its link */
+    batch_gen_init(&s->gen, params.seed, params.mean_size / params.utilization,
+                   0, params.num_nodes, params.mean_size);
+    if (params.size_dist == REQ_SIZE_PARETO &&
+        batch_gen_set_pareto(&s->gen, params.mean_size, params.pareto_alpha) != 0) {
+        print_usage(argv);
+        return -1;
+    }
+    s->batch_pos = s->batch.n = 0;
+
+    printf("algo, target_util, fct, request_time, completion_time, src, dst, size\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_simulation(s, status);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    fprintf(stderr, "simulated %" PRIu64 " timeslots of %d nodes with %s flow "
+            "scheduling in %.2f s\n", params.duration, params.num_nodes,
+            sim_flow_sched_names[params.flow_sched],
+            (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9);
+    fprintf(stderr, "observed utilization %f, %" PRIu64 " allocations beyond demand\n",
+            (double) s->num_allocated / (duration * params.num_nodes), s->num_wasted);
+    if (s->num_completed > 0)
+        fprintf(stderr, "%" PRIu64 " flows completed, %" PRIu64 " incomplete; "
+                "fct mean %f, p50 %u, p99 %u, max %" PRIu64 "\n",
+                s->num_completed, s->num_incomplete,
+                (double) s->sum_fct / s->num_completed,
+                sim_fct_percentile(s->fct_histogram, s->num_completed, 0.5),
+                sim_fct_percentile(s->fct_histogram, s->num_completed, 0.99),
+                s->max_fct);
+    if (s->num_short > 0)
+        fprintf(stderr, "%" PRIu64 " short flows (<= %u MTUs); fct p50 %u, "
+                "p99 %u, p99.9 %u\n", s->num_short, params.short_size,
+                sim_fct_percentile(s->short_fct_histogram, s->num_short, 0.5),
+                sim_fct_percentile(s->short_fct_histogram, s->num_short, 0.99),
+                sim_fct_percentile(s->short_fct_histogram, s->num_short, 0.999));
+
+    free(s->queue.events);
+    free(s->flows);
+    free(s);
+    free(status);
+    return 0;
+}
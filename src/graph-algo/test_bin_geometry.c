@@ -0,0 +1,70 @@
+/*
+ * test_bin_geometry.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Checks the runtime bin geometries of bin_geometry.h. The graph-algo build
+ * defines NDEBUG, so failures are reported explicitly rather than by assert().
+ */
+
+#include "bin_geometry.h"
+
+#include <stdio.h>
+
+#define BASE				1024
+
+#define CHECK(cond)													\
+	do {															\
+		if (!(cond)) {												\
+			fprintf(stderr, "%s:%d: check failed: %s\n",			\
+					__FILE__, __LINE__, #cond);						\
+			return 1;												\
+		}															\
+	} while (0)
+
+int main()
+{
+	struct bin_geometry geom;
+	uint16_t computed_bin, prev_bin;
+	uint8_t mode;
+	int i;
+
+	/* recent flows keep a bin each, and older flows never move to a newer bin
+	 * as their gap grows */
+	for (mode = BIN_GEOM_LINEAR; mode <= BIN_GEOM_ADAPTIVE; mode++) {
+		CHECK(bin_geometry_init(&geom, mode, 8, 4) == 0);
+		prev_bin = NUM_BINS + BATCH_SIZE - 1;
+		for (i = 0; i <= BIN_GEOM_MAX_GAP + BATCH_SIZE; i++) {
+			computed_bin = bin_geometry_index(&geom, BASE + BATCH_SIZE - i, BASE);
+			if (i <= BATCH_SIZE)
+				CHECK(computed_bin == NUM_BINS + BATCH_SIZE - 1 - i);
+			else
+				CHECK(computed_bin >= bin_geometry_history_bin(7));
+			CHECK(computed_bin <= prev_bin);
+			prev_bin = computed_bin;
+		}
+	}
+
+	/* linear bins are width timeslots wide */
+	CHECK(bin_geometry_init(&geom, BIN_GEOM_LINEAR, 8, 4) == 0);
+	CHECK(bin_geometry_index(&geom, BASE - 4, BASE) == bin_geometry_history_bin(0));
+	CHECK(bin_geometry_index(&geom, BASE - 5, BASE) == bin_geometry_history_bin(1));
+
+	/* adaptive bins split the observed flows evenly */
+	CHECK(bin_geometry_init(&geom, BIN_GEOM_ADAPTIVE, 8, 0) == 0);
+	for (i = 0; i < 8 * 100; i++)
+		bin_geometry_index(&geom, BASE - 1 - (i % 8), BASE);
+	bin_geometry_retune(&geom);
+	for (i = 0; i < 8; i++)
+		CHECK(bin_geometry_index(&geom, BASE - 1 - i, BASE)
+				== bin_geometry_history_bin(i));
+
+	/* bad parameters are refused */
+	CHECK(bin_geometry_init(&geom, BIN_GEOM_LOG,
+			BIN_GEOM_MAX_HISTORY_BINS + 1, 1) == -1);
+	CHECK(bin_geometry_init(&geom, BIN_GEOM_LINEAR, 8, 0) == -1);
+	CHECK(bin_geometry_init(&geom, BIN_GEOM_ADAPTIVE + 1, 8, 1) == -1);
+
+	printf("bin geometry tests passed\n");
+	return 0;
+}
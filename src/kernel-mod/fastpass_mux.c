@@ -0,0 +1,765 @@
+/*
+ * fastpass_mux.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Control connection shared by the fastpass qdiscs of a network namespace.
+ *    See fastpass_mux.h.
+ *
+ * Locking: conn_lock protects the fpproto_conn, the demand counters and the
+ *    sent[] table. Members are published with RCU; every entry point
+ *    that calls into members holds rcu_read_lock, and fpmux_put waits for a
+ *    grace period before the member's qdisc goes away. Member callbacks that
+ *    run under conn_lock (reset, ack, neg-ack, trigger) must not call back
+ *    into the mux; ALLOC and alloc report callbacks run without it.
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#include <linux/rcupdate.h>
+#include <linux/seq_file.h>
+#include <linux/in.h>
+#include <linux/err.h>
+#include <linux/net.h>
+#include <net/pkt_sched.h>
+#include <net/sock.h>
+
+#include "fastpass_proto.h"
+#include "fastpass_mux.h"
+#include "../protocol/platform.h"
+
+#define FASTPASS_CTRL_SOCK_WMEM		(64*1024*1024)
+
+/* ALLOC payloads carry at most 63*2 timeslot specs */
+#define FPMUX_ALLOC_MAX_TSLOTS		126
+/* alloc reports carry at most 63 destinations */
+#define FPMUX_REPORT_MAX_DSTS		63
+
+static LIST_HEAD(fpmux_list);
+static DEFINE_MUTEX(fpmux_mutex);
+
+static struct fpproto_ops fpmux_proto_ops;
+
+static inline struct fpmux_member *member_at(struct fpmux *mux, int slot)
+{
+	return rcu_dereference(mux->members[slot]);
+}
+
+/**
+ * Encodes @n timeslots, at increasing @offsets from the ALLOC's base
+ *    timeslot and to destination indices @dst_idx, as ALLOC timeslot specs.
+ *    Returns the number of spec bytes, which is never more than the ALLOC
+ *    the timeslots were taken from used.
+ */
+static int encode_specs(u16 *offsets, u8 *dst_idx, int n, u8 *specs)
+{
+	u32 prev = 0;
+	u32 gap;
+	u32 skip;
+	int len = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		gap = offsets[i] - prev;
+		while (gap > 16) {
+			skip = min_t(u32, 16, (gap - 1) / 16);
+			specs[len++] = skip - 1;
+			gap -= 16 * skip;
+		}
+		specs[len++] = (dst_idx[i] << 4) | (gap - 1);
+		prev = offsets[i];
+	}
+	return len;
+}
+
+/*** fpproto callbacks ***/
+
+static void fpmux_handle_reset(void *param)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	struct fpmux_member *m;
+	int slot;
+
+	fpmux_demand_reset(&mux->demand);
+	for (slot = 0; slot < FPMUX_MAX_MEMBERS; slot++) {
+		m = member_at(mux, slot);
+		if (m != NULL)
+			m->ops->handle_reset(m->ops_param);
+	}
+}
+
+static void fpmux_trigger_request(void *param)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	struct fpmux_member *m;
+	int i;
+	int slot;
+
+	/* any member's request carries the connection's acks; rotate among them */
+	for (i = 0; i < FPMUX_MAX_MEMBERS; i++) {
+		slot = (mux->trigger_slot + i) % FPMUX_MAX_MEMBERS;
+		m = member_at(mux, slot);
+		if (m == NULL)
+			continue;
+		mux->trigger_slot = slot + 1;
+		m->ops->trigger_request(m->ops_param);
+		return;
+	}
+}
+
+/**
+ * Translates @pd's A-REQs back to the member that sent them, and returns the
+ *    member, or NULL if it has left. Assumes conn_lock is held.
+ */
+static struct fpmux_member *member_pktdesc(struct fpmux *mux,
+		struct fpproto_pktdesc *pd, struct fpproto_pktdesc *member_pd)
+{
+	struct fpmux_sent *sent = &mux->sent[wnd_pos(pd->seqno)];
+	struct fpmux_member *m = member_at(mux, sent->slot);
+	int i;
+
+	if (m == NULL || m->gen != sent->gen) {
+		mux->stat.stale_acks++;
+		return NULL;
+	}
+
+	memcpy(member_pd, pd, sizeof(*member_pd));
+	for (i = 0; i < pd->n_areq; i++)
+		member_pd->areq[i].tslots = sent->tslots[i];
+	return m;
+}
+
+static void fpmux_handle_ack(void *param, struct fpproto_pktdesc *pd)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	struct fpproto_pktdesc member_pd;
+	struct fpmux_member *m;
+
+	if (!mux->shared) {
+		m = member_at(mux, 0);
+		if (m != NULL)
+			m->ops->handle_ack(m->ops_param, pd);
+		return;
+	}
+
+	m = member_pktdesc(mux, pd, &member_pd);
+	if (m != NULL)
+		m->ops->handle_ack(m->ops_param, &member_pd);
+}
+
+static void fpmux_handle_neg_ack(void *param, struct fpproto_pktdesc *pd)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	struct fpproto_pktdesc member_pd;
+	struct fpmux_member *m;
+
+	if (!mux->shared) {
+		m = member_at(mux, 0);
+		if (m != NULL)
+			m->ops->handle_neg_ack(m->ops_param, pd);
+		return;
+	}
+
+	m = member_pktdesc(mux, pd, &member_pd);
+	if (m != NULL)
+		m->ops->handle_neg_ack(m->ops_param, &member_pd);
+}
+
+static void fpmux_handle_alloc(void *param, u32 base_tslot, u16 *dst_ids,
+		int n_dst, u8 *tslots, int n_tslots)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	struct fpmux_member *m;
+	s8 owner[FPMUX_ALLOC_MAX_TSLOTS];
+	u16 offsets[FPMUX_ALLOC_MAX_TSLOTS];
+	u8 dst_idx[FPMUX_ALLOC_MAX_TSLOTS];
+	u16 member_offsets[FPMUX_ALLOC_MAX_TSLOTS];
+	u8 member_dst_idx[FPMUX_ALLOC_MAX_TSLOTS];
+	u8 specs[FPMUX_ALLOC_MAX_TSLOTS];
+	u32 offset = 0;
+	int n_alloc = 0;
+	bool delivered = false;
+	int n;
+	int i;
+	int slot;
+	u8 spec;
+
+	if (!mux->shared) {
+		m = member_at(mux, 0);
+		if (m != NULL)
+			m->ops->handle_alloc(m->ops_param, base_tslot, dst_ids, n_dst,
+					tslots, n_tslots);
+		return;
+	}
+
+	if (unlikely(n_tslots > FPMUX_ALLOC_MAX_TSLOTS))
+		return;
+
+	/* decide who gets each timeslot */
+	spin_lock_irq(&mux->conn_lock);
+	for (i = 0; i < n_tslots; i++) {
+		spec = tslots[i];
+		if ((spec >> 4) == 0) {
+			offset += 16 * (1 + (spec & 0xF));
+			continue;
+		}
+		offset += 1 + (spec & 0xF);
+
+		/* members would reject an invalid timeslot, so nobody claims it */
+		if (unlikely((spec >> 4) > n_dst
+				|| dst_ids[(spec >> 4) - 1] >= MAX_NODES))
+			owner[n_alloc] = -1;
+		else
+			owner[n_alloc] = fpmux_demand_claim(&mux->demand,
+					dst_ids[(spec >> 4) - 1], 1);
+		offsets[n_alloc] = offset;
+		dst_idx[n_alloc] = spec >> 4;
+		n_alloc++;
+	}
+	spin_unlock_irq(&mux->conn_lock);
+
+	/* hand each member the timeslots it claimed */
+	for (slot = 0; slot < FPMUX_MAX_MEMBERS; slot++) {
+		m = member_at(mux, slot);
+		if (m == NULL)
+			continue;
+
+		n = 0;
+		for (i = 0; i < n_alloc; i++) {
+			if (owner[i] != slot)
+				continue;
+			member_offsets[n] = offsets[i];
+			member_dst_idx[n] = dst_idx[i];
+			n++;
+		}
+
+		if (n == 0)
+			continue;
+
+		m->ops->handle_alloc(m->ops_param, base_tslot, dst_ids, n_dst, specs,
+				encode_specs(member_offsets, member_dst_idx, n, specs));
+		delivered = true;
+	}
+
+	/* every ALLOC should be ACKed, even if no member claimed anything */
+	if (!delivered)
+		fpmux_trigger_request(mux);
+}
+
+static void fpmux_handle_areq(void *param, u16 *dst_and_count, int n)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	struct fpmux_counters *conn = &mux->demand.conn;
+	struct fpmux_counters *mc;
+	struct fpmux_member *m;
+	u16 member_report[2 * FPMUX_REPORT_MAX_DSTS];
+	int n_member;
+	int i;
+	int slot;
+	u16 dst_id;
+	u16 count_low;
+	u64 count;
+	bool need_reset = false;
+
+	if (!mux->shared) {
+		m = member_at(mux, 0);
+		if (m != NULL)
+			m->ops->handle_areq(m->ops_param, dst_and_count, n);
+		return;
+	}
+
+	if (unlikely(n > FPMUX_REPORT_MAX_DSTS))
+		return;
+
+	/* timeslots the controller allocated beyond what we saw were lost;
+	 * assign them as if they had arrived */
+	spin_lock_irq(&mux->conn_lock);
+	for (i = 0; i < n; i++) {
+		dst_id = ntohs(dst_and_count[2*i]);
+		count_low = ntohs(dst_and_count[2*i + 1]);
+		if (unlikely(dst_id >= MAX_NODES))
+			continue;
+
+		count = conn->assigned[dst_id] - (1 << 15);
+		count += (u16)(count_low - count);
+		if ((s64)(count - conn->assigned[dst_id]) <= 0)
+			continue;
+
+		if (unlikely((s64)(count - conn->requested[dst_id]) > 0)) {
+			FASTPASS_WARN("got an alloc report for dst %d larger than requested (%llu > %llu), will reset\n",
+					dst_id, count, conn->requested[dst_id]);
+			mux->stat.report_larger_than_requested++;
+			need_reset = true;
+			break;
+		}
+
+		fpmux_demand_claim(&mux->demand, dst_id,
+				count - conn->assigned[dst_id]);
+	}
+	spin_unlock_irq(&mux->conn_lock);
+
+	if (unlikely(need_reset)) {
+		fpmux_force_reset(mux);
+		return;
+	}
+
+	/* report to each member what it was assigned */
+	for (slot = 0; slot < FPMUX_MAX_MEMBERS; slot++) {
+		m = member_at(mux, slot);
+		if (m == NULL)
+			continue;
+
+		n_member = 0;
+		mc = &mux->demand.member[slot];
+		spin_lock_irq(&mux->conn_lock);
+		for (i = 0; i < n; i++) {
+			dst_id = ntohs(dst_and_count[2*i]);
+			if (dst_id >= MAX_NODES || mc->requested[dst_id] == 0)
+				continue;
+			member_report[2*n_member] = htons(dst_id);
+			member_report[2*n_member + 1] = htons((u16)mc->assigned[dst_id]);
+			n_member++;
+		}
+		spin_unlock_irq(&mux->conn_lock);
+
+		if (n_member > 0)
+			m->ops->handle_areq(m->ops_param, member_report, n_member);
+	}
+}
+
+static int fpmux_cancel_retrans_timer(void *param)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	hrtimer_try_to_cancel(&mux->retrans_timer);
+	return 0;
+}
+
+static void fpmux_set_retrans_timer(void *param, u64 when)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	hrtimer_start(&mux->retrans_timer, ns_to_ktime(when), HRTIMER_MODE_ABS);
+}
+
+static struct fpproto_ops fpmux_proto_ops = {
+	.handle_reset	= &fpmux_handle_reset,
+	.handle_alloc	= &fpmux_handle_alloc,
+	.handle_ack		= &fpmux_handle_ack,
+	.handle_neg_ack	= &fpmux_handle_neg_ack,
+	.handle_areq	= &fpmux_handle_areq,
+	.trigger_request= &fpmux_trigger_request,
+	.set_timer		= &fpmux_set_retrans_timer,
+	.cancel_timer	= &fpmux_cancel_retrans_timer,
+};
+
+/*** timers and rx ***/
+
+static void retrans_tasklet_func(unsigned long int param)
+{
+	struct fpmux *mux = (struct fpmux *)param;
+	u64 now_monotonic = fp_monotonic_time_ns();
+
+	rcu_read_lock();
+	spin_lock_irq(&mux->conn_lock);
+	if (likely(mux->is_destroyed == false))
+		fpproto_handle_timeout(&mux->conn, now_monotonic);
+	spin_unlock_irq(&mux->conn_lock);
+	rcu_read_unlock();
+}
+
+static enum hrtimer_restart retrans_timer_func(struct hrtimer *timer)
+{
+	struct fpmux *mux = container_of(timer, struct fpmux, retrans_timer);
+	tasklet_schedule(&mux->retrans_tasklet);
+	return HRTIMER_NORESTART;
+}
+
+static void ctrl_rcv_handler(void *priv, u8 *pkt, u32 len, __be32 saddr,
+		__be32 daddr)
+{
+	struct fpmux *mux = (struct fpmux *)priv;
+	bool ret = false;
+	u64 in_seq;
+
+	rcu_read_lock();
+	spin_lock_irq(&mux->conn_lock);
+	if (likely(mux->is_destroyed == false))
+		ret = fpproto_handle_rx_packet(&mux->conn, pkt, len, saddr, daddr,
+				&in_seq);
+	spin_unlock_irq(&mux->conn_lock);
+	if (!ret)
+		goto out;
+
+	ret = fpproto_perform_rx_callbacks(&mux->conn, pkt, len);
+	if (!ret)
+		goto out;
+
+	spin_lock_irq(&mux->conn_lock);
+	if (likely(mux->is_destroyed == false))
+		fpproto_successful_rx(&mux->conn, in_seq);
+	spin_unlock_irq(&mux->conn_lock);
+out:
+	rcu_read_unlock();
+}
+
+/* connects the control socket to the controller */
+static int connect_ctrl_socket(struct fpmux *mux, __be32 ctrl_addr)
+{
+	struct sock *sk;
+	int opt;
+	int rc;
+	struct sockaddr_in sock_addr = {
+			.sin_family = AF_INET,
+			.sin_port = FASTPASS_DEFAULT_PORT_NETORDER
+	};
+
+	FASTPASS_BUG_ON(mux->ctrl_sock != NULL);
+
+	/* create socket */
+	rc = __sock_create(mux->net, AF_INET, SOCK_DGRAM, IPPROTO_FASTPASS,
+			&mux->ctrl_sock, 1);
+	if (rc != 0) {
+		FASTPASS_WARN("Error %d creating socket\n", rc);
+		mux->ctrl_sock = NULL;
+		return rc;
+	}
+
+	/* we need a larger-than-default wmem, so we don't run out. ask for a lot,
+	 * the call will not fail if it's too much */
+	opt = FASTPASS_CTRL_SOCK_WMEM;
+	rc = kernel_setsockopt(mux->ctrl_sock, SOL_SOCKET, SO_SNDBUF, (char *)&opt,
+			sizeof(opt));
+	if (rc != 0)
+		FASTPASS_WARN("Could not set socket wmem size\n");
+
+	sk = mux->ctrl_sock->sk;
+
+	FASTPASS_BUG_ON(sk->sk_priority != TC_PRIO_CONTROL);
+	FASTPASS_BUG_ON(sk->sk_allocation != GFP_ATOMIC);
+
+	/* give socket a reference to the mux for rx */
+	((struct fastpass_sock *)sk)->rcv_handler = ctrl_rcv_handler;
+	fpproto_set_priv(sk, (void *)mux);
+
+	/* connect */
+	sock_addr.sin_addr.s_addr = ctrl_addr;
+	rc = kernel_connect(mux->ctrl_sock, (struct sockaddr *)&sock_addr,
+			sizeof(sock_addr), 0);
+	if (rc != 0)
+		goto err_release;
+
+	return 0;
+
+err_release:
+	FASTPASS_WARN("Error %d trying to connect to addr 0x%X (in netorder)\n",
+			rc, ctrl_addr);
+	sock_release(mux->ctrl_sock);
+	mux->ctrl_sock = NULL;
+	return rc;
+}
+
+/*** lifetime ***/
+
+static struct fpmux *fpmux_create(struct net *net, __be32 ctrl_addr,
+		bool shared, u64 rst_win_ns, u32 send_timeout)
+{
+	struct fpmux *mux;
+	int err;
+
+	mux = vzalloc(sizeof(*mux));
+	if (mux == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	mux->net = net;
+	mux->shared = shared;
+	spin_lock_init(&mux->tx_lock);
+
+	/* initialize the fastpass protocol (before initializing socket) */
+	mux->is_destroyed = false;
+	spin_lock_init(&mux->conn_lock);
+	fpproto_init_conn(&mux->conn, &fpmux_proto_ops, (void *)mux, rst_win_ns,
+			send_timeout);
+
+	/* initialize retransmission timer */
+	tasklet_init(&mux->retrans_tasklet, &retrans_tasklet_func,
+			(unsigned long int)mux);
+	hrtimer_init(&mux->retrans_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	mux->retrans_timer.function = retrans_timer_func;
+
+	err = connect_ctrl_socket(mux, ctrl_addr);
+	if (err != 0)
+		goto out_destroy_conn;
+
+	return mux;
+
+out_destroy_conn:
+	fpproto_destroy_conn(&mux->conn);
+	vfree(mux);
+	return ERR_PTR(err);
+}
+
+static void fpmux_destroy(struct fpmux *mux)
+{
+	/* no member sends anymore, can close the control socket */
+	fp_debug("closing control socket\n");
+	sock_release(mux->ctrl_sock);
+	mux->ctrl_sock = NULL;
+
+	spin_lock_irq(&mux->conn_lock);
+	mux->is_destroyed = true;
+	spin_unlock_irq(&mux->conn_lock);
+
+	/**
+	 * At this point:
+	 * 1. control packets stop arriving (ctrl_rcv_handler)
+	 * 2. no new control packets are committed (no members)
+	 * 3. no retransmission timers are handled (retrans_tasklet_func)
+	 * So none of the fpproto_conn API is called after this point.
+	 */
+	fpproto_destroy_conn(&mux->conn);
+
+	/* no race with other code setting the timer, so we can cancel it */
+	hrtimer_cancel(&mux->retrans_timer);
+	tasklet_kill(&mux->retrans_tasklet);
+
+	vfree(mux);
+}
+
+/**
+ * Joins the control connection of @net, creating it if there is none. If
+ *    @shared is false, always creates a private connection. The connection
+ *    parameters of an existing connection are kept.
+ * @slot: set to the member's slot, to be passed to the other calls
+ * @return the connection, or an ERR_PTR
+ */
+struct fpmux *fpmux_get(struct net *net, __be32 ctrl_addr, bool shared,
+		struct fpproto_ops *ops, void *ops_param, u64 rst_win_ns,
+		u32 send_timeout, int *slot)
+{
+	struct fpmux *mux = NULL;
+	struct fpmux *iter;
+	struct fpmux_member *m;
+	int i;
+
+	m = kzalloc(sizeof(*m), GFP_KERNEL);
+	if (m == NULL)
+		return ERR_PTR(-ENOMEM);
+	m->ops = ops;
+	m->ops_param = ops_param;
+
+	mutex_lock(&fpmux_mutex);
+
+	if (shared) {
+		list_for_each_entry(iter, &fpmux_list, list) {
+			if (iter->net == net && iter->shared) {
+				mux = iter;
+				break;
+			}
+		}
+	}
+
+	if (mux == NULL) {
+		mux = fpmux_create(net, ctrl_addr, shared, rst_win_ns, send_timeout);
+		if (IS_ERR(mux))
+			goto out_free_member;
+		list_add(&mux->list, &fpmux_list);
+	}
+
+	for (i = 0; i < FPMUX_MAX_MEMBERS; i++)
+		if (rcu_access_pointer(mux->members[i]) == NULL)
+			break;
+	if (i == FPMUX_MAX_MEMBERS) {
+		FASTPASS_WARN("control connection already has %d qdiscs\n",
+				FPMUX_MAX_MEMBERS);
+		mux = ERR_PTR(-EBUSY);
+		goto out_free_member;
+	}
+
+	/* a new member starts at zero on every destination, like the rest after
+	 * a reset; its requests add to the connection's counters from there */
+	spin_lock_irq(&mux->conn_lock);
+	m->gen = ++mux->next_gen;
+	rcu_assign_pointer(mux->members[i], m);
+	spin_unlock_irq(&mux->conn_lock);
+
+	mux->refcount++;
+	mux->stat.members_joined++;
+	*slot = i;
+
+	mutex_unlock(&fpmux_mutex);
+	return mux;
+
+out_free_member:
+	mutex_unlock(&fpmux_mutex);
+	kfree(m);
+	return mux;
+}
+
+/**
+ * Leaves the control connection; the last member to leave closes it. After
+ *    this returns, the mux makes no more calls to the member's ops. Timeslots
+ *    the member requested but was not assigned become abandoned demand, which
+ *    the next requests of other members to the same destinations use up
+ *    before the connection asks the arbiter for more.
+ */
+void fpmux_put(struct fpmux *mux, int slot)
+{
+	struct fpmux_member *m;
+
+	mutex_lock(&fpmux_mutex);
+
+	spin_lock_irq(&mux->conn_lock);
+	m = rcu_dereference_protected(mux->members[slot], 1);
+	RCU_INIT_POINTER(mux->members[slot], NULL);
+	fpmux_demand_leave(&mux->demand, slot);
+	spin_unlock_irq(&mux->conn_lock);
+
+	synchronize_rcu();
+	kfree(m);
+
+	if (--mux->refcount == 0) {
+		list_del(&mux->list);
+		fpmux_destroy(mux);
+	}
+
+	mutex_unlock(&fpmux_mutex);
+}
+
+/*** tx ***/
+
+/* nacks the tail of the outwnd if it has not been nacked or acked */
+void fpmux_prepare_to_send(struct fpmux *mux)
+{
+	rcu_read_lock();
+	spin_lock_irq(&mux->conn_lock);
+	if (likely(mux->is_destroyed == false))
+		fpproto_prepare_to_send(&mux->conn);
+	spin_unlock_irq(&mux->conn_lock);
+	rcu_read_unlock();
+}
+
+/**
+ * Rebases the A-REQs of the member's @kern_pd onto the connection's counters,
+ *    commits it and queues it on the control socket.
+ * @return true if the packet was queued, false if the caller should free it
+ */
+bool fpmux_commit_request(struct fpmux *mux, int slot,
+		struct fp_kernel_pktdesc *kern_pd, u64 now)
+{
+	struct fpproto_pktdesc *pd = &kern_pd->pktdesc;
+	struct fpmux_member *m;
+	struct fpmux_sent *sent;
+	u64 member_tslots[FASTPASS_PKT_MAX_AREQ];
+	int i;
+
+	rcu_read_lock();
+	spin_lock_irq(&mux->conn_lock);
+	if (unlikely(mux->is_destroyed == true))
+		goto out_unlock;
+
+	m = member_at(mux, slot);
+	if (unlikely(m == NULL))
+		goto out_unlock;
+
+	if (mux->shared) {
+		for (i = 0; i < pd->n_areq; i++) {
+			member_tslots[i] = pd->areq[i].tslots;
+			pd->areq[i].tslots = fpmux_demand_request(&mux->demand, slot,
+					pd->areq[i].src_dst_key, member_tslots[i]);
+		}
+	}
+
+	fpproto_commit_packet(&mux->conn, pd, now);
+
+	if (mux->shared) {
+		sent = &mux->sent[wnd_pos(pd->seqno)];
+		sent->slot = slot;
+		sent->gen = m->gen;
+		memcpy(sent->tslots, member_tslots, pd->n_areq * sizeof(u64));
+	}
+
+	spin_lock(&mux->tx_lock);
+	fpproto_queue_pktdesc(mux->ctrl_sock->sk, kern_pd);
+	spin_unlock(&mux->tx_lock);
+
+	spin_unlock_irq(&mux->conn_lock);
+	rcu_read_unlock();
+	return true;
+
+out_unlock:
+	spin_unlock_irq(&mux->conn_lock);
+	rcu_read_unlock();
+	return false;
+}
+
+/* sends the queued requests of all members. Called from member tasklets */
+u32 fpmux_flush_tx(struct fpmux *mux)
+{
+	u32 n_sent;
+
+	spin_lock(&mux->tx_lock);
+	n_sent = fpproto_flush_tx(mux->ctrl_sock->sk);
+	spin_unlock(&mux->tx_lock);
+	return n_sent;
+}
+
+/**
+ * Resets the connection and all its members, when a member finds the
+ *    protocol state corrupt. Must not be called with conn_lock held.
+ */
+void fpmux_force_reset(struct fpmux *mux)
+{
+	struct fpmux_member *m;
+	int slot;
+
+	rcu_read_lock();
+	spin_lock_irq(&mux->conn_lock);
+	fpproto_force_reset(&mux->conn);
+	fpmux_demand_reset(&mux->demand);
+	spin_unlock_irq(&mux->conn_lock);
+
+	/* fpproto does not call the reset callback on a forced reset */
+	for (slot = 0; slot < FPMUX_MAX_MEMBERS; slot++) {
+		m = member_at(mux, slot);
+		if (m != NULL)
+			m->ops->handle_reset(m->ops_param);
+	}
+	rcu_read_unlock();
+}
+
+void fpmux_set_send_timeout(struct fpmux *mux, u32 send_timeout)
+{
+	spin_lock_irq(&mux->conn_lock);
+	mux->conn.send_timeout = send_timeout;
+	spin_unlock_irq(&mux->conn_lock);
+}
+
+u32 fpmux_n_members(struct fpmux *mux)
+{
+	u32 n = 0;
+	int slot;
+
+	for (slot = 0; slot < FPMUX_MAX_MEMBERS; slot++)
+		if (rcu_access_pointer(mux->members[slot]) != NULL)
+			n++;
+	return n;
+}
+
+void fpmux_print_stats(struct fpmux *mux, struct seq_file *seq)
+{
+	struct fpmux_stat *st = &mux->stat;
+
+	seq_printf(seq, "\n  control connection %p: %s, %u qdiscs (%llu joined)",
+			mux, mux->shared ? "shared" : "private", fpmux_n_members(mux),
+			st->members_joined);
+	if (mux->demand.unclaimed)
+		seq_printf(seq, "\n  %llu allocated timeslots not claimed by any qdisc",
+				mux->demand.unclaimed);
+	if (st->stale_acks)
+		seq_printf(seq, "\n  %llu acks for requests of departed qdiscs",
+				st->stale_acks);
+	if (st->report_larger_than_requested)
+		seq_printf(seq, "\n  %llu alloc reports larger than the connection's requests (causes a reset)",
+				st->report_larger_than_requested);
+}
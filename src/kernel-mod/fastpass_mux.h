@@ -0,0 +1,100 @@
+/*
+ * fastpass_mux.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FASTPASS_MUX_H_
+#define FASTPASS_MUX_H_
+
+#include <linux/types.h>
+#include <linux/hrtimer.h>
+#include <linux/interrupt.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/seq_file.h>
+#include <net/net_namespace.h>
+
+#include "fastpass_proto.h"
+#include "../protocol/fpmux_demand.h"
+#include "../protocol/fpproto.h"
+#include "../protocol/topology.h"
+#include "../protocol/window.h"
+
+/**
+ * A control connection to the arbiter, shared by the qdiscs of a network
+ *    namespace.
+ *
+ * The arbiter knows a host by the source address of its control packets, so
+ *    all qdiscs whose control sockets would route the same way are one node
+ *    to it. The mux runs one fpproto_conn, socket and retransmission timer for
+ *    all of them: each member's A-REQs are rebased onto per-destination
+ *    counters of the connection, and ALLOCs and alloc reports are split back
+ *    among the members that have outstanding requests to each destination
+ *    (see protocol/fpmux_demand.h).
+ */
+
+struct fpmux_stat {
+	__u64 members_joined;
+	__u64 stale_acks;			/* acks for requests of departed members */
+	__u64 report_larger_than_requested;
+};
+
+/* one qdisc using the connection */
+struct fpmux_member {
+	struct fpproto_ops		*ops;
+	void					*ops_param;
+	u32						gen;
+};
+
+/* what a sent packet carried, to translate acks back to the member */
+struct fpmux_sent {
+	u8						slot;
+	u32						gen;
+	u64						tslots[FASTPASS_PKT_MAX_AREQ];
+};
+
+struct fpmux {
+	struct list_head		list;		/* in the registry */
+	struct net				*net;
+	u32						refcount;	/* protected by the registry mutex */
+	bool					shared;
+
+	struct socket			*ctrl_sock;
+	spinlock_t				tx_lock;	/* serializes the socket's tx queue */
+
+	bool					is_destroyed;
+	struct fpproto_conn		conn;
+	spinlock_t				conn_lock;	/* protects conn and the counters */
+
+	struct tasklet_struct	retrans_tasklet;
+	struct hrtimer			retrans_timer;
+
+	struct fpmux_member __rcu *members[FPMUX_MAX_MEMBERS];
+	u32						next_gen;
+	u32						trigger_slot;
+
+	/* per destination, the connection's and members' timeslot counters */
+	struct fpmux_demand		demand;
+	struct fpmux_sent		sent[1 << FASTPASS_WND_LOG];
+
+	struct fpmux_stat		stat;
+};
+
+struct fpmux *fpmux_get(struct net *net, __be32 ctrl_addr, bool shared,
+		struct fpproto_ops *ops, void *ops_param, u64 rst_win_ns,
+		u32 send_timeout, int *slot);
+void fpmux_put(struct fpmux *mux, int slot);
+
+void fpmux_prepare_to_send(struct fpmux *mux);
+bool fpmux_commit_request(struct fpmux *mux, int slot,
+		struct fp_kernel_pktdesc *kern_pd, u64 now);
+u32 fpmux_flush_tx(struct fpmux *mux);
+
+void fpmux_force_reset(struct fpmux *mux);
+void fpmux_set_send_timeout(struct fpmux *mux, u32 send_timeout);
+
+u32 fpmux_n_members(struct fpmux *mux);
+void fpmux_print_stats(struct fpmux *mux, struct seq_file *seq);
+
+#endif /* FASTPASS_MUX_H_ */
@@ -206,7 +206,17 @@ static int fpproto_disconnect(struct sock *sk, int flags)
 
 static void fpproto_destroy_sock(struct sock *sk)
 {
+	struct fastpass_sock *fp = fastpass_sk(sk);
+	struct fp_kernel_pktdesc *kern_pd, *tmp;
+
 	fp_debug("visited\n");
+
+	/* drop descriptors that were queued but never flushed */
+	list_for_each_entry_safe(kern_pd, tmp, &fp->tx_queue, q_elem) {
+		list_del(&kern_pd->q_elem);
+		fpproto_pktdesc_free(&kern_pd->pktdesc);
+	}
+	fp->tx_queue_len = 0;
 }
 
 /**
@@ -310,6 +320,67 @@ void fpproto_send_pktdesc(struct sock *sk,
 	fpproto_pktdesc_free(pd);
 }
 
+/**
+ * Queues a committed packet descriptor, to be sent on the next
+ *    fpproto_flush_tx. Must be called from the same context as the flush.
+ */
+void fpproto_queue_pktdesc(struct sock *sk,
+		struct fp_kernel_pktdesc *kern_pd)
+{
+	struct fastpass_sock *fp = fastpass_sk(sk);
+
+	list_add_tail(&kern_pd->q_elem, &fp->tx_queue);
+	fp->tx_queue_len++;
+}
+
+/**
+ * Sends all queued packet descriptors. All skbs are built first and then
+ *    handed to the IP layer back to back, so the device sees the batch as a
+ *    burst rather than interleaved with encoding work.
+ * @return the number of packets handed to the IP layer
+ */
+u32 fpproto_flush_tx(struct sock *sk)
+{
+	struct fastpass_sock *fp = fastpass_sk(sk);
+	struct fp_kernel_pktdesc *kern_pd, *tmp;
+	struct sk_buff_head skbs;
+	struct sk_buff *skb;
+	u32 n_sent = 0;
+
+	if (fp->tx_queue_len == 0)
+		return 0;
+
+	__skb_queue_head_init(&skbs);
+
+	list_for_each_entry_safe(kern_pd, tmp, &fp->tx_queue, q_elem) {
+		list_del(&kern_pd->q_elem);
+
+		if (atomic_read(&kern_pd->refcount) == 1) {
+			/* already timed out, can free */
+			free_kernel_pktdesc_no_refcount(kern_pd);
+			continue;
+		}
+
+		skb = fpproto_make_skb(sk, &kern_pd->pktdesc);
+		if (likely(skb != NULL))
+			__skb_queue_tail(&skbs, skb);
+
+		/* free the pktdesc if refcount allows (be wary of a race here) */
+		fpproto_pktdesc_free(&kern_pd->pktdesc);
+	}
+	fp->tx_queue_len = 0;
+
+	while ((skb = __skb_dequeue(&skbs)) != NULL) {
+		fpproto_send_skb(sk, skb);
+		n_sent++;
+	}
+
+	fp->stat.tx_batches++;
+	if (n_sent > fp->stat.tx_batch_max)
+		fp->stat.tx_batch_max = n_sent;
+	return n_sent;
+}
+
 static int fpproto_sk_init(struct sock *sk)
 {
 	struct fastpass_sock *fp = fastpass_sk(sk);
@@ -321,6 +392,8 @@ static int fpproto_sk_init(struct sock *sk)
 	inet_sk(sk)->inet_sport = FASTPASS_DEFAULT_PORT_NETORDER;
 
 	fp->mss_cache = 536;
+	INIT_LIST_HEAD(&fp->tx_queue);
+	fp->tx_queue_len = 0;
 
 	fpproto_set_priv(sk, NULL);
 
@@ -396,6 +469,15 @@ void fpproto_print_socket_stats(struct sock *sk, struct seq_file *seq)
 	struct fp_socket_stat *sks = &fp->stat;
 
 	seq_printf(seq, "\n  %llu control packets outputted", sks->xmit_success);
+	seq_printf(seq, "\n  %llu transmit batches, largest %llu packets",
+			sks->tx_batches, sks->tx_batch_max);
+}
+
+void fpproto_dump_socket_stats(struct sock *sk, struct fp_socket_stat *stat)
+{
+	struct fastpass_sock *fp = fastpass_sk(sk);
+
+	memcpy(stat, &fp->stat, sizeof(fp->stat));
 }
 
 void fpproto_print_socket_errors(struct sock *sk, struct seq_file *seq)
@@ -30,12 +30,16 @@ struct fp_socket_stat {
 	__u64 xmit_errors;
 	__u64 skb_alloc_error;
 	__u64 xmit_success;
+	__u64 tx_batches;
+	__u64 tx_batch_max;
 };
 
 /**
  * @inet: the IPv4 socket information
  * @mss_cache: maximum segment size cache
  * @qdisc: the qdisc that owns the socket
+ * @tx_queue: packet descriptors queued by fpproto_queue_pktdesc, to be sent on
+ *    the next fpproto_flush_tx
  */
 struct fastpass_sock {
 	/* inet_sock has to be the first member */
@@ -43,6 +47,8 @@ struct fastpass_sock {
 	__u32 					mss_cache;
 	void					*sch_fastpass_priv;
 	void (*rcv_handler)(void *priv, u8 *pkt, u32 len, __be32 saddr, __be32 daddr);
+	struct list_head		tx_queue;
+	u32						tx_queue_len;
 
 	struct fp_socket_stat stat;
 };
@@ -60,11 +66,14 @@ void fpproto_unregister(void);
 void fpproto_set_priv(struct sock *sk, void *priv);
 
 void fpproto_send_pktdesc(struct sock *sk, struct fp_kernel_pktdesc *kern_pd);
+void fpproto_queue_pktdesc(struct sock *sk, struct fp_kernel_pktdesc *kern_pd);
+u32 fpproto_flush_tx(struct sock *sk);
 
 void fpproto_handle_pending_rx(struct sock *sk);
 
 void fpproto_print_socket_stats(struct sock *sk, struct seq_file *seq);
 void fpproto_print_socket_errors(struct sock *sk, struct seq_file *seq);
+void fpproto_dump_socket_stats(struct sock *sk, struct fp_socket_stat *stat);
 
 static inline struct fastpass_hdr *fastpass_hdr(
 		const struct sk_buff *skb)
@@ -0,0 +1,243 @@
+/*
+ * fpstat.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Reads the binary statistics of a fastpass qdisc over rtnetlink, and prints
+ *    the rate of each counter. Does not touch the proc files, so it is cheap
+ *    enough to run at high frequency.
+ *
+ * usage: fpstat <dev> [interval_ms]
+ */
+
+#include <errno.h>
+#include <net/if.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "pkt_sched.h"
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/gen_stats.h>
+
+#include "../protocol/fastpass_stats.h"
+
+#define FPSTAT_BUF_SIZE		(64 * 1024)
+
+struct stat_field {
+	const char	*name;
+	size_t		offset;
+};
+
+#define TSQ_FIELD(f)	{ #f, offsetof(struct tc_fastpass_qd_stats, tsq_stats) \
+							+ offsetof(struct tsq_sched_stat, f) }
+#define FP_FIELD(f)		{ #f, offsetof(struct tc_fastpass_qd_stats, sched_stats) \
+							+ offsetof(struct fp_sched_stat, f) }
+#define QD_FIELD(f)		{ #f, offsetof(struct tc_fastpass_qd_stats, f) }
+
+static const struct stat_field fields[] = {
+	QD_FIELD(demand_tslots),
+	QD_FIELD(requested_tslots),
+	QD_FIELD(alloc_tslots),
+	QD_FIELD(acked_tslots),
+	QD_FIELD(used_tslots),
+
+	TSQ_FIELD(ctrl_pkts),
+	TSQ_FIELD(ntp_pkts),
+	TSQ_FIELD(ptp_pkts),
+	TSQ_FIELD(arp_pkts),
+	TSQ_FIELD(igmp_pkts),
+	TSQ_FIELD(ssh_pkts),
+	TSQ_FIELD(data_pkts),
+	TSQ_FIELD(classify_errors),
+	TSQ_FIELD(above_plimit),
+	TSQ_FIELD(allocation_errors),
+	TSQ_FIELD(pkt_too_big),
+	TSQ_FIELD(added_tslots),
+	TSQ_FIELD(used_timeslots),
+	TSQ_FIELD(missed_timeslots),
+	TSQ_FIELD(backlog_too_high),
+	TSQ_FIELD(unwanted_alloc),
+	TSQ_FIELD(dst_not_found_admit_now),
+	TSQ_FIELD(overfull_tslots),
+
+	FP_FIELD(admitted_timeslots),
+	FP_FIELD(early_enqueue),
+	FP_FIELD(late_enqueue1),
+	FP_FIELD(late_enqueue2),
+	FP_FIELD(late_enqueue3),
+	FP_FIELD(late_enqueue4),
+	FP_FIELD(req_alloc_errors),
+	FP_FIELD(request_with_empty_flowqueue),
+	FP_FIELD(queued_flow_already_acked),
+	FP_FIELD(requested_dsts),
+	FP_FIELD(aged_requests),
+	FP_FIELD(alloc_too_late),
+	FP_FIELD(alloc_premature),
+	FP_FIELD(unwanted_alloc),
+	FP_FIELD(alloc_report_larger_than_requested),
+	FP_FIELD(timeslots_assumed_lost),
+	FP_FIELD(urgent_requests),
+};
+
+#define N_FIELDS	(sizeof(fields) / sizeof(fields[0]))
+
+static __u64 get_field(struct tc_fastpass_qd_stats *st, int i)
+{
+	__u64 val;
+	memcpy(&val, (char *)st + fields[i].offset, sizeof(val));
+	return val;
+}
+
+/**
+ * Finds the TCA_STATS_APP of the fastpass qdisc in a dump reply.
+ * Returns 1 if found, 0 if not in this message.
+ */
+static int parse_qdisc(struct nlmsghdr *nlh, int ifindex,
+		struct tc_fastpass_qd_stats *st)
+{
+	struct tcmsg *tcm = NLMSG_DATA(nlh);
+	int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*tcm));
+	struct rtattr *rta = (struct rtattr *)((char *)tcm + NLMSG_ALIGN(sizeof(*tcm)));
+	struct rtattr *app = NULL;
+	int is_fastpass = 0;
+
+	if (tcm->tcm_ifindex != ifindex)
+		return 0;
+
+	for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		if (rta->rta_type == TCA_KIND)
+			is_fastpass = (strcmp(RTA_DATA(rta), "fastpass") == 0);
+		if (rta->rta_type == TCA_STATS2) {
+			struct rtattr *sub = RTA_DATA(rta);
+			int sub_len = RTA_PAYLOAD(rta);
+			for (; RTA_OK(sub, sub_len); sub = RTA_NEXT(sub, sub_len))
+				if (sub->rta_type == TCA_STATS_APP)
+					app = sub;
+		}
+	}
+
+	if (!is_fastpass || app == NULL)
+		return 0;
+
+	memset(st, 0, sizeof(*st));
+	memcpy(st, RTA_DATA(app), RTA_PAYLOAD(app) < sizeof(*st) ?
+			RTA_PAYLOAD(app) : sizeof(*st));
+	return 1;
+}
+
+/**
+ * Reads the statistics of the fastpass qdisc on @ifindex.
+ * Returns 0 on success, -1 on error.
+ */
+static int read_stats(int fd, int ifindex, struct tc_fastpass_qd_stats *st)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct tcmsg tcm;
+	} req;
+	static char buf[FPSTAT_BUF_SIZE];
+	struct nlmsghdr *nlh;
+	int found = 0;
+	int len;
+
+	memset(&req, 0, sizeof(req));
+	req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct tcmsg));
+	req.nlh.nlmsg_type = RTM_GETQDISC;
+	req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.tcm.tcm_family = AF_UNSPEC;
+	req.tcm.tcm_ifindex = ifindex;
+
+	if (send(fd, &req, req.nlh.nlmsg_len, 0) < 0) {
+		perror("send");
+		return -1;
+	}
+
+	while (1) {
+		len = recv(fd, buf, sizeof(buf), 0);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("recv");
+			return -1;
+		}
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len);
+				nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_DONE)
+				return found ? 0 : -1;
+			if (nlh->nlmsg_type == NLMSG_ERROR) {
+				fprintf(stderr, "netlink error\n");
+				return -1;
+			}
+			if (nlh->nlmsg_type == RTM_NEWQDISC && !found)
+				found = parse_qdisc(nlh, ifindex, st);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct tc_fastpass_qd_stats prev, cur;
+	unsigned int interval_ms = 1000;
+	int ifindex;
+	int fd;
+	int i;
+	double secs;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <dev> [interval_ms]\n", argv[0]);
+		return 1;
+	}
+	ifindex = if_nametoindex(argv[1]);
+	if (ifindex == 0) {
+		fprintf(stderr, "unknown device %s\n", argv[1]);
+		return 1;
+	}
+	if (argc > 2)
+		interval_ms = atoi(argv[2]);
+
+	fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+
+	if (read_stats(fd, ifindex, &prev) != 0) {
+		fprintf(stderr, "no fastpass qdisc statistics on %s\n", argv[1]);
+		return 1;
+	}
+	if (prev.version != FASTPASS_STATS_VERSION) {
+		fprintf(stderr, "statistics version %u, expected %u\n", prev.version,
+				FASTPASS_STATS_VERSION);
+		return 1;
+	}
+
+	while (1) {
+		usleep(interval_ms * 1000);
+		if (read_stats(fd, ifindex, &cur) != 0)
+			return 1;
+
+		secs = (double)(cur.stat_timestamp - prev.stat_timestamp) / 1e9;
+		if (secs <= 0)
+			continue;
+
+		printf("timeslot %llu, %u flows (%u inactive), %u unrequested dsts\n",
+				(unsigned long long)cur.current_timeslot, cur.flows,
+				cur.inactive_flows, cur.n_unreq_flows);
+		for (i = 0; i < N_FIELDS; i++) {
+			__u64 delta = get_field(&cur, i) - get_field(&prev, i);
+			if (delta == 0)
+				continue;
+			printf("  %-36s %14llu %14.1f/s\n", fields[i].name,
+					(unsigned long long)get_field(&cur, i), delta / secs);
+		}
+		printf("\n");
+		fflush(stdout);
+		prev = cur;
+	}
+	return 0;
+}
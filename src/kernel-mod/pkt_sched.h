@@ -765,14 +765,25 @@ enum {
 	TCA_FASTPASS_DEV_BACKLOG_NS,/* max number of ns to backlog the internal queue */
 	TCA_FASTPASS_MAX_PRELOAD,	/* #timeslots to look ahead to future when queueing internal */
 	TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS, /* how often to update internal queue */
+	TCA_FASTPASS_RETRANS_TIMEOUT_NS, /* time to wait for an ACK before retransmitting (ns) */
+	TCA_FASTPASS_FLOW_SCHED,	/* scheduler among flows to a destination, TC_FASTPASS_FLOW_SCHED_* */
 	__TCA_FASTPASS_MAX
 };
 
 #define TCA_FASTPASS_MAX	(__TCA_FASTPASS_MAX - 1)
 
+/* which flow an allocated timeslot serves, among flows to the same destination */
+enum {
+	TC_FASTPASS_FLOW_SCHED_FIFO,	/* packets in arrival order, flows not separated */
+	TC_FASTPASS_FLOW_SCHED_DRR,		/* deficit round robin over 5-tuple flows */
+	TC_FASTPASS_FLOW_SCHED_SRPT,	/* smallest flow first, by skb->mark or backlog */
+	__TC_FASTPASS_FLOW_SCHED_MAX
+};
+
 #define TC_FASTPASS_SCHED_STAT_MAX_BYTES (35 * sizeof(__u64))
 #define TC_FASTPASS_SOCKET_STAT_MAX_BYTES (12 * sizeof(__u64))
 #define TC_FASTPASS_PROTO_STAT_MAX_BYTES (50 * sizeof(__u64))
+#define TC_FASTPASS_TSQ_STAT_MAX_BYTES (32 * sizeof(__u64))
 
 struct tc_fastpass_qd_stats {
 	__u32	version;
@@ -792,5 +803,6 @@ struct tc_fastpass_qd_stats {
 	__u8	sched_stats[TC_FASTPASS_SCHED_STAT_MAX_BYTES];
 	__u8	socket_stats[TC_FASTPASS_SOCKET_STAT_MAX_BYTES];
 	__u8	proto_stats[TC_FASTPASS_PROTO_STAT_MAX_BYTES];
+	__u8	tsq_stats[TC_FASTPASS_TSQ_STAT_MAX_BYTES];
 };
 #endif
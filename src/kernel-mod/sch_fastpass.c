@@ -21,6 +21,7 @@
 #include <linux/prefetch.h>
 #include <linux/time.h>
 #include <linux/bitops.h>
+#include <linux/percpu_counter.h>
 #include <linux/version.h>
 #include <linux/ip.h>
 #include <linux/inet.h>
@@ -35,9 +36,13 @@
 #endif
 
 #include "sch_timeslot.h"
+#include "../protocol/fastpass_stats.h"
 #include "fastpass_proto.h"
+#include "fastpass_mux.h"
 #include "../protocol/platform.h"
+#include "../protocol/endpoint.h"
 #include "../protocol/pacer.h"
+#include "../protocol/alloc_bounds.h"
 #include "../protocol/window.h"
 #include "../protocol/topology.h"
 #include "../protocol/stat_print.h"
@@ -45,43 +50,50 @@
 /*
  * FastPass client qdisc
  *
- * Invariants:
- *  - If a flow has unreq_tslots > 0, then it is linked to q->unreq_flows,
- *      otherwise flow->next is NULL.
- *
- *  	An exception is if flow->next == &do_not_schedule (which is used for
- *  	q->internal), then it is not linked to q->unreq_flows.
+ * The control loop (demand accounting, requests, ALLOC handling) lives in
+ *    protocol/endpoint.c; this file runs it with timers, the shared control
+ *    connection and the timeslot queues of sch_timeslot.
  *
+ * Invariants:
+ *  - If a flow has unreq_tslots > 0, then it is linked to one of
+ *      ep->unreq_buckets, otherwise flow->req_list is empty.
  */
 
 #define FASTPASS_HORIZON					64
-#define FASTPASS_REQUEST_WINDOW_SIZE 		(1 << 13)
-
-#define FASTPASS_CTRL_SOCK_WMEM				(64*1024*1024)
 
 #define PROC_FILENAME_MAX_SIZE				64
 
-enum {
-	FLOW_UNQUEUED,
-	FLOW_REQUEST_QUEUE,
-};
-
 /* module parameters */
 static u32 req_cost = (2 << 20);
 module_param(req_cost, uint, 0444);
-MODULE_PARM_DESC(req_cost, "Cost of sending a request in ns, for request pacing");
+MODULE_PARM_DESC(req_cost, "Cost of sending a request in ns, for request pacing, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(req_cost);
 
 static u32 req_bucketlen = 4 * (2 << 20); /* 4 * req_cost */
 module_param(req_bucketlen, uint, 0444);
-MODULE_PARM_DESC(req_bucketlen, "Max bucket size in ns, for request pacing");
+MODULE_PARM_DESC(req_bucketlen, "Max bucket size in ns, for request pacing, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(req_bucketlen);
 
 static u32 req_min_gap = 1000;
 module_param(req_min_gap, uint, 0444);
-MODULE_PARM_DESC(req_min_gap, "ns to wait from when data arrives to sending request");
+MODULE_PARM_DESC(req_min_gap, "ns to wait from when data arrives to sending request, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(req_min_gap);
 
+static u32 req_max_age_ns = 4 * (2 << 20); /* 4 * req_cost */
+module_param(req_max_age_ns, uint, 0444);
+MODULE_PARM_DESC(req_max_age_ns, "ns a dst can wait for a request before it is served ahead of larger ones");
+EXPORT_SYMBOL_GPL(req_max_age_ns);
+
+static u32 tx_batch_quota = 4;
+module_param(tx_batch_quota, uint, 0444);
+MODULE_PARM_DESC(tx_batch_quota, "max requests sent in one batch by a maintenance tasklet run");
+EXPORT_SYMBOL_GPL(tx_batch_quota);
+
+static bool share_ctrl_conn = true;
+module_param(share_ctrl_conn, bool, 0444);
+MODULE_PARM_DESC(share_ctrl_conn, "qdiscs in the same network namespace share one connection to the controller");
+EXPORT_SYMBOL_GPL(share_ctrl_conn);
+
 static char *ctrl_addr = "192.168.100.222";
 module_param(ctrl_addr, charp, 0444);
 MODULE_PARM_DESC(ctrl_addr, "IPv4 address of the controller");
@@ -95,12 +107,12 @@ EXPORT_SYMBOL_GPL(reset_window_us);
 
 static u32 retrans_timeout_ns = 200000;
 module_param(retrans_timeout_ns, uint, 0444);
-MODULE_PARM_DESC(retrans_timeout_ns, "how long to wait for an ACK before retransmitting request");
+MODULE_PARM_DESC(retrans_timeout_ns, "how long to wait for an ACK before retransmitting request, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(retrans_timeout_ns);
 
 static u32 update_timer_ns = 2048;
 module_param(update_timer_ns, uint, 0444);
-MODULE_PARM_DESC(update_timer_ns, "how often to perform periodic tasks");
+MODULE_PARM_DESC(update_timer_ns, "how often to perform periodic tasks, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(update_timer_ns);
 
 static bool proc_dump_dst = true;
@@ -110,48 +122,23 @@ EXPORT_SYMBOL_GPL(proc_dump_dst);
 
 static u32 miss_threshold = 16;
 module_param(miss_threshold, uint, 0444);
-MODULE_PARM_DESC(miss_threshold, "how far in the past can the allocation be and still be accepted");
+MODULE_PARM_DESC(miss_threshold, "how far in the past can the allocation be and still be accepted, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(miss_threshold);
 
 static u32 max_preload = 64;
 module_param(max_preload, uint, 0444);
-MODULE_PARM_DESC(max_preload, "how futuristic can an allocation be and still be accepted");
+MODULE_PARM_DESC(max_preload, "how futuristic can an allocation be and still be accepted, default for new qdiscs (change with tc)");
 EXPORT_SYMBOL_GPL(max_preload);
 
-/*
- * Per flow structure, dynamically allocated
- */
-struct fp_dst {
-	u64		demand_tslots;		/* total needed timeslots */
-	u64		requested_tslots;	/* highest requested timeslots */
-	u64		acked_tslots;		/* highest requested timeslots that was acked*/
-	u64		alloc_tslots;		/* total received allocations */
-	u64		used_tslots;		/* timeslots in which packets moved */
-	spinlock_t lock;
-	uint8_t state;
-};
+static bool adaptive_bounds = false;
+module_param(adaptive_bounds, bool, 0444);
+MODULE_PARM_DESC(adaptive_bounds, "adapt miss_threshold and max_preload to the arrival offsets of ALLOCs, using the configured values as limits");
+EXPORT_SYMBOL_GPL(adaptive_bounds);
 
-struct fp_sched_stat {
-	/* dequeue-related */
-	__u64		admitted_timeslots;
-	__u64		early_enqueue;
-	__u64		late_enqueue1;
-	__u64		late_enqueue2;
-	__u64		late_enqueue3;
-	__u64		late_enqueue4;
-
-	/* request-related */
-	__u64		req_alloc_errors;
-	__u64		request_with_empty_flowqueue;
-	__u64		queued_flow_already_acked;
-	/* alloc-related */
-	__u64		alloc_too_late;
-	__u64		alloc_premature;
-	__u64		unwanted_alloc;
-	/* alloc report-related */
-	__u64		alloc_report_larger_than_requested;
-	__u64		timeslots_assumed_lost;
-};
+static u32 adaptive_waste_shift = 8;
+module_param(adaptive_waste_shift, uint, 0444);
+MODULE_PARM_DESC(adaptive_waste_shift, "adaptive bounds drop at most 1/2^adaptive_waste_shift of ALLOCs on each side");
+EXPORT_SYMBOL_GPL(adaptive_waste_shift);
 
 /**
  *
@@ -160,60 +147,31 @@ struct fp_sched_data {
 	/* configuration paramters */
 	u32		tslot_mul;					/* mul to calculate timeslot from nsec */
 	u32		tslot_shift;				/* shift to calculate timeslot from nsec */
+	/* tunables, initialized from the module parameters and changed via tc */
+	u32		req_cost;
+	u32		req_bucketlen;
+	u32		req_min_gap;
+	u32		retrans_timeout_ns;
+	u32		update_timer_ns;
 
 	/* state */
-	u16 unreq_flows[MAX_NODES]; 		/* flows with unscheduled packets */
-	u32 unreq_dsts_head;
-	u32 unreq_dsts_tail;
-	spinlock_t 				unreq_flows_lock;
-
-	struct fp_dst dsts[MAX_NODES];
-
-	struct fp_window alloc_wnd;
-	u64		current_timeslot;
+	struct fp_endpoint		ep;				/* the control loop */
 	u64		schedule[(1 << FASTPASS_WND_LOG)];	/* flows scheduled in the next time slots */
 
 	struct tasklet_struct	maintenance_tasklet;
 	struct hrtimer			maintenance_timer;
-	struct tasklet_struct	retrans_tasklet;
-	struct hrtimer			retrans_timer;
 
 	spinlock_t 				pacer_lock;
 	struct fp_pacer request_pacer;
-	struct socket	*ctrl_sock;			/* socket to the controller */
-
-	bool					is_destroyed;
-	struct fpproto_conn		conn;
-	spinlock_t 				conn_lock;
+	struct fpmux			*mux;			/* connection to the controller */
+	int						mux_slot;
 
 	struct proc_dir_entry *proc_entry;
-
-	/* counters */
-	atomic_t demand_tslots;		/* total needed timeslots */
-	u64		requested_tslots;	/* highest requested timeslots */
-	atomic_t alloc_tslots;		/* total received allocations */
-	u64		acked_tslots;		/* total acknowledged requests */
-	u64		used_tslots;
-
-	/* statistics */
-	struct fp_sched_stat stat;
 };
 
 static struct tsq_qdisc_entry *fastpass_tsq_entry;
 static struct proc_dir_entry *fastpass_proc_entry;
 
-static inline struct fp_dst *get_dst(struct fp_sched_data *q, u32 index) {
-	struct fp_dst *ret = &q->dsts[index];
-	fp_debug("get dst %u\n", index);
-	spin_lock(&ret->lock);
-	return ret;
-}
-
-static inline void release_dst(struct fp_sched_data *q, struct fp_dst *dst) {
-	fp_debug("put dst %u\n", (u32)(dst - &q->dsts[0]));
-	spin_unlock(&dst->lock);
-}
-
 /**
  *  computes the time when next request should go out
  *  @returns true if the timer was set, false if it was already set
@@ -234,461 +192,53 @@ void trigger_tx_voidp(void *param)
 	trigger_tx(q);
 }
 
-static int cancel_retrans_timer(void *param)
+static void fastpass_admit(void *param, u64 *dst_ids, u32 *n_tslots, int n)
 {
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	hrtimer_try_to_cancel(&q->retrans_timer);
-	return 0;
+	tsq_admit_now_batch(param, dst_ids, n_tslots, n);
 }
 
-static void set_retrans_timer(void *param, u64 when)
+static void fastpass_force_reset(void *param)
 {
 	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	hrtimer_start(&q->retrans_timer, ns_to_ktime(when), HRTIMER_MODE_ABS);
+	fpmux_force_reset(q->mux);
 }
 
-/**
- * Enqueues flow to the request queue, if it's not already in the retransmit
- *    queue
- * Assumes dst_id is already locked by caller.
- */
-static void unreq_dsts_enqueue_if_not_queued(struct fp_sched_data *q, u32 dst_id,
-		struct fp_dst *dst)
-{
-	if (dst->state != FLOW_UNQUEUED) {
-		return;
-	}
-
-	/* enqueue */
-	spin_lock(&q->unreq_flows_lock);
-	q->unreq_flows[q->unreq_dsts_tail++ % MAX_NODES] = dst_id;
-	spin_unlock(&q->unreq_flows_lock);
-	dst->state = FLOW_REQUEST_QUEUE;
-
-	/* update request timer if necessary */
-	if (trigger_tx(q))
-		fp_debug("set request timer to %llu\n", pacer_next_event(&q->request_pacer));
-}
-
-/* returns NULL if the dst queue is empty */
-static struct fp_dst *unreq_dsts_dequeue_and_get(struct fp_sched_data* q, u32 *dst_id)
-{
-	struct fp_dst *res;
-
-	/* get entry and remove from queue */
-	spin_lock(&q->unreq_flows_lock);
-	if (unlikely(q->unreq_dsts_head == q->unreq_dsts_tail)) {
-		spin_unlock(&q->unreq_flows_lock);
-		return NULL;
-	}
-	*dst_id = q->unreq_flows[q->unreq_dsts_head++ % MAX_NODES];
-	spin_unlock(&q->unreq_flows_lock);
-	res = get_dst(q, *dst_id);
-	res->state = FLOW_UNQUEUED;
-
-	return res;
-}
-
-static inline u32 n_unreq_dsts(struct fp_sched_data *q)
-{
-	return q->unreq_dsts_tail - q->unreq_dsts_head;
-}
-
-void flow_inc_used(struct fp_sched_data *q, struct fp_dst* dst, u64 amount) {
-	dst->used_tslots += amount;
-	q->used_tslots += amount;
-}
-
-/**
- * Increase the number of unrequested packets for the flow.
- *   Maintains the necessary invariants, e.g. adds the flow to the unreq_flows
- *   list if necessary
- */
-static void flow_inc_demand(struct fp_sched_data *q, u32 dst_id,
-		struct fp_dst *dst, u64 amount)
-{
-	dst->demand_tslots += amount;
-
-	/* if flow not on scheduling queue yet, enqueue */
-	unreq_dsts_enqueue_if_not_queued(q, dst_id, dst);
-
-	atomic_add(amount, &q->demand_tslots);
-}
-
-/**
- * Performs a reset of all flows
- */
-static void handle_reset(void *param)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-
-	struct fp_dst *dst;
-	u32 idx;
-	u32 dst_id;
-	u32 mask = MAX_NODES - 1;
-	u32 base_idx = jhash_1word((__be32)fp_monotonic_time_ns(), 0) & mask;
-
-	BUILD_BUG_ON_MSG(MAX_NODES & (MAX_NODES - 1), "MAX_NODES needs to be a power of 2");
-
-	/* reset future allocations */
-	wnd_reset(&q->alloc_wnd, q->current_timeslot);
-
-	atomic_set(&q->demand_tslots, 0);
-	q->requested_tslots = 0;	/* will remain 0 when we're done */
-	atomic_set(&q->alloc_tslots, 0);		/* will remain 0 when we're done */
-	q->acked_tslots = 0; 		/* will remain 0 when we're done */
-	q->used_tslots = 0; 		/* will remain 0 when we're done */
-
-	/* for each cell in hash table: */
-	for (idx = 0; idx < MAX_NODES; idx++) {
-		/* we start from a pseudo-random index 'base_idx' to have less
-		 * discrimination towards the lower idx in unreq_dsts_enqueue, however
-		 * this is not a perfectly fair scheme */
-		dst_id = (idx + base_idx) & mask;
-		dst = get_dst(q, dst_id);
-
-		/* if flow was empty anyway, nothing more to do */
-		if (likely(dst->demand_tslots == dst->used_tslots))
-			goto release;
-
-		/* has timeslots pending, rebase counters to 0 */
-		dst->demand_tslots -= dst->used_tslots;
-		dst->alloc_tslots = 0;
-		dst->acked_tslots = 0;
-		dst->requested_tslots = 0;
-		dst->used_tslots = 0;
-
-		atomic_add(dst->demand_tslots, &q->demand_tslots);
-
-		fp_debug("rebased flow 0x%04X, new demand %llu timeslots\n",
-				dst_id, dst->demand_tslots);
-
-		/* add flow to request queue if it's not already there */
-		unreq_dsts_enqueue_if_not_queued(q, dst_id, dst);
-release:
-		release_dst(q, dst);
-	}
-}
-
-/**
- * Handles an ALLOC payload
- */
-static void handle_alloc(void *param, u32 base_tslot, u16 *dst_ids,
-		int n_dst, u8 *tslots, int n_tslots)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	int i;
-	u8 spec;
-	int dst_id_idx;
-	u32 dst_id;
-	u64 full_tslot;
-	u64 now_real = fp_get_time_ns();
-	u64 current_timeslot;
-
-	/* every alloc should be ACKed */
-	trigger_tx(q);
-
-	/* find full timeslot value of the ALLOC */
-	current_timeslot = (now_real * q->tslot_mul) >> q->tslot_shift;
-
-	full_tslot = current_timeslot - (1ULL << 18); /* 1/4 back, 3/4 front */
-	full_tslot += ((u32)base_tslot - (u32)full_tslot) & 0xFFFFF; /* 20 bits */
-
-	fp_debug("got ALLOC for timeslot %d (full %llu, current %llu), %d destinations, %d timeslots, mask 0x%016llX\n",
-			base_tslot, full_tslot, q->current_timeslot, n_dst, n_tslots,
-			wnd_get_mask(&q->alloc_wnd, q->current_timeslot+63));
-
-	for (i = 0; i < n_tslots; i++) {
-		struct fp_dst *dst;
-
-		spec = tslots[i];
-		dst_id_idx = spec >> 4;
-
-		if (dst_id_idx == 0) {
-			/* Skip instruction */
-			base_tslot += 16 * (1 + (spec & 0xF));
-			full_tslot += 16 * (1 + (spec & 0xF));
-			fp_debug("ALLOC skip to timeslot %d full %llu (no allocation)\n",
-					base_tslot, full_tslot);
-			continue;
-		}
-
-		if (dst_id_idx > n_dst) {
-			/* destination index out of bounds */
-			FASTPASS_CRIT("ALLOC tslot spec 0x%02X has illegal dst index %d (max %d)\n",
-					spec, dst_id_idx, n_dst);
-			return;
-		}
-
-		base_tslot += 1 + (spec & 0xF);
-		full_tslot += 1 + (spec & 0xF);
-		fp_debug("Timeslot %d (full %llu) to destination 0x%04x (%d)\n",
-				base_tslot, full_tslot, dst_ids[dst_id_idx - 1], dst_ids[dst_id_idx - 1]);
-
-		/* is alloc too far in the past? */
-		if (unlikely(time_before64(full_tslot, current_timeslot - miss_threshold))) {
-		//if (unlikely(wnd_seq_before(&q->alloc_wnd, full_tslot))) {
-			q->stat.alloc_too_late++;
-			fp_debug("-X- already gone, dropping\n");
-			continue;
-		}
-
-		if (unlikely(time_after64(full_tslot, current_timeslot + max_preload))) {
-//		if (unlikely(wnd_seq_after(&q->alloc_wnd, full_tslot))) {
-			q->stat.alloc_premature++;
-			fp_debug("-X- too futuristic, dropping\n");
-			continue;
-		}
-
-		/* sanity check */
-//		if (wnd_is_marked(&q->alloc_wnd, full_tslot)) {
-//			FASTPASS_WARN("got ALLOC tslot %llu dst 0x%X but but it was already marked for 0x%llX current_tslot %llu base %u now_real %llu\n",
-//					full_tslot, dst[dst_ind - 1], q->schedule[wnd_pos(full_tslot)],
-//					q->current_timeslot, base_tslot, now_real);
-//			continue;
-//		}
-
-		dst_id = dst_ids[dst_id_idx - 1];
-		dst = get_dst(q, dst_id);
-		/* okay, allocate */
-//		wnd_mark(&q->alloc_wnd, full_tslot);
-//		q->schedule[wnd_pos(full_tslot)] = dst[dst_ind - 1];
-		if (dst->used_tslots != dst->demand_tslots) {
-
-			flow_inc_used(q, dst, 1);
-			dst->alloc_tslots++;
-			release_dst(q, dst);
-
-			tsq_admit_now(q, dst_id);
-
-			atomic_inc(&q->alloc_tslots);
-			q->stat.admitted_timeslots++;
-			if (full_tslot > current_timeslot) {
-				q->stat.early_enqueue++;
-			} else {
-				u64 tslot = current_timeslot;
-				if (unlikely(full_tslot < tslot - (miss_threshold >> 1))) {
-					if (unlikely(full_tslot < tslot - 3*(miss_threshold >> 2)))
-						q->stat.late_enqueue4++;
-					else
-						q->stat.late_enqueue3++;
-				} else {
-					if (unlikely(full_tslot < tslot - (miss_threshold >> 2)))
-						q->stat.late_enqueue2++;
-					else
-						q->stat.late_enqueue1++;
-				}
-			}
-
-		} else {
-			release_dst(q, dst);
-			q->stat.unwanted_alloc++;
-			fp_debug("got an allocation over demand, flow 0x%04X, demand %llu\n",
-					dst_id, dst->demand_tslots);
-		}
-	}
-
-	fp_debug("mask after: 0x%016llX\n",
-			wnd_get_mask(&q->alloc_wnd, q->current_timeslot+63));
-}
-
-static void handle_areq(void *param, u16 *dst_and_count, int n)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	struct fp_dst *dst;
-	int i;
-	u16 dst_id;
-	u16 count_low;
-	u64 count;
-
-	trigger_tx(q);
-
-	for (i = 0; i < n; i++) {
-		dst_id = ntohs(dst_and_count[2*i]);
-		count_low = ntohs(dst_and_count[2*i + 1]);
-
-		dst = get_dst(q, dst_id);
-
-		/* get full count */
-		/* TODO: This is not perfectly safe. For example, if there is a big
-		 * outage and the controller thinks it had produced many timeslots, this
-		 * can go out of sync */
-		count = dst->alloc_tslots - (1 << 15);
-		count += (u16)(count_low - count);
-
-		/* update counts */
-		if ((s64)(count - dst->alloc_tslots) > 0) {
-			u64 n_lost = count - dst->alloc_tslots;
-
-			if (unlikely((s64)(count - dst->requested_tslots) > 0)) {
-				release_dst(q, dst);
-				FASTPASS_WARN("got an alloc report for dst %d larger than requested (%llu > %llu), will reset\n",
-						dst_id, count, dst->requested_tslots);
-				q->stat.alloc_report_larger_than_requested++;
-				/* This corrupts the status; will force a reset */
-				spin_lock(&q->conn_lock);
-				fpproto_force_reset(&q->conn);
-				spin_unlock(&q->conn_lock);
-				handle_reset((void *)q); /* manually call callback since fpproto won't call it */
-				return;
-			}
-
-			fp_debug("controller allocated %llu our allocated %llu, will increase demand by %llu\n",
-					count, dst->alloc_tslots, n_lost);
-
-			dst->alloc_tslots += n_lost;
-			flow_inc_used(q, dst, n_lost);
-			flow_inc_demand(q, dst_id, dst, n_lost);
-
-			atomic_add(n_lost, &q->alloc_tslots);
-			q->stat.timeslots_assumed_lost += n_lost;
-		}
-
-		release_dst(q, dst);
-	}
-}
-
-static void handle_ack(void *param, struct fpproto_pktdesc *pd)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	int i;
-	u64 new_acked;
-	u64 delta;
-
-	for (i = 0; i < pd->n_areq; i++) {
-		u32 dst_id = pd->areq[i].src_dst_key;
-		/* this node made pd, so no need to check bounds */
-		struct fp_dst *dst = get_dst(q, dst_id);
-
-		new_acked = pd->areq[i].tslots;
-		if (dst->acked_tslots < new_acked) {
-			FASTPASS_BUG_ON(new_acked > dst->demand_tslots);
-			delta = new_acked - dst->acked_tslots;
-			q->acked_tslots += delta;
-			dst->acked_tslots = new_acked;
-			fp_debug("acked request of %llu additional slots, flow 0x%04X, total %llu slots\n",
-					delta, dst_id, new_acked);
-
-			/* the demand-limiting window might be in effect, re-enqueue flow */
-			if (unlikely(dst->requested_tslots != dst->demand_tslots))
-				unreq_dsts_enqueue_if_not_queued(q, dst_id, dst);
-		}
-
-		release_dst(q, dst);
-	}
-}
-
-static void handle_neg_ack(void *param, struct fpproto_pktdesc *pd)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	int i;
-	u64 req_tslots;
-
-	for (i = 0; i < pd->n_areq; i++) {
-		u32 dst_id = pd->areq[i].src_dst_key;
-		/* this node made pd, so no need to check bounds */
-		struct fp_dst *dst = get_dst(q, dst_id);
-
-		req_tslots = pd->areq[i].tslots;
-		/* don't need to resend if got ack >= req_tslots */
-		if (req_tslots <= dst->acked_tslots) {
-			fp_debug("nack for request of %llu for flow 0x%04X, but already acked %llu\n",
-							req_tslots, dst_id, dst->acked_tslots);
-			goto release;
-		}
-
-		/* add to retransmit queue */
-		unreq_dsts_enqueue_if_not_queued(q, dst_id, dst);
-
-		fp_debug("nack for request of %llu for flow 0x%04X (%llu acked), added to retransmit queue\n",
-						req_tslots, dst_id, dst->acked_tslots);
-release:
-		release_dst(q, dst);
-	}
-}
+static struct fpep_ops fastpass_ep_ops = {
+	.admit				= &fastpass_admit,
+	.trigger_request	= &trigger_tx_voidp,
+	.force_reset		= &fastpass_force_reset,
+};
 
 /**
- * Send a request packet to the controller
+ * Build a request packet to the controller, and queue it on the control
+ *    socket. The packet goes out on the next fpproto_flush_tx.
  */
-static void send_request(struct fp_sched_data *q)
+static void send_request(struct fp_sched_data *q, u64 now_monotonic)
 {
-	u64 now_monotonic = fp_monotonic_time_ns();
-
 	struct fp_kernel_pktdesc *kern_pd;
-	struct fpproto_pktdesc *pd;
-	u64 new_requested;
-	int q_alloc_tslots;
 
-	fp_debug("start: unreq_flows=%u, unreq_tslots=%llu, now_mono=%llu, scheduled=%llu, diff=%lld, next_seq=%08llX\n",
-			n_unreq_dsts(q), atomic_read(&q->demand_tslots) - q->requested_tslots, now_monotonic,
+	fp_debug("start: now_mono=%llu, scheduled=%llu, diff=%lld\n", now_monotonic,
 			pacer_next_event(&q->request_pacer),
-			(s64 )now_monotonic - (s64 )pacer_next_event(&q->request_pacer),
-			q->conn.next_seqno);
-	FASTPASS_BUG_ON(!q->ctrl_sock);
+			(s64 )now_monotonic - (s64 )pacer_next_event(&q->request_pacer));
+	FASTPASS_BUG_ON(!q->mux);
 
 	/* allocate packet descriptor */
 	kern_pd = fpproto_pktdesc_alloc();
 	if (!kern_pd)
 		goto alloc_err;
-	pd = &kern_pd->pktdesc;
 
-	pd->n_areq = 0;
-
-	spin_lock_irq(&q->conn_lock);
-	if (unlikely(q->is_destroyed == true))
-		goto out_conn_destroyed;
 	/* nack the tail of the outwnd if it has not been nacked or acked */
-	fpproto_prepare_to_send(&q->conn);
-	spin_unlock_irq(&q->conn_lock);
-
-	while (pd->n_areq < FASTPASS_PKT_MAX_AREQ) {
-		/* get entry */
-		u32 dst_id;
-		struct fp_dst *dst = unreq_dsts_dequeue_and_get(q, &dst_id);
-		if (dst == NULL)
-			break;
+	fpmux_prepare_to_send(q->mux);
 
-		new_requested = min_t(u64, dst->demand_tslots,
-				dst->acked_tslots + FASTPASS_REQUEST_WINDOW_SIZE - 1);
-		if(new_requested <= dst->acked_tslots) {
-			q->stat.queued_flow_already_acked++;
-			fp_debug("flow 0x%04X was in queue, but already fully acked\n",
-					dst_id);
-			release_dst(q, dst);
-			continue;
-		}
-
-		q->requested_tslots += (new_requested - dst->requested_tslots);
-		dst->requested_tslots = new_requested;
-		release_dst(q, dst);
-
-		pd->areq[pd->n_areq].src_dst_key = dst_id;
-		pd->areq[pd->n_areq].tslots = new_requested;
+	fpep_fill_request(&q->ep, &kern_pd->pktdesc, now_monotonic);
 
-		pd->n_areq++;
-	}
-
-	if(pd->n_areq == 0) {
-		q->stat.request_with_empty_flowqueue++;
-		fp_debug("was called with no flows pending (could be due to bad packets?)\n");
-	}
-	fp_debug("end: unreq_flows=%u, unreq_tslots=%llu\n",
-			n_unreq_dsts(q), atomic_read(&q->demand_tslots) - q->requested_tslots);
-
-	spin_lock_irq(&q->conn_lock);
-	if (unlikely(q->is_destroyed == true))
+	/* commit on the shared connection, and queue with the rest of the batch */
+	if (unlikely(!fpmux_commit_request(q->mux, q->mux_slot, kern_pd,
+			now_monotonic)))
 		goto out_conn_destroyed;
-	fpproto_commit_packet(&q->conn, pd, now_monotonic);
-	spin_unlock_irq(&q->conn_lock);
-
-	/* let fpproto send the pktdesc */
-	fpproto_send_pktdesc(q->ctrl_sock->sk, kern_pd);
 
 	/* set timer for next request, if a request would be required */
-	/* demand_tslots only increases and is larger than alloc_tslots, so read it
-	 *   second to be on safe side */
-	q_alloc_tslots = atomic_read(&q->alloc_tslots);
-	if (q_alloc_tslots != atomic_read(&q->demand_tslots))
+	if (fpep_has_pending_demand(&q->ep))
 		/* have more requests to send */
 		trigger_tx(q);
 
@@ -696,16 +246,14 @@ static void send_request(struct fp_sched_data *q)
 
 out_conn_destroyed:
 	free_kernel_pktdesc_no_refcount(kern_pd);
-	spin_unlock_irq(&q->conn_lock);
 	return;
 
 alloc_err:
-	q->stat.req_alloc_errors++;
+	FP_STAT_INC(&q->ep, req_alloc_errors);
 	fp_debug("request allocation failed\n");
 	trigger_tx(q); /* try again */
 }
 
-
 static enum hrtimer_restart maintenance_timer_func(struct hrtimer *timer)
 {
 	struct fp_sched_data *q =
@@ -714,7 +262,7 @@ static enum hrtimer_restart maintenance_timer_func(struct hrtimer *timer)
 	/* schedule tasklet to write request */
 	tasklet_schedule(&q->maintenance_tasklet);
 
-	hrtimer_forward_now(timer, ns_to_ktime(update_timer_ns));
+	hrtimer_forward_now(timer, ns_to_ktime(q->update_timer_ns));
 	return HRTIMER_RESTART;
 }
 
@@ -723,6 +271,7 @@ static void maintenance_tasklet_func(unsigned long int param)
 	struct fp_sched_data *q = (struct fp_sched_data *)param;
 	u64 now_monotonic = fp_monotonic_time_ns();
 	bool should_send = false;
+	u32 n_requests = 0;
 //	u64 now_real;
 
 
@@ -743,119 +292,32 @@ static void maintenance_tasklet_func(unsigned long int param)
 	}
 	spin_unlock_irq(&q->pacer_lock);
 
-	if (should_send)
-		send_request(q);
-}
-
-static void retrans_tasklet_func(unsigned long int param)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)param;
-	u64 now_monotonic = fp_monotonic_time_ns();
-
-	spin_lock_irq(&q->conn_lock);
-	if (likely(q->is_destroyed == false))
-		fpproto_handle_timeout(&q->conn, now_monotonic);
-	spin_unlock_irq(&q->conn_lock);
-}
+	/* while the bucket has credit, send more requests in the same batch */
+	while (should_send) {
+		send_request(q, now_monotonic);
+		if (++n_requests >= tx_batch_quota || fpep_n_unreq_dsts(&q->ep) == 0)
+			break;
 
-static enum hrtimer_restart retrans_timer_func(struct hrtimer *timer)
-{
-	struct fp_sched_data *q =
-			container_of(timer, struct fp_sched_data, retrans_timer);
-	tasklet_schedule(&q->retrans_tasklet);
-	return HRTIMER_NORESTART;
-}
+		spin_lock_irq(&q->pacer_lock);
+		should_send = pacer_take_burst(&q->request_pacer, now_monotonic);
+		spin_unlock_irq(&q->pacer_lock);
+	}
 
-void ctrl_rcv_handler(void *priv, u8 *pkt, u32 len, __be32 saddr, __be32 daddr)
-{
-	struct fp_sched_data *q = (struct fp_sched_data *)priv;
-	bool ret = false;
-	u64 in_seq;
-
-	spin_lock_irq(&q->conn_lock);
-	if (likely(q->is_destroyed == false))
-		ret = fpproto_handle_rx_packet(&q->conn, pkt, len, saddr, daddr, &in_seq);
-	spin_unlock_irq(&q->conn_lock);
-	if (!ret)
-		return;
-
-	ret = fpproto_perform_rx_callbacks(&q->conn, pkt, len);
-	if (!ret)
-		return;
-
-	spin_lock_irq(&q->conn_lock);
-	if (likely(q->is_destroyed == false))
-		fpproto_successful_rx(&q->conn, in_seq);
-	spin_unlock_irq(&q->conn_lock);
+	/* requests left over by the quota go out on the next timer tick */
+	if (n_requests != 0)
+		fpmux_flush_tx(q->mux);
 }
 
+/* the protocol calls into the control loop, with &q->ep as its param */
 struct fpproto_ops fastpass_sch_proto_ops = {
-	.handle_reset	= &handle_reset,
-	.handle_alloc	= &handle_alloc,
-	.handle_ack		= &handle_ack,
-	.handle_neg_ack	= &handle_neg_ack,
-	.handle_areq	= &handle_areq,
-	.trigger_request= &trigger_tx_voidp,
-	.set_timer		= &set_retrans_timer,
-	.cancel_timer	= &cancel_retrans_timer,
+	.handle_reset	= &fpep_handle_reset,
+	.handle_alloc	= &fpep_handle_alloc,
+	.handle_ack		= &fpep_handle_ack,
+	.handle_neg_ack	= &fpep_handle_neg_ack,
+	.handle_areq	= &fpep_handle_areq,
+	.trigger_request= &fpep_trigger_request,
 };
 
-/* reconnects the control socket to the controller */
-static int connect_ctrl_socket(struct fp_sched_data *q, struct net *qdisc_net)
-{
-	struct sock *sk;
-	int opt;
-	int rc;
-	struct sockaddr_in sock_addr = {
-			.sin_family = AF_INET,
-			.sin_port = FASTPASS_DEFAULT_PORT_NETORDER
-	};
-
-	FASTPASS_BUG_ON(q->ctrl_sock != NULL);
-
-	/* create socket */
-	rc = __sock_create(qdisc_net, AF_INET, SOCK_DGRAM, IPPROTO_FASTPASS,
-			&q->ctrl_sock, 1);
-	if (rc != 0) {
-		FASTPASS_WARN("Error %d creating socket\n", rc);
-		q->ctrl_sock = NULL;
-		return rc;
-	}
-
-	/* we need a larger-than-default wmem, so we don't run out. ask for a lot,
-	 * the call will not fail if it's too much */
-	opt = FASTPASS_CTRL_SOCK_WMEM;
-	rc = kernel_setsockopt(q->ctrl_sock, SOL_SOCKET, SO_SNDBUF, (char *)&opt,
-			sizeof(opt));
-	if (rc != 0)
-		FASTPASS_WARN("Could not set socket wmem size\n");
-
-	sk = q->ctrl_sock->sk;
-
-	FASTPASS_BUG_ON(sk->sk_priority != TC_PRIO_CONTROL);
-	FASTPASS_BUG_ON(sk->sk_allocation != GFP_ATOMIC);
-
-	/* give socket a reference to this qdisc for watchdog */
-	((struct fastpass_sock *)sk)->rcv_handler = ctrl_rcv_handler;
-	fpproto_set_priv(sk, (void *)q);
-
-	/* connect */
-	sock_addr.sin_addr.s_addr = ctrl_addr_netorder;
-	rc = kernel_connect(q->ctrl_sock, (struct sockaddr *)&sock_addr,
-			sizeof(sock_addr), 0);
-	if (rc != 0)
-		goto err_release;
-
-	return 0;
-
-err_release:
-	FASTPASS_WARN("Error %d trying to connect to addr 0x%X (in netorder)\n",
-			rc, ctrl_addr_netorder);
-	sock_release(q->ctrl_sock);
-	q->ctrl_sock = NULL;
-	return rc;
-}
-
 /*
  * Prints flow status
  */
@@ -869,47 +331,76 @@ static void dump_flow_info(struct seq_file *seq, struct fp_sched_data *q,
 	printk(KERN_DEBUG "fastpass flows (only_active=%d):\n", only_active);
 
 	for (dst_id = 0; dst_id < MAX_NODES; dst_id++) {
-		dst = &q->dsts[dst_id];
+		dst = &q->ep.dsts[dst_id];
 
-		if (dst->demand_tslots == dst->used_tslots && only_active)
+		if (atomic64_read(&dst->demand_tslots)
+				== atomic64_read(&dst->used_tslots) && only_active)
 			continue;
 
 		num_printed++;
 		printk(KERN_DEBUG "flow 0x%04X demand %llu requested %llu acked %llu alloc %llu used %llu state %d\n",
-				dst_id, dst->demand_tslots, dst->requested_tslots,
-				dst->acked_tslots, dst->alloc_tslots, dst->used_tslots,
+				dst_id, (u64)atomic64_read(&dst->demand_tslots),
+				(u64)atomic64_read(&dst->requested_tslots),
+				(u64)atomic64_read(&dst->acked_tslots),
+				(u64)atomic64_read(&dst->alloc_tslots),
+				(u64)atomic64_read(&dst->used_tslots),
 				dst->state);
 	}
 
 	printk(KERN_DEBUG "fastpass printed %u flows\n", num_printed);
 }
 
+/* sums the per-CPU statistics */
+static void fastpass_stat_sum(struct fp_sched_data *q, struct fp_sched_stat *sum)
+{
+	int cpu;
+
+	fp_stat_sum(sum, q->ep.stat, sizeof(*sum));
+
+	/* maxima do not add up */
+	sum->request_delay_max_ns = 0;
+	for_each_possible_cpu(cpu)
+		sum->request_delay_max_ns = max_t(u64, sum->request_delay_max_ns,
+				per_cpu_ptr(q->ep.stat, cpu)->request_delay_max_ns);
+}
+
 static int fastpass_proc_show(struct seq_file *seq, void *v)
 {
 	struct fp_sched_data *q = (struct fp_sched_data *)seq->private;
 	u64 now_real = fp_get_time_ns();
-	struct fp_sched_stat *scs = &q->stat;
+	struct fp_sched_stat stat_sum;
+	struct fp_sched_stat *scs = &stat_sum;
+	s64 demand;
+
+	fastpass_stat_sum(q, scs);
 
 	/* time */
 	seq_printf(seq, "  fp_sched_data *p = %p ", q);
 	seq_printf(seq, ", timestamp 0x%llX ", now_real);
-	seq_printf(seq, ", timeslot 0x%llX", q->current_timeslot);
+	seq_printf(seq, ", timeslot 0x%llX", q->ep.current_timeslot);
 
 	/* configuration */
-	seq_printf(seq, "\n  req_cost %u ", req_cost);
-	seq_printf(seq, ", req_bucketlen %u", req_bucketlen);
-	seq_printf(seq, ", req_min_gap %u", req_min_gap);
+	seq_printf(seq, "\n  req_cost %u ", q->req_cost);
+	seq_printf(seq, ", req_bucketlen %u", q->req_bucketlen);
+	seq_printf(seq, ", req_min_gap %u", q->req_min_gap);
+	seq_printf(seq, ", req_max_age_ns %u", q->ep.req_max_age_ns);
+	seq_printf(seq, ", tx_batch_quota %u", tx_batch_quota);
 	seq_printf(seq, ", ctrl_addr %s", ctrl_addr);
+	seq_printf(seq, ", share_ctrl_conn %u", share_ctrl_conn);
 	seq_printf(seq, ", reset_window_us %u", reset_window_us);
-	seq_printf(seq, ", retrans_timeout_ns %u", retrans_timeout_ns);
-	seq_printf(seq, ", update_timer_ns %u", update_timer_ns);
+	seq_printf(seq, ", retrans_timeout_ns %u", q->retrans_timeout_ns);
+	seq_printf(seq, ", update_timer_ns %u", q->update_timer_ns);
 	seq_printf(seq, ", proc_dump_dst %u", proc_dump_dst);
-	seq_printf(seq, ", miss_threshold %u", miss_threshold);
-	seq_printf(seq, ", max_preload %u", max_preload);
+	seq_printf(seq, ", miss_threshold %u", q->ep.miss_threshold);
+	seq_printf(seq, ", max_preload %u", q->ep.max_preload);
+	if (q->ep.adaptive_bounds)
+		seq_printf(seq, "\n  adaptive bounds: miss_threshold %u, max_preload %u (%llu adjustments)",
+				q->ep.alloc_bounds.miss_threshold, q->ep.alloc_bounds.max_preload,
+				q->ep.alloc_bounds.n_adjustments);
 
 	/* timeslot statistics */
 	seq_printf(seq, "\n  horizon mask 0x%016llx",
-			wnd_get_mask(&q->alloc_wnd, q->current_timeslot+63));
+			wnd_get_mask(&q->ep.alloc_wnd, q->ep.current_timeslot+63));
 	seq_printf(seq, " (%llu %llu %llu %llu behind, %llu fast)", scs->late_enqueue4,
 			scs->late_enqueue3, scs->late_enqueue2, scs->late_enqueue1,
 			scs->early_enqueue);
@@ -919,21 +410,31 @@ static int fastpass_proc_show(struct seq_file *seq, void *v)
 
 	/* total since reset */
 	seq_printf(seq, "\n  since reset: ");
-	seq_printf(seq, " demand %u", atomic_read(&q->demand_tslots));
-	seq_printf(seq, ", requested %llu", q->requested_tslots);
-	seq_printf(seq, " (%u yet unrequested)", (u32)(atomic_read(&q->demand_tslots) - q->requested_tslots));
-	seq_printf(seq, ", acked %llu", q->acked_tslots);
-	seq_printf(seq, ", allocs %u", atomic_read(&q->alloc_tslots));
-	seq_printf(seq, ", used %llu", q->used_tslots);
+	demand = percpu_counter_sum(&q->ep.demand_tslots);
+	seq_printf(seq, " demand %lld", demand);
+	seq_printf(seq, ", requested %llu", q->ep.requested_tslots);
+	seq_printf(seq, " (%lld yet unrequested)", demand - (s64)q->ep.requested_tslots);
+	seq_printf(seq, ", acked %llu", q->ep.acked_tslots);
+	seq_printf(seq, ", allocs %llu", (u64)atomic64_read(&q->ep.alloc_tslots));
+	seq_printf(seq, ", used %llu", q->ep.used_tslots);
 	seq_printf(seq, ", admitted %llu", scs->admitted_timeslots);
 
 	seq_printf(seq, "\n  %llu requests w/no a-req", scs->request_with_empty_flowqueue);
+	seq_printf(seq, "\n  %u dsts waiting to be requested", fpep_n_unreq_dsts(&q->ep));
+	if (scs->requested_dsts)
+		seq_printf(seq, ", request staleness avg %llu ns max %llu ns over %llu a-reqs (%llu served by age)",
+				div64_u64(scs->request_delay_total_ns, scs->requested_dsts),
+				scs->request_delay_max_ns, scs->requested_dsts,
+				scs->aged_requests);
+	if (scs->urgent_requests)
+		seq_printf(seq, "\n  %llu urgent a-reqs", scs->urgent_requests);
 
 	/* protocol state */
-	fpproto_update_internal_stats(&q->conn);
-	fpproto_print_stats(&q->conn.stat, seq);
+	fpmux_print_stats(q->mux, seq);
+	fpproto_update_internal_stats(&q->mux->conn);
+	fpproto_print_stats(&q->mux->conn.stat, seq);
 	/* socket state */
-	fpproto_print_socket_stats(q->ctrl_sock->sk, seq);
+	fpproto_print_socket_stats(q->mux->ctrl_sock->sk, seq);
 
 	/* error statistics */
 	seq_printf(seq, "\n errors:");
@@ -943,8 +444,8 @@ static int fastpass_proc_show(struct seq_file *seq, void *v)
 		seq_printf(seq, "\n  %llu alloc report larger than requested_timeslots (causes a reset)",
 				scs->alloc_report_larger_than_requested);
 
-	fpproto_print_errors(&q->conn.stat, seq);
-	fpproto_print_socket_errors(q->ctrl_sock->sk, seq);
+	fpproto_print_errors(&q->mux->conn.stat, seq);
+	fpproto_print_socket_errors(q->mux->ctrl_sock->sk, seq);
 
 	/* warnings */
 	seq_printf(seq, "\n warnings:");
@@ -958,7 +459,7 @@ static int fastpass_proc_show(struct seq_file *seq, void *v)
 		seq_printf(seq, "\n  %llu premature allocations (something wrong with time-sync?)\n",
 				scs->alloc_premature);
 
-	fpproto_print_warnings(&q->conn.stat, seq);
+	fpproto_print_warnings(&q->mux->conn.stat, seq);
 
 	/* flow info */
 	if (proc_dump_dst)
@@ -999,62 +500,70 @@ static int fpq_new_qdisc(void *priv, struct net *qdisc_net, u32 tslot_mul,
 		u32 tslot_shift)
 {
 	struct fp_sched_data *q = (struct fp_sched_data *)priv;
+	struct fp_sched_stat __percpu *stat;
 
 	u64 now_real = fp_get_time_ns();
 	u64 now_monotonic = fp_monotonic_time_ns();
 	int err;
-	int i;
-
-	q->unreq_dsts_head = q->unreq_dsts_tail = 0;
-	q->tslot_mul		= tslot_mul;
-	q->tslot_shift		= tslot_shift;
-
-	/* calculate timeslot from beginning of Epoch */
-	q->current_timeslot = (now_real * q->tslot_mul) >> q->tslot_shift;
-	wnd_reset(&q->alloc_wnd, q->current_timeslot);
 
-	spin_lock_init(&q->unreq_flows_lock);
+	stat = alloc_percpu(struct fp_sched_stat);
+	err = -ENOMEM;
+	if (stat == NULL)
+		goto out;
 
-	for (i = 0; i < MAX_NODES; i++)
-		spin_lock_init(&q->dsts[i].lock);
+	err = fpep_init(&q->ep, &fastpass_ep_ops, (void *)q, stat, tslot_mul,
+			tslot_shift, now_real);
+	if (err != 0)
+		goto out_free_stat;
+
+	q->req_cost				= req_cost;
+	q->req_bucketlen		= req_bucketlen;
+	q->req_min_gap			= req_min_gap;
+	q->retrans_timeout_ns	= retrans_timeout_ns;
+	q->update_timer_ns		= update_timer_ns;
+	q->ep.miss_threshold	= miss_threshold;
+	q->ep.max_preload		= max_preload;
+	q->ep.req_max_age_ns	= req_max_age_ns;
+	q->ep.adaptive_bounds	= adaptive_bounds;
+	alloc_bounds_init(&q->ep.alloc_bounds, q->ep.miss_threshold,
+			q->ep.max_preload, adaptive_waste_shift);
 
 	spin_lock_init(&q->pacer_lock);
-	pacer_init_full(&q->request_pacer, now_monotonic, req_cost,
-			req_bucketlen, req_min_gap);
+	pacer_init_full(&q->request_pacer, now_monotonic, q->req_cost,
+			q->req_bucketlen, q->req_min_gap);
 
-	err = fastpass_proc_init(q);
-	if (err != 0)
-		goto out;
+	tasklet_init(&q->maintenance_tasklet, &maintenance_tasklet_func, (unsigned long int)q);
+	hrtimer_init(&q->maintenance_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	q->maintenance_timer.function = maintenance_timer_func;
 
-	/* initialize the fastpass protocol (before initializing socket) */
-	q->is_destroyed = false;
-	spin_lock_init(&q->conn_lock);
-	fpproto_init_conn(&q->conn, &fastpass_sch_proto_ops, (void *)q,
-			(u64)reset_window_us * NSEC_PER_USEC, retrans_timeout_ns);
+	/* join the control connection; protocol callbacks may arrive from here */
+	q->mux = fpmux_get(qdisc_net, ctrl_addr_netorder, share_ctrl_conn,
+			&fastpass_sch_proto_ops, (void *)&q->ep,
+			(u64)reset_window_us * NSEC_PER_USEC, q->retrans_timeout_ns,
+			&q->mux_slot);
+	if (IS_ERR(q->mux)) {
+		err = PTR_ERR(q->mux);
+		q->mux = NULL;
+		goto out_destroy_ep;
+	}
 
-	/* connect socket */
-	q->ctrl_sock		= NULL;
-	err = connect_ctrl_socket(q, qdisc_net);
+	err = fastpass_proc_init(q);
 	if (err != 0)
-		goto out_destroy_conn;
+		goto out_put_mux;
 
-	tasklet_init(&q->maintenance_tasklet, &maintenance_tasklet_func, (unsigned long int)q);
-
-	hrtimer_init(&q->maintenance_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
-	q->maintenance_timer.function = maintenance_timer_func;
-	hrtimer_start(&q->maintenance_timer, ns_to_ktime(update_timer_ns),
+	hrtimer_start(&q->maintenance_timer, ns_to_ktime(q->update_timer_ns),
 			HRTIMER_MODE_REL);
 
-	/* initialize retransmission timer */
-	tasklet_init(&q->retrans_tasklet, &retrans_tasklet_func, (unsigned long int)q);
-	hrtimer_init(&q->retrans_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
-	q->retrans_timer.function = retrans_timer_func;
-
 	return err;
 
-out_destroy_conn:
-	fpproto_destroy_conn(&q->conn);
-	fastpass_proc_cleanup(q);
+out_put_mux:
+	fpmux_put(q->mux, q->mux_slot);
+	q->mux = NULL;
+out_destroy_ep:
+	fpep_destroy(&q->ep);
+out_free_stat:
+	free_percpu(stat);
+	q->ep.stat = NULL;
 out:
 	pr_info("%s: error creating new qdisc err=%d\n", __func__, err);
 	return err;
@@ -1072,38 +581,135 @@ static void fpq_stop_qdisc(void *priv) {
 	hrtimer_cancel(&q->maintenance_timer);
 	tasklet_kill(&q->maintenance_tasklet);
 
-	/* send_request is not going to run anymore, can close the control socket */
-	fp_debug("closing control socket\n");
-	sock_release(q->ctrl_sock);
-	q->ctrl_sock = NULL;
-
-	spin_lock(&q->conn_lock);
-	q->is_destroyed = true;
-	spin_unlock(&q->conn_lock);
-
 	/**
-	 * At this point:
-	 * 1. control packets stop arriving (ctrl_rcv_handler)
-	 * 2. no new control packets are committed (send_request)
-	 * 3. no retransmission timers are handled (retrans_tasklet_func)
-	 * So none of the fpproto_conn API is called after this point.
+	 * send_request is not going to run anymore, can leave the control
+	 *    connection. Once fpmux_put returns, no protocol callbacks run on q;
+	 *    the last qdisc to leave closes the connection.
 	 */
-
-	fpproto_destroy_conn(&q->conn);
-
-	/* no race with other code setting the timer, so we can cancel retrans_timer */
-	hrtimer_cancel(&q->retrans_timer);
-	tasklet_kill(&q->retrans_tasklet);
+	fpmux_put(q->mux, q->mux_slot);
+	q->mux = NULL;
 
 	fastpass_proc_cleanup(q);
+	fpep_destroy(&q->ep);
+	free_percpu(q->ep.stat);
+	q->ep.stat = NULL;
 }
 
 static void fpq_add_timeslot(void *priv, u64 dst_id)
 {
 	struct fp_sched_data *q = (struct fp_sched_data *)priv;
-	struct fp_dst *dst = get_dst(q, dst_id);
-	flow_inc_demand(q, dst_id, dst, 1);
-	release_dst(q, dst);
+	fpep_inc_demand(&q->ep, dst_id, 1);
+}
+
+static void fpq_mark_urgent(void *priv, u64 dst_id)
+{
+	struct fp_sched_data *q = (struct fp_sched_data *)priv;
+	fpep_mark_urgent(&q->ep, dst_id);
+}
+
+/**
+ * Changes the tunables of a running qdisc. Either all given values are
+ *    applied, or none are.
+ */
+static int fpq_change(void *priv, struct nlattr **tb)
+{
+	struct fp_sched_data *q = (struct fp_sched_data *)priv;
+	u32 nreq_cost = q->req_cost;
+	u32 nreq_bucketlen = q->req_bucketlen;
+	u32 nreq_min_gap = q->req_min_gap;
+	u32 nretrans_timeout_ns = q->retrans_timeout_ns;
+
+	if (tb[TCA_FASTPASS_REQUEST_COST])
+		nreq_cost = nla_get_u32(tb[TCA_FASTPASS_REQUEST_COST]);
+	if (tb[TCA_FASTPASS_REQUEST_BUCKET])
+		nreq_bucketlen = nla_get_u32(tb[TCA_FASTPASS_REQUEST_BUCKET]);
+	if (tb[TCA_FASTPASS_REQUEST_GAP])
+		nreq_min_gap = nla_get_u32(tb[TCA_FASTPASS_REQUEST_GAP]);
+	if (tb[TCA_FASTPASS_RETRANS_TIMEOUT_NS])
+		nretrans_timeout_ns = nla_get_u32(tb[TCA_FASTPASS_RETRANS_TIMEOUT_NS]);
+
+	if (nreq_cost == 0 || nreq_bucketlen < nreq_cost || nretrans_timeout_ns == 0)
+		return -EINVAL;
+	if (tb[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS]
+			&& nla_get_u32(tb[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS]) == 0)
+		return -EINVAL;
+	/* allocations are kept track of in a window of FASTPASS_WND_LEN */
+	if (tb[TCA_FASTPASS_MISS_THRESHOLD]
+			&& nla_get_u32(tb[TCA_FASTPASS_MISS_THRESHOLD]) >= FASTPASS_WND_LEN)
+		return -EINVAL;
+	if (tb[TCA_FASTPASS_MAX_PRELOAD]
+			&& nla_get_u32(tb[TCA_FASTPASS_MAX_PRELOAD]) >= FASTPASS_WND_LEN)
+		return -EINVAL;
+
+	spin_lock_irq(&q->pacer_lock);
+	q->req_cost = nreq_cost;
+	q->req_bucketlen = nreq_bucketlen;
+	q->req_min_gap = nreq_min_gap;
+	pacer_update_params(&q->request_pacer, nreq_cost, nreq_bucketlen,
+			nreq_min_gap);
+	spin_unlock_irq(&q->pacer_lock);
+
+	/* the timeout belongs to the connection, shared with other qdiscs */
+	q->retrans_timeout_ns = nretrans_timeout_ns;
+	if (q->mux)
+		fpmux_set_send_timeout(q->mux, nretrans_timeout_ns);
+
+	/* read by the timer and ALLOC handling without locks; takes effect on
+	 * their next run */
+	if (tb[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS])
+		q->update_timer_ns = nla_get_u32(tb[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS]);
+	if (tb[TCA_FASTPASS_MISS_THRESHOLD])
+		q->ep.miss_threshold = nla_get_u32(tb[TCA_FASTPASS_MISS_THRESHOLD]);
+	if (tb[TCA_FASTPASS_MAX_PRELOAD])
+		q->ep.max_preload = nla_get_u32(tb[TCA_FASTPASS_MAX_PRELOAD]);
+	alloc_bounds_set_max(&q->ep.alloc_bounds, q->ep.miss_threshold,
+			q->ep.max_preload);
+
+	return 0;
+}
+
+/* dumps the tunables to a netlink skb */
+static int fpq_dump(void *priv, struct sk_buff *skb)
+{
+	struct fp_sched_data *q = (struct fp_sched_data *)priv;
+
+	if (nla_put_u32(skb, TCA_FASTPASS_REQUEST_COST, q->req_cost) ||
+	    nla_put_u32(skb, TCA_FASTPASS_REQUEST_BUCKET, q->req_bucketlen) ||
+	    nla_put_u32(skb, TCA_FASTPASS_REQUEST_GAP, q->req_min_gap) ||
+	    nla_put_u32(skb, TCA_FASTPASS_RETRANS_TIMEOUT_NS, q->retrans_timeout_ns) ||
+	    nla_put_u32(skb, TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS, q->update_timer_ns) ||
+	    nla_put_u32(skb, TCA_FASTPASS_MISS_THRESHOLD, q->ep.miss_threshold) ||
+	    nla_put_u32(skb, TCA_FASTPASS_MAX_PRELOAD, q->ep.max_preload))
+		return -1;
+	return 0;
+}
+
+/* fills in the fastpass part of the binary statistics */
+static void fpq_dump_stats(void *priv, struct tc_fastpass_qd_stats *st)
+{
+	struct fp_sched_data *q = (struct fp_sched_data *)priv;
+
+	BUILD_BUG_ON(sizeof(struct fp_sched_stat) > TC_FASTPASS_SCHED_STAT_MAX_BYTES);
+	BUILD_BUG_ON(sizeof(struct fp_socket_stat) > TC_FASTPASS_SOCKET_STAT_MAX_BYTES);
+	BUILD_BUG_ON(sizeof(struct fp_proto_stat) > TC_FASTPASS_PROTO_STAT_MAX_BYTES);
+
+	if (q->ep.stat == NULL)
+		return; /* qdisc is being destroyed */
+
+	st->n_unreq_flows		= fpep_n_unreq_dsts(&q->ep);
+	st->horizon_mask		= wnd_get_mask(&q->ep.alloc_wnd, q->ep.current_timeslot+63);
+	st->time_next_request	= pacer_next_event(&q->request_pacer);
+	st->demand_tslots		= percpu_counter_sum(&q->ep.demand_tslots);
+	st->requested_tslots	= q->ep.requested_tslots;
+	st->alloc_tslots		= atomic64_read(&q->ep.alloc_tslots);
+	st->acked_tslots		= q->ep.acked_tslots;
+	st->used_tslots			= q->ep.used_tslots;
+
+	fastpass_stat_sum(q, (struct fp_sched_stat *)st->sched_stats);
+	fpproto_dump_socket_stats(q->mux->ctrl_sock->sk,
+			(struct fp_socket_stat *)st->socket_stats);
+	fpproto_update_internal_stats(&q->mux->conn);
+	fpproto_dump_stats(&q->mux->conn, (struct fp_proto_stat *)st->proto_stats);
 }
 
 static struct tsq_ops fastpass_tsq_ops __read_mostly = {
@@ -1113,6 +719,10 @@ static struct tsq_ops fastpass_tsq_ops __read_mostly = {
 	.new_qdisc = fpq_new_qdisc,
 	.stop_qdisc = fpq_stop_qdisc,
 	.add_timeslot = fpq_add_timeslot,
+	.mark_urgent = fpq_mark_urgent,
+	.change = fpq_change,
+	.dump = fpq_dump,
+	.dump_stats = fpq_dump_stats,
 };
 
 static int __init fastpass_module_init(void)
@@ -22,6 +22,7 @@
 #include <linux/rbtree.h>
 #include <linux/hash.h>
 #include <linux/prefetch.h>
+#include <linux/random.h>
 #include <linux/time.h>
 #include <linux/bitops.h>
 #include <linux/version.h>
@@ -38,6 +39,7 @@
 #endif
 
 #include "sch_timeslot.h"
+#include "../protocol/fastpass_stats.h"
 #include "fastpass_proto.h"
 #include "../protocol/platform.h"
 #include "../protocol/pacer.h"
@@ -48,20 +50,36 @@
 
 #define PROC_FILENAME_MAX_SIZE				64
 
+#define TSQ_FLOWS_PER_DST_LOG				4
+#define TSQ_FLOWS_PER_DST					(1 << TSQ_FLOWS_PER_DST_LOG)
+
 struct timeslot_skb_q {
 	struct list_head list;
 	struct sk_buff	*head;		/* list of skbs for this flow : first skb */
 	struct sk_buff *tail;		/* last skb in the list */
 };
 
+/*
+ * A flow within a destination: packets whose 5-tuple hashes to one bucket.
+ *   skbs.list links the flow into its destination's active list.
+ */
+struct tsq_flow {
+	struct timeslot_skb_q skbs;
+	s64		deficit;			/* DRR: time the flow may send in this round */
+	u32		backlog;			/* bytes queued */
+	u32		size_hint;			/* SRPT: skb->mark when the flow became active */
+};
+
 /*
  * Per flow structure, dynamically allocated
  */
 struct tsq_dst {
 	u64		src_dst_key;		/* flow identifier */
 	struct rb_node	fp_node; 	/* anchor in fp_root[] trees */
-	struct list_head skb_qs;	/* a queue for each timeslot */
-	s64		credit;				/* time remaining in the last scheduled timeslot */
+	struct list_head active;	/* flows with queued packets, in service order */
+	u32		requested_tslots;	/* timeslots requested and not yet admitted */
+	s64		credit;				/* time remaining in the last requested timeslot */
+	struct tsq_flow flows[TSQ_FLOWS_PER_DST];
 };
 
 struct rcu_hash_tbl_cleanup {
@@ -70,36 +88,6 @@ struct rcu_hash_tbl_cleanup {
 };
 
 /* Scheduler statistics */
-struct tsq_sched_stat {
-	u64		gc_flows;
-	/* enqueue-related */
-	u64		ctrl_pkts;
-	u64 	ntp_pkts;
-	u64 	ptp_pkts;
-	u64		arp_pkts;
-	u64		igmp_pkts;
-	u64		ssh_pkts;
-	u64		data_pkts;
-	u64		classify_errors;
-	u64		above_plimit;
-	u64		allocation_errors;
-	u64		pkt_too_big;
-	/* dequeue-related */
-	u64		added_tslots;
-	u64		used_timeslots;
-	u64		missed_timeslots;
-	u64		flow_not_found_update;
-	u64		early_enqueue;
-	u64		late_enqueue1;
-	u64		late_enqueue2;
-	u64		late_enqueue3;
-	u64		late_enqueue4;
-	u64		backlog_too_high;
-	u64		clock_move_causes_reset;
-	/* alloc-related */
-	u64		unwanted_alloc;
-	u64		dst_not_found_admit_now;
-};
 
 /**
  *
@@ -112,6 +100,8 @@ struct tsq_sched_data {
 
 	struct psched_ratecfg data_rate;	/* rate of payload packets */
 	u32		tslot_len_approx;					/* duration of a timeslot, in nanosecs */
+	u32		flow_sched;					/* TC_FASTPASS_FLOW_SCHED_* */
+	u32		flow_hash_seed;				/* perturbs the flow hash */
 
 	struct tsq_ops *timeslot_ops;
 
@@ -148,12 +138,11 @@ struct tsq_sched_data {
 	u32		inactive_flows;  /* protected by fpproto_maintenance_lock */
 
 	/* statistics */
-	struct tsq_sched_stat stat;
+	struct tsq_sched_stat __percpu *stat;
 };
 
 static struct proc_dir_entry *tsq_proc_entry;
 static struct kmem_cache *timeslot_dst_cachep __read_mostly;
-static struct kmem_cache *timeslot_skb_q_cachep __read_mostly;
 
 static int tsq_proc_init(struct tsq_sched_data *q, struct tsq_ops *ops);
 static void tsq_proc_cleanup(struct tsq_sched_data *q);
@@ -270,15 +259,14 @@ static struct tsq_dst *dst_lookup(struct tsq_sched_data *q, u64 src_dst_key,
 	/* allocate a new one */
 	dst = kmem_cache_zalloc(timeslot_dst_cachep, GFP_ATOMIC | __GFP_NOWARN);
 	if (unlikely(!dst)) {
-		q->stat.allocation_errors++;
+		FP_STAT_INC(q, allocation_errors);
 		return NULL;
 	}
 	dst->src_dst_key = src_dst_key;
 
 	rb_link_node(&dst->fp_node, parent, p);
 	rb_insert_color(&dst->fp_node, root);
-	INIT_LIST_HEAD(&dst->skb_qs);
-	dst->credit = 0;
+	INIT_LIST_HEAD(&dst->active);
 
 	q->flows++;
 	q->inactive_flows++;
@@ -308,14 +296,14 @@ static struct timeslot_skb_q *classify_hi_prio(struct sk_buff *skb, struct tsq_s
 	// ARP packets should not count as classify errors
 	switch (proto) {
 	case __constant_htons(ETH_P_ARP):
-		q->stat.arp_pkts++;
+		FP_STAT_INC(q, arp_pkts);
 		return &q->reg_prio;
 
 	case __constant_htons(ETH_P_1588):
 	case __constant_htons(ETH_P_ALL):
 		/* Special case the PTP broadcasts: MAC 01:1b:19:00:00:00 */
 		if (likely(get_mac(skb) == 0x011b19000000)) {
-			q->stat.ptp_pkts++;
+			FP_STAT_INC(q, ptp_pkts);
 			return &q->hi_prio;
 		}
 		goto cannot_classify;
@@ -337,17 +325,17 @@ ipv4_ipv6:
 	switch(keys.ip_proto) {
 	case IPPROTO_IGMP:
 		/* IGMP is used for PTP multicast membership, allow all of them */
-		q->stat.igmp_pkts++;
+		FP_STAT_INC(q, igmp_pkts);
 		return &q->reg_prio;
 	case IPPROTO_UDP:
 		/* NTP packets */
 		if (unlikely(keys.port16[1] == __constant_htons(123))) {
-			q->stat.ntp_pkts++;
+			FP_STAT_INC(q, ntp_pkts);
 			return &q->hi_prio;
 		}
 		/* PTP packets are port 319,320 */
 		if (((ntohs(keys.port16[1]) - 1) & ~1) == 318) {
-			q->stat.ptp_pkts++;
+			FP_STAT_INC(q, ptp_pkts);
 			return &q->hi_prio;
 		}
 		break;
@@ -355,12 +343,12 @@ ipv4_ipv6:
 		/* SSH packets, so we can access server */
 		if (unlikely(keys.port16[0] == __constant_htons(22)
 				|| keys.port16[1] == __constant_htons(22))) {
-			q->stat.ssh_pkts++;
+			FP_STAT_INC(q, ssh_pkts);
 			return &q->reg_prio;
 		}
 		break;
 	case IPPROTO_FASTPASS:
-		q->stat.ctrl_pkts++;
+		FP_STAT_INC(q, ctrl_pkts);
 		return &q->hi_prio;
 	default:
 		break;
@@ -369,7 +357,7 @@ ipv4_ipv6:
 	return NULL;
 
 cannot_classify:
-	q->stat.classify_errors++;
+	FP_STAT_INC(q, classify_errors);
 	fp_debug("cannot classify packet with protocol %u:\n", skb->protocol);
 	print_hex_dump(KERN_DEBUG, "cannot classify: ", DUMP_PREFIX_OFFSET,
 			16, 1, skb->data, min_t(size_t, skb->len, 64), false);
@@ -394,10 +382,27 @@ static struct tsq_dst *classify_data(struct sk_buff *skb, struct tsq_sched_data
 	else
 		src_dst_key = fp_map_mac_to_id(src_dst_key);
 
-	q->stat.data_pkts++;
+	FP_STAT_INC(q, data_pkts);
 	return dst_lookup(q, src_dst_key, true);
 }
 
+/* returns the index of the packet's flow within its destination */
+static u32 classify_flow(struct sk_buff *skb, struct tsq_sched_data *q)
+{
+	struct flow_keys keys;
+	u32 hash;
+
+	/* FIFO keeps all packets of a destination in one flow */
+	if (q->flow_sched == TC_FASTPASS_FLOW_SCHED_FIFO
+			|| !skb_flow_dissect(skb, &keys))
+		return 0;
+
+	hash = jhash_3words((__force u32)keys.dst,
+			(__force u32)keys.src ^ keys.ip_proto,
+			(__force u32)keys.ports, q->flow_hash_seed);
+	return hash >> (32 - TSQ_FLOWS_PER_DST_LOG);
+}
+
 /* enqueue packet to the qdisc (part of the qdisc api) */
 static int tsq_enqueue(struct sk_buff *skb, struct Qdisc *sch)
 {
@@ -423,7 +428,7 @@ static int tsq_enqueue(struct sk_buff *skb, struct Qdisc *sch)
 
 	/* enforce qdisc packet limit on data packets */
 	if (unlikely(sch->q.qlen >= sch->limit)) {
-		q->stat.above_plimit++;
+		FP_STAT_INC(q, above_plimit);
 		return qdisc_drop(skb, sch);
 	}
 
@@ -441,12 +446,15 @@ static void enqueue_single_skb(struct Qdisc *sch, struct sk_buff *skb)
 {
 	struct tsq_sched_data *q = qdisc_priv(sch);
 	struct tsq_dst *dst;
-	struct timeslot_skb_q *timeslot_q;
+	struct tsq_flow *flow;
 	s64 cost;
 	bool created_new_timeslot = false;
+	bool urgent = (skb->priority == TC_PRIO_CONTROL);
 	u64 src_dst_key;
+	u32 flow_idx;
 
 	cost = (s64) psched_l2t_ns(&q->data_rate, qdisc_pkt_len(skb));
+	flow_idx = classify_flow(skb, q);
 
 	spin_lock(&q->hash_tbl_lock);
 	dst = classify_data(skb, q);
@@ -457,38 +465,41 @@ static void enqueue_single_skb(struct Qdisc *sch, struct sk_buff *skb)
 
 	/* check if need to request a new slot */
 	if (cost > dst->credit) {
-		timeslot_q = kmem_cache_alloc(timeslot_skb_q_cachep, GFP_ATOMIC | __GFP_NOWARN);
-		if (unlikely(timeslot_q == NULL)) {
-			FASTPASS_WARN("allocation of timeslot_skb_q failed, enqueueing to prequeue");
-			goto enqueue_to_prequeue;
-		}
-
-		if (unlikely(list_empty(&dst->skb_qs)))
+		if (unlikely(dst->requested_tslots == 0))
 			q->inactive_flows--;
 
-		skb_q_init(timeslot_q);
-		list_add_tail(&timeslot_q->list, &dst->skb_qs);
+		dst->requested_tslots++;
 		dst->credit = q->tslot_len_approx;
-		q->stat.added_tslots++;
+		FP_STAT_INC(q, added_tslots);
 		created_new_timeslot = true;
-		src_dst_key = dst->src_dst_key;
 
 		/* packets bigger than a timeslot cause warning and still get timeslot */
 		if (unlikely(cost > q->tslot_len_approx)) {
 			FASTPASS_WARN("got packet that is larger than a timeslot len=%d\n",
 				qdisc_pkt_len(skb));
-			q->stat.pkt_too_big++;
+			FP_STAT_INC(q, pkt_too_big);
 		}
-	} else {
-		timeslot_q = list_entry(dst->skb_qs.prev, struct timeslot_skb_q, list);
 	}
-
 	dst->credit -= cost;
-	skb_q_enqueue(timeslot_q, skb);
+	src_dst_key = dst->src_dst_key;
+
+	/* packets wait in their flow; admission decides which timeslot they use */
+	flow = &dst->flows[flow_idx];
+	if (skb_q_empty(&flow->skbs)) {
+		list_add_tail(&flow->skbs.list, &dst->active);
+		flow->deficit = q->tslot_len_approx;
+		flow->size_hint = skb->mark;
+	}
+	skb_q_enqueue(&flow->skbs, skb);
+	flow->backlog += qdisc_pkt_len(skb);
 	spin_unlock(&q->hash_tbl_lock);
 
 	if (created_new_timeslot)
 		q->timeslot_ops->add_timeslot(sched_data_to_priv(q), src_dst_key);
+	/* also when the packet fits in the dst's last timeslot, which may not be
+	 * allocated yet */
+	if (unlikely(urgent) && q->timeslot_ops->mark_urgent != NULL)
+		q->timeslot_ops->mark_urgent(sched_data_to_priv(q), src_dst_key);
 
 	fp_debug("enqueued data packet of len %d to flow 0x%llX\n",
 			qdisc_pkt_len(skb), dst->src_dst_key);
@@ -562,7 +573,7 @@ begin:
 	if (unlikely(f == NULL)) {
 		fp_debug("could not find flow for allocation at timeslot %llu key 0x%llX node 0x%X will force reset\n",
 				next_nonempty, next_key, fp_alloc_node(next_key));
-		q->stat.flow_not_found_update++;
+		FP_STAT_INC(q, flow_not_found_update);
 		/* This corrupts the status; will force a reset */
 		fpproto_force_reset(fpproto_conn(q));
 		handle_reset((void *)sch); /* manually call callback since fpproto won't call it */
@@ -584,7 +595,7 @@ begin:
 
 	/* is alloc too far in the past? */
 	if (unlikely(time_before64(next_nonempty, q->current_timeslot - q->miss_threshold))) {
-		q->stat.missed_timeslots++;
+		FP_STAT_INC(q, missed_timeslots);
 		fp_debug("missed timeslot %llu by %llu timeslots, rescheduling\n",
 				next_nonempty, q->current_timeslot - next_nonempty);
 		goto reschedule_timeslot_and_continue;
@@ -596,7 +607,7 @@ begin:
 			goto done; /* maybe later queue will drain */
 
 		/* timeslots are late and backlog is full. will reschedule */
-		q->stat.backlog_too_high++;
+		FP_STAT_INC(q, backlog_too_high);
 		fp_debug("backlog too high processing timeslot %llu at %llu, will try again at next update\n",
 				next_nonempty, q->current_timeslot);
 		goto done;
@@ -616,22 +627,22 @@ begin:
 
 	/* statistics */
 	moved_timeslots++;
-	q->stat.used_timeslots++;
+	FP_STAT_INC(q, used_timeslots);
 	if (next_nonempty > q->current_timeslot) {
-		q->stat.early_enqueue++;
+		FP_STAT_INC(q, early_enqueue);
 	} else {
 		u64 tslot = q->current_timeslot;
 		u64 thresh = q->miss_threshold;
 		if (unlikely(next_nonempty < tslot - (thresh >> 1))) {
 			if (unlikely(next_nonempty < tslot - 3*(thresh >> 2)))
-				q->stat.late_enqueue4++;
+				FP_STAT_INC(q, late_enqueue4);
 			else
-				q->stat.late_enqueue3++;
+				FP_STAT_INC(q, late_enqueue3);
 		} else {
 			if (unlikely(next_nonempty < tslot - (thresh >> 2)))
-				q->stat.late_enqueue2++;
+				FP_STAT_INC(q, late_enqueue2);
 			else
-				q->stat.late_enqueue1++;
+				FP_STAT_INC(q, late_enqueue1);
 
 		}
 	}
@@ -651,7 +662,7 @@ done:
 		if (-1*(s64)tslot_advance > CLOCK_MOVE_RESET_THRESHOLD_TSLOTS) {
 			FASTPASS_WARN("current timeslot moved back a lot: %lld timeslots. new current %llu. will reset\n",
 					(s64)tslot_advance, q->current_timeslot);
-			q->stat.clock_move_causes_reset++;
+			FP_STAT_INC(q, clock_move_causes_reset);
 			/* This corrupts the status; will force a reset */
 			fpproto_force_reset(fpproto_conn(q));
 			handle_reset((void *)sch); /* manually call callback since fpproto won't call it */
@@ -675,52 +686,173 @@ done:
 }
 #endif
 
-void tsq_admit_now(void *priv, u64 src_dst_key)
+/* the flow of @dst that should send next, by q->flow_sched. @dst must have
+ *    an active flow. */
+static struct tsq_flow *dst_next_flow(struct tsq_sched_data *q,
+		struct tsq_dst *dst)
 {
-	struct tsq_sched_data *q = priv_to_sched_data(priv);
-	struct tsq_dst *dst;
-	struct timeslot_skb_q *timeslot_q;
+	struct tsq_flow *flow, *best;
+
+	switch (q->flow_sched) {
+	case TC_FASTPASS_FLOW_SCHED_DRR:
+		/* the quantum is a timeslot, so every round gives each flow a turn */
+		while (1) {
+			flow = list_first_entry(&dst->active, struct tsq_flow, skbs.list);
+			if (flow->deficit > 0)
+				return flow;
+			flow->deficit += q->tslot_len_approx;
+			list_move_tail(&flow->skbs.list, &dst->active);
+		}
 
-	/* find the mentioned destination */
-	spin_lock(&q->hash_tbl_lock);
-	dst = dst_lookup(q, src_dst_key, false);
-	if (unlikely(dst == NULL)) {
-		FASTPASS_WARN("couldn't find flow 0x%llX from alloc.\n", src_dst_key);
-		q->stat.dst_not_found_admit_now++;
-		return;
+	case TC_FASTPASS_FLOW_SCHED_SRPT:
+		/* flows without a size hint are ranked by what they have queued */
+		best = NULL;
+		list_for_each_entry(flow, &dst->active, skbs.list) {
+			if (best == NULL
+					|| (flow->size_hint ? : flow->backlog)
+						< (best->size_hint ? : best->backlog))
+				best = flow;
+		}
+		return best;
+
+	default:
+		return list_first_entry(&dst->active, struct tsq_flow, skbs.list);
 	}
+}
 
-	/* are there timeslots waiting? */
-	if (unlikely(list_empty(&dst->skb_qs))) {
-		/* got an alloc without a timeslot */
-		q->stat.unwanted_alloc++;
-		fp_debug("got an allocation over demand, flow 0x%04llX\n",
-				dst->src_dst_key);
-		return;
+/**
+ * Moves a timeslot's worth of packets of @dst to @admitted, each from the
+ *    flow dst_next_flow() picks. The last requested timeslot takes all the
+ *    remaining packets, since reordering flows can pack timeslots less tightly
+ *    than the enqueue-time estimate. Assumes q->hash_tbl_lock is held.
+ */
+static void dst_fill_tslot(struct tsq_sched_data *q, struct tsq_dst *dst,
+		struct timeslot_skb_q *admitted)
+{
+	bool last = (--dst->requested_tslots == 0);
+	s64 budget = q->tslot_len_approx;
+	bool overfull = false;
+	struct tsq_flow *flow;
+	struct sk_buff *skb;
+	s64 cost;
+
+	while (!list_empty(&dst->active)) {
+		flow = dst_next_flow(q, dst);
+		skb = flow->skbs.head;
+		cost = (s64) psched_l2t_ns(&q->data_rate, qdisc_pkt_len(skb));
+
+		/* a timeslot always takes at least one packet */
+		if (cost > budget && budget < q->tslot_len_approx) {
+			if (!last)
+				break;
+			overfull = true;
+		}
+
+		skb_q_dequeue(&flow->skbs);
+		skb_q_enqueue(admitted, skb);
+		budget -= cost;
+		flow->deficit -= cost;
+		flow->backlog -= qdisc_pkt_len(skb);
+		if (skb_q_empty(&flow->skbs))
+			list_del(&flow->skbs.list);
 	}
 
-	/* get a timeslot's worth skb_q */
-	timeslot_q = list_first_entry(&dst->skb_qs, struct timeslot_skb_q, list);
-	list_del(dst->skb_qs.next);
+	if (unlikely(overfull))
+		FP_STAT_INC(q, overfull_tslots);
+}
+
+/**
+ * Moves up to @n_tslots timeslots' worth of packets of @dst to @admitted.
+ *    Assumes q->hash_tbl_lock is held. Returns the number of timeslots moved.
+ */
+static u32 dst_take_tslots(struct tsq_sched_data *q, struct tsq_dst *dst,
+		u32 n_tslots, struct timeslot_skb_q *admitted)
+{
+	u32 n_admitted = min_t(u32, n_tslots, dst->requested_tslots);
+	u32 i;
+
+	for (i = 0; i < n_admitted; i++)
+		dst_fill_tslot(q, dst, admitted);
+
+	if (unlikely(n_admitted < n_tslots)) {
+		/* got allocs without a timeslot */
+		FP_STAT_ADD(q, unwanted_alloc, n_tslots - n_admitted);
+		fp_debug("got %u allocations over demand, flow 0x%04llX\n",
+				n_tslots - n_admitted, dst->src_dst_key);
+	}
+
+	if (unlikely(n_admitted == 0))
+		return 0;
+
 	/* if we dequeued the last skb, make sure it has no remaining credit */
-	if (unlikely(list_empty(&dst->skb_qs))) {
+	if (dst->requested_tslots == 0) {
 		dst->credit = 0;
 		q->inactive_flows++;
 	}
-	q->stat.used_timeslots++;
+	FP_STAT_ADD(q, used_timeslots, n_admitted);
+	return n_admitted;
+}
+
+u32 tsq_admit_now_batch(void *priv, u64 *src_dst_keys, u32 *n_tslots, int n)
+{
+	struct tsq_sched_data *q = priv_to_sched_data(priv);
+	struct tsq_dst *dsts[TSQ_ADMIT_BATCH_MAX];
+	struct timeslot_skb_q batch = {.head = NULL, .tail = NULL};
+	u32 n_admitted = 0;
+	int i;
+
+	if (unlikely(n > TSQ_ADMIT_BATCH_MAX)) {
+		FASTPASS_WARN("admit batch of %d flows, max %d\n", n,
+				TSQ_ADMIT_BATCH_MAX);
+		n = TSQ_ADMIT_BATCH_MAX;
+	}
+
+	spin_lock(&q->hash_tbl_lock);
+
+	/* resolve all destinations first, so fetching their queues overlaps */
+	for (i = 0; i < n; i++) {
+		dsts[i] = NULL;
+		if (unlikely(n_tslots[i] == 0))
+			continue;
+		dsts[i] = dst_lookup(q, src_dst_keys[i], false);
+		if (unlikely(dsts[i] == NULL)) {
+			FASTPASS_WARN("couldn't find flow 0x%llX from alloc.\n",
+					src_dst_keys[i]);
+			FP_STAT_INC(q, dst_not_found_admit_now);
+			continue;
+		}
+		prefetchw(dsts[i]->active.next);
+	}
+
+	for (i = 0; i < n; i++)
+		if (likely(dsts[i] != NULL))
+			n_admitted += dst_take_tslots(q, dsts[i], n_tslots[i], &batch);
+
 	spin_unlock(&q->hash_tbl_lock);
 
-	/* put in prequeue */
+	if (unlikely(n_admitted == 0))
+		return 0;
+
+	/* put in prequeue, all timeslots at once */
 	spin_lock(&q->prequeue_lock);
-	skb_q_append(&q->prequeue, timeslot_q);
+	skb_q_append(&q->prequeue, &batch);
 	spin_unlock(&q->prequeue_lock);
 
 	/* unthrottle qdisc */
 	qdisc_unthrottled(q->qdisc);
 	__netif_schedule(qdisc_root(q->qdisc));
 
-	/* free the timeslot_q */
-	kmem_cache_free(timeslot_skb_q_cachep, timeslot_q);
+	return n_admitted;
+}
+
+u32 tsq_admit_now_n(void *priv, u64 src_dst_key, u32 n_tslots)
+{
+	return tsq_admit_now_batch(priv, &src_dst_key, &n_tslots, 1);
+}
+
+void tsq_admit_now(void *priv, u64 src_dst_key)
+{
+	tsq_admit_now_n(priv, src_dst_key, 1);
 }
 
 /* Extract packet from the queue (part of the qdisc API) */
@@ -772,8 +904,7 @@ static void tsq_tc_reset(struct Qdisc *sch)
 	struct sk_buff *skb;
 	struct rb_node *p;
 	struct tsq_dst *dst;
-	struct timeslot_skb_q *timeslot_q, *next_q;
-	unsigned int idx;
+	unsigned int idx, i;
 
 	while ((skb = skb_q_dequeue(&q->reg_prio)) != NULL)
 		kfree_skb(skb);
@@ -797,11 +928,9 @@ static void tsq_tc_reset(struct Qdisc *sch)
 			dst = container_of(p, struct tsq_dst, fp_node);
 			rb_erase(p, root);
 
-			list_for_each_entry_safe(timeslot_q, next_q, &dst->skb_qs, list) {
-				while ((skb = skb_q_dequeue(timeslot_q)) != NULL)
+			for (i = 0; i < TSQ_FLOWS_PER_DST; i++)
+				while ((skb = skb_q_dequeue(&dst->flows[i].skbs)) != NULL)
 					kfree_skb(skb);
-				kmem_cache_free(timeslot_skb_q_cachep, timeslot_q);
-			}
 
 			kmem_cache_free(timeslot_dst_cachep, dst);
 		}
@@ -917,13 +1046,13 @@ void tsq_garbage_collect(void *priv)
 			dst = container_of(cur, struct tsq_dst, fp_node);
 
 			/* can we garbage-collect this flow? */
-			if (list_empty(&dst->skb_qs)) {
+			if (dst->requested_tslots == 0) {
 				/* yes, let's gc */
 				/* erase from old tree */
 				rb_erase(cur, root);
 				fp_debug("gc flow 0x%04llX\n", dst->src_dst_key);
 				kmem_cache_free(timeslot_dst_cachep, dst);
-				q->stat.gc_flows++;
+				FP_STAT_INC(q, gc_flows);
 				continue;
 			}
 		}
@@ -943,14 +1072,46 @@ static const struct nla_policy tsq_policy[TCA_FASTPASS_MAX + 1] = {
 	[TCA_FASTPASS_DEV_BACKLOG_NS]	= { .type = NLA_U32 },
 	[TCA_FASTPASS_MAX_PRELOAD]		= { .type = NLA_U32 },
 	[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS]		= { .type = NLA_U32 },
+	[TCA_FASTPASS_REQUEST_COST]		= { .type = NLA_U32 },
+	[TCA_FASTPASS_REQUEST_BUCKET]	= { .type = NLA_U32 },
+	[TCA_FASTPASS_REQUEST_GAP]		= { .type = NLA_U32 },
+	[TCA_FASTPASS_RETRANS_TIMEOUT_NS]	= { .type = NLA_U32 },
+	[TCA_FASTPASS_FLOW_SCHED]		= { .type = NLA_U32 },
 };
 
+/* true if tb has options that are handled by the timeslot ops */
+static bool tsq_has_ops_options(struct nlattr **tb)
+{
+	return tb[TCA_FASTPASS_MISS_THRESHOLD] || tb[TCA_FASTPASS_MAX_PRELOAD]
+			|| tb[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS]
+			|| tb[TCA_FASTPASS_REQUEST_COST] || tb[TCA_FASTPASS_REQUEST_BUCKET]
+			|| tb[TCA_FASTPASS_REQUEST_GAP] || tb[TCA_FASTPASS_RETRANS_TIMEOUT_NS];
+}
+
+/* passes options to the timeslot ops, once they have created their qdisc */
+static int tsq_ops_change(struct tsq_sched_data *q, struct nlattr *opt)
+{
+	struct nlattr *tb[TCA_FASTPASS_MAX + 1];
+	int err;
+
+	err = nla_parse_nested(tb, TCA_FASTPASS_MAX, opt, tsq_policy);
+	if (err < 0)
+		return err;
+
+	if (!tsq_has_ops_options(tb))
+		return 0;
+	return q->timeslot_ops->change(sched_data_to_priv(q), tb);
+}
+
 /* change configuration (part of qdisc API) */
 static int tsq_tc_change(struct Qdisc *sch, struct nlattr *opt) {
 	struct tsq_sched_data *q = qdisc_priv(sch);
+	struct tsq_qdisc_entry *reg = container_of(sch->ops, struct tsq_qdisc_entry, qdisc_ops);
 	struct nlattr *tb[TCA_FASTPASS_MAX + 1];
 	int err = 0;
-	u32 fp_log;
+	u32 plimit = 0;
+	u32 fp_log = q->hash_tbl_log;
+	u32 flow_sched = q->flow_sched;
 	u32 tslot_mul = q->tslot_mul;
 	u32 tslot_shift = q->tslot_shift;
 	bool changed_tslot_len = false;
@@ -967,71 +1128,65 @@ static int tsq_tc_change(struct Qdisc *sch, struct nlattr *opt) {
 	if (err < 0)
 		return err;
 
-	sch_tree_lock(sch);
-
-	fp_log = q->hash_tbl_log;
-
+	/* validate all options before changing anything */
 	if (tb[TCA_FASTPASS_PLIMIT]) {
-		u32 nval = nla_get_u32(tb[TCA_FASTPASS_PLIMIT]);
-
-		if (nval > 0)
-			sch->limit = nval;
-		else
-			err = -EINVAL;
+		plimit = nla_get_u32(tb[TCA_FASTPASS_PLIMIT]);
+		if (plimit == 0)
+			return -EINVAL;
 	}
-
 	if (tb[TCA_FASTPASS_BUCKETS_LOG]) {
-		u32 nval = nla_get_u32(tb[TCA_FASTPASS_BUCKETS_LOG]);
-
-		if (nval >= 1 && nval <= ilog2(256*1024))
-			fp_log = nval;
-		else
-			err = -EINVAL;
+		fp_log = nla_get_u32(tb[TCA_FASTPASS_BUCKETS_LOG]);
+		if (fp_log < 1 || fp_log > ilog2(256*1024))
+			return -EINVAL;
 	}
 	if (tb[TCA_FASTPASS_DATA_RATE]) {
 		data_rate_spec.rate = nla_get_u32(tb[TCA_FASTPASS_DATA_RATE]);
 		if (data_rate_spec.rate == 0)
-			err = -EINVAL;
-		else
-			psched_ratecfg_precompute(&q->data_rate, &data_rate_spec, 0);
+			return -EINVAL;
 	}
 	if (tb[TCA_FASTPASS_TIMESLOT_NSEC]) {
 		FASTPASS_WARN("got deprecated timeslot length paramter\n");
-		err = -EINVAL;
+		return -EINVAL;
 	}
 	if (tb[TCA_FASTPASS_TIMESLOT_MUL]) {
 		tslot_mul = nla_get_u32(tb[TCA_FASTPASS_TIMESLOT_MUL]);
 		changed_tslot_len = true;
 		if (tslot_mul == 0)
-			err = -EINVAL;
+			return -EINVAL;
 	}
 	if (tb[TCA_FASTPASS_TIMESLOT_SHIFT]) {
 		tslot_shift = nla_get_u32(tb[TCA_FASTPASS_TIMESLOT_SHIFT]);
 		changed_tslot_len = true;
 	}
-
-	if (tb[TCA_FASTPASS_MISS_THRESHOLD]) {
-		FASTPASS_WARN("should use kernel module parameter for miss threshold rather than tc\n");
-		err = -EINVAL;
-	}
-
 	if (tb[TCA_FASTPASS_DEV_BACKLOG_NS]) {
 		FASTPASS_WARN("got deprecated max dev backlog paramter\n");
-		err = -EINVAL;
+		return -EINVAL;
 	}
-
-	if (tb[TCA_FASTPASS_MAX_PRELOAD]) {
-		FASTPASS_WARN("should use kernel module parameter for max preload rather than tc\n");
-		err = -EINVAL;
+	if (tb[TCA_FASTPASS_FLOW_SCHED]) {
+		flow_sched = nla_get_u32(tb[TCA_FASTPASS_FLOW_SCHED]);
+		if (flow_sched >= __TC_FASTPASS_FLOW_SCHED_MAX)
+			return -EINVAL;
 	}
-
-	if (tb[TCA_FASTPASS_UPDATE_TIMESLOT_TIMER_NS]) {
-		FASTPASS_WARN("got deprecated update timeslot timer paramter\n");
-		err = -EINVAL;
+	if (tsq_has_ops_options(tb) && reg->ops->change == NULL) {
+		FASTPASS_WARN("got options that %s does not support\n", reg->ops->id);
+		return -EINVAL;
 	}
 
+	sch_tree_lock(sch);
+
+	if (plimit)
+		sch->limit = plimit;
+	if (tb[TCA_FASTPASS_DATA_RATE])
+		psched_ratecfg_precompute(&q->data_rate, &data_rate_spec, 0);
+	/* queued packets stay in their flows, and are still served */
+	q->flow_sched = flow_sched;
+
 	err = tsq_tc_resize(q, fp_log);
 
+	/* on init, the options are passed once the ops have created the qdisc */
+	if (!err && q->timeslot_ops != NULL && tsq_has_ops_options(tb))
+		err = q->timeslot_ops->change(sched_data_to_priv(q), tb);
+
 	if (!err && changed_tslot_len) {
 		u64 now_real = fp_get_time_ns();
 		q->tslot_mul		= tslot_mul;
@@ -1069,6 +1224,7 @@ static void tsq_tc_destroy(struct Qdisc *sch)
 
 	fp_debug("resetting qdisc\n");
 	tsq_tc_reset(sch);
+	free_percpu(q->stat);
 	fp_debug("done resetting qdisc. setting up rcu\n");
 	q->hash_tbl_cleanup->hash_tbl = q->dst_hash_tbl;
 	call_rcu(&q->hash_tbl_cleanup->rcu_head, tsq_rcu_free);
@@ -1095,6 +1251,8 @@ static int tsq_tc_init(struct Qdisc *sch, struct nlattr *opt)
 	q->hash_tbl_log		= ilog2(1024);
 	q->tslot_mul		= 419;
 	q->tslot_shift		= 19;
+	q->flow_sched		= TC_FASTPASS_FLOW_SCHED_FIFO;
+	get_random_bytes(&q->flow_hash_seed, sizeof(q->flow_hash_seed));
 
 
 	psched_ratecfg_precompute(&q->data_rate, &data_rate_spec, 0);
@@ -1119,14 +1277,19 @@ static int tsq_tc_init(struct Qdisc *sch, struct nlattr *opt)
 
 	tasklet_init(&q->enqueue_tasklet, &enqueue_tasklet_func, (unsigned long int)sch);
 
+	q->stat = alloc_percpu(struct tsq_sched_stat);
+	err = -ENOMEM;
+	if (q->stat == NULL)
+		goto out;
+
 	err = -ENOSYS;
 	if (tsq_proc_init(q, reg->ops) != 0)
-		goto out;
+		goto out_free_stat;
 
 	q->hash_tbl_cleanup = kmalloc(sizeof(struct rcu_hash_tbl_cleanup), GFP_ATOMIC);
 	err = -ENOMEM;
 	if (q->hash_tbl_cleanup == NULL)
-		goto out;
+		goto out_free_stat;
 
 	if (opt) {
 		err = tsq_tc_change(sch, opt);
@@ -1142,12 +1305,23 @@ static int tsq_tc_init(struct Qdisc *sch, struct nlattr *opt)
 	if (err)
 		goto out_free_hash_tbl;
 
+	if (opt && reg->ops->change) {
+		err = tsq_ops_change(q, opt);
+		if (err)
+			goto out_stop_qdisc;
+	}
+
 	return err;
 
+out_stop_qdisc:
+	reg->ops->stop_qdisc(sched_data_to_priv(q));
+
 out_free_hash_tbl:
 	kfree(q->dst_hash_tbl);
 out_free_cleanup:
 	kfree(q->hash_tbl_cleanup);
+out_free_stat:
+	free_percpu(q->stat);
 out:
 	return err;
 }
@@ -1167,7 +1341,12 @@ static int tsq_tc_dump(struct Qdisc *sch, struct sk_buff *skb)
 	    nla_put_u32(skb, TCA_FASTPASS_DATA_RATE, (u32)q->data_rate.rate_bytes_ps) ||
 	    nla_put_u32(skb, TCA_FASTPASS_TIMESLOT_NSEC, q->tslot_len_approx) ||
 	    nla_put_u32(skb, TCA_FASTPASS_TIMESLOT_MUL, q->tslot_mul) ||
-	    nla_put_u32(skb, TCA_FASTPASS_TIMESLOT_SHIFT, q->tslot_shift))
+	    nla_put_u32(skb, TCA_FASTPASS_TIMESLOT_SHIFT, q->tslot_shift) ||
+	    nla_put_u32(skb, TCA_FASTPASS_FLOW_SCHED, q->flow_sched))
+		goto nla_put_failure;
+
+	if (q->timeslot_ops->dump
+			&& q->timeslot_ops->dump(sched_data_to_priv(q), skb) != 0)
 		goto nla_put_failure;
 
 	nla_nest_end(skb, opts);
@@ -1177,11 +1356,43 @@ nla_put_failure:
 	return -1;
 }
 
+/* dumps statistics in binary form to a netlink skb (part of qdisc API) */
+static int tsq_tc_dump_stats(struct Qdisc *sch, struct gnet_dump *d)
+{
+	struct tsq_sched_data *q = qdisc_priv(sch);
+	struct tc_fastpass_qd_stats *st;
+	int err;
+
+	BUILD_BUG_ON(sizeof(struct tsq_sched_stat) > TC_FASTPASS_TSQ_STAT_MAX_BYTES);
+
+	/* called under the qdisc lock, and too large for the stack */
+	st = kzalloc(sizeof(*st), GFP_ATOMIC);
+	if (st == NULL)
+		return -1;
+
+	st->version				= FASTPASS_STATS_VERSION;
+	st->flows				= q->flows;
+	st->inactive_flows		= q->inactive_flows;
+	st->stat_timestamp		= fp_get_time_ns();
+	st->current_timeslot	= q->current_timeslot;
+	fp_stat_sum(st->tsq_stats, q->stat, sizeof(struct tsq_sched_stat));
+
+	if (q->timeslot_ops->dump_stats)
+		q->timeslot_ops->dump_stats(sched_data_to_priv(q), st);
+
+	err = gnet_stats_copy_app(d, st, sizeof(*st));
+	kfree(st);
+	return err;
+}
+
 static int tsq_proc_show(struct seq_file *seq, void *v)
 {
 	struct tsq_sched_data *q = (struct tsq_sched_data *)seq->private;
 	u64 now_real = fp_get_time_ns();
-	struct tsq_sched_stat *scs = &q->stat;
+	struct tsq_sched_stat stat_sum;
+	struct tsq_sched_stat *scs = &stat_sum;
+
+	fp_stat_sum(scs, q->stat, sizeof(*scs));
 
 	/* time */
 	seq_printf(seq, "  tsq_sched_data *p = %p ", q);
@@ -1194,6 +1405,7 @@ static int tsq_proc_show(struct seq_file *seq, void *v)
 	seq_printf(seq, ", timeslot_ns %u", q->tslot_len_approx);
 	seq_printf(seq, ", timeslot_mul %u", q->tslot_mul);
 	seq_printf(seq, ", timeslot_shift %u", q->tslot_shift);
+	seq_printf(seq, ", flow_sched %u", q->flow_sched);
 
 	/* flow statistics */
 	seq_printf(seq, "\n  %u flows (%u inactive)",
@@ -1240,6 +1452,9 @@ static int tsq_proc_show(struct seq_file *seq, void *v)
 	if (scs->unwanted_alloc)
 		seq_printf(seq, "\n  %llu timeslots allocated beyond the demand of the flow (could happen due to reset / controller timeouts)",
 				scs->unwanted_alloc);
+	if (scs->overfull_tslots)
+		seq_printf(seq, "\n  %llu timeslots carried extra packets after flows were reordered",
+				scs->overfull_tslots);
 	if (scs->clock_move_causes_reset)
 		seq_printf(seq, "\n  %llu large clock moves caused resets",
 				scs->clock_move_causes_reset);
@@ -1300,6 +1515,7 @@ struct tsq_qdisc_entry *tsq_register_qdisc(struct tsq_ops *ops)
 	qops->destroy	=	tsq_tc_destroy,
 	qops->change		=	tsq_tc_change,
 	qops->dump		=	tsq_tc_dump,
+	qops->dump_stats	=	tsq_tc_dump_stats,
 	qops->owner		=	THIS_MODULE,
 
 	err = register_qdisc(qops);
@@ -1338,16 +1554,8 @@ int tsq_init(void)
 	if (!timeslot_dst_cachep)
 		goto out_remove_proc;
 
-	timeslot_skb_q_cachep = kmem_cache_create("timeslot_skb_q_cache",
-					   sizeof(struct timeslot_skb_q),
-					   0, 0, NULL);
-	if (!timeslot_skb_q_cachep)
-		goto out_destroy_dst_cache;
-
 	return 0;
 
-out_destroy_dst_cache:
-	kmem_cache_destroy(timeslot_dst_cachep);
 out_remove_proc:
 	proc_remove(tsq_proc_entry);
 out:
@@ -1359,7 +1567,6 @@ void tsq_exit(void)
 {
 	pr_info("%s: begin\n", __func__);
 	proc_remove(tsq_proc_entry);
-	kmem_cache_destroy(timeslot_skb_q_cachep);
 	kmem_cache_destroy(timeslot_dst_cachep);
 	pr_info("%s: end\n", __func__);
 }
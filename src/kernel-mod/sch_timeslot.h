@@ -4,6 +4,8 @@
 #include <linux/types.h>
 #include <net/sch_generic.h>
 
+struct tc_fastpass_qd_stats;
+
 struct tsq_ops {
 	char			id[IFNAMSIZ];
 	int			priv_size;
@@ -11,6 +13,15 @@ struct tsq_ops {
 								u32 tslot_shift);
 	void		(* stop_qdisc)(void *priv);
 	void		(* add_timeslot)(void *priv, u64 src_dst_key);
+	/* optional: the demand added so far to src_dst_key carries a control
+	 * packet, and should be allocated ahead of other demand */
+	void		(* mark_urgent)(void *priv, u64 src_dst_key);
+	/* optional: applies TCA_FASTPASS_* options not handled by the tsq */
+	int			(* change)(void *priv, struct nlattr **tb);
+	/* optional: dumps the options set by change */
+	int			(* dump)(void *priv, struct sk_buff *skb);
+	/* optional: fills in the ops' part of the binary statistics */
+	void		(* dump_stats)(void *priv, struct tc_fastpass_qd_stats *st);
 };
 
 struct tsq_qdisc_entry {
@@ -48,6 +59,22 @@ void tsq_schedule(void *priv, u64 src_dst_key, u64 timeslot);
  */
 void tsq_admit_now(void *priv, u64 src_dst_key);
 
+/**
+ * Admits up to @n_tslots timeslots from a flow right now, taking the flow's
+ *    locks once. Returns the number of timeslots admitted.
+ */
+u32 tsq_admit_now_n(void *priv, u64 src_dst_key, u32 n_tslots);
+
+/* the most flows tsq_admit_now_batch takes at once */
+#define TSQ_ADMIT_BATCH_MAX		16
+
+/**
+ * Admits up to @n_tslots[i] timeslots from each flow @src_dst_keys[i] right
+ *    now, looking up all flows under one lock and moving their packets to the
+ *    prequeue together. Returns the total number of timeslots admitted.
+ */
+u32 tsq_admit_now_batch(void *priv, u64 *src_dst_keys, u32 *n_tslots, int n);
+
 /**
  * Garbage-collects information for empty queues.
  */
@@ -0,0 +1,142 @@
+/*
+ * alloc_bounds.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+/**
+ * Adapts the window in which ALLOCs are accepted to the observed arrival
+ *    offsets of ALLOCs.
+ *
+ * An ALLOC's offset is its timeslot minus the current timeslot when it
+ *    arrives: ALLOCs with negative offsets arrive late, those with positive
+ *    offsets early. ALLOCs outside [-miss_threshold, max_preload] are dropped
+ *    and waste the timeslot the arbiter allocated; the ones inside are sent
+ *    off their timeslot by up to the window's width. The controller picks the
+ *    narrowest window that wastes at most 1/2^waste_shift of the ALLOCs on
+ *    each side, and never goes beyond the configured bounds.
+ */
+#ifndef FP_ALLOC_BOUNDS_H_
+#define FP_ALLOC_BOUNDS_H_
+
+#include "platform/generic.h"
+#include "window.h"
+
+/* larger offsets are counted together with this one */
+#define ALLOC_BOUNDS_MAX_OFFSET		(FASTPASS_WND_LEN - 1)
+/* number of ALLOCs between adjustments */
+#define ALLOC_BOUNDS_EPOCH			1024
+/* the adaptive bounds are never tighter than this */
+#define ALLOC_BOUNDS_MIN			2
+
+struct fp_alloc_bounds {
+	u32		miss_threshold;		/* current bounds */
+	u32		max_preload;
+	u32		max_miss_threshold;	/* configured bounds */
+	u32		max_max_preload;
+	u32		waste_shift;
+	u32		n_samples;			/* since last adjustment */
+	u64		n_adjustments;
+	u32		late_hist[ALLOC_BOUNDS_MAX_OFFSET + 1];	/* by lateness */
+	u32		early_hist[ALLOC_BOUNDS_MAX_OFFSET + 1];	/* by earliness */
+};
+
+static inline u32 alloc_bounds_clamp(u32 val, u32 max)
+{
+	if (max < ALLOC_BOUNDS_MIN)
+		return max;
+	if (val < ALLOC_BOUNDS_MIN)
+		return ALLOC_BOUNDS_MIN;
+	return (val > max) ? max : val;
+}
+
+/**
+ * Sets the configured bounds, which cap the adaptive ones
+ */
+static inline void alloc_bounds_set_max(struct fp_alloc_bounds *ab,
+		u32 max_miss_threshold, u32 max_max_preload)
+{
+	ab->max_miss_threshold = max_miss_threshold;
+	ab->max_max_preload = max_max_preload;
+	ab->miss_threshold = alloc_bounds_clamp(ab->miss_threshold, max_miss_threshold);
+	ab->max_preload = alloc_bounds_clamp(ab->max_preload, max_max_preload);
+}
+
+/**
+ * Initializes the controller. It starts out with the configured bounds.
+ */
+static inline void alloc_bounds_init(struct fp_alloc_bounds *ab,
+		u32 max_miss_threshold, u32 max_max_preload, u32 waste_shift)
+{
+	memset(ab, 0, sizeof(*ab));
+	ab->waste_shift = waste_shift;
+	ab->miss_threshold = max_miss_threshold;
+	ab->max_preload = max_max_preload;
+	alloc_bounds_set_max(ab, max_miss_threshold, max_max_preload);
+}
+
+/**
+ * Returns the smallest bound such that at most @allowed of the samples in
+ *    @hist lie beyond it.
+ */
+static inline u32 alloc_bounds_tail(u32 *hist, u64 allowed)
+{
+	u64 beyond = 0;
+	s32 bound;
+
+	for (bound = ALLOC_BOUNDS_MAX_OFFSET; bound > 0; bound--) {
+		if (beyond + hist[bound] > allowed)
+			return bound;
+		beyond += hist[bound];
+	}
+	return 0;
+}
+
+/**
+ * Recomputes the bounds from the observed offsets, then decays the
+ *    observations so the bounds follow changes in arbiter load.
+ */
+static inline void alloc_bounds_adjust(struct fp_alloc_bounds *ab)
+{
+	u64 total = 0;
+	u64 allowed;
+	u32 i;
+
+	for (i = 0; i <= ALLOC_BOUNDS_MAX_OFFSET; i++)
+		total += ab->late_hist[i] + ab->early_hist[i];
+	allowed = total >> ab->waste_shift;
+
+	ab->miss_threshold = alloc_bounds_clamp(
+			alloc_bounds_tail(ab->late_hist, allowed), ab->max_miss_threshold);
+	ab->max_preload = alloc_bounds_clamp(
+			alloc_bounds_tail(ab->early_hist, allowed), ab->max_max_preload);
+
+	for (i = 0; i <= ALLOC_BOUNDS_MAX_OFFSET; i++) {
+		ab->late_hist[i] >>= 1;
+		ab->early_hist[i] >>= 1;
+	}
+	ab->n_samples = 0;
+	ab->n_adjustments++;
+}
+
+/**
+ * Records the arrival offset of an ALLOC'd timeslot, whether or not it is
+ *    accepted. Adjusts the bounds every ALLOC_BOUNDS_EPOCH samples.
+ */
+static inline void alloc_bounds_observe(struct fp_alloc_bounds *ab, s64 offset)
+{
+	u32 *hist = ab->early_hist;
+
+	if (offset < 0) {
+		hist = ab->late_hist;
+		offset = -offset;
+	}
+	if (offset > ALLOC_BOUNDS_MAX_OFFSET)
+		offset = ALLOC_BOUNDS_MAX_OFFSET;
+	hist[offset]++;
+
+	if (unlikely(++ab->n_samples >= ALLOC_BOUNDS_EPOCH))
+		alloc_bounds_adjust(ab);
+}
+
+#endif /* FP_ALLOC_BOUNDS_H_ */
@@ -0,0 +1,99 @@
+/*
+ * arbiter_role.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+/**
+ * Master/standby role of an arbiter.
+ *
+ * The master multicasts watchdog packets to the controller group. A standby
+ *    keeps no allocator state; it listens for watchdogs, and when none arrived
+ *    for longer than the trigger threshold it takes over: it becomes master,
+ *    claims the controller IP, and rebuilds each node's connection lazily,
+ *    resetting it on the first packet the node sends. The reset makes the
+ *    endpoint re-request all its unmet demand, which refills the allocator.
+ *
+ * Times are in the caller's clock units.
+ */
+#ifndef FP_ARBITER_ROLE_H_
+#define FP_ARBITER_ROLE_H_
+
+#include "platform/generic.h"
+#include "topology.h"
+
+#define ARB_RESYNC_WORDS		((MAX_NODES + 63) / 64)
+
+struct fp_arb_role {
+	bool	is_master;
+	u64		threshold;			/* watchdog silence that triggers takeover */
+	u64		last_watchdog;
+	u64		took_over_at;
+	u32		n_takeovers;
+	/* nodes whose connections were not rebuilt since the takeover */
+	u64		resync_pending[ARB_RESYNC_WORDS];
+};
+
+/**
+ * Initializes the role. A standby counts the watchdog silence from @now.
+ */
+static inline
+void arb_role_init(struct fp_arb_role *r, bool is_master, u64 now,
+		u64 threshold)
+{
+	memset(r, 0, sizeof(*r));
+	r->is_master = is_master;
+	r->threshold = threshold;
+	r->last_watchdog = now;
+}
+
+static inline
+bool arb_role_is_master(struct fp_arb_role *r)
+{
+	return r->is_master;
+}
+
+static inline
+void arb_role_saw_watchdog(struct fp_arb_role *r, u64 now)
+{
+	r->last_watchdog = now;
+}
+
+/**
+ * @return true if this is a standby whose master went silent
+ */
+static inline
+bool arb_role_should_take_over(struct fp_arb_role *r, u64 now)
+{
+	return !r->is_master && (s64)(now - r->last_watchdog) > (s64)r->threshold;
+}
+
+/**
+ * Becomes master; every node's connection must be rebuilt
+ */
+static inline
+void arb_role_take_over(struct fp_arb_role *r, u64 now)
+{
+	r->is_master = true;
+	r->took_over_at = now;
+	r->n_takeovers++;
+	memset(r->resync_pending, 0xFF, sizeof(r->resync_pending));
+}
+
+/**
+ * @return true, once after a takeover, on the first packet from @node_id;
+ *    the caller should then reset the node's connection
+ */
+static inline
+bool arb_role_needs_resync(struct fp_arb_role *r, u16 node_id)
+{
+	u64 mask = 1ULL << (node_id & 63);
+	u64 *word = &r->resync_pending[node_id >> 6];
+
+	if (likely(!(*word & mask)))
+		return false;
+	*word &= ~mask;
+	return true;
+}
+
+#endif /* FP_ARBITER_ROLE_H_ */
@@ -0,0 +1,756 @@
+/*
+ * endpoint.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * The endpoint control loop; see endpoint.h. Was part of sch_fastpass.c.
+ */
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/bitops.h>
+#include <linux/prefetch.h>
+#endif
+
+#include "endpoint.h"
+#include "platform.h"
+
+#ifndef __KERNEL__
+/* the emulated clock of userspace builds */
+u64 fp_emu_now_ns;
+#endif
+
+static inline struct fp_dst *get_dst(struct fp_endpoint *ep, u32 index) {
+	fp_debug("get dst %u\n", index);
+	return &ep->dsts[index];
+}
+
+/**
+ * Returns the request bucket of a dst: the urgent bucket if the controller
+ *    has not acked all its urgent demand, otherwise log2 of the timeslots a
+ *    request would add to what the controller has acked.
+ */
+static inline u32 unreq_bucket(struct fp_dst *dst)
+{
+	/* read acked first: demand only grows, so it cannot fall behind */
+	u64 acked = atomic64_read(&dst->acked_tslots);
+	u64 demand = atomic64_read(&dst->demand_tslots);
+	u64 delta;
+
+	if (unlikely(atomic64_read(&dst->urgent_tslots) > acked))
+		return FASTPASS_REQ_URGENT_BUCKET;
+	if (unlikely(demand <= acked))
+		return 0;
+	delta = min_t(u64, demand, acked + FASTPASS_REQUEST_WINDOW_SIZE - 1) - acked;
+	return min_t(u32, fls64(delta), FASTPASS_REQ_SIZE_BUCKETS - 1);
+}
+
+/* unlinks dst from its request bucket. Assumes unreq_flows_lock is held */
+static inline void unreq_bucket_unlink(struct fp_endpoint *ep,
+		struct fp_dst *dst)
+{
+	list_del_init(&dst->req_list);
+	if (list_empty(&ep->unreq_buckets[dst->req_bucket]))
+		ep->unreq_bucket_mask &= ~(1U << dst->req_bucket);
+}
+
+/* links dst into a request bucket. Assumes unreq_flows_lock is held */
+static inline void unreq_bucket_link(struct fp_endpoint *ep,
+		struct fp_dst *dst, u32 bucket)
+{
+	list_add_tail(&dst->req_list, &ep->unreq_buckets[bucket]);
+	ep->unreq_bucket_mask |= (1U << bucket);
+	dst->req_bucket = bucket;
+}
+
+/**
+ * Enqueues flow to the request queue, if it's not already in the retransmit
+ *    queue. A flow that is already queued moves up if its demand grew enough.
+ * Callers update the dst's counters with a full barrier before calling, which
+ *    pairs with the barrier in unreq_dsts_dequeue: either the request path
+ *    sees the update, or the dst is seen unqueued here and queued again.
+ */
+static void unreq_dsts_enqueue_if_not_queued(struct fp_endpoint *ep, u32 dst_id,
+		struct fp_dst *dst)
+{
+	u32 bucket = unreq_bucket(dst);
+
+	/* common case: already queued in a high enough bucket, no lock needed */
+	if (ACCESS_ONCE(dst->state) != FLOW_UNQUEUED
+			&& bucket <= ACCESS_ONCE(dst->req_bucket))
+		return;
+
+	spin_lock(&ep->unreq_flows_lock);
+	if (dst->state != FLOW_UNQUEUED) {
+		/* move up, unless another CPU already did */
+		if (bucket > dst->req_bucket) {
+			unreq_bucket_unlink(ep, dst);
+			unreq_bucket_link(ep, dst, bucket);
+		}
+		spin_unlock(&ep->unreq_flows_lock);
+		return;
+	}
+
+	/* enqueue */
+	dst->req_enqueue_ns = fp_monotonic_time_ns();
+	unreq_bucket_link(ep, dst, bucket);
+	ep->n_unreq_dsts++;
+	dst->state = FLOW_REQUEST_QUEUE;
+	spin_unlock(&ep->unreq_flows_lock);
+
+	/* update request timer if necessary */
+	ep->ops->trigger_request(ep->ops_param);
+}
+
+/**
+ * Dequeues the most valuable dst: the first in the highest non-empty bucket,
+ *    unless the oldest dst at the head of a bucket has waited longer than
+ *    req_max_age_ns. Urgent dsts always go first.
+ * returns NULL if the dst queue is empty
+ */
+static struct fp_dst *unreq_dsts_dequeue(struct fp_endpoint *ep,
+		u32 *dst_id, u64 now_monotonic)
+{
+	struct fp_dst *res;
+	struct fp_dst *oldest;
+	struct fp_dst *cand;
+	u32 mask;
+
+	/* get entry and remove from queue */
+	spin_lock(&ep->unreq_flows_lock);
+	if (unlikely(ep->unreq_bucket_mask == 0)) {
+		spin_unlock(&ep->unreq_flows_lock);
+		return NULL;
+	}
+
+	res = list_first_entry(&ep->unreq_buckets[fls(ep->unreq_bucket_mask) - 1],
+			struct fp_dst, req_list);
+
+	/* find the dst that waited longest */
+	oldest = res;
+	mask = ep->unreq_bucket_mask & ~(1U << res->req_bucket);
+	while (mask) {
+		cand = list_first_entry(&ep->unreq_buckets[__ffs(mask)],
+				struct fp_dst, req_list);
+		if (time_before64(cand->req_enqueue_ns, oldest->req_enqueue_ns))
+			oldest = cand;
+		mask &= mask - 1;
+	}
+	if (unlikely(oldest != res
+			&& res->req_bucket != FASTPASS_REQ_URGENT_BUCKET
+			&& now_monotonic - oldest->req_enqueue_ns > ep->req_max_age_ns)) {
+		res = oldest;
+		FP_STAT_INC(ep, aged_requests);
+	}
+
+	unreq_bucket_unlink(ep, res);
+	ep->n_unreq_dsts--;
+	res->state = FLOW_UNQUEUED;
+	spin_unlock(&ep->unreq_flows_lock);
+
+	/* order the dequeue before reading the counters; pairs with the counter
+	 * updates before unreq_dsts_enqueue_if_not_queued */
+	smp_mb();
+
+	*dst_id = res - &ep->dsts[0];
+	return res;
+}
+
+static void flow_inc_used(struct fp_endpoint *ep, struct fp_dst* dst, u64 amount) {
+	atomic64_add(amount, &dst->used_tslots);
+	ep->used_tslots += amount;
+}
+
+/**
+ * Marks up to @amount timeslots of the flow's unmet demand as used.
+ * @return the number of timeslots marked
+ */
+static u64 flow_reserve_used(struct fp_endpoint *ep, struct fp_dst *dst,
+		u64 amount)
+{
+	u64 used;
+	u64 n;
+
+	do {
+		used = atomic64_read(&dst->used_tslots);
+		n = min_t(u64, amount, atomic64_read(&dst->demand_tslots) - used);
+		if (n == 0)
+			return 0;
+	} while (atomic64_cmpxchg(&dst->used_tslots, used, used + n) != used);
+
+	ep->used_tslots += n;
+	return n;
+}
+
+/**
+ * Increase the number of unrequested packets for the flow.
+ *   Maintains the necessary invariants, e.g. adds the flow to the unreq_flows
+ *   list if necessary
+ */
+static void flow_inc_demand(struct fp_endpoint *ep, u32 dst_id,
+		struct fp_dst *dst, u64 amount)
+{
+	/* full barrier, see unreq_dsts_enqueue_if_not_queued */
+	atomic64_add_return(amount, &dst->demand_tslots);
+
+	/* if flow not on scheduling queue yet, enqueue */
+	unreq_dsts_enqueue_if_not_queued(ep, dst_id, dst);
+
+	percpu_counter_add(&ep->demand_tslots, amount);
+}
+
+/**
+ * Performs a reset of all flows
+ */
+void fpep_handle_reset(void *param)
+{
+	struct fp_endpoint *ep = (struct fp_endpoint *)param;
+
+	struct fp_dst *dst;
+	u32 idx;
+	u32 dst_id;
+	u64 used;
+	u64 demand;
+	u64 urgent;
+	u32 mask = MAX_NODES - 1;
+	u32 base_idx = jhash_1word((__be32)fp_monotonic_time_ns(), 0) & mask;
+
+	BUILD_BUG_ON_MSG(MAX_NODES & (MAX_NODES - 1), "MAX_NODES needs to be a power of 2");
+
+	/* reset future allocations */
+	wnd_reset(&ep->alloc_wnd, ep->current_timeslot);
+
+	percpu_counter_set(&ep->demand_tslots, 0);
+	ep->requested_tslots = 0;	/* will remain 0 when we're done */
+	atomic64_set(&ep->alloc_tslots, 0);		/* will remain 0 when we're done */
+	ep->acked_tslots = 0; 		/* will remain 0 when we're done */
+	ep->used_tslots = 0; 		/* will remain 0 when we're done */
+
+	/* for each cell in hash table: */
+	for (idx = 0; idx < MAX_NODES; idx++) {
+		/* we start from a pseudo-random index 'base_idx' to have less
+		 * discrimination towards the lower idx in unreq_dsts_enqueue, however
+		 * this is not a perfectly fair scheme */
+		dst_id = (idx + base_idx) & mask;
+		dst = get_dst(ep, dst_id);
+		used = atomic64_read(&dst->used_tslots);
+
+		/* if flow was empty anyway, nothing more to do */
+		if (likely(atomic64_read(&dst->demand_tslots) == used))
+			continue;
+
+		/* has timeslots pending, rebase counters to 0. enqueues racing with
+		 * the rebase only add to demand, so subtract rather than set */
+		demand = atomic64_sub_return(used, &dst->demand_tslots);
+		urgent = atomic64_read(&dst->urgent_tslots);
+		atomic64_set(&dst->urgent_tslots, (urgent > used) ? urgent - used : 0);
+		atomic64_set(&dst->alloc_tslots, 0);
+		atomic64_set(&dst->acked_tslots, 0);
+		atomic64_set(&dst->requested_tslots, 0);
+		atomic64_set(&dst->used_tslots, 0);
+
+		percpu_counter_add(&ep->demand_tslots, demand);
+
+		fp_debug("rebased flow 0x%04X, new demand %llu timeslots\n",
+				dst_id, demand);
+
+		/* add flow to request queue if it's not already there */
+		unreq_dsts_enqueue_if_not_queued(ep, dst_id, dst);
+	}
+}
+
+/**
+ * Accounts for an admitted timeslot in the early/late enqueue statistics
+ */
+static inline void alloc_lateness_stat(struct fp_endpoint *ep, u64 full_tslot,
+		u64 current_timeslot)
+{
+	if (full_tslot > current_timeslot) {
+		FP_STAT_INC(ep, early_enqueue);
+	} else {
+		u64 tslot = current_timeslot;
+		if (unlikely(full_tslot < tslot - (ep->miss_threshold >> 1))) {
+			if (unlikely(full_tslot < tslot - 3*(ep->miss_threshold >> 2)))
+				FP_STAT_INC(ep, late_enqueue4);
+			else
+				FP_STAT_INC(ep, late_enqueue3);
+		} else {
+			if (unlikely(full_tslot < tslot - (ep->miss_threshold >> 2)))
+				FP_STAT_INC(ep, late_enqueue2);
+			else
+				FP_STAT_INC(ep, late_enqueue1);
+		}
+	}
+}
+
+/**
+ * Handles an ALLOC payload.
+ *
+ * The payload is first parsed into per-destination timeslot lists, so each
+ *    destination's state is locked and updated once, and its timeslots are
+ *    handed to the scheduler together.
+ */
+void fpep_handle_alloc(void *param, u32 base_tslot, u16 *dst_ids,
+		int n_dst, u8 *tslots, int n_tslots)
+{
+	struct fp_endpoint *ep = (struct fp_endpoint *)param;
+	int i;
+	u8 spec;
+	int dst_id_idx;
+	u32 dst_id;
+	u64 full_tslot;
+	u64 first_tslot;
+	u64 now_real = fp_get_time_ns();
+	u64 current_timeslot;
+	u32 cur_miss_threshold = ep->miss_threshold;
+	u32 cur_max_preload = ep->max_preload;
+	/* timeslots that are in time, as offsets from first_tslot, grouped by
+	 * destination index. skips are at most 256, so offsets fit in 16 bits */
+	u16 dst_tslots[FASTPASS_ALLOC_MAX_TSLOTS];
+	u8 n_dst_tslots[FASTPASS_ALLOC_MAX_DSTS + 1] = {0};
+	u8 dst_start[FASTPASS_ALLOC_MAX_DSTS + 2];
+	u8 dst_fill[FASTPASS_ALLOC_MAX_DSTS + 1];
+	/* destinations by index, resolved once for the whole ALLOC */
+	struct fp_dst *dsts[FASTPASS_ALLOC_MAX_DSTS + 1];
+	u64 admit_keys[FASTPASS_ALLOC_MAX_DSTS];
+	u32 admit_n[FASTPASS_ALLOC_MAX_DSTS];
+	int n_admit_dsts = 0;
+
+	/* every alloc should be ACKed */
+	ep->ops->trigger_request(ep->ops_param);
+
+	if (unlikely(n_tslots > FASTPASS_ALLOC_MAX_TSLOTS
+			|| n_dst > FASTPASS_ALLOC_MAX_DSTS)) {
+		FASTPASS_CRIT("ALLOC has %d timeslots to %d destinations, max %d and %d\n",
+				n_tslots, n_dst, FASTPASS_ALLOC_MAX_TSLOTS,
+				FASTPASS_ALLOC_MAX_DSTS);
+		return;
+	}
+
+	/* resolve the destinations, and start fetching them while specs decode */
+	for (dst_id_idx = 1; dst_id_idx <= n_dst; dst_id_idx++) {
+		dst_id = dst_ids[dst_id_idx - 1];
+		if (unlikely(dst_id >= MAX_NODES)) {
+			FASTPASS_CRIT("ALLOC has illegal destination 0x%04X\n", dst_id);
+			return;
+		}
+		dsts[dst_id_idx] = get_dst(ep, dst_id);
+		prefetchw(dsts[dst_id_idx]);
+	}
+
+	/* find full timeslot value of the ALLOC */
+	current_timeslot = (now_real * ep->tslot_mul) >> ep->tslot_shift;
+
+	first_tslot = current_timeslot - (1ULL << 18); /* 1/4 back, 3/4 front */
+	first_tslot += ((u32)base_tslot - (u32)first_tslot) & 0xFFFFF; /* 20 bits */
+
+	fp_debug("got ALLOC for timeslot %d (full %llu, current %llu), %d destinations, %d timeslots, mask 0x%016llX\n",
+			base_tslot, first_tslot, ep->current_timeslot, n_dst, n_tslots,
+			wnd_get_mask(&ep->alloc_wnd, ep->current_timeslot+63));
+
+	if (ep->adaptive_bounds) {
+		cur_miss_threshold = ep->alloc_bounds.miss_threshold;
+		cur_max_preload = ep->alloc_bounds.max_preload;
+	}
+
+	/* first pass: validate specs and count timeslots per destination */
+	full_tslot = first_tslot;
+	for (i = 0; i < n_tslots; i++) {
+		spec = tslots[i];
+		dst_id_idx = spec >> 4;
+
+		if (dst_id_idx == 0) {
+			/* Skip instruction */
+			full_tslot += 16 * (1 + (spec & 0xF));
+			continue;
+		}
+
+		if (dst_id_idx > n_dst) {
+			/* destination index out of bounds */
+			FASTPASS_CRIT("ALLOC tslot spec 0x%02X has illegal dst index %d (max %d)\n",
+					spec, dst_id_idx, n_dst);
+			return;
+		}
+
+		full_tslot += 1 + (spec & 0xF);
+
+		if (ep->adaptive_bounds)
+			alloc_bounds_observe(&ep->alloc_bounds,
+					(s64)(full_tslot - current_timeslot));
+
+		/* is alloc too far in the past or too far in the future? */
+		if (unlikely(time_before64(full_tslot, current_timeslot - cur_miss_threshold))
+				|| unlikely(time_after64(full_tslot, current_timeslot + cur_max_preload)))
+			continue;
+
+		n_dst_tslots[dst_id_idx]++;
+	}
+
+	dst_start[1] = 0;
+	for (dst_id_idx = 1; dst_id_idx <= n_dst; dst_id_idx++) {
+		dst_start[dst_id_idx + 1] = dst_start[dst_id_idx] + n_dst_tslots[dst_id_idx];
+		dst_fill[dst_id_idx] = dst_start[dst_id_idx];
+	}
+
+	/* second pass: put timeslots in their destination's list */
+	full_tslot = first_tslot;
+	for (i = 0; i < n_tslots; i++) {
+		spec = tslots[i];
+		dst_id_idx = spec >> 4;
+
+		if (dst_id_idx == 0) {
+			/* Skip instruction */
+			base_tslot += 16 * (1 + (spec & 0xF));
+			full_tslot += 16 * (1 + (spec & 0xF));
+			fp_debug("ALLOC skip to timeslot %d full %llu (no allocation)\n",
+					base_tslot, full_tslot);
+			continue;
+		}
+
+		base_tslot += 1 + (spec & 0xF);
+		full_tslot += 1 + (spec & 0xF);
+		fp_debug("Timeslot %d (full %llu) to destination 0x%04x (%d)\n",
+				base_tslot, full_tslot, dst_ids[dst_id_idx - 1], dst_ids[dst_id_idx - 1]);
+
+		/* is alloc too far in the past? */
+		if (unlikely(time_before64(full_tslot, current_timeslot - cur_miss_threshold))) {
+			FP_STAT_INC(ep, alloc_too_late);
+			fp_debug("-X- already gone, dropping\n");
+			continue;
+		}
+
+		if (unlikely(time_after64(full_tslot, current_timeslot + cur_max_preload))) {
+			FP_STAT_INC(ep, alloc_premature);
+			fp_debug("-X- too futuristic, dropping\n");
+			continue;
+		}
+
+		dst_tslots[dst_fill[dst_id_idx]++] = (u16)(full_tslot - first_tslot);
+	}
+
+	/* update each destination once, and admit all timeslots together */
+	for (dst_id_idx = 1; dst_id_idx <= n_dst; dst_id_idx++) {
+		struct fp_dst *dst = dsts[dst_id_idx];
+		u32 n_alloc = n_dst_tslots[dst_id_idx];
+		u32 n_admit;
+		u16 *dst_tslot = &dst_tslots[dst_start[dst_id_idx]];
+
+		if (n_alloc == 0)
+			continue;
+
+		dst_id = dst_ids[dst_id_idx - 1];
+		n_admit = flow_reserve_used(ep, dst, n_alloc);
+		if (n_admit > 0)
+			atomic64_add(n_admit, &dst->alloc_tslots);
+
+		if (unlikely(n_admit < n_alloc)) {
+			FP_STAT_ADD(ep, unwanted_alloc, n_alloc - n_admit);
+			fp_debug("got %u allocations over demand, flow 0x%04X, demand %llu\n",
+					n_alloc - n_admit, dst_id,
+					(u64)atomic64_read(&dst->demand_tslots));
+		}
+
+		if (n_admit == 0)
+			continue;
+
+		admit_keys[n_admit_dsts] = dst_id;
+		admit_n[n_admit_dsts] = n_admit;
+		n_admit_dsts++;
+
+		atomic64_add(n_admit, &ep->alloc_tslots);
+		FP_STAT_ADD(ep, admitted_timeslots, n_admit);
+		for (i = 0; i < n_admit; i++)
+			alloc_lateness_stat(ep, first_tslot + dst_tslot[i], current_timeslot);
+	}
+
+	if (n_admit_dsts > 0)
+		ep->ops->admit(ep->ops_param, admit_keys, admit_n, n_admit_dsts);
+
+	fp_debug("mask after: 0x%016llX\n",
+			wnd_get_mask(&ep->alloc_wnd, ep->current_timeslot+63));
+}
+
+void fpep_handle_areq(void *param, u16 *dst_and_count, int n)
+{
+	struct fp_endpoint *ep = (struct fp_endpoint *)param;
+	struct fp_dst *dst;
+	int i;
+	u16 dst_id;
+	u16 count_low;
+	u64 count;
+	u64 alloc;
+	u64 requested;
+
+	ep->ops->trigger_request(ep->ops_param);
+
+	for (i = 0; i < n; i++) {
+		dst_id = ntohs(dst_and_count[2*i]);
+		count_low = ntohs(dst_and_count[2*i + 1]);
+
+		if (unlikely(dst_id >= MAX_NODES)) {
+			FASTPASS_WARN("got an alloc report for illegal dst 0x%04X\n", dst_id);
+			continue;
+		}
+		dst = get_dst(ep, dst_id);
+
+		/* get full count */
+		/* TODO: This is not perfectly safe. For example, if there is a big
+		 * outage and the controller thinks it had produced many timeslots, this
+		 * can go out of sync */
+		alloc = atomic64_read(&dst->alloc_tslots);
+		count = alloc - (1 << 15);
+		count += (u16)(count_low - count);
+
+		/* update counts */
+		if ((s64)(count - alloc) > 0) {
+			u64 n_lost = count - alloc;
+
+			requested = atomic64_read(&dst->requested_tslots);
+			if (unlikely((s64)(count - requested) > 0)) {
+				FASTPASS_WARN("got an alloc report for dst %d larger than requested (%llu > %llu), will reset\n",
+						dst_id, count, requested);
+				FP_STAT_INC(ep, alloc_report_larger_than_requested);
+				/* This corrupts the status; will force a reset of the
+				 * connection, which resets this endpoint too */
+				ep->ops->force_reset(ep->ops_param);
+				return;
+			}
+
+			fp_debug("controller allocated %llu our allocated %llu, will increase demand by %llu\n",
+					count, alloc, n_lost);
+
+			/* demand before used, so used never passes demand */
+			atomic64_add(n_lost, &dst->alloc_tslots);
+			flow_inc_demand(ep, dst_id, dst, n_lost);
+			flow_inc_used(ep, dst, n_lost);
+
+			atomic64_add(n_lost, &ep->alloc_tslots);
+			FP_STAT_ADD(ep, timeslots_assumed_lost, n_lost);
+		}
+	}
+}
+
+void fpep_handle_ack(void *param, struct fpproto_pktdesc *pd)
+{
+	struct fp_endpoint *ep = (struct fp_endpoint *)param;
+	int i;
+	u64 new_acked;
+	u64 acked;
+	u64 delta;
+
+	for (i = 0; i < pd->n_areq; i++) {
+		u32 dst_id = pd->areq[i].src_dst_key;
+		/* this node made pd, so no need to check bounds */
+		struct fp_dst *dst = get_dst(ep, dst_id);
+
+		/* acks are handled under the connection lock, so acked_tslots has
+		 * a single writer */
+		new_acked = pd->areq[i].tslots;
+		acked = atomic64_read(&dst->acked_tslots);
+		if (acked < new_acked) {
+			FASTPASS_BUG_ON(new_acked > atomic64_read(&dst->demand_tslots));
+			delta = new_acked - acked;
+			ep->acked_tslots += delta;
+			atomic64_set(&dst->acked_tslots, new_acked);
+			fp_debug("acked request of %llu additional slots, flow 0x%04X, total %llu slots\n",
+					delta, dst_id, new_acked);
+
+			/* the demand-limiting window might be in effect, re-enqueue flow.
+			 * full barrier, see unreq_dsts_enqueue_if_not_queued */
+			smp_mb();
+			if (unlikely(atomic64_read(&dst->requested_tslots)
+					!= atomic64_read(&dst->demand_tslots)))
+				unreq_dsts_enqueue_if_not_queued(ep, dst_id, dst);
+		}
+	}
+}
+
+void fpep_handle_neg_ack(void *param, struct fpproto_pktdesc *pd)
+{
+	struct fp_endpoint *ep = (struct fp_endpoint *)param;
+	int i;
+	u64 req_tslots;
+	u64 acked;
+
+	for (i = 0; i < pd->n_areq; i++) {
+		u32 dst_id = pd->areq[i].src_dst_key;
+		/* this node made pd, so no need to check bounds */
+		struct fp_dst *dst = get_dst(ep, dst_id);
+
+		req_tslots = pd->areq[i].tslots;
+		acked = atomic64_read(&dst->acked_tslots);
+		/* don't need to resend if got ack >= req_tslots */
+		if (req_tslots <= acked) {
+			fp_debug("nack for request of %llu for flow 0x%04X, but already acked %llu\n",
+							req_tslots, dst_id, acked);
+			continue;
+		}
+
+		/* add to retransmit queue */
+		unreq_dsts_enqueue_if_not_queued(ep, dst_id, dst);
+
+		fp_debug("nack for request of %llu for flow 0x%04X (%llu acked), added to retransmit queue\n",
+						req_tslots, dst_id, acked);
+	}
+}
+
+
+int fpep_init(struct fp_endpoint *ep, struct fpep_ops *ops, void *ops_param,
+		struct fp_sched_stat __percpu *stat, u32 tslot_mul, u32 tslot_shift,
+		u64 now_real)
+{
+	int i;
+
+	ep->ops = ops;
+	ep->ops_param = ops_param;
+	ep->stat = stat;
+	ep->tslot_mul = tslot_mul;
+	ep->tslot_shift = tslot_shift;
+
+	for (i = 0; i < FASTPASS_REQ_BUCKETS; i++)
+		INIT_LIST_HEAD(&ep->unreq_buckets[i]);
+	ep->unreq_bucket_mask = 0;
+	ep->n_unreq_dsts = 0;
+	spin_lock_init(&ep->unreq_flows_lock);
+
+	for (i = 0; i < MAX_NODES; i++) {
+		atomic64_set(&ep->dsts[i].demand_tslots, 0);
+		atomic64_set(&ep->dsts[i].urgent_tslots, 0);
+		atomic64_set(&ep->dsts[i].requested_tslots, 0);
+		atomic64_set(&ep->dsts[i].acked_tslots, 0);
+		atomic64_set(&ep->dsts[i].alloc_tslots, 0);
+		atomic64_set(&ep->dsts[i].used_tslots, 0);
+		INIT_LIST_HEAD(&ep->dsts[i].req_list);
+		ep->dsts[i].state = FLOW_UNQUEUED;
+	}
+
+	/* calculate timeslot from beginning of Epoch */
+	ep->current_timeslot = (now_real * ep->tslot_mul) >> ep->tslot_shift;
+	wnd_reset(&ep->alloc_wnd, ep->current_timeslot);
+
+	ep->requested_tslots = 0;
+	atomic64_set(&ep->alloc_tslots, 0);
+	ep->acked_tslots = 0;
+	ep->used_tslots = 0;
+	return percpu_counter_init(&ep->demand_tslots, 0);
+}
+
+void fpep_destroy(struct fp_endpoint *ep)
+{
+	percpu_counter_destroy(&ep->demand_tslots);
+}
+
+void fpep_inc_demand(struct fp_endpoint *ep, u32 dst_id, u64 amount)
+{
+	flow_inc_demand(ep, dst_id, get_dst(ep, dst_id), amount);
+}
+
+void fpep_mark_urgent(struct fp_endpoint *ep, u32 dst_id)
+{
+	struct fp_dst *dst = get_dst(ep, dst_id);
+	u64 demand = atomic64_read(&dst->demand_tslots);
+	u64 urgent = atomic64_read(&dst->urgent_tslots);
+	u64 prev;
+
+	/* CPUs race to raise the mark; the highest wins */
+	while (urgent < demand) {
+		prev = atomic64_cmpxchg(&dst->urgent_tslots, urgent, demand);
+		if (prev == urgent)
+			break;
+		urgent = prev;
+	}
+
+	/* the dst moves to the urgent bucket. full barrier, see
+	 * unreq_dsts_enqueue_if_not_queued */
+	smp_mb();
+	unreq_dsts_enqueue_if_not_queued(ep, dst_id, dst);
+}
+
+u16 fpep_fill_request(struct fp_endpoint *ep, struct fpproto_pktdesc *pd,
+		u64 now_monotonic)
+{
+	u64 new_requested;
+	u64 demand, acked, requested, urgent;
+	bool is_urgent;
+
+	fp_debug("start: unreq_flows=%u, unreq_tslots=%lld, now_mono=%llu\n",
+			fpep_n_unreq_dsts(ep),
+			(s64)percpu_counter_read(&ep->demand_tslots) - (s64)ep->requested_tslots,
+			now_monotonic);
+
+	pd->n_areq = 0;
+
+	while (pd->n_areq < FASTPASS_PKT_MAX_AREQ) {
+		/* get entry */
+		u32 dst_id;
+		u64 delay;
+		struct fp_dst *dst = unreq_dsts_dequeue(ep, &dst_id, now_monotonic);
+		if (dst == NULL)
+			break;
+
+		/* read after the dequeue: increments that come later re-enqueue */
+		acked = atomic64_read(&dst->acked_tslots);
+		demand = atomic64_read(&dst->demand_tslots);
+		urgent = atomic64_read(&dst->urgent_tslots);
+		requested = atomic64_read(&dst->requested_tslots);
+		new_requested = min_t(u64, demand,
+				acked + FASTPASS_REQUEST_WINDOW_SIZE - 1);
+
+		/* unacked urgent demand is requested on its own, so the arbiter does
+		 * not prioritize later demand with it; the rest follows once it is
+		 * acked. Retransmits after a NACK come here again, still urgent */
+		is_urgent = (urgent > acked);
+		if (unlikely(is_urgent)) {
+			new_requested = min_t(u64, new_requested, urgent);
+			new_requested = max_t(u64, new_requested, requested);
+		}
+
+		if(new_requested <= acked) {
+			FP_STAT_INC(ep, queued_flow_already_acked);
+			fp_debug("flow 0x%04X was in queue, but already fully acked\n",
+					dst_id);
+			continue;
+		}
+
+		/* requests are sent from the tasklet only, so this is the only writer */
+		ep->requested_tslots += (new_requested - requested);
+		atomic64_set(&dst->requested_tslots, new_requested);
+
+		/* how stale the controller's view of this dst's demand got */
+		delay = now_monotonic - dst->req_enqueue_ns;
+		FP_STAT_INC(ep, requested_dsts);
+		FP_STAT_ADD(ep, request_delay_total_ns, delay);
+		FP_STAT_MAX(ep, request_delay_max_ns, delay);
+
+		pd->areq[pd->n_areq].src_dst_key = dst_id;
+		pd->areq[pd->n_areq].tslots = new_requested;
+		pd->areq[pd->n_areq].urgent = is_urgent;
+		if (unlikely(is_urgent))
+			FP_STAT_INC(ep, urgent_requests);
+
+		pd->n_areq++;
+	}
+
+	if(pd->n_areq == 0) {
+		FP_STAT_INC(ep, request_with_empty_flowqueue);
+		fp_debug("was called with no flows pending (could be due to bad packets?)\n");
+	}
+	fp_debug("end: unreq_flows=%u, unreq_tslots=%lld\n", fpep_n_unreq_dsts(ep),
+			(s64)percpu_counter_read(&ep->demand_tslots) - (s64)ep->requested_tslots);
+
+	return pd->n_areq;
+}
+
+bool fpep_has_pending_demand(struct fp_endpoint *ep)
+{
+	/* demand_tslots only increases and is larger than alloc_tslots, so read it
+	 *   second to be on safe side. Summing the per-cpu counter is costly, but
+	 *   is done once per request */
+	return atomic64_read(&ep->alloc_tslots) != percpu_counter_sum(&ep->demand_tslots);
+}
+
+void fpep_trigger_request(void *param)
+{
+	struct fp_endpoint *ep = (struct fp_endpoint *)param;
+	ep->ops->trigger_request(ep->ops_param);
+}
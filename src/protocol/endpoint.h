@@ -0,0 +1,191 @@
+/*
+ * endpoint.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+/**
+ * Platform-independent control loop of a FastPass endpoint: keeps the demand
+ *    of every destination, builds A-REQs from it, and handles the ACKs, NACKs,
+ *    ALLOCs, alloc reports and resets of the connection to the arbiter.
+ *
+ * The kernel qdisc wraps it with timers, the control socket and the packet
+ *    queues; in userspace it builds against platform/userspace.h, with an
+ *    emulated clock, so the logic can be tested and benchmarked without a
+ *    kernel.
+ */
+#ifndef FP_ENDPOINT_H_
+#define FP_ENDPOINT_H_
+
+#ifdef __KERNEL__
+#include <linux/atomic.h>
+#include <linux/list.h>
+#include <linux/percpu_counter.h>
+#include <linux/spinlock.h>
+#else
+#include "platform/userspace.h"
+#endif
+
+#include "fpproto.h"
+#include "alloc_bounds.h"
+#include "window.h"
+#include "topology.h"
+#include "fastpass_stats.h"
+
+#define FASTPASS_REQUEST_WINDOW_SIZE 		(1 << 13)
+
+/* unrequested dsts are bucketed by log2 of their unacked timeslots; the
+ * request window caps that at 2^13. Dsts with unacked urgent demand have a
+ * bucket of their own above those */
+#define FASTPASS_REQ_SIZE_BUCKETS			14
+#define FASTPASS_REQ_URGENT_BUCKET			FASTPASS_REQ_SIZE_BUCKETS
+#define FASTPASS_REQ_BUCKETS				(FASTPASS_REQ_SIZE_BUCKETS + 1)
+
+/* an ALLOC payload has at most 63 pairs of timeslot specs */
+#define FASTPASS_ALLOC_MAX_TSLOTS	126
+#define FASTPASS_ALLOC_MAX_DSTS		15
+
+enum {
+	FLOW_UNQUEUED,
+	FLOW_REQUEST_QUEUE,
+};
+
+/**
+ * Per flow structure. The counters only grow (until a reset rebases
+ *    them), and each has a single kind of writer, so they are updated without
+ *    a lock:
+ *  - demand_tslots: enqueue on any CPU, and lost-ALLOC reports
+ *  - urgent_tslots: enqueue of urgent packets on any CPU, only raised
+ *  - requested_tslots: the request path
+ *  - acked_tslots: ack handling, under the connection lock
+ *  - alloc_tslots, used_tslots: ALLOC handling
+ *  The request path reconciles them when it builds an A-REQ. state, req_list
+ *  and req_bucket are protected by ep->unreq_flows_lock.
+ */
+struct fp_dst {
+	atomic64_t	demand_tslots;		/* total needed timeslots */
+	atomic64_t	urgent_tslots;		/* demand up to here is urgent */
+	atomic64_t	requested_tslots;	/* highest requested timeslots */
+	atomic64_t	acked_tslots;		/* highest requested timeslots that was acked*/
+	atomic64_t	alloc_tslots;		/* total received allocations */
+	atomic64_t	used_tslots;		/* timeslots in which packets moved */
+	struct list_head req_list;	/* anchor in ep->unreq_buckets[] */
+	u64		req_enqueue_ns;		/* when the dst last became unrequested */
+	uint8_t state;
+	uint8_t req_bucket;			/* index in ep->unreq_buckets[], if queued */
+};
+
+/**
+ * Operations the endpoint needs from its platform
+ */
+struct fpep_ops {
+	/**
+	 * Sends up to @n_tslots[i] timeslots' worth of packets to each
+	 *    destination @dst_ids[i], now
+	 */
+	void	(*admit)(void *param, u64 *dst_ids, u32 *n_tslots, int n);
+
+	/**
+	 * There is demand to request; a request should be sent when the pacer
+	 *    allows
+	 */
+	void	(*trigger_request)(void *param);
+
+	/**
+	 * The accounting went out of sync with the arbiter; the connection should
+	 *    be reset
+	 */
+	void	(*force_reset)(void *param);
+};
+
+struct fp_endpoint {
+	/* configuration paramters */
+	u32		tslot_mul;					/* mul to calculate timeslot from nsec */
+	u32		tslot_shift;				/* shift to calculate timeslot from nsec */
+	/* tunables, changed by the platform while running */
+	u32		miss_threshold;
+	u32		max_preload;
+	u32		req_max_age_ns;
+	bool	adaptive_bounds;
+	struct fp_alloc_bounds alloc_bounds;	/* if adaptive_bounds */
+
+	struct fpep_ops	*ops;
+	void			*ops_param;
+
+	/* state */
+	struct list_head unreq_buckets[FASTPASS_REQ_BUCKETS]; /* flows with unscheduled packets */
+	u32 unreq_bucket_mask;				/* non-empty unreq_buckets */
+	u32 n_unreq_dsts;
+	spinlock_t 				unreq_flows_lock;
+
+	struct fp_dst dsts[MAX_NODES];
+
+	struct fp_window alloc_wnd;
+	u64		current_timeslot;
+
+	/* counters */
+	struct percpu_counter demand_tslots;	/* total needed timeslots */
+	u64		requested_tslots;	/* highest requested timeslots */
+	atomic64_t alloc_tslots;	/* total received allocations */
+	u64		acked_tslots;		/* total acknowledged requests */
+	u64		used_tslots;
+
+	/* statistics, allocated by the platform */
+	struct fp_sched_stat __percpu *stat;
+};
+
+/**
+ * Initializes the endpoint. The tunables are set by the caller afterwards.
+ * @stat: zeroed statistics, kept per-CPU in the kernel
+ * @now_real: the current real time, to find the current timeslot
+ * Returns 0 on success, negative on error.
+ */
+int fpep_init(struct fp_endpoint *ep, struct fpep_ops *ops, void *ops_param,
+		struct fp_sched_stat __percpu *stat, u32 tslot_mul, u32 tslot_shift,
+		u64 now_real);
+
+/**
+ * Frees resources of the endpoint. Does not free the statistics.
+ */
+void fpep_destroy(struct fp_endpoint *ep);
+
+/**
+ * Adds @amount timeslots to the demand of destination @dst_id
+ */
+void fpep_inc_demand(struct fp_endpoint *ep, u32 dst_id, u64 amount);
+
+/**
+ * Marks the demand of destination @dst_id so far as urgent: it is requested
+ *    ahead of other destinations, in A-REQs that ask the arbiter to allocate
+ *    it with priority.
+ */
+void fpep_mark_urgent(struct fp_endpoint *ep, u32 dst_id);
+
+/**
+ * Fills @pd with A-REQs of the most valuable unrequested destinations.
+ * Returns the number of A-REQs filled.
+ */
+u16 fpep_fill_request(struct fp_endpoint *ep, struct fpproto_pktdesc *pd,
+		u64 now_monotonic);
+
+/**
+ * Returns true if some demand has not been allocated yet. Exact, so costly
+ *    on a kernel with many CPUs.
+ */
+bool fpep_has_pending_demand(struct fp_endpoint *ep);
+
+static inline u32 fpep_n_unreq_dsts(struct fp_endpoint *ep)
+{
+	return ep->n_unreq_dsts;
+}
+
+/* protocol callbacks; @param is the struct fp_endpoint */
+void fpep_handle_reset(void *param);
+void fpep_handle_alloc(void *param, u32 base_tslot, u16 *dst_ids,
+		int n_dst, u8 *tslots, int n_tslots);
+void fpep_handle_areq(void *param, u16 *dst_and_count, int n);
+void fpep_handle_ack(void *param, struct fpproto_pktdesc *pd);
+void fpep_handle_neg_ack(void *param, struct fpproto_pktdesc *pd);
+void fpep_trigger_request(void *param);
+
+#endif /* FP_ENDPOINT_H_ */
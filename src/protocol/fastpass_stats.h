@@ -0,0 +1,124 @@
+/*
+ * fastpass_stats.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+/**
+ * Statistics of the timeslot and fastpass qdiscs. These are kept per-CPU, and
+ *    exported as-is in struct tc_fastpass_qd_stats, so userspace can read them
+ *    without parsing the proc files. Only append fields, and bump
+ *    FASTPASS_STATS_VERSION when the layout changes.
+ *
+ * fp_sched_stat is updated by the endpoint control loop (endpoint.c), so this
+ *    lives with the protocol; the kernel module and fpstat include it from here.
+ */
+#ifndef FASTPASS_STATS_H_
+#define FASTPASS_STATS_H_
+
+#include <linux/types.h>
+
+#ifdef __KERNEL__
+#include <linux/percpu.h>
+#include <linux/string.h>
+#endif
+
+#define FASTPASS_STATS_VERSION		2
+
+struct tsq_sched_stat {
+	__u64		gc_flows;
+	/* enqueue-related */
+	__u64		ctrl_pkts;
+	__u64		ntp_pkts;
+	__u64		ptp_pkts;
+	__u64		arp_pkts;
+	__u64		igmp_pkts;
+	__u64		ssh_pkts;
+	__u64		data_pkts;
+	__u64		classify_errors;
+	__u64		above_plimit;
+	__u64		allocation_errors;
+	__u64		pkt_too_big;
+	/* dequeue-related */
+	__u64		added_tslots;
+	__u64		used_timeslots;
+	__u64		missed_timeslots;
+	__u64		flow_not_found_update;
+	__u64		early_enqueue;
+	__u64		late_enqueue1;
+	__u64		late_enqueue2;
+	__u64		late_enqueue3;
+	__u64		late_enqueue4;
+	__u64		backlog_too_high;
+	__u64		clock_move_causes_reset;
+	/* alloc-related */
+	__u64		unwanted_alloc;
+	__u64		dst_not_found_admit_now;
+	__u64		overfull_tslots;
+};
+
+struct fp_sched_stat {
+	/* dequeue-related */
+	__u64		admitted_timeslots;
+	__u64		early_enqueue;
+	__u64		late_enqueue1;
+	__u64		late_enqueue2;
+	__u64		late_enqueue3;
+	__u64		late_enqueue4;
+
+	/* request-related */
+	__u64		req_alloc_errors;
+	__u64		request_with_empty_flowqueue;
+	__u64		queued_flow_already_acked;
+	__u64		requested_dsts;
+	__u64		request_delay_total_ns;
+	__u64		request_delay_max_ns;
+	__u64		aged_requests;
+	/* alloc-related */
+	__u64		alloc_too_late;
+	__u64		alloc_premature;
+	__u64		unwanted_alloc;
+	/* alloc report-related */
+	__u64		alloc_report_larger_than_requested;
+	__u64		timeslots_assumed_lost;
+	/* request-related, since version 2 */
+	__u64		urgent_requests;
+};
+
+#ifdef __KERNEL__
+/* update a counter of q->stat, on the current CPU */
+#define FP_STAT_INC(q, field)		this_cpu_inc((q)->stat->field)
+#define FP_STAT_ADD(q, field, n)	this_cpu_add((q)->stat->field, (n))
+#define FP_STAT_MAX(q, field, n)	do {							\
+		if ((n) > this_cpu_read((q)->stat->field))					\
+			this_cpu_write((q)->stat->field, (n));					\
+	} while (0)
+
+/**
+ * Sums per-CPU statistics made of __u64 counters into @sum.
+ */
+static inline void fp_stat_sum(void *sum, void __percpu *stat, size_t size)
+{
+	__u64 *dst = (__u64 *)sum;
+	__u64 *src;
+	size_t i;
+	int cpu;
+
+	memset(sum, 0, size);
+	for_each_possible_cpu(cpu) {
+		src = (__u64 *)per_cpu_ptr(stat, cpu);
+		for (i = 0; i < size / sizeof(__u64); i++)
+			dst[i] += src[i];
+	}
+}
+#else
+/* userspace builds of the endpoint keep a single copy of the statistics */
+#define FP_STAT_INC(q, field)		((q)->stat->field++)
+#define FP_STAT_ADD(q, field, n)	((q)->stat->field += (n))
+#define FP_STAT_MAX(q, field, n)	do {							\
+		if ((n) > (q)->stat->field)									\
+			(q)->stat->field = (n);									\
+	} while (0)
+#endif
+
+#endif /* FASTPASS_STATS_H_ */
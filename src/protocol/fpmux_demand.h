@@ -0,0 +1,140 @@
+/*
+ * fpmux_demand.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+/**
+ * Per-destination demand accounting of a control connection shared by
+ *    several qdiscs (see kernel-mod/fastpass_mux.h).
+ *
+ * The arbiter sees one cumulative requested count per destination for the
+ *    connection; each member has its own. A member's increments are added to
+ *    the connection's count, and timeslots the arbiter allocates are assigned
+ *    to members that requested more than they were assigned. Throughout,
+ *
+ *    conn.requested - conn.assigned = sum over members of their
+ *                                     (requested - assigned) + abandoned
+ *
+ * When a member leaves, the arbiter still owes the connection the timeslots
+ *    the member requested and was not assigned. They become abandoned demand:
+ *    later increments of the remaining members are taken from it before the
+ *    connection's count grows, and allocations no member claims wear it down.
+ *    The connection's count never goes backwards, so it stays consistent with
+ *    the arbiter's, and alloc reports never exceed it.
+ *
+ * Callers serialize all calls (the mux holds its conn_lock).
+ */
+#ifndef FPMUX_DEMAND_H_
+#define FPMUX_DEMAND_H_
+
+#include "platform/generic.h"
+#include "topology.h"
+
+#define FPMUX_MAX_MEMBERS		8
+
+struct fpmux_counters {
+	u64						requested[MAX_NODES];
+	u64						assigned[MAX_NODES];
+};
+
+/**
+ * @conn: the connection's counters, as the arbiter sees them
+ * @member: each member slot's counters; zero for empty slots
+ * @abandoned: requested and not assigned timeslots of departed members
+ * @claim_slot: per destination, the member slot that claims first next time
+ * @unclaimed: allocated timeslots that no member claimed
+ */
+struct fpmux_demand {
+	struct fpmux_counters	conn;
+	struct fpmux_counters	member[FPMUX_MAX_MEMBERS];
+	u64						abandoned[MAX_NODES];
+	u8						claim_slot[MAX_NODES];
+	u64						unclaimed;
+};
+
+/* zeroes the counters of the connection and all its members */
+static inline void fpmux_demand_reset(struct fpmux_demand *d)
+{
+	memset(&d->conn, 0, sizeof(d->conn));
+	memset(d->member, 0, sizeof(d->member));
+	memset(d->abandoned, 0, sizeof(d->abandoned));
+}
+
+/**
+ * Records that the member in @slot requested @tslots timeslots to @dst in
+ *    total.
+ * @return the connection's requested count to put in the A-REQ
+ */
+static inline u64 fpmux_demand_request(struct fpmux_demand *d, int slot,
+		u16 dst, u64 tslots)
+{
+	struct fpmux_counters *m = &d->member[slot];
+	u64 more;
+	u64 reuse;
+
+	if (tslots > m->requested[dst]) {
+		more = tslots - m->requested[dst];
+		reuse = (more < d->abandoned[dst]) ? more : d->abandoned[dst];
+		d->abandoned[dst] -= reuse;
+		d->conn.requested[dst] += more - reuse;
+		m->requested[dst] = tslots;
+	}
+	return d->conn.requested[dst];
+}
+
+/**
+ * Assigns @n timeslots allocated to @dst to members that requested timeslots
+ *    they were not yet assigned. Members claim in turn, starting after the
+ *    last member that claimed a timeslot to @dst, so that members waiting on
+ *    the same destination share its allocations.
+ * @return the slot of the last member that got a timeslot, or -1 if none did
+ */
+static inline int fpmux_demand_claim(struct fpmux_demand *d, u16 dst, u64 n)
+{
+	struct fpmux_counters *m;
+	int start = d->claim_slot[dst];
+	int last = -1;
+	int slot;
+	int i;
+	u64 take;
+
+	d->conn.assigned[dst] += n;
+
+	for (i = 0; i < FPMUX_MAX_MEMBERS && n > 0; i++) {
+		slot = (start + i) % FPMUX_MAX_MEMBERS;
+		m = &d->member[slot];
+		if (m->assigned[dst] >= m->requested[dst])
+			continue;
+		take = m->requested[dst] - m->assigned[dst];
+		take = (n < take) ? n : take;
+		m->assigned[dst] += take;
+		n -= take;
+		last = slot;
+	}
+
+	if (last >= 0)
+		d->claim_slot[dst] = (last + 1) % FPMUX_MAX_MEMBERS;
+
+	/* the rest is what departed members were owed, or an over-allocation */
+	d->abandoned[dst] -= (n < d->abandoned[dst]) ? n : d->abandoned[dst];
+	d->unclaimed += n;
+	return last;
+}
+
+/**
+ * Clears the counters of the member in @slot, which is leaving. What it
+ *    requested and was not assigned becomes abandoned demand.
+ */
+static inline void fpmux_demand_leave(struct fpmux_demand *d, int slot)
+{
+	struct fpmux_counters *m = &d->member[slot];
+	u32 dst;
+
+	for (dst = 0; dst < MAX_NODES; dst++)
+		if (m->requested[dst] > m->assigned[dst])
+			d->abandoned[dst] += m->requested[dst] - m->assigned[dst];
+	memset(m, 0, sizeof(*m));
+}
+
+#endif /* FPMUX_DEMAND_H_ */
@@ -893,7 +893,8 @@ int fpproto_encode_packet(struct fpproto_pktdesc *pd, u8 *pkt, u32 max_len,
 		/* A-REQ requests */
 		for (i = 0; i < pd->n_areq; i++) {
 			areq = (struct fastpass_areq *)curp;
-			areq->dst = htons((__be16)pd->areq[i].src_dst_key);
+			areq->dst = htons(((u16)pd->areq[i].src_dst_key & FASTPASS_AREQ_DST_MASK)
+					| (pd->areq[i].urgent ? FASTPASS_AREQ_URGENT : 0));
 			areq->count = htons((u16)pd->areq[i].tslots);
 			curp += 4;
 			remaining_len -= 4;
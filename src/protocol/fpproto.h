@@ -75,14 +75,20 @@ extern bool fastpass_debug;
 #define FASTPASS_PTYPE_ALLOC		0x3
 #define FASTPASS_PTYPE_ACK			0x4
 
+/* A-REQ dst field: the msb marks the demand as urgent-class */
+#define FASTPASS_AREQ_URGENT		0x8000
+#define FASTPASS_AREQ_DST_MASK		0x7FFF
+
 /**
  * An A-REQ for a single destination
  * @src_dst_key: the key for the flow
  * @tslots: the total number of tslots requested
+ * @urgent: whether newly requested tslots should be allocated with priority
  */
 struct fpproto_areq_desc {
 	u64		src_dst_key;
 	u64		tslots;
+	bool	urgent;
 };
 
 /**
@@ -42,6 +42,19 @@ void pacer_init_full(struct fp_pacer *pa, u64 now, u32 cost, u32 max_credit,
 	pa->min_gap = min_gap;
 }
 
+/**
+ * Changes the pacer's parameters, keeping its accumulated credit. Credit
+ *    beyond the new @max_credit is discarded on the next reset.
+ */
+static inline
+void pacer_update_params(struct fp_pacer *pa, u32 cost, u32 max_credit,
+		u32 min_gap)
+{
+	pa->cost = cost;
+	pa->max_credit = max_credit;
+	pa->min_gap = min_gap;
+}
+
 /**
  * @return true if the event is pending, false otherwise
  */
@@ -84,5 +97,19 @@ static inline void pacer_reset(struct fp_pacer *pa)
 	pa->next_event = PACER_NO_NEXT_EVENT;
 }
 
+/**
+ * Takes a triggered event right away if the bucket holds credit for it,
+ *    without waiting for min_gap. Used to send several events in one burst.
+ * @return true if the event was taken, false if it has to wait
+ */
+static inline bool pacer_take_burst(struct fp_pacer *pa, u64 now)
+{
+	if (!pacer_is_triggered(pa) || now < pa->T + pa->cost)
+		return false;
+
+	pa->T = max_t(u64, pa->T, now - pa->max_credit) + pa->cost;
+	pa->next_event = PACER_NO_NEXT_EVENT;
+	return true;
+}
 
 #endif /* FP_PACER_H_ */
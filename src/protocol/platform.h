@@ -10,6 +10,8 @@
 
 #ifdef __KERNEL__
 #include "../kernel-mod/linux-platform.h"
+#elif defined(FASTPASS_ENDPOINT)
+#include "platform/userspace.h"
 #else
 #include "../arbiter/dpdk-platform.h"
 #endif
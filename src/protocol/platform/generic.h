@@ -124,6 +124,11 @@ typedef uint8_t u8;
 	type __max2 = (y);			\
 	__max1 > __max2 ? __max1: __max2; })
 
+#define min_t(type, x, y) ({			\
+	type __min1 = (x);			\
+	type __min2 = (y);			\
+	__min1 < __min2 ? __min1: __min2; })
+
 /* typecheck.h */
 #define typecheck(type,x) \
 ({	type __dummy; \
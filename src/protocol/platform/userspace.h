@@ -0,0 +1,205 @@
+/*
+ * userspace.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+/**
+ * Platform for userspace builds of the endpoint: the kernel primitives that
+ *    endpoint.c uses, and an emulated clock that only moves when the user
+ *    sets fp_emu_now_ns, so runs are deterministic.
+ *
+ * Atomics and locks are real, but per-CPU data is kept in a single copy.
+ */
+#ifndef FP_PROTO_PLATFORM_USERSPACE_H_
+#define FP_PROTO_PLATFORM_USERSPACE_H_
+
+#include <stddef.h>
+#include "generic.h"
+#include "debug.h"
+
+#define __percpu
+
+#define ACCESS_ONCE(x)			(*(volatile typeof(x) *)&(x))
+#define smp_mb()				__sync_synchronize()
+#define prefetchw(x)			__builtin_prefetch((x), 1)
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define BUILD_BUG_ON_MSG(cond, msg)	_Static_assert(!(cond), msg)
+
+#define FASTPASS_WARN(fmt, a...)	fprintf(stderr, "%s: " fmt, __func__, ##a)
+#define FASTPASS_CRIT(fmt, a...)	fprintf(stderr, fmt " at %s:%d/%s()\n", \
+										##a, __FILE__, __LINE__, __func__)
+
+#define FASTPASS_PR_DEBUG(enable, fmt, a...)	do { if (enable)	     \
+							printf("%s: " fmt, __func__, ##a); \
+						} while(0)
+
+/* bitops.h */
+static inline int fls(unsigned int x)
+{
+	return x ? 32 - __builtin_clz(x) : 0;
+}
+
+static inline int fls64(u64 x)
+{
+	return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+/* atomic64 */
+typedef struct {
+	s64 counter;
+} atomic64_t;
+
+static inline s64 atomic64_read(const atomic64_t *v)
+{
+	return __atomic_load_n(&v->counter, __ATOMIC_RELAXED);
+}
+
+static inline void atomic64_set(atomic64_t *v, s64 i)
+{
+	__atomic_store_n(&v->counter, i, __ATOMIC_RELAXED);
+}
+
+static inline void atomic64_add(s64 i, atomic64_t *v)
+{
+	__atomic_add_fetch(&v->counter, i, __ATOMIC_RELAXED);
+}
+
+static inline s64 atomic64_add_return(s64 i, atomic64_t *v)
+{
+	return __atomic_add_fetch(&v->counter, i, __ATOMIC_SEQ_CST);
+}
+
+static inline s64 atomic64_sub_return(s64 i, atomic64_t *v)
+{
+	return __atomic_sub_fetch(&v->counter, i, __ATOMIC_SEQ_CST);
+}
+
+static inline s64 atomic64_cmpxchg(atomic64_t *v, s64 old, s64 new)
+{
+	__atomic_compare_exchange_n(&v->counter, &old, new, false,
+			__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return old;
+}
+
+/* spinlock */
+typedef struct {
+	volatile int locked;
+} spinlock_t;
+
+static inline void spin_lock_init(spinlock_t *lock)
+{
+	lock->locked = 0;
+}
+
+static inline void spin_lock(spinlock_t *lock)
+{
+	while (__sync_lock_test_and_set(&lock->locked, 1))
+		while (lock->locked);
+}
+
+static inline void spin_unlock(spinlock_t *lock)
+{
+	__sync_lock_release(&lock->locked);
+}
+
+/* list.h, the parts the endpoint uses */
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define LIST_HEAD(name) \
+	struct list_head name = { &(name), &(name) }
+
+#define list_entry(ptr, type, member) \
+	container_of(ptr, type, member)
+
+#define list_first_entry(ptr, type, member) \
+	list_entry((ptr)->next, type, member)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+	return head->next == head;
+}
+
+static inline void list_add_tail(struct list_head *new, struct list_head *head)
+{
+	new->next = head;
+	new->prev = head->prev;
+	head->prev->next = new;
+	head->prev = new;
+}
+
+static inline void list_del_init(struct list_head *entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+	INIT_LIST_HEAD(entry);
+}
+
+/* percpu_counter, as a single atomic counter */
+struct percpu_counter {
+	atomic64_t count;
+};
+
+static inline int percpu_counter_init(struct percpu_counter *fbc, s64 amount)
+{
+	atomic64_set(&fbc->count, amount);
+	return 0;
+}
+
+static inline void percpu_counter_destroy(struct percpu_counter *fbc)
+{
+}
+
+static inline void percpu_counter_add(struct percpu_counter *fbc, s64 amount)
+{
+	atomic64_add(amount, &fbc->count);
+}
+
+static inline void percpu_counter_set(struct percpu_counter *fbc, s64 amount)
+{
+	atomic64_set(&fbc->count, amount);
+}
+
+static inline s64 percpu_counter_read(struct percpu_counter *fbc)
+{
+	return atomic64_read(&fbc->count);
+}
+
+static inline s64 percpu_counter_sum(struct percpu_counter *fbc)
+{
+	return atomic64_read(&fbc->count);
+}
+
+/* the emulated clock, in ns. Defined in endpoint.c */
+extern u64 fp_emu_now_ns;
+
+static inline u64 fp_get_time_ns(void)
+{
+	return fp_emu_now_ns;
+}
+
+static inline u64 fp_monotonic_time_ns(void)
+{
+	return fp_emu_now_ns;
+}
+
+/* packet descriptors are malloc'd by the tests */
+struct fpproto_pktdesc;
+
+static inline void fpproto_pktdesc_free(struct fpproto_pktdesc *pd)
+{
+	free(pd);
+}
+
+#endif /* FP_PROTO_PLATFORM_USERSPACE_H_ */
@@ -242,9 +242,8 @@ static inline bool wnd_at_or_after(struct fp_window *wnd, u64 seqno, u64 *out_se
 	if (unlikely(wnd_seq_before(wnd, seqno))) {
 		if (wnd_empty(wnd))
 			return false;
-		else
-			*out_seqno = wnd_earliest_marked(wnd);
-			return true;
+		*out_seqno = wnd_earliest_marked(wnd);
+		return true;
 	}
 
 	/* check seqno's word in marked */
@@ -0,0 +1,101 @@
+'''
+Created on October 18, 2026
+
+Tests of the Python 3 bulk bindings (fpbulk). Buffers are array.arrays here;
+numpy arrays of the same dtypes work the same way.
+'''
+import array
+import sys
+import unittest
+
+sys.path.insert(0, '../../bindings/graph-algo')
+
+import fpbulk
+
+class Test(unittest.TestCase):
+
+    def alloc_buffers(self, num_batches, max_edges):
+        sizes = array.array('H', [0] * (num_batches * fpbulk.BATCH_SIZE))
+        src = array.array('H', [0] * max_edges)
+        dst = array.array('H', [0] * max_edges)
+        return sizes, src, dst
+
+    def test_one_request(self):
+        """Basic test involving one src/dst pair."""
+        alloc = fpbulk.Allocator(2)
+        alloc.add_backlog(array.array('H', [0]), array.array('H', [1]),
+                          array.array('I', [5]))
+
+        sizes, src, dst = self.alloc_buffers(2, 64)
+        n = alloc.allocate(sizes, src, dst, num_batches=2)
+
+        # one packet admitted in each of the first 5 timeslots
+        self.assertEqual(n, 5)
+        self.assertEqual(list(sizes[:5]), [1] * 5)
+        self.assertEqual(sum(sizes), 5)
+        self.assertEqual(list(src[:5]), [0] * 5)
+        self.assertEqual(list(dst[:5]), [1] * 5)
+
+    def test_admitted_is_matching(self):
+        """Each timeslot admits each src and each dst at most once, and
+        serves no more than the demand."""
+        num_nodes = 64
+        num_batches = 64
+        duration = num_batches * fpbulk.BATCH_SIZE
+        max_requests = duration * num_nodes
+        req_src = array.array('H', [0] * max_requests)
+        req_dst = array.array('H', [0] * max_requests)
+        req_backlog = array.array('H', [0] * max_requests)
+        req_time = array.array('I', [0] * max_requests)
+        n_req = fpbulk.generate_requests(req_src, req_dst, req_backlog,
+                                         req_time, num_nodes, duration, 0.9,
+                                         10)
+        self.assertTrue(n_req > 0)
+
+        alloc = fpbulk.Allocator(num_nodes)
+        alloc.add_backlog(req_src[:n_req], req_dst[:n_req],
+                          array.array('I', req_backlog[:n_req]))
+
+        sizes, src, dst = self.alloc_buffers(num_batches, duration * num_nodes)
+        n = alloc.allocate(sizes, src, dst, num_batches=num_batches)
+        self.assertEqual(n, sum(sizes))
+
+        demand = {}
+        for i in range(n_req):
+            pair = (req_src[i], req_dst[i])
+            demand[pair] = demand.get(pair, 0) + req_backlog[i]
+
+        served = {}
+        start = 0
+        for size in sizes:
+            edges = list(zip(src[start:start + size], dst[start:start + size]))
+            self.assertEqual(len(set(s for s, d in edges)), size)
+            self.assertEqual(len(set(d for s, d in edges)), size)
+            for pair in edges:
+                served[pair] = served.get(pair, 0) + 1
+            start += size
+        for pair, count in served.items():
+            self.assertTrue(count <= demand[pair])
+
+    def test_bad_buffers(self):
+        """Buffers of the wrong element size or length, and read-only output
+        buffers, are rejected."""
+        alloc = fpbulk.Allocator(4)
+        with self.assertRaises(TypeError):
+            alloc.add_backlog(array.array('I', [0]), array.array('H', [1]),
+                              array.array('I', [1]))
+        with self.assertRaises(ValueError):
+            alloc.add_backlog(array.array('H', [0, 1]), array.array('H', [1]),
+                              array.array('I', [1]))
+        with self.assertRaises(ValueError):
+            alloc.add_backlog(array.array('H', [0]), array.array('H', [0]),
+                              array.array('I', [1]))
+        with self.assertRaises(ValueError):
+            alloc.allocate(array.array('H', [0]), array.array('H', [0]),
+                           array.array('H', [0]))
+        with self.assertRaises(BufferError):
+            alloc.allocate(bytes(2 * fpbulk.BATCH_SIZE),
+                           array.array('H', [0]), array.array('H', [0]))
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,96 @@
+/*
+ * alloc_bounds_test.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "../platform/generic.h"
+#include "../platform/debug.h"
+#include "../alloc_bounds.h"
+
+#define WASTE_SHIFT		8
+#define N_EPOCHS		32
+
+static u32 rand_state = 12345;
+
+static u32 next_rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return (rand_state >> 16) & 0x7FFF;
+}
+
+/**
+ * Synthetic arrival offset: most ALLOCs arrive up to @max_late timeslots late,
+ *    a few arrive up to @max_early timeslots early, and 1/512 are stragglers
+ *    that arrive @max_late * 4 late.
+ */
+static s64 synthetic_offset(u32 max_late, u32 max_early)
+{
+	u32 r = next_rand();
+
+	if (r % 512 == 0)
+		return -(s64)(4 * max_late);
+	if (r % 8 == 0)
+		return next_rand() % (max_early + 1);
+	return -(s64)(next_rand() % (max_late + 1));
+}
+
+/**
+ * Runs a phase of the trace. Returns the number of ALLOCs the current bounds
+ *    would have dropped.
+ */
+static u32 run_phase(struct fp_alloc_bounds *ab, u32 max_late, u32 max_early)
+{
+	u32 i;
+	u32 dropped = 0;
+	s64 offset;
+
+	for (i = 0; i < N_EPOCHS * ALLOC_BOUNDS_EPOCH; i++) {
+		offset = synthetic_offset(max_late, max_early);
+		if (offset < -(s64)ab->miss_threshold || offset > (s64)ab->max_preload)
+			dropped++;
+		alloc_bounds_observe(ab, offset);
+	}
+	return dropped;
+}
+
+/* test */
+int main(void) {
+	struct fp_alloc_bounds ab;
+	u32 dropped;
+
+	/* starts out with the configured bounds */
+	alloc_bounds_init(&ab, 64, 64, WASTE_SHIFT);
+	FASTPASS_BUG_ON(ab.miss_threshold != 64);
+	FASTPASS_BUG_ON(ab.max_preload != 64);
+
+	/* loaded arbiter: window covers the lateness, but not the stragglers */
+	run_phase(&ab, 24, 4);
+	FASTPASS_BUG_ON(ab.n_adjustments != N_EPOCHS);
+	FASTPASS_BUG_ON(ab.miss_threshold < 24);
+	FASTPASS_BUG_ON(ab.miss_threshold >= 4 * 24);
+	FASTPASS_BUG_ON(ab.max_preload < 4 - 1 || ab.max_preload > 4);
+	dropped = run_phase(&ab, 24, 4);
+	/* stragglers are dropped, little else is */
+	FASTPASS_BUG_ON(dropped > 2 * (N_EPOCHS * ALLOC_BOUNDS_EPOCH) / 512);
+
+	/* idle arbiter: window shrinks with the lateness */
+	run_phase(&ab, 3, 1);
+	FASTPASS_BUG_ON(ab.miss_threshold > 3);
+	FASTPASS_BUG_ON(ab.max_preload != ALLOC_BOUNDS_MIN);
+
+	/* and grows back under load */
+	run_phase(&ab, 40, 4);
+	FASTPASS_BUG_ON(ab.miss_threshold < 40);
+
+	/* configured bounds cap the adaptive ones */
+	alloc_bounds_set_max(&ab, 16, 1);
+	FASTPASS_BUG_ON(ab.miss_threshold != 16);
+	FASTPASS_BUG_ON(ab.max_preload != 1);
+	run_phase(&ab, 40, 4);
+	FASTPASS_BUG_ON(ab.miss_threshold != 16);
+	FASTPASS_BUG_ON(ab.max_preload != 1);
+
+	printf("done testing alloc_bounds, quitting\n");
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * arbiter_role_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Unit test of the master/standby role helpers of arbiter_role.h, on an
+ *    emulated clock: a standby fed watchdogs every WATCHDOG_PACKET_GAP_SEC
+ *    stays standby, takes over once the watchdogs stop for longer than
+ *    WATCHDOG_TRIGGER_THRESHOLD_SEC, and then resyncs every node exactly once.
+ *    It also prints the failover gap the helpers give when nodes retransmit
+ *    their requests every RETRANS_TIMEOUT_NS after the master dies.
+ *
+ * This does not run the arbiter's comm core, which needs DPDK; the watchdog
+ *    rx loop, gratuitous ARP and connection resets of the failover path are
+ *    not covered here, and the printed gap is of the role logic alone, not a
+ *    measurement of the arbiter.
+ */
+
+#include "../platform/generic.h"
+#include "../platform/debug.h"
+#include "../arbiter_role.h"
+
+#define N_TEST_NODES			16
+#define WATCHDOG_GAP_NS			(100 * 1000)		/* WATCHDOG_PACKET_GAP_SEC */
+#define TAKEOVER_THRESHOLD_NS	(2 * 1000 * 1000)	/* WATCHDOG_TRIGGER_THRESHOLD_SEC */
+#define STEP_NS					(10 * 1000)
+#define KILL_MASTER_AT_NS		(50 * 1000 * 1000)
+#define RETRANS_TIMEOUT_NS		(200 * 1000)		/* sch_fastpass default */
+
+static struct fp_arb_role role;
+
+/* a master never takes over, whatever the watchdog silence */
+static void test_master(void)
+{
+	u64 now = 1ULL << 40;
+
+	arb_role_init(&role, true, now, TAKEOVER_THRESHOLD_NS);
+	FASTPASS_BUG_ON(!arb_role_is_master(&role));
+	FASTPASS_BUG_ON(arb_role_should_take_over(&role,
+			now + 100 * TAKEOVER_THRESHOLD_NS));
+	/* nodes of a master that did not take over need no resync */
+	FASTPASS_BUG_ON(arb_role_needs_resync(&role, 0));
+	FASTPASS_BUG_ON(role.n_takeovers != 0);
+}
+
+/* the standby takes over within a step of the threshold after the last
+ * watchdog, and not while watchdogs arrive */
+static void test_takeover(void)
+{
+	u64 start = 1ULL << 40;
+	u64 now = start;
+	u64 last_watchdog = 0;
+	u64 took_over_at = 0;
+
+	arb_role_init(&role, false, now, TAKEOVER_THRESHOLD_NS);
+	FASTPASS_BUG_ON(arb_role_is_master(&role));
+
+	for (; now - start < KILL_MASTER_AT_NS + 2 * TAKEOVER_THRESHOLD_NS;
+			now += STEP_NS) {
+		if (now - start < KILL_MASTER_AT_NS
+				&& now - last_watchdog >= WATCHDOG_GAP_NS) {
+			arb_role_saw_watchdog(&role, now);
+			last_watchdog = now;
+		}
+		if (arb_role_should_take_over(&role, now)) {
+			FASTPASS_BUG_ON(took_over_at != 0);
+			arb_role_take_over(&role, now);
+			took_over_at = now;
+		}
+	}
+
+	FASTPASS_BUG_ON(!arb_role_is_master(&role));
+	FASTPASS_BUG_ON(role.n_takeovers != 1);
+	FASTPASS_BUG_ON(role.took_over_at != took_over_at);
+	FASTPASS_BUG_ON(took_over_at - last_watchdog <= TAKEOVER_THRESHOLD_NS);
+	FASTPASS_BUG_ON(took_over_at - last_watchdog
+			> TAKEOVER_THRESHOLD_NS + STEP_NS);
+}
+
+/* after the takeover, the first packet of each node asks for a reset */
+static void test_resync(void)
+{
+	int i;
+
+	for (i = 0; i < N_TEST_NODES; i++)
+		FASTPASS_BUG_ON(!arb_role_needs_resync(&role, i));
+	for (i = 0; i < N_TEST_NODES; i++)
+		FASTPASS_BUG_ON(arb_role_needs_resync(&role, i));
+
+	/* including the last node id */
+	FASTPASS_BUG_ON(!arb_role_needs_resync(&role, MAX_NODES - 1));
+	FASTPASS_BUG_ON(arb_role_needs_resync(&role, MAX_NODES - 1));
+}
+
+/* the silence is measured correctly across a clock wraparound */
+static void test_clock_wrap(void)
+{
+	u64 now = -(u64)TAKEOVER_THRESHOLD_NS / 2;
+
+	arb_role_init(&role, false, now, TAKEOVER_THRESHOLD_NS);
+	now += TAKEOVER_THRESHOLD_NS;
+	FASTPASS_BUG_ON(arb_role_should_take_over(&role, now));
+	now += STEP_NS;
+	FASTPASS_BUG_ON(!arb_role_should_take_over(&role, now));
+}
+
+/**
+ * The master dies between two watchdogs. Each node retransmits its request
+ *    every RETRANS_TIMEOUT_NS, at its own phase, and the standby resets a
+ *    node's connection on its first packet after the takeover. Prints the
+ *    time from the master's death to the takeover and to the last reset.
+ */
+static void test_failover_gap(void)
+{
+	u64 start = 1ULL << 40;
+	u64 killed_at = start + KILL_MASTER_AT_NS;
+	u64 now;
+	u64 took_over_at = 0;
+	u64 last_resync_at = 0;
+	u64 phase;
+	int n_resynced = 0;
+	int i;
+
+	arb_role_init(&role, false, start, TAKEOVER_THRESHOLD_NS);
+
+	for (now = start; n_resynced < N_TEST_NODES; now += STEP_NS) {
+		if (time_before64(now, killed_at)) {
+			if ((now - start) % WATCHDOG_GAP_NS == 0)
+				arb_role_saw_watchdog(&role, now);
+			continue;
+		}
+		FASTPASS_BUG_ON(now - killed_at > 10 * TAKEOVER_THRESHOLD_NS);
+		if (arb_role_should_take_over(&role, now)) {
+			arb_role_take_over(&role, now);
+			took_over_at = now;
+		}
+		if (!arb_role_is_master(&role))
+			continue;
+		for (i = 0; i < N_TEST_NODES; i++) {
+			/* node i sends at a multiple of STEP_NS near its phase */
+			phase = (u64)i * RETRANS_TIMEOUT_NS / N_TEST_NODES;
+			if ((now - start) % RETRANS_TIMEOUT_NS
+					!= phase - phase % STEP_NS)
+				continue;
+			if (arb_role_needs_resync(&role, i)) {
+				n_resynced++;
+				last_resync_at = now;
+			}
+		}
+	}
+
+	FASTPASS_BUG_ON(took_over_at - killed_at
+			> TAKEOVER_THRESHOLD_NS + WATCHDOG_GAP_NS + STEP_NS);
+	FASTPASS_BUG_ON(last_resync_at - took_over_at > RETRANS_TIMEOUT_NS);
+	printf("master killed: took over after %llu us, all %d nodes reset after "
+			"%llu us\n", (took_over_at - killed_at) / 1000, N_TEST_NODES,
+			(last_resync_at - killed_at) / 1000);
+}
+
+/* test */
+int main(void) {
+	test_master();
+	test_takeover();
+	test_resync();
+	test_clock_wrap();
+	test_failover_gap();
+
+	printf("done testing arbiter role, quitting\n");
+	return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * demand_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Measures fpep_inc_demand, which every enqueued packet calls, from a growing
+ *    number of threads: as is, with lockless per-destination counters, and
+ *    with each call serialized by a per-destination spinlock, as enqueue did
+ *    before the counters became atomic. Threads either all add demand to the
+ *    same destination, or each to its own.
+ *
+ * Results only mean something with at least as many CPUs as threads: a
+ *    preempted lock holder stalls the other threads for a whole time slice.
+ *
+ * usage: demand_bench [n_ops_per_thread] [max_threads]
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include "../platform/generic.h"
+#include "../platform/debug.h"
+#include "../endpoint.h"
+
+#define TSLOT_MUL		1
+#define TSLOT_SHIFT		10
+#define MAX_THREADS		64
+
+struct dst_lock {
+	spinlock_t	lock;
+} __attribute__((aligned(64)));
+
+struct bench_thread {
+	pthread_t	thread;
+	u32			dst_id;
+	bool		locked;
+};
+
+static struct fp_endpoint ep;
+static struct fp_sched_stat stat;
+static struct dst_lock dst_locks[MAX_NODES];
+static struct bench_thread threads[MAX_THREADS];
+static pthread_barrier_t start_barrier;
+static u32 n_ops;
+
+static void bench_admit(void *param, u64 *dst_ids, u32 *n_tslots, int n)
+{
+}
+
+static void bench_trigger_request(void *param)
+{
+}
+
+static void bench_force_reset(void *param)
+{
+	FASTPASS_BUG();
+}
+
+static struct fpep_ops bench_ops = {
+	.admit				= &bench_admit,
+	.trigger_request	= &bench_trigger_request,
+	.force_reset		= &bench_force_reset,
+};
+
+static u64 get_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *bench_thread_main(void *arg)
+{
+	struct bench_thread *t = (struct bench_thread *)arg;
+	spinlock_t *lock = &dst_locks[t->dst_id].lock;
+	u32 i;
+
+	pthread_barrier_wait(&start_barrier);
+	if (t->locked) {
+		for (i = 0; i < n_ops; i++) {
+			spin_lock(lock);
+			fpep_inc_demand(&ep, t->dst_id, 1);
+			spin_unlock(lock);
+		}
+	} else {
+		for (i = 0; i < n_ops; i++)
+			fpep_inc_demand(&ep, t->dst_id, 1);
+	}
+	return NULL;
+}
+
+/**
+ * Runs @n_threads threads that each add demand @n_ops times, to the same
+ *    destination if @shared_dst, and prints the aggregate rate.
+ */
+static void run(int n_threads, bool shared_dst, bool locked)
+{
+	u64 start, elapsed;
+	u64 total_ops = (u64)n_threads * n_ops;
+	int i;
+
+	fp_emu_now_ns = 1ULL << 40;
+	memset(&stat, 0, sizeof(stat));
+	FASTPASS_BUG_ON(fpep_init(&ep, &bench_ops, NULL, &stat, TSLOT_MUL,
+			TSLOT_SHIFT, fp_emu_now_ns) != 0);
+	for (i = 0; i < MAX_NODES; i++)
+		spin_lock_init(&dst_locks[i].lock);
+	FASTPASS_BUG_ON(pthread_barrier_init(&start_barrier, NULL,
+			n_threads + 1) != 0);
+
+	for (i = 0; i < n_threads; i++) {
+		threads[i].dst_id = shared_dst ? 1 : 1 + i;
+		threads[i].locked = locked;
+		FASTPASS_BUG_ON(pthread_create(&threads[i].thread, NULL,
+				&bench_thread_main, &threads[i]) != 0);
+	}
+
+	pthread_barrier_wait(&start_barrier);
+	start = get_ns();
+	for (i = 0; i < n_threads; i++)
+		pthread_join(threads[i].thread, NULL);
+	elapsed = get_ns() - start;
+
+	FASTPASS_BUG_ON(percpu_counter_sum(&ep.demand_tslots) != total_ops);
+	printf("%2d threads %s dst %-9s: %7.1f ns/thread op %7.2f Mops/s\n",
+			n_threads, shared_dst ? "shared" : "own   ",
+			locked ? "dst lock" : "lockless",
+			(double)elapsed / n_ops,
+			(double)total_ops * 1000 / elapsed);
+
+	pthread_barrier_destroy(&start_barrier);
+	fpep_destroy(&ep);
+}
+
+int main(int argc, char **argv)
+{
+	int max_threads = 16;
+	int n_threads;
+
+	n_ops = 1000000;
+	if (argc > 1)
+		n_ops = atoi(argv[1]);
+	if (argc > 2)
+		max_threads = atoi(argv[2]);
+	FASTPASS_BUG_ON(max_threads < 1 || max_threads > MAX_THREADS);
+
+	for (n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+		run(n_threads, true, false);
+		run(n_threads, true, true);
+		run(n_threads, false, false);
+		run(n_threads, false, true);
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * endpoint_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Measures the cost of handling an ALLOC in the endpoint control loop, with
+ *    the emulated clock frozen so every ALLOC decodes the same way.
+ *
+ * usage: endpoint_bench [n_allocs]
+ */
+
+#include <time.h>
+
+#include "../platform/generic.h"
+#include "../platform/debug.h"
+#include "../endpoint.h"
+
+#define TSLOT_MUL		1
+#define TSLOT_SHIFT		10
+#define WINDOW			64
+
+static struct fp_endpoint ep;
+static struct fp_sched_stat stat;
+static u64 n_admitted;
+
+static void bench_admit(void *param, u64 *dst_ids, u32 *n_tslots, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		n_admitted += n_tslots[i];
+}
+
+static void bench_trigger_request(void *param)
+{
+}
+
+static void bench_force_reset(void *param)
+{
+	FASTPASS_BUG();
+}
+
+static struct fpep_ops bench_ops = {
+	.admit				= &bench_admit,
+	.trigger_request	= &bench_trigger_request,
+	.force_reset		= &bench_force_reset,
+};
+
+static u64 get_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Handles @n_allocs ALLOCs of @n_tslots timeslots spread over @n_dst
+ *    destinations, and prints the cost per ALLOC and per timeslot.
+ */
+static void run(u32 n_allocs, int n_dst, int n_tslots)
+{
+	u16 dst_ids[FASTPASS_ALLOC_MAX_DSTS];
+	u8 specs[FASTPASS_ALLOC_MAX_TSLOTS];
+	u64 now_tslot;
+	u64 start, elapsed;
+	u32 i;
+	int j;
+
+	fp_emu_now_ns = 1ULL << 40;
+	memset(&stat, 0, sizeof(stat));
+	FASTPASS_BUG_ON(fpep_init(&ep, &bench_ops, NULL, &stat, TSLOT_MUL,
+			TSLOT_SHIFT, fp_emu_now_ns) != 0);
+	ep.miss_threshold = WINDOW;
+	ep.max_preload = WINDOW;
+	ep.req_max_age_ns = 1 << 20;
+	alloc_bounds_init(&ep.alloc_bounds, WINDOW, WINDOW, 8);
+	now_tslot = (fp_emu_now_ns * TSLOT_MUL) >> TSLOT_SHIFT;
+
+	/* enough demand that every timeslot is admitted */
+	for (j = 0; j < n_dst; j++) {
+		dst_ids[j] = 1 + 13 * j;
+		fpep_inc_demand(&ep, dst_ids[j], (u64)n_allocs * n_tslots);
+	}
+
+	/* consecutive timeslots centered on now, round-robin over the dsts */
+	for (j = 0; j < n_tslots; j++)
+		specs[j] = (1 + j % n_dst) << 4;
+
+	n_admitted = 0;
+	start = get_ns();
+	for (i = 0; i < n_allocs; i++)
+		fpep_handle_alloc(&ep, (u32)(now_tslot - n_tslots / 2 - 1), dst_ids,
+				n_dst, specs, n_tslots);
+	elapsed = get_ns() - start;
+
+	FASTPASS_BUG_ON(n_admitted != (u64)n_allocs * n_tslots);
+	printf("%2d dsts %3d tslots: %8.1f ns/ALLOC %6.2f ns/timeslot\n", n_dst,
+			n_tslots, (double)elapsed / n_allocs,
+			(double)elapsed / ((double)n_allocs * n_tslots));
+	fpep_destroy(&ep);
+}
+
+int main(int argc, char **argv)
+{
+	u32 n_allocs = 1000000;
+
+	if (argc > 1)
+		n_allocs = atoi(argv[1]);
+
+	run(n_allocs, 1, 16);
+	run(n_allocs, 1, WINDOW);
+	run(n_allocs, 4, WINDOW);
+	run(n_allocs, FASTPASS_ALLOC_MAX_DSTS, WINDOW);
+	run(n_allocs, FASTPASS_ALLOC_MAX_DSTS, 2 * WINDOW - 2);
+	return 0;
+}
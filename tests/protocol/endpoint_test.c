@@ -0,0 +1,325 @@
+/*
+ * endpoint_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Runs the endpoint control loop against a fake scheduler and a fake control
+ *    socket, on the emulated clock.
+ */
+
+#include "../platform/generic.h"
+#include "../platform/debug.h"
+#include "../endpoint.h"
+
+#define TSLOT_MUL		1
+#define TSLOT_SHIFT		10		/* ~1us timeslots */
+
+static struct fp_endpoint ep;
+static struct fp_sched_stat stat;
+
+/* fake scheduler: counts admitted timeslots per destination */
+static u64 admitted[MAX_NODES];
+static u32 n_triggers;
+static u32 n_force_resets;
+
+static void fake_admit(void *param, u64 *dst_ids, u32 *n_tslots, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		admitted[dst_ids[i]] += n_tslots[i];
+}
+
+static void fake_trigger_request(void *param)
+{
+	n_triggers++;
+}
+
+static void fake_force_reset(void *param)
+{
+	n_force_resets++;
+}
+
+static struct fpep_ops fake_ops = {
+	.admit				= &fake_admit,
+	.trigger_request	= &fake_trigger_request,
+	.force_reset		= &fake_force_reset,
+};
+
+static void setup(void)
+{
+	fp_emu_now_ns = 1ULL << 40;
+	memset(&stat, 0, sizeof(stat));
+	memset(admitted, 0, sizeof(admitted));
+	n_triggers = 0;
+	n_force_resets = 0;
+
+	FASTPASS_BUG_ON(fpep_init(&ep, &fake_ops, NULL, &stat, TSLOT_MUL,
+			TSLOT_SHIFT, fp_emu_now_ns) != 0);
+	ep.miss_threshold = 16;
+	ep.max_preload = 64;
+	ep.req_max_age_ns = 1000000;
+	ep.adaptive_bounds = false;
+	alloc_bounds_init(&ep.alloc_bounds, ep.miss_threshold, ep.max_preload, 8);
+}
+
+static u64 now_tslot(void)
+{
+	return (fp_emu_now_ns * TSLOT_MUL) >> TSLOT_SHIFT;
+}
+
+/* fake control socket: what goes on the wire is what the endpoint fills in */
+static void send_request(struct fpproto_pktdesc *pd)
+{
+	memset(pd, 0, sizeof(*pd));
+	fpep_fill_request(&ep, pd, fp_emu_now_ns);
+}
+
+/**
+ * Delivers an ALLOC of @n_tslots consecutive timeslots to @dst, starting
+ *    @offset timeslots from now.
+ */
+static void deliver_alloc(u16 dst, s64 offset, int n_tslots)
+{
+	u8 specs[FASTPASS_ALLOC_MAX_TSLOTS];
+	u32 base = (u32)(now_tslot() + offset - 1);
+	int i;
+
+	for (i = 0; i < n_tslots; i++)
+		specs[i] = 1 << 4;	/* dst index 1, next timeslot */
+	fpep_handle_alloc(&ep, base, &dst, 1, specs, n_tslots);
+}
+
+static void deliver_report(u16 dst, u16 count)
+{
+	u16 dst_and_count[2] = { htons(dst), htons(count) };
+	fpep_handle_areq(&ep, dst_and_count, 1);
+}
+
+/* requests go out largest demand first, and ALLOCs are admitted */
+static void test_request_ack_alloc(void)
+{
+	struct fpproto_pktdesc pd;
+
+	setup();
+	fpep_inc_demand(&ep, 5, 3);
+	fpep_inc_demand(&ep, 7, 100);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 2);
+	FASTPASS_BUG_ON(n_triggers == 0);
+
+	send_request(&pd);
+	FASTPASS_BUG_ON(pd.n_areq != 2);
+	FASTPASS_BUG_ON(pd.areq[0].src_dst_key != 7 || pd.areq[0].tslots != 100);
+	FASTPASS_BUG_ON(pd.areq[1].src_dst_key != 5 || pd.areq[1].tslots != 3);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 0);
+	FASTPASS_BUG_ON(ep.requested_tslots != 103);
+
+	fpep_handle_ack(&ep, &pd);
+	FASTPASS_BUG_ON(ep.acked_tslots != 103);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 0);
+
+	deliver_alloc(5, 0, 3);
+	FASTPASS_BUG_ON(admitted[5] != 3);
+	FASTPASS_BUG_ON(stat.admitted_timeslots != 3);
+	FASTPASS_BUG_ON(!fpep_has_pending_demand(&ep));
+
+	deliver_alloc(7, 1, 100);
+	FASTPASS_BUG_ON(stat.alloc_premature == 0);	/* beyond max_preload */
+	FASTPASS_BUG_ON(admitted[7] != ep.max_preload);
+	deliver_alloc(7, 0, 100 - ep.max_preload);
+	FASTPASS_BUG_ON(admitted[7] != 100);
+	FASTPASS_BUG_ON(fpep_has_pending_demand(&ep));
+
+	/* more timeslots than demand are not admitted */
+	deliver_alloc(5, 0, 2);
+	FASTPASS_BUG_ON(admitted[5] != 3);
+	FASTPASS_BUG_ON(stat.unwanted_alloc != 2);
+	fpep_destroy(&ep);
+}
+
+/* lost requests are sent again, unless acked meanwhile */
+static void test_neg_ack(void)
+{
+	struct fpproto_pktdesc pd, pd2;
+
+	setup();
+	fpep_inc_demand(&ep, 9, 4);
+	send_request(&pd);
+	FASTPASS_BUG_ON(pd.n_areq != 1);
+
+	fpep_handle_neg_ack(&ep, &pd);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 1);
+	send_request(&pd2);
+	FASTPASS_BUG_ON(pd2.n_areq != 1 || pd2.areq[0].tslots != 4);
+
+	fpep_handle_ack(&ep, &pd2);
+	fpep_handle_neg_ack(&ep, &pd);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 0);
+	fpep_destroy(&ep);
+}
+
+/* ALLOCs outside the acceptance window and to unknown dsts are dropped */
+static void test_dropped_allocs(void)
+{
+	struct fpproto_pktdesc pd;
+	u16 bad_dst = MAX_NODES;
+	u8 spec = 1 << 4;
+
+	setup();
+	fpep_inc_demand(&ep, 3, 10);
+	send_request(&pd);
+	fpep_handle_ack(&ep, &pd);
+
+	deliver_alloc(3, -(s64)ep.miss_threshold - 2, 1);
+	FASTPASS_BUG_ON(stat.alloc_too_late != 1);
+	deliver_alloc(3, ep.max_preload + 1, 1);
+	FASTPASS_BUG_ON(stat.alloc_premature != 1);
+	FASTPASS_BUG_ON(admitted[3] != 0);
+
+	fpep_handle_alloc(&ep, (u32)now_tslot(), &bad_dst, 1, &spec, 1);
+	FASTPASS_BUG_ON(stat.admitted_timeslots != 0);
+	fpep_destroy(&ep);
+}
+
+/* alloc reports recover lost ALLOCs, and reset on inconsistency */
+static void test_alloc_report(void)
+{
+	struct fpproto_pktdesc pd;
+
+	setup();
+	fpep_inc_demand(&ep, 11, 10);
+	send_request(&pd);
+	fpep_handle_ack(&ep, &pd);
+	deliver_alloc(11, 0, 2);
+
+	/* arbiter allocated 6, we saw 2: 4 were lost and are demanded again */
+	deliver_report(11, 6);
+	FASTPASS_BUG_ON(stat.timeslots_assumed_lost != 4);
+	FASTPASS_BUG_ON(atomic64_read(&ep.dsts[11].demand_tslots) != 14);
+	FASTPASS_BUG_ON(atomic64_read(&ep.dsts[11].alloc_tslots) != 6);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 1);
+	FASTPASS_BUG_ON(n_force_resets != 0);
+
+	/* a report beyond what was requested forces a reset */
+	deliver_report(11, 20);
+	FASTPASS_BUG_ON(n_force_resets != 1);
+
+	/* reset rebases the counters, keeping the unmet demand */
+	fpep_handle_reset(&ep);
+	FASTPASS_BUG_ON(atomic64_read(&ep.dsts[11].demand_tslots) != 8);
+	FASTPASS_BUG_ON(atomic64_read(&ep.dsts[11].used_tslots) != 0);
+	FASTPASS_BUG_ON(percpu_counter_sum(&ep.demand_tslots) != 8);
+	send_request(&pd);
+	FASTPASS_BUG_ON(pd.n_areq != 1 || pd.areq[0].tslots != 8);
+	fpep_destroy(&ep);
+}
+
+/* dsts that waited long are served ahead of larger ones */
+static void test_request_age(void)
+{
+	struct fpproto_pktdesc pd;
+	u32 i;
+
+	setup();
+	fpep_inc_demand(&ep, 1, 1);
+	fp_emu_now_ns += 2 * ep.req_max_age_ns;
+	for (i = 0; i < FASTPASS_PKT_MAX_AREQ; i++)
+		fpep_inc_demand(&ep, 100 + i, 1000);
+
+	send_request(&pd);
+	FASTPASS_BUG_ON(pd.n_areq != FASTPASS_PKT_MAX_AREQ);
+	FASTPASS_BUG_ON(pd.areq[0].src_dst_key != 1);
+	FASTPASS_BUG_ON(stat.aged_requests == 0);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 1);
+	fpep_destroy(&ep);
+}
+
+/**
+ * Encodes @pd as it goes on the wire, and decodes its A-REQs as the arbiter's
+ *    handle_areq does. Returns the number of A-REQs.
+ */
+static int wire_areqs(struct fpproto_pktdesc *pd, u16 *dst, u16 *count,
+		bool *urgent)
+{
+	u8 pkt[256];
+	u8 *curp = pkt + 8;		/* after the header */
+	u16 type;
+	u16 wire_dst;
+	int n;
+	int i;
+
+	FASTPASS_BUG_ON(fpproto_encode_packet(pd, pkt, sizeof(pkt), 0, 0, 0) < 0);
+	type = ntohs(*(__be16 *)curp);
+	FASTPASS_BUG_ON((type >> 12) != FASTPASS_PTYPE_AREQ);
+	n = type & 0x3F;
+	curp += 2;
+	for (i = 0; i < n; i++) {
+		wire_dst = ntohs(*(__be16 *)curp);
+		urgent[i] = !!(wire_dst & FASTPASS_AREQ_URGENT);
+		dst[i] = wire_dst & FASTPASS_AREQ_DST_MASK;
+		count[i] = ntohs(*(__be16 *)(curp + 2));
+		curp += 4;
+	}
+	return n;
+}
+
+/* urgent demand goes out first, flagged on the wire, on its own and again
+ * after a NACK; later demand follows once it is acked */
+static void test_urgent(void)
+{
+	struct fpproto_pktdesc pd;
+	u16 dst[FASTPASS_PKT_MAX_AREQ];
+	u16 count[FASTPASS_PKT_MAX_AREQ];
+	bool urgent[FASTPASS_PKT_MAX_AREQ];
+
+	setup();
+	fpep_inc_demand(&ep, 7, 100);
+	fpep_inc_demand(&ep, 5, 2);
+	fpep_mark_urgent(&ep, 5);
+	fpep_inc_demand(&ep, 5, 30);
+
+	/* the small urgent dst goes ahead of the larger one, with only its urgent
+	 * timeslots */
+	send_request(&pd);
+	FASTPASS_BUG_ON(wire_areqs(&pd, dst, count, urgent) != 2);
+	FASTPASS_BUG_ON(dst[0] != 5 || count[0] != 2 || !urgent[0]);
+	FASTPASS_BUG_ON(dst[1] != 7 || count[1] != 100 || urgent[1]);
+	FASTPASS_BUG_ON(stat.urgent_requests != 1);
+
+	/* a retransmit is still urgent */
+	fpep_handle_neg_ack(&ep, &pd);
+	send_request(&pd);
+	FASTPASS_BUG_ON(wire_areqs(&pd, dst, count, urgent) != 2);
+	FASTPASS_BUG_ON(dst[0] != 5 || count[0] != 2 || !urgent[0]);
+	FASTPASS_BUG_ON(stat.urgent_requests != 2);
+
+	/* once acked, the rest of the demand is requested as usual */
+	fpep_handle_ack(&ep, &pd);
+	FASTPASS_BUG_ON(fpep_n_unreq_dsts(&ep) != 1);
+	send_request(&pd);
+	FASTPASS_BUG_ON(wire_areqs(&pd, dst, count, urgent) != 1);
+	FASTPASS_BUG_ON(dst[0] != 5 || count[0] != 32 || urgent[0]);
+	fpep_handle_ack(&ep, &pd);
+
+	/* a reset rebases the urgent mark with the demand */
+	deliver_alloc(5, 0, 1);
+	fpep_mark_urgent(&ep, 5);
+	fpep_handle_reset(&ep);
+	FASTPASS_BUG_ON(atomic64_read(&ep.dsts[5].urgent_tslots) != 31);
+	send_request(&pd);
+	FASTPASS_BUG_ON(wire_areqs(&pd, dst, count, urgent) != 2);
+	FASTPASS_BUG_ON(dst[0] != 5 || count[0] != 31 || !urgent[0]);
+	fpep_destroy(&ep);
+}
+
+/* test */
+int main(void) {
+	test_request_ack_alloc();
+	test_neg_ack();
+	test_dropped_allocs();
+	test_alloc_report();
+	test_request_age();
+	test_urgent();
+
+	printf("done testing endpoint, quitting\n");
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * fpmux_demand_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Checks the demand accounting of a shared control connection, with two
+ *    members requesting the same destination.
+ */
+
+#include "../platform/generic.h"
+#include "../platform/debug.h"
+#include "../fpmux_demand.h"
+
+#define DST			5
+#define SLOT_A		0
+#define SLOT_B		1
+
+static struct fpmux_demand d;
+
+static u64 outstanding(struct fpmux_counters *c, u16 dst)
+{
+	return c->requested[dst] - c->assigned[dst];
+}
+
+/* what the connection is owed equals what its members and departed members
+ * are owed */
+static void check_invariant(u16 dst)
+{
+	u64 sum = d.abandoned[dst];
+	int slot;
+
+	for (slot = 0; slot < FPMUX_MAX_MEMBERS; slot++)
+		sum += outstanding(&d.member[slot], dst);
+	FASTPASS_BUG_ON(outstanding(&d.conn, dst) != sum);
+}
+
+/* allocations to a destination alternate between the members waiting on it */
+static void test_shared_dst(void)
+{
+	int owners[5];
+	int i;
+
+	fpmux_demand_reset(&d);
+	FASTPASS_BUG_ON(fpmux_demand_request(&d, SLOT_A, DST, 3) != 3);
+	FASTPASS_BUG_ON(fpmux_demand_request(&d, SLOT_B, DST, 2) != 5);
+	/* a retransmitted request does not add demand */
+	FASTPASS_BUG_ON(fpmux_demand_request(&d, SLOT_A, DST, 3) != 5);
+	check_invariant(DST);
+
+	for (i = 0; i < 5; i++)
+		owners[i] = fpmux_demand_claim(&d, DST, 1);
+	FASTPASS_BUG_ON(owners[0] != SLOT_A || owners[1] != SLOT_B);
+	FASTPASS_BUG_ON(owners[2] != SLOT_A || owners[3] != SLOT_B);
+	FASTPASS_BUG_ON(owners[4] != SLOT_A);
+	FASTPASS_BUG_ON(d.member[SLOT_A].assigned[DST] != 3);
+	FASTPASS_BUG_ON(d.member[SLOT_B].assigned[DST] != 2);
+	FASTPASS_BUG_ON(d.unclaimed != 0);
+	check_invariant(DST);
+
+	/* nobody asked for this one */
+	FASTPASS_BUG_ON(fpmux_demand_claim(&d, DST, 1) != -1);
+	FASTPASS_BUG_ON(d.unclaimed != 1);
+}
+
+/* a departing member's outstanding demand serves the remaining member */
+static void test_member_leaves(void)
+{
+	u64 conn_requested;
+	u64 unclaimed;
+	int i;
+
+	fpmux_demand_reset(&d);
+	d.unclaimed = 0;
+	fpmux_demand_request(&d, SLOT_A, DST, 10);
+	fpmux_demand_request(&d, SLOT_B, DST, 4);
+	for (i = 0; i < 4; i++)
+		fpmux_demand_claim(&d, DST, 1);
+	FASTPASS_BUG_ON(d.member[SLOT_A].assigned[DST] != 2);
+	FASTPASS_BUG_ON(d.member[SLOT_B].assigned[DST] != 2);
+
+	/* A leaves owed 8 timeslots */
+	fpmux_demand_leave(&d, SLOT_A);
+	FASTPASS_BUG_ON(d.abandoned[DST] != 8);
+	FASTPASS_BUG_ON(d.member[SLOT_A].requested[DST] != 0);
+	check_invariant(DST);
+
+	/* B's next 5 timeslots come out of A's, so the connection asks for no
+	 * more */
+	conn_requested = d.conn.requested[DST];
+	FASTPASS_BUG_ON(fpmux_demand_request(&d, SLOT_B, DST, 9)
+			!= conn_requested);
+	FASTPASS_BUG_ON(d.abandoned[DST] != 3);
+	check_invariant(DST);
+
+	/* the arbiter allocates everything the connection asked for: B gets all
+	 * it requested, and the rest is unclaimed */
+	unclaimed = d.unclaimed;
+	fpmux_demand_claim(&d, DST, outstanding(&d.conn, DST));
+	FASTPASS_BUG_ON(d.member[SLOT_B].assigned[DST] != 9);
+	FASTPASS_BUG_ON(d.unclaimed - unclaimed != 3);
+	FASTPASS_BUG_ON(d.abandoned[DST] != 0);
+	FASTPASS_BUG_ON(d.conn.assigned[DST] != d.conn.requested[DST]);
+	check_invariant(DST);
+
+	/* with nothing left to reuse, B's requests grow the connection's again */
+	FASTPASS_BUG_ON(fpmux_demand_request(&d, SLOT_B, DST, 11)
+			!= conn_requested + 2);
+	check_invariant(DST);
+
+	/* a member joining the slot starts from zero */
+	FASTPASS_BUG_ON(fpmux_demand_request(&d, SLOT_A, DST, 1)
+			!= conn_requested + 3);
+	check_invariant(DST);
+}
+
+/* test */
+int main(void) {
+	test_shared_dst();
+	test_member_leaves();
+
+	printf("done testing fpmux demand, quitting\n");
+	return 0;
+}